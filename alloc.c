@@ -0,0 +1,387 @@
+#include <malloc.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+#include "budget.h"
+#include "profile.h"
+
+// Quantidade máxima de locais no relatório
+#define ALLOC_REPORT_LINES 30
+
+// Tamanho inicial da tabela de blocos vivos (potência de 2)
+#define ALLOC_TABLE_INITIAL 4096
+
+// Baldes da tabela de locais (potência de 2)
+#define ALLOC_SITE_BUCKETS 256
+
+int allocTracking = 0;
+int allocProfiling = 0;
+
+__thread size_t allocHeapLimit = 0;
+
+// Bytes vivos da execução limitada; pode ficar negativo quando ela libera blocos
+// alocados antes de começar
+static __thread long long heapUsed = 0;
+
+// Totais de um local de alocação (uma linha com ALLOC_*)
+typedef struct AllocSite
+{
+    const char *site;
+    const char *function;
+    size_t liveBytes;
+    size_t liveBlocks;
+    size_t peakBytes; // maior valor de liveBytes
+    size_t allocations;
+    size_t bytes; // total alocado, inclusive o que já foi liberado
+    struct AllocSite *next;
+} AllocSite;
+
+// Bloco vivo; a tabela usa endereçamento aberto com sondagem linear
+typedef struct
+{
+    void *pointer; // NULL: posição livre
+    size_t size;
+    AllocSite *site;
+} AllocBlock;
+
+// As threads do --batch compartilham as tabelas; o mutex só é usado com o
+// rastreamento ativo
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static AllocBlock *blocks = NULL;
+static size_t blockCapacity = 0;
+static size_t blockCount = 0;
+
+static AllocSite *sites[ALLOC_SITE_BUCKETS];
+static int siteCount = 0;
+
+// Totais do processo
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+static size_t frees = 0;
+
+static size_t hashPointer(const void *pointer, size_t mask)
+{
+    uint64_t key = (uint64_t)(uintptr_t)pointer;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key & mask;
+}
+
+// O local é identificado pelo endereço da string constante de ALLOC_SITE
+static AllocSite *findSite(const char *site, const char *function)
+{
+    size_t bucket = ((uintptr_t)site >> 3) & (ALLOC_SITE_BUCKETS - 1);
+    for (AllocSite *entry = sites[bucket]; entry; entry = entry->next)
+    {
+        if (entry->site == site)
+        {
+            return entry;
+        }
+    }
+    AllocSite *entry = calloc(1, sizeof(AllocSite));
+    entry->site = site;
+    entry->function = function;
+    entry->next = sites[bucket];
+    sites[bucket] = entry;
+    siteCount++;
+    return entry;
+}
+
+// Posição do bloco na tabela, ou a posição livre onde ele entraria
+static size_t findSlot(const void *pointer)
+{
+    size_t mask = blockCapacity - 1;
+    size_t slot = hashPointer(pointer, mask);
+    while (blocks[slot].pointer && blocks[slot].pointer != pointer)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void growBlocks(void)
+{
+    AllocBlock *old = blocks;
+    size_t oldCapacity = blockCapacity;
+    blockCapacity = blockCapacity ? blockCapacity * 2 : ALLOC_TABLE_INITIAL;
+    blocks = calloc(blockCapacity, sizeof(AllocBlock));
+    for (size_t i = 0; i < oldCapacity; i++)
+    {
+        if (old[i].pointer)
+        {
+            blocks[findSlot(old[i].pointer)] = old[i];
+        }
+    }
+    free(old);
+}
+
+// Tira o bloco da tabela e desconta dos totais; a deleção desloca os blocos
+// seguintes da mesma sequência para não deixar buracos na sondagem
+static void removeBlock(size_t slot)
+{
+    AllocBlock *block = &blocks[slot];
+    block->site->liveBytes -= block->size;
+    block->site->liveBlocks--;
+    liveBytes -= block->size;
+    blockCount--;
+    frees++;
+
+    size_t mask = blockCapacity - 1;
+    size_t hole = slot;
+    size_t next = (slot + 1) & mask;
+    while (blocks[next].pointer)
+    {
+        size_t home = hashPointer(blocks[next].pointer, mask);
+        // O bloco pode ocupar o buraco se sua posição ideal não está entre o buraco e ele
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            blocks[hole] = blocks[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    blocks[hole].pointer = NULL;
+}
+
+static void forget(void *pointer)
+{
+    if (!pointer || blockCount == 0)
+    {
+        return;
+    }
+    size_t slot = findSlot(pointer);
+    if (blocks[slot].pointer)
+    {
+        removeBlock(slot);
+    }
+}
+
+static void record(void *pointer, size_t size, const char *site, const char *function)
+{
+    if (!pointer)
+    {
+        return;
+    }
+    if ((blockCount + 1) * 2 > blockCapacity)
+    {
+        growBlocks();
+    }
+    size_t slot = findSlot(pointer);
+    // Um endereço ainda na tabela foi liberado por um free comum
+    if (blocks[slot].pointer)
+    {
+        removeBlock(slot);
+        slot = findSlot(pointer);
+    }
+    AllocSite *entry = findSite(site, function);
+    blocks[slot].pointer = pointer;
+    blocks[slot].size = size;
+    blocks[slot].site = entry;
+    blockCount++;
+
+    entry->liveBytes += size;
+    entry->liveBlocks++;
+    entry->allocations++;
+    entry->bytes += size;
+    if (entry->liveBytes > entry->peakBytes)
+    {
+        entry->peakBytes = entry->liveBytes;
+    }
+    liveBytes += size;
+    allocations++;
+    allocatedBytes += size;
+    if (liveBytes > peakBytes)
+    {
+        peakBytes = liveBytes;
+    }
+}
+
+static void trackedRecord(void *pointer, size_t size, const char *site, const char *function)
+{
+    if (allocTracking)
+    {
+        pthread_mutex_lock(&lock);
+        record(pointer, size, site, function);
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+static void trackedForget(void *pointer)
+{
+    if (allocTracking)
+    {
+        pthread_mutex_lock(&lock);
+        forget(pointer);
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+// Soma o bloco à memória da execução limitada; fora do mutex, porque o fail()
+// não volta
+static void charge(void *pointer)
+{
+    if (allocHeapLimit && pointer)
+    {
+        heapUsed += malloc_usable_size(pointer);
+        if (heapUsed > (long long)allocHeapLimit)
+        {
+            budgetHeapExceeded(allocHeapLimit);
+        }
+    }
+}
+
+static void discharge(void *pointer)
+{
+    if (allocHeapLimit && pointer)
+    {
+        heapUsed -= malloc_usable_size(pointer);
+    }
+}
+
+// Alocação contada no perfil, na função e na linha em execução
+static void profiled(size_t size)
+{
+    if (allocProfiling)
+    {
+        profileAllocation(size);
+    }
+}
+
+void *allocTrackedMalloc(size_t size, const char *site, const char *function)
+{
+    void *pointer = malloc(size);
+    profiled(size);
+    trackedRecord(pointer, size, site, function);
+    charge(pointer);
+    return pointer;
+}
+
+void *allocTrackedCalloc(size_t count, size_t size, const char *site, const char *function)
+{
+    void *pointer = calloc(count, size);
+    profiled(count * size);
+    trackedRecord(pointer, count * size, site, function);
+    charge(pointer);
+    return pointer;
+}
+
+// O bloco realocado passa a contar no local do realloc; no perfil, só quando cresce
+void *allocTrackedRealloc(void *pointer, size_t size, const char *site, const char *function)
+{
+    if (allocProfiling && (!pointer || malloc_usable_size(pointer) < size))
+    {
+        profileAllocation(size);
+    }
+    discharge(pointer);
+    if (allocTracking)
+    {
+        pthread_mutex_lock(&lock);
+        forget(pointer);
+        void *resized = realloc(pointer, size);
+        record(resized ? resized : pointer, size, site, function);
+        pthread_mutex_unlock(&lock);
+        charge(resized ? resized : pointer);
+        return resized;
+    }
+    void *resized = realloc(pointer, size);
+    charge(resized ? resized : pointer);
+    return resized;
+}
+
+char *allocTrackedStrdup(const char *text, const char *site, const char *function)
+{
+    char *copy = strdup(text);
+    profiled(strlen(text) + 1);
+    trackedRecord(copy, strlen(text) + 1, site, function);
+    charge(copy);
+    return copy;
+}
+
+void allocTrackedFree(void *pointer)
+{
+    trackedForget(pointer);
+    discharge(pointer);
+    free(pointer);
+}
+
+void allocLimitStart(size_t bytes)
+{
+    heapUsed = 0;
+    allocHeapLimit = bytes;
+}
+
+void allocLimitStop(void)
+{
+    allocHeapLimit = 0;
+}
+
+// Ordem do relatório: mais bytes vivos primeiro, depois maior pico
+static int compareSites(const void *a, const void *b)
+{
+    const AllocSite *left = *(const AllocSite *const *)a;
+    const AllocSite *right = *(const AllocSite *const *)b;
+    if (left->liveBytes != right->liveBytes)
+    {
+        return left->liveBytes < right->liveBytes ? 1 : -1;
+    }
+    if (left->peakBytes != right->peakBytes)
+    {
+        return left->peakBytes < right->peakBytes ? 1 : -1;
+    }
+    return strcmp(left->site, right->site);
+}
+
+static void allocReport(void)
+{
+    pthread_mutex_lock(&lock);
+    AllocSite **sorted = malloc(sizeof(AllocSite *) * (siteCount ? siteCount : 1));
+    int index = 0;
+    for (int i = 0; i < ALLOC_SITE_BUCKETS; i++)
+    {
+        for (AllocSite *entry = sites[i]; entry; entry = entry->next)
+        {
+            sorted[index++] = entry;
+        }
+    }
+    qsort(sorted, siteCount, sizeof(AllocSite *), compareSites);
+
+    fprintf(stderr, "\nAlocações: %zu (%zu bytes), %zu liberadas; pico de %zu bytes vivos\n", allocations,
+            allocatedBytes, frees, peakBytes);
+    fprintf(stderr, "Vivos no fim: %zu bytes em %zu blocos\n\n", liveBytes, blockCount);
+    fprintf(stderr, "%-20s %-24s %12s %10s %12s %14s %14s\n", "local", "função", "vivos", "blocos", "pico",
+            "alocações", "bytes");
+    int shown = siteCount < ALLOC_REPORT_LINES ? siteCount : ALLOC_REPORT_LINES;
+    for (int i = 0; i < shown; i++)
+    {
+        AllocSite *entry = sorted[i];
+        // Só o nome do arquivo, sem o diretório usado na compilação
+        const char *site = strrchr(entry->site, '/');
+        site = site ? site + 1 : entry->site;
+        fprintf(stderr, "%-20s %-22s %12zu %10zu %12zu %12zu %14zu\n", site, entry->function, entry->liveBytes,
+                entry->liveBlocks, entry->peakBytes, entry->allocations, entry->bytes);
+    }
+    if (siteCount > shown)
+    {
+        fprintf(stderr, "... mais %d locais\n", siteCount - shown);
+    }
+    fprintf(stderr, "(vivos, pico e bytes em bytes; pico é o maior valor de vivos de cada local)\n");
+    free(sorted);
+    pthread_mutex_unlock(&lock);
+}
+
+void allocEnable(void)
+{
+    if (allocTracking)
+    {
+        return;
+    }
+    allocTracking = 1;
+    atexit(allocReport);
+}
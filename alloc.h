@@ -0,0 +1,80 @@
+#ifndef PHTML_ALLOC_H
+#define PHTML_ALLOC_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+
+// Alocações rastreadas (phtml --alloc-report arquivo.phtml)
+//
+// As alocações do interpretador (ambientes, variáveis, strings, argumentos, a
+// tabela de funções, arrays, mapas e a IR) passam pelas macros ALLOC_*, que
+// guardam o local (arquivo:linha e função) de cada uma. Sem --alloc-report elas
+// são malloc, calloc, realloc, strdup e free depois de um teste de
+// allocTracking. Com ele, cada bloco vivo fica em uma tabela com o tamanho e o
+// local, e no fim do processo a saída de erro mostra, para cada local, os bytes
+// e blocos ainda vivos, o pico de bytes vivos e o total alocado, além do pico
+// de bytes vivos do interpretador inteiro.
+//
+// ALLOC_FREE aceita blocos que não vieram das macros (do mpc, por exemplo):
+// eles só não estão na tabela. Como o JIT e o perfil, é só da linha de comando.
+//
+// As mesmas macros medem a memória de uma execução com limite (ver budget.h):
+// com allocHeapLimit, o tamanho real de cada bloco (malloc_usable_size) é somado
+// na alocação e descontado na liberação, na thread que executa.
+//
+// Elas também alimentam o perfil (profile.h), que soma cada alocação (e cada
+// realloc que aumenta o bloco) à função e à linha em execução, e os contadores
+// do --stats: ALLOC_STRING, ALLOC_STRING_COPY e ALLOC_COUNTED são as versões
+// que contam strings e objetos, e nenhum local precisa chamar os dois à parte.
+
+// Diferente de zero depois de allocEnable
+extern int allocTracking;
+
+// Diferente de zero com o perfil por instrumentação ativo (ver profileEnable)
+extern int allocProfiling;
+
+// Limite de memória da execução na thread atual; 0: sem limite
+extern __thread size_t allocHeapLimit;
+
+#define ALLOC_HOOKED (allocTracking || allocProfiling || allocHeapLimit)
+
+#define ALLOC_QUOTE(text) #text
+#define ALLOC_LINE(line) ALLOC_QUOTE(line)
+#define ALLOC_SITE __FILE__ ":" ALLOC_LINE(__LINE__)
+
+#define ALLOC_MALLOC(size) \
+    (ALLOC_HOOKED ? allocTrackedMalloc((size), ALLOC_SITE, __func__) : malloc(size))
+#define ALLOC_CALLOC(count, size) \
+    (ALLOC_HOOKED ? allocTrackedCalloc((count), (size), ALLOC_SITE, __func__) : calloc((count), (size)))
+#define ALLOC_REALLOC(pointer, size) \
+    (ALLOC_HOOKED ? allocTrackedRealloc((pointer), (size), ALLOC_SITE, __func__) : realloc((pointer), (size)))
+#define ALLOC_STRDUP(text) \
+    (ALLOC_HOOKED ? allocTrackedStrdup((text), ALLOC_SITE, __func__) : strdup(text))
+#define ALLOC_FREE(pointer) \
+    (ALLOC_HOOKED ? allocTrackedFree(pointer) : free(pointer))
+
+// Strings do interpretador ('size' inclui o '\0') e objetos contados pelo --stats;
+// sem -DPHTML_STATS são as macros acima
+#define ALLOC_STRING(size) \
+    (STATS_COUNT(strings), STATS_ADD(stringBytes, (size)), ALLOC_MALLOC(size))
+#define ALLOC_STRING_COPY(text) \
+    (STATS_COUNT(strings), STATS_ADD(stringBytes, strlen(text) + 1), ALLOC_STRDUP(text))
+#define ALLOC_COUNTED(field, size) \
+    (STATS_COUNT(field), ALLOC_MALLOC(size))
+
+// Ativa o rastreamento; o relatório é emitido na saída do processo (atexit)
+void allocEnable(void);
+
+// Início e fim da contagem de memória de uma execução limitada (ver budget.h)
+void allocLimitStart(size_t bytes);
+void allocLimitStop(void);
+
+// Versões rastreadas, chamadas pelas macros; 'site' deve ser uma string constante
+void *allocTrackedMalloc(size_t size, const char *site, const char *function);
+void *allocTrackedCalloc(size_t count, size_t size, const char *site, const char *function);
+void *allocTrackedRealloc(void *pointer, size_t size, const char *site, const char *function);
+char *allocTrackedStrdup(const char *text, const char *site, const char *function);
+void allocTrackedFree(void *pointer);
+
+#endif
@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phtml.h"
+#include "error.h"
+#include "array.h"
+#include "simd.h"
+#include "alloc.h"
+
+#define ARRAY_INITIAL_CAPACITY 8
+
+static size_t elementSize(ValueType type)
+{
+    switch (type)
+    {
+    case TYPE_CHAR:
+        return sizeof(char);
+    case TYPE_FLOAT:
+        return sizeof(float);
+    case TYPE_STRING:
+        return sizeof(char *);
+    case TYPE_LONG:
+        return sizeof(long long);
+    case TYPE_DOUBLE:
+        return sizeof(double);
+    default:
+        return sizeof(int); // int e bool
+    }
+}
+
+Value newArray(ValueType elementType)
+{
+    Array *array = ALLOC_MALLOC(sizeof(Array));
+    array->elementType = elementType;
+    array->length = 0;
+    array->capacity = 0;
+    array->items = NULL;
+
+    Value val;
+    val.type = TYPE_ARRAY;
+    val.value.arrayValue = array;
+    return val;
+}
+
+static Array *requireArray(Value value)
+{
+    if (value.type != TYPE_ARRAY)
+    {
+        fail("Erro: valor do tipo %s não é um array\n", getTypeString(value.type));
+    }
+    return value.value.arrayValue;
+}
+
+static int checkIndex(Array *array, Value index)
+{
+    long long i;
+    if (index.type == TYPE_INT)
+    {
+        i = index.value.intValue;
+    }
+    else if (index.type == TYPE_LONG)
+    {
+        i = index.value.longValue;
+    }
+    else
+    {
+        fail("Erro: índice de array deve ser int, recebido %s\n", getTypeString(index.type));
+    }
+
+    if (i < 0 || i >= array->length)
+    {
+        fail("Erro: índice %lld fora dos limites do array (tamanho %d)\n", i, array->length);
+    }
+    return (int)i;
+}
+
+// Converte o valor para o tipo dos elementos; int vira float em arrays de float
+static Value convertElement(Array *array, Value value)
+{
+    if (array->elementType == TYPE_VOID && value.type != TYPE_VOID && value.type != TYPE_ARRAY)
+    {
+        array->elementType = value.type;
+    }
+
+    if (array->elementType == TYPE_FLOAT && value.type == TYPE_INT)
+    {
+        value.type = TYPE_FLOAT;
+        value.value.floatValue = value.value.intValue;
+    }
+    else
+    {
+        value = widenValue(array->elementType, value);
+    }
+
+    if (value.type != array->elementType || value.type == TYPE_VOID)
+    {
+        fail("Erro: valor do tipo %s não pode ser guardado em um array de %s\n",
+             getTypeString(value.type), getTypeString(array->elementType));
+    }
+    return value;
+}
+
+Value arrayElement(Array *array, int index)
+{
+    Value val;
+    val.type = array->elementType;
+
+    switch (array->elementType)
+    {
+    case TYPE_INT:
+        val.value.intValue = ((int *)array->items)[index];
+        break;
+    case TYPE_FLOAT:
+        val.value.floatValue = ((float *)array->items)[index];
+        break;
+    case TYPE_CHAR:
+        val.value.charValue = ((char *)array->items)[index];
+        break;
+    case TYPE_BOOL:
+        val.value.boolValue = ((int *)array->items)[index];
+        break;
+    case TYPE_STRING:
+        val.value.stringValue = ((char **)array->items)[index];
+        break;
+    case TYPE_LONG:
+        val.value.longValue = ((long long *)array->items)[index];
+        break;
+    case TYPE_DOUBLE:
+        val.value.doubleValue = ((double *)array->items)[index];
+        break;
+    default:
+        break;
+    }
+    return val;
+}
+
+// Guarda um valor já convertido; strings são copiadas e a anterior é liberada
+static void storeElement(Array *array, int index, Value value, int replace)
+{
+    switch (array->elementType)
+    {
+    case TYPE_INT:
+        ((int *)array->items)[index] = value.value.intValue;
+        break;
+    case TYPE_FLOAT:
+        ((float *)array->items)[index] = value.value.floatValue;
+        break;
+    case TYPE_CHAR:
+        ((char *)array->items)[index] = value.value.charValue;
+        break;
+    case TYPE_BOOL:
+        ((int *)array->items)[index] = value.value.boolValue;
+        break;
+    case TYPE_STRING:
+    {
+        char **items = array->items;
+        char *copy = ALLOC_STRING_COPY(value.value.stringValue);
+        if (replace)
+        {
+            ALLOC_FREE(items[index]);
+        }
+        items[index] = copy;
+        break;
+    }
+    case TYPE_LONG:
+        ((long long *)array->items)[index] = value.value.longValue;
+        break;
+    case TYPE_DOUBLE:
+        ((double *)array->items)[index] = value.value.doubleValue;
+        break;
+    default:
+        break;
+    }
+}
+
+Value arrayGet(Value array, Value index)
+{
+    Array *a = requireArray(array);
+    return arrayElement(a, checkIndex(a, index));
+}
+
+void arraySet(Value array, Value index, Value value)
+{
+    Array *a = requireArray(array);
+    int i = checkIndex(a, index);
+    storeElement(a, i, convertElement(a, value), 1);
+}
+
+void arrayPush(Value array, Value value)
+{
+    Array *a = requireArray(array);
+    value = convertElement(a, value);
+
+    if (a->length == a->capacity)
+    {
+        a->capacity = a->capacity ? a->capacity * 2 : ARRAY_INITIAL_CAPACITY;
+        a->items = ALLOC_REALLOC(a->items, elementSize(a->elementType) * a->capacity);
+    }
+    storeElement(a, a->length, value, 0);
+    a->length++;
+}
+
+Value valueLength(Value value)
+{
+    Value val;
+    val.type = TYPE_INT;
+
+    if (value.type == TYPE_ARRAY)
+    {
+        val.value.intValue = value.value.arrayValue->length;
+    }
+    else if (value.type == TYPE_MAP)
+    {
+        val.value.intValue = value.value.mapValue->count;
+    }
+    else if (value.type == TYPE_STRING)
+    {
+        val.value.intValue = (int)strlen(value.value.stringValue);
+    }
+    else
+    {
+        fail("Erro: <length> espera um array, um map ou uma string, recebido %s\n", getTypeString(value.type));
+    }
+    return val;
+}
+
+static const char *operationName(ArrayOp op)
+{
+    switch (op)
+    {
+    case ARRAY_SUM:
+        return "<sum>";
+    case ARRAY_MIN:
+        return "<min>";
+    case ARRAY_MAX:
+        return "<max>";
+    case ARRAY_DOT:
+        return "<dot>";
+    case ARRAY_ADD:
+        return "<add>";
+    case ARRAY_MUL:
+        return "<mul>";
+    default:
+        return "<count>";
+    }
+}
+
+// Tipo numérico dos elementos; um array ainda sem tipo é tratado como int[] vazio
+static ValueType numericElementType(ArrayOp op, Array *array)
+{
+    ValueType type = array->elementType == TYPE_VOID ? TYPE_INT : array->elementType;
+    if (type != TYPE_INT && type != TYPE_LONG && type != TYPE_FLOAT && type != TYPE_DOUBLE)
+    {
+        fail("Erro: %s espera um array de números, recebido um array de %s\n",
+             operationName(op), getTypeString(type));
+    }
+    return type;
+}
+
+// Converte o segundo operando de <add>, <mul> e <count> para o tipo dos elementos
+static Value convertScalar(ArrayOp op, ValueType type, Value value)
+{
+    if (type == TYPE_FLOAT && value.type == TYPE_INT)
+    {
+        value.type = TYPE_FLOAT;
+        value.value.floatValue = value.value.intValue;
+    }
+    else
+    {
+        value = widenValue(type, value);
+    }
+
+    if (value.type != type)
+    {
+        fail("Erro: %s não aceita um valor do tipo %s com um array de %s\n",
+             operationName(op), getTypeString(value.type), getTypeString(type));
+    }
+    return value;
+}
+
+Value arrayOperation(ArrayOp op, Operator compare, Value left, Value right)
+{
+    const SimdKernels *k = simdKernels();
+    Array *a = requireArray(left);
+    ValueType type = numericElementType(op, a);
+    int n = a->length;
+
+    Value val;
+    val.type = type;
+
+    if (op == ARRAY_SUM)
+    {
+        switch (type)
+        {
+        case TYPE_INT:
+            val.value.intValue = k->sumInt(a->items, n);
+            break;
+        case TYPE_LONG:
+            val.value.longValue = k->sumLong(a->items, n);
+            break;
+        case TYPE_FLOAT:
+            val.value.floatValue = k->sumFloat(a->items, n);
+            break;
+        default:
+            val.value.doubleValue = k->sumDouble(a->items, n);
+            break;
+        }
+        return val;
+    }
+
+    if (op == ARRAY_MIN || op == ARRAY_MAX)
+    {
+        if (n == 0)
+        {
+            fail("Erro: %s de um array vazio\n", operationName(op));
+        }
+        int max = op == ARRAY_MAX;
+        switch (type)
+        {
+        case TYPE_INT:
+            val.value.intValue = max ? k->maxInt(a->items, n) : k->minInt(a->items, n);
+            break;
+        case TYPE_LONG:
+            val.value.longValue = max ? k->maxLong(a->items, n) : k->minLong(a->items, n);
+            break;
+        case TYPE_FLOAT:
+            val.value.floatValue = max ? k->maxFloat(a->items, n) : k->minFloat(a->items, n);
+            break;
+        default:
+            val.value.doubleValue = max ? k->maxDouble(a->items, n) : k->minDouble(a->items, n);
+            break;
+        }
+        return val;
+    }
+
+    if (op == ARRAY_DOT)
+    {
+        Array *b = requireArray(right);
+        if (numericElementType(op, b) != type || b->length != n)
+        {
+            fail("Erro: <dot> espera arrays do mesmo tipo e tamanho, recebidos %s[%d] e %s[%d]\n",
+                 getTypeString(type), n, getTypeString(numericElementType(op, b)), b->length);
+        }
+        switch (type)
+        {
+        case TYPE_INT:
+            val.value.intValue = k->dotInt(a->items, b->items, n);
+            break;
+        case TYPE_LONG:
+            val.value.longValue = k->dotLong(a->items, b->items, n);
+            break;
+        case TYPE_FLOAT:
+            val.value.floatValue = k->dotFloat(a->items, b->items, n);
+            break;
+        default:
+            val.value.doubleValue = k->dotDouble(a->items, b->items, n);
+            break;
+        }
+        return val;
+    }
+
+    Value scalar = convertScalar(op, type, right);
+
+    if (op == ARRAY_COUNT)
+    {
+        val.type = TYPE_INT;
+        switch (type)
+        {
+        case TYPE_INT:
+            val.value.intValue = k->countInt(a->items, n, compare, scalar.value.intValue);
+            break;
+        case TYPE_LONG:
+            val.value.intValue = k->countLong(a->items, n, compare, scalar.value.longValue);
+            break;
+        case TYPE_FLOAT:
+            val.value.intValue = k->countFloat(a->items, n, compare, scalar.value.floatValue);
+            break;
+        default:
+            val.value.intValue = k->countDouble(a->items, n, compare, scalar.value.doubleValue);
+            break;
+        }
+        return val;
+    }
+
+    // <add> e <mul> criam um array novo, já com o tamanho final
+    Operator arithmetic = op == ARRAY_ADD ? OP_ADD : OP_MUL;
+    Value result = newArray(type);
+    Array *out = result.value.arrayValue;
+    out->length = n;
+    out->capacity = n;
+    out->items = n > 0 ? ALLOC_MALLOC(elementSize(type) * n) : NULL;
+    switch (type)
+    {
+    case TYPE_INT:
+        k->mapInt(out->items, a->items, n, arithmetic, scalar.value.intValue);
+        break;
+    case TYPE_LONG:
+        k->mapLong(out->items, a->items, n, arithmetic, scalar.value.longValue);
+        break;
+    case TYPE_FLOAT:
+        k->mapFloat(out->items, a->items, n, arithmetic, scalar.value.floatValue);
+        break;
+    default:
+        k->mapDouble(out->items, a->items, n, arithmetic, scalar.value.doubleValue);
+        break;
+    }
+    return result;
+}
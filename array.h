@@ -0,0 +1,39 @@
+#ifndef PHTML_ARRAY_H
+#define PHTML_ARRAY_H
+
+#include "phtml.h"
+
+// Arrays (<var type='int[]'>)
+//
+// Os elementos ficam em um único bloco contíguo no formato nativo do tipo
+// (int, float, double, ...) em vez de Values ou variáveis separadas. O array é
+// compartilhado por referência: atribuições e parâmetros copiam só o ponteiro,
+// e <push> ou a atribuição de um elemento são vistos por todas as variáveis.
+// Índices começam em 0; um índice fora dos limites encerra o programa.
+
+// Array vazio; com TYPE_VOID o tipo é definido pelo primeiro elemento
+Value newArray(ValueType elementType);
+
+// Elemento 'index' (strings continuam pertencendo ao array, como em readVariable)
+Value arrayElement(Array *array, int index);
+
+// Operações usadas por a[i], <assign var='a[i]'> e <push>
+Value arrayGet(Value array, Value index);
+void arraySet(Value array, Value index, Value value);
+void arrayPush(Value array, Value value);
+
+// <length>: quantidade de elementos de um array ou map, ou de caracteres de uma string
+Value valueLength(Value value);
+
+// Operações em bloco sobre arrays de int, long, float ou double, feitas pelas
+// rotinas vetoriais de simd.c:
+//   <sum>v</sum>, <min>v</min>, <max>v</max>  -> valor do tipo dos elementos
+//   <dot>a, b</dot>                          -> produto escalar (mesmo tipo e tamanho)
+//   <add>v, k</add>, <mul>v, k</mul>         -> novo array com cada elemento somado a
+//                                               (multiplicado por) k
+//   <count op='>'>v, k</count>               -> quantidade de elementos com v[i] > k
+// 'right' é o segundo operando (TYPE_VOID em <sum>, <min> e <max>) e 'compare' o
+// operador de <count>
+Value arrayOperation(ArrayOp op, Operator compare, Value left, Value right);
+
+#endif
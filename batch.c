@@ -0,0 +1,497 @@
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "libphtml.h"
+#include "batch.h"
+
+// Arquivo .phtml, analisado pelo primeiro job que precisar dele
+typedef struct
+{
+    const char *path;
+    pthread_mutex_t lock;
+    int compiled;
+    PhtmlProgram *program;
+    PhtmlStatus status;
+    char *error;
+    double milliseconds;
+} Script;
+
+typedef struct
+{
+    int line;   // linha na lista, para as mensagens
+    char *text; // cópia da linha; o caminho e os argumentos string apontam para ela
+    const char *path;
+    int script;
+    int argCount;
+    PhtmlValue *args;
+
+    // Resultado
+    PhtmlStatus status;
+    char *output;
+    size_t length;
+    double milliseconds;
+    int worker;
+    int done;
+} Job;
+
+// Fila de uma thread: a dona tira do início, as outras roubam do fim
+typedef struct
+{
+    pthread_mutex_t lock;
+    int *jobs;
+    int head;
+    int tail;
+} JobQueue;
+
+typedef struct
+{
+    PhtmlRuntime *runtime;
+    const BatchOptions *options;
+    Job *jobs;
+    int jobCount;
+    Script *scripts;
+    int scriptCount;
+    JobQueue *queues;
+    int workerCount;
+    int steals;
+
+    // Saída padrão em ordem: o próximo job a ser escrito
+    pthread_mutex_t printLock;
+    int nextToPrint;
+} Batch;
+
+typedef struct
+{
+    Batch *batch;
+    int index;
+} Worker;
+
+// Cópia local de propósito: measureNow (bench/medida.c) é das ferramentas de
+// bench e não entra no binário phtml, e aqui basta o tempo desde 'start', como
+// nos relógios próprios de trace.c, profile.c e stats.c
+static double elapsedMilliseconds(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+int batchSplitLine(char *text, const char **path, PhtmlValue **args, int *argCount)
+{
+    int capacity = 0;
+    char *c = text;
+    *path = NULL;
+    *argCount = 0;
+    *args = NULL;
+
+    for (;;)
+    {
+        while (isspace((unsigned char)*c))
+        {
+            c++;
+        }
+        if (*c == '\0')
+        {
+            return 1;
+        }
+
+        char *field = c;
+        int quoted = *c == '"';
+        if (quoted)
+        {
+            field = ++c;
+            c = strchr(c, '"');
+            if (!c)
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            while (*c && !isspace((unsigned char)*c))
+            {
+                c++;
+            }
+        }
+        int last = *c == '\0';
+        *c = '\0';
+        if (!last)
+        {
+            c++;
+        }
+
+        if (!*path)
+        {
+            *path = field;
+            continue;
+        }
+        if (*argCount == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 4;
+            *args = realloc(*args, sizeof(PhtmlValue) * capacity);
+        }
+        (*args)[(*argCount)++] = quoted ? phtmlString(field) : phtmlParseArgument(field);
+        if (last)
+        {
+            return 1;
+        }
+    }
+}
+
+static int readList(Batch *batch, const char *listPath)
+{
+    FILE *list = strcmp(listPath, "-") == 0 ? stdin : fopen(listPath, "r");
+    if (!list)
+    {
+        fprintf(stderr, "Erro: não foi possível abrir a lista '%s'\n", listPath);
+        return 0;
+    }
+
+    int capacity = 0;
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    int lineNumber = 0;
+    int ok = 1;
+    while (getline(&line, &lineCapacity, list) >= 0)
+    {
+        lineNumber++;
+        char *start = line;
+        while (isspace((unsigned char)*start))
+        {
+            start++;
+        }
+        if (*start == '\0' || *start == '#')
+        {
+            continue;
+        }
+
+        if (batch->jobCount == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            batch->jobs = realloc(batch->jobs, sizeof(Job) * capacity);
+        }
+        Job *job = &batch->jobs[batch->jobCount];
+        memset(job, 0, sizeof(Job));
+        job->line = lineNumber;
+        job->text = strdup(start);
+        if (!batchSplitLine(job->text, &job->path, &job->args, &job->argCount))
+        {
+            fprintf(stderr, "Erro: %s:%d: aspas sem fechamento\n", listPath, lineNumber);
+            free(job->text);
+            free(job->args);
+            ok = 0;
+            continue;
+        }
+        batch->jobCount++;
+    }
+    free(line);
+    if (list != stdin)
+    {
+        fclose(list);
+    }
+    return ok;
+}
+
+static int comparePaths(const void *a, const void *b)
+{
+    const Job *left = *(Job *const *)a;
+    const Job *right = *(Job *const *)b;
+    int order = strcmp(left->path, right->path);
+    return order ? order : left->line - right->line;
+}
+
+// Agrupa os jobs por arquivo, para que cada um seja analisado uma vez
+static void collectScripts(Batch *batch)
+{
+    Job **sorted = malloc(sizeof(Job *) * batch->jobCount);
+    for (int i = 0; i < batch->jobCount; i++)
+    {
+        sorted[i] = &batch->jobs[i];
+    }
+    qsort(sorted, batch->jobCount, sizeof(Job *), comparePaths);
+
+    batch->scripts = calloc(batch->jobCount, sizeof(Script));
+    for (int i = 0; i < batch->jobCount; i++)
+    {
+        if (i == 0 || strcmp(sorted[i]->path, sorted[i - 1]->path) != 0)
+        {
+            Script *script = &batch->scripts[batch->scriptCount++];
+            script->path = sorted[i]->path;
+            pthread_mutex_init(&script->lock, NULL);
+        }
+        sorted[i]->script = batch->scriptCount - 1;
+    }
+    free(sorted);
+}
+
+static Script *compileScript(Batch *batch, Job *job)
+{
+    Script *script = &batch->scripts[job->script];
+    pthread_mutex_lock(&script->lock);
+    if (!script->compiled)
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        script->status = phtmlCompileFile(batch->runtime, script->path, &script->program);
+        if (script->status != PHTML_OK)
+        {
+            script->error = strdup(phtmlError(batch->runtime));
+        }
+        script->milliseconds = elapsedMilliseconds(&start);
+        script->compiled = 1;
+    }
+    pthread_mutex_unlock(&script->lock);
+    return script;
+}
+
+static int takeJob(Batch *batch, int worker)
+{
+    int job = -1;
+    JobQueue *own = &batch->queues[worker];
+    pthread_mutex_lock(&own->lock);
+    if (own->head < own->tail)
+    {
+        job = own->jobs[own->head++];
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    // Nenhum job é criado durante a execução: se todas as filas estão vazias, acabou
+    for (int i = 1; job < 0 && i < batch->workerCount; i++)
+    {
+        JobQueue *victim = &batch->queues[(worker + i) % batch->workerCount];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->head < victim->tail)
+        {
+            job = victim->jobs[--victim->tail];
+            __atomic_add_fetch(&batch->steals, 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return job;
+}
+
+// Guarda a saída do job com a mensagem de erro no fim, como na linha de comando
+static void keepOutput(Job *job, const char *output, size_t length, const char *error)
+{
+    size_t errorLength = error[0] ? strlen(error) + 1 : 0;
+    job->output = malloc(length + errorLength + 1);
+    memcpy(job->output, output, length);
+    if (errorLength)
+    {
+        memcpy(job->output + length, error, errorLength - 1);
+        job->output[length + errorLength - 1] = '\n';
+    }
+    job->length = length + errorLength;
+    job->output[job->length] = '\0';
+}
+
+static void writeJobFile(Batch *batch, Job *job, int number)
+{
+    const char *name = strrchr(job->path, '/');
+    name = name ? name + 1 : job->path;
+    size_t nameLength = strlen(name);
+    if (nameLength > 6 && strcmp(name + nameLength - 6, ".phtml") == 0)
+    {
+        nameLength -= 6;
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%04d-%.*s.out", batch->options->outputDir, number, (int)nameLength, name);
+    FILE *file = fopen(path, "wb");
+    if (!file || fwrite(job->output, 1, job->length, file) != job->length)
+    {
+        fprintf(stderr, "Erro: não foi possível escrever '%s'\n", path);
+        job->status = PHTML_ERROR_IO;
+    }
+    if (file && fclose(file) != 0)
+    {
+        job->status = PHTML_ERROR_IO;
+    }
+    free(job->output);
+    job->output = NULL;
+}
+
+// Escreve, em ordem, os jobs prontos que estavam esperando os anteriores
+static void finishJob(Batch *batch, Job *job)
+{
+    pthread_mutex_lock(&batch->printLock);
+    job->done = 1;
+    while (batch->nextToPrint < batch->jobCount && batch->jobs[batch->nextToPrint].done)
+    {
+        Job *ready = &batch->jobs[batch->nextToPrint++];
+        fwrite(ready->output, 1, ready->length, stdout);
+        free(ready->output);
+        ready->output = NULL;
+    }
+    pthread_mutex_unlock(&batch->printLock);
+}
+
+static void *runWorker(void *argument)
+{
+    Worker *worker = argument;
+    Batch *batch = worker->batch;
+    // Buffer de saída da thread, ampliado por phtmlRunBuffered quando um job não cabe
+    char *buffer = NULL;
+    size_t capacity = 0;
+
+    int index;
+    while ((index = takeJob(batch, worker->index)) >= 0)
+    {
+        Job *job = &batch->jobs[index];
+        job->worker = worker->index;
+        Script *script = compileScript(batch, job);
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        size_t length = 0;
+        if (script->status != PHTML_OK)
+        {
+            job->status = script->status;
+            keepOutput(job, "", 0, script->error);
+        }
+        else
+        {
+            job->status = phtmlRunBuffered(script->program, "main", job->args, job->argCount,
+                                           &buffer, &capacity, &length, NULL);
+            keepOutput(job, buffer, length, job->status == PHTML_OK ? "" : phtmlError(batch->runtime));
+        }
+        job->milliseconds = elapsedMilliseconds(&start);
+
+        if (batch->options->outputDir)
+        {
+            writeJobFile(batch, job, index + 1);
+        }
+        else
+        {
+            finishJob(batch, job);
+        }
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+static void printReport(Batch *batch, double totalMilliseconds)
+{
+    int failures = 0;
+    double jobMilliseconds = 0;
+    double compileMilliseconds = 0;
+
+    fprintf(stderr, "%6s %6s %12s  %s\n", "job", "thread", "tempo (ms)", "arquivo: status");
+    for (int i = 0; i < batch->jobCount; i++)
+    {
+        Job *job = &batch->jobs[i];
+        fprintf(stderr, "%6d %6d %12.3f  %s: %s\n", i + 1, job->worker, job->milliseconds,
+                job->path, phtmlStatusString(job->status));
+        failures += job->status != PHTML_OK;
+        jobMilliseconds += job->milliseconds;
+    }
+    for (int i = 0; i < batch->scriptCount; i++)
+    {
+        compileMilliseconds += batch->scripts[i].milliseconds;
+    }
+
+    fprintf(stderr, "%d jobs (%d com erro) em %d threads, %d roubos\n",
+            batch->jobCount, failures, batch->workerCount, batch->steals);
+    fprintf(stderr, "%d arquivos analisados em %.3f ms; jobs somam %.3f ms; tempo total %.3f ms\n",
+            batch->scriptCount, compileMilliseconds, jobMilliseconds, totalMilliseconds);
+}
+
+static void freeBatch(Batch *batch)
+{
+    for (int i = 0; i < batch->scriptCount; i++)
+    {
+        phtmlDestroyProgram(batch->scripts[i].program);
+        free(batch->scripts[i].error);
+        pthread_mutex_destroy(&batch->scripts[i].lock);
+    }
+    for (int i = 0; i < batch->jobCount; i++)
+    {
+        free(batch->jobs[i].text);
+        free(batch->jobs[i].args);
+    }
+    for (int i = 0; i < batch->workerCount; i++)
+    {
+        free(batch->queues[i].jobs);
+        pthread_mutex_destroy(&batch->queues[i].lock);
+    }
+    pthread_mutex_destroy(&batch->printLock);
+    free(batch->queues);
+    free(batch->scripts);
+    free(batch->jobs);
+}
+
+int batchRun(const char *listPath, const BatchOptions *options)
+{
+    Batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.options = options;
+    if (!readList(&batch, listPath))
+    {
+        freeBatch(&batch);
+        return 1;
+    }
+    collectScripts(&batch);
+
+    batch.workerCount = options->workers > 0 ? options->workers : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (batch.workerCount > batch.jobCount)
+    {
+        batch.workerCount = batch.jobCount;
+    }
+    if (batch.workerCount < 1)
+    {
+        batch.workerCount = 1;
+    }
+
+    // Distribuição inicial alternada: os primeiros jobs da lista ficam no início de
+    // todas as filas, e a saída em ordem não espera pelos últimos
+    batch.queues = calloc(batch.workerCount, sizeof(JobQueue));
+    for (int i = 0; i < batch.workerCount; i++)
+    {
+        JobQueue *queue = &batch.queues[i];
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->jobs = malloc(sizeof(int) * (batch.jobCount / batch.workerCount + 1));
+        for (int job = i; job < batch.jobCount; job += batch.workerCount)
+        {
+            queue->jobs[queue->tail++] = job;
+        }
+    }
+    pthread_mutex_init(&batch.printLock, NULL);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    batch.runtime = phtmlCreateRuntime();
+    phtmlSetLimits(batch.runtime, &options->limits);
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * batch.workerCount);
+    Worker *workers = malloc(sizeof(Worker) * batch.workerCount);
+    for (int i = 0; i < batch.workerCount; i++)
+    {
+        workers[i].batch = &batch;
+        workers[i].index = i;
+        pthread_create(&threads[i], NULL, runWorker, &workers[i]);
+    }
+    for (int i = 0; i < batch.workerCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    fflush(stdout);
+    double totalMilliseconds = elapsedMilliseconds(&start);
+
+    printReport(&batch, totalMilliseconds);
+    int failures = 0;
+    for (int i = 0; i < batch.jobCount; i++)
+    {
+        failures += batch.jobs[i].status != PHTML_OK;
+    }
+
+    free(threads);
+    free(workers);
+    freeBatch(&batch);
+    phtmlDestroyRuntime(batch.runtime);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+#ifndef PHTML_BATCH_H
+#define PHTML_BATCH_H
+
+#include "libphtml.h"
+
+// Execução em lote (phtml --batch lista.txt)
+//
+// A lista tem um job por linha: o caminho do arquivo .phtml seguido dos
+// argumentos da função main, separados por espaços ("..." para textos com
+// espaços). Linhas vazias e iniciadas por '#' são ignoradas; "-" lê a lista da
+// entrada padrão.
+//
+//     paginas/inicio.phtml
+//     paginas/produto.phtml 42 "Cadeira azul" 199.90
+//
+// Os jobs são executados pela biblioteca (libphtml.h) em um conjunto fixo de
+// threads. Cada thread tem sua fila de jobs e, quando ela esvazia, rouba jobs do
+// fim da fila de outra thread. Cada arquivo é analisado uma única vez, mesmo que
+// apareça em vários jobs.
+//
+// A saída de cada job vai para um arquivo em 'outputDir' (NNNN-nome.out, com o
+// número do job na lista) ou, sem ele, para a saída padrão na ordem da lista (um
+// job só é escrito depois dos anteriores). Erros aparecem no fim da saída do job,
+// como na linha de comando. O tempo de cada job e um resumo saem na saída de erro.
+
+typedef struct
+{
+    int workers;           // 0: uma thread por processador
+    const char *outputDir; // NULL: saída padrão, na ordem da lista
+    PhtmlLimits limits;    // de cada job (--max-steps, --max-time, --max-heap, --max-depth)
+} BatchOptions;
+
+// Retorna 0 se todos os jobs terminaram sem erro
+int batchRun(const char *listPath, const BatchOptions *options);
+
+// Separa uma linha da lista (também usada nos pedidos do --serve) no próprio
+// texto: 'path' e os argumentos string apontam para 'text', e 'args' deve ser
+// liberado por quem chamou. Retorna 0 se houver aspas sem fechamento.
+int batchSplitLine(char *text, const char **path, PhtmlValue **args, int *argCount);
+
+#endif
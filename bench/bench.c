@@ -0,0 +1,332 @@
+// Executor dos benchmarks (bench/*.phtml)
+//
+//     phtml-bench [-n repetições] [-w aquecimento] [-p ./phtml] [-f "opções"] [-j saida.json] arquivos...
+//     phtml-bench -n 10 -f "-O" -j otimizado.json bench/*.phtml
+//
+// Cada arquivo é executado pelo interpretador indicado em -p, com as opções de -f,
+// 'repetições' vezes depois de 'aquecimento' execuções descartadas, com a saída
+// descartada. Para cada um são impressos a mediana, o mínimo, a média e o desvio
+// padrão do tempo real e a mediana das instruções executadas, contadas pelo
+// perf_event_open quando o sistema permite (senão aparecem como "-").
+//
+// Com -j, os mesmos números e os tempos de cada repetição são gravados em JSON,
+// para comparar versões ou opções do interpretador.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "medida.h"
+
+// Quantidade máxima de opções repassadas ao interpretador
+#define BENCH_FLAGS_MAX 32
+
+typedef struct
+{
+    const char *file;
+    double *times;        // milissegundos, um por repetição
+    long long *counts;    // instruções, um por repetição (-1 sem contador)
+    int failed;           // alguma execução terminou com erro
+    double median;
+    double min;
+    double mean;
+    double stddev;
+    long long instructions; // mediana, ou -1
+} Benchmark;
+
+// Contador de instruções do processo 'pid' e dos que ele criar, ligado no exec
+static int openCounter(pid_t pid)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+// Executa uma vez; retorna 0 se o programa terminou com erro
+static int runOnce(char **command, double *milliseconds, long long *instructions)
+{
+    *milliseconds = 0;
+    *instructions = -1;
+
+    // O filho espera o contador ser aberto antes do exec
+    int ready[2];
+    if (pipe(ready) != 0)
+    {
+        return 0;
+    }
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        return 0;
+    }
+    if (pid == 0)
+    {
+        close(ready[1]);
+        char go;
+        if (read(ready[0], &go, 1) != 1)
+        {
+            _exit(127);
+        }
+        close(ready[0]);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        execv(command[0], command);
+        _exit(127);
+    }
+
+    close(ready[0]);
+    int counter = openCounter(pid);
+    double start = measureNow();
+    int released = write(ready[1], "x", 1) == 1;
+    close(ready[1]);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    *milliseconds = (measureNow() - start) * 1e3;
+
+    if (counter >= 0)
+    {
+        long long count;
+        if (read(counter, &count, sizeof(count)) == sizeof(count))
+        {
+            *instructions = count;
+        }
+        close(counter);
+    }
+    return released && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static int compareCounts(const void *a, const void *b)
+{
+    long long left = *(const long long *)a;
+    long long right = *(const long long *)b;
+    return (left > right) - (left < right);
+}
+
+static void summarize(Benchmark *bench, int iterations)
+{
+    double *sorted = malloc(sizeof(double) * iterations);
+    memcpy(sorted, bench->times, sizeof(double) * iterations);
+    bench->median = measureMedian(sorted, iterations);
+    bench->min = sorted[0];
+    double sum = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        sum += bench->times[i];
+    }
+    bench->mean = sum / iterations;
+    double squares = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        squares += (bench->times[i] - bench->mean) * (bench->times[i] - bench->mean);
+    }
+    bench->stddev = iterations > 1 ? sqrt(squares / (iterations - 1)) : 0;
+    free(sorted);
+
+    long long *counts = malloc(sizeof(long long) * iterations);
+    memcpy(counts, bench->counts, sizeof(long long) * iterations);
+    qsort(counts, iterations, sizeof(long long), compareCounts);
+    bench->instructions = counts[0] < 0 ? -1 : counts[iterations / 2];
+    free(counts);
+}
+
+// Nome do benchmark: o arquivo sem diretório e sem extensão
+static void benchName(const char *file, char *name, size_t size)
+{
+    const char *base = strrchr(file, '/');
+    base = base ? base + 1 : file;
+    snprintf(name, size, "%s", base);
+    char *dot = strrchr(name, '.');
+    if (dot)
+    {
+        *dot = '\0';
+    }
+}
+
+static void writeString(FILE *out, const char *text)
+{
+    fputc('"', out);
+    for (; *text; text++)
+    {
+        if (*text == '"' || *text == '\\')
+        {
+            fputc('\\', out);
+        }
+        fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+static int writeJson(const char *path, const char *phtml, const char *flags, int iterations,
+                     Benchmark *benches, int count)
+{
+    FILE *out = fopen(path, "w");
+    if (!out)
+    {
+        fprintf(stderr, "Erro: não foi possível criar '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    fprintf(out, "{\n  \"phtml\": ");
+    writeString(out, phtml);
+    fprintf(out, ",\n  \"flags\": ");
+    writeString(out, flags);
+    fprintf(out, ",\n  \"iterations\": %d,\n  \"benchmarks\": [", iterations);
+    for (int i = 0; i < count; i++)
+    {
+        Benchmark *bench = &benches[i];
+        char name[256];
+        benchName(bench->file, name, sizeof(name));
+        fprintf(out, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        writeString(out, name);
+        fprintf(out, ", \"file\": ");
+        writeString(out, bench->file);
+        fprintf(out, ", \"ok\": %s, \"medianMs\": %.3f, \"minMs\": %.3f, \"meanMs\": %.3f, \"stddevMs\": %.3f, ",
+                bench->failed ? "false" : "true", bench->median, bench->min, bench->mean, bench->stddev);
+        if (bench->instructions >= 0)
+        {
+            fprintf(out, "\"instructions\": %lld, ", bench->instructions);
+        }
+        else
+        {
+            fprintf(out, "\"instructions\": null, ");
+        }
+        fprintf(out, "\"samplesMs\": [");
+        for (int j = 0; j < iterations; j++)
+        {
+            fprintf(out, "%s%.3f", j > 0 ? ", " : "", bench->times[j]);
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 5;
+    int warmup = 1;
+    const char *phtml = "./phtml";
+    const char *flags = "";
+    const char *jsonPath = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:p:f:j:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 'w':
+            warmup = atoi(optarg);
+            break;
+        case 'p':
+            phtml = optarg;
+            break;
+        case 'f':
+            flags = optarg;
+            break;
+        case 'j':
+            jsonPath = optarg;
+            break;
+        default:
+            optind = argc + 1;
+        }
+    }
+    if (optind >= argc || iterations < 1 || warmup < 0)
+    {
+        fprintf(stderr, "Uso: %s [-n repetições] [-w aquecimento] [-p ./phtml] [-f \"opções\"] [-j saida.json] arquivos...\n",
+                argv[0]);
+        return 2;
+    }
+
+    // Linha de comando: interpretador, opções separadas por espaço e o arquivo
+    char *command[BENCH_FLAGS_MAX + 3];
+    int fixed = 0;
+    command[fixed++] = (char *)phtml;
+    char *flagCopy = strdup(flags);
+    for (char *flag = strtok(flagCopy, " "); flag && fixed < BENCH_FLAGS_MAX + 1; flag = strtok(NULL, " "))
+    {
+        command[fixed++] = flag;
+    }
+    command[fixed + 1] = NULL;
+
+    int count = argc - optind;
+    Benchmark *benches = calloc(count, sizeof(Benchmark));
+    int counted = 1;
+    int failures = 0;
+
+    printf("%-20s %10s %11s %11s %10s %18s\n", "benchmark", "mediana", "mínimo", "média", "desvio", "instruções");
+    for (int i = 0; i < count; i++)
+    {
+        Benchmark *bench = &benches[i];
+        bench->file = argv[optind + i];
+        bench->times = malloc(sizeof(double) * iterations);
+        bench->counts = malloc(sizeof(long long) * iterations);
+        command[fixed] = (char *)bench->file;
+
+        for (int run = -warmup; run < iterations; run++)
+        {
+            double milliseconds;
+            long long instructions;
+            int ok = runOnce(command, &milliseconds, &instructions);
+            if (run >= 0)
+            {
+                bench->failed |= !ok;
+                bench->times[run] = milliseconds;
+                bench->counts[run] = instructions;
+            }
+        }
+        summarize(bench, iterations);
+        counted &= bench->instructions >= 0;
+        failures += bench->failed;
+
+        char name[256];
+        benchName(bench->file, name, sizeof(name));
+        char instructions[32] = "-";
+        if (bench->instructions >= 0)
+        {
+            snprintf(instructions, sizeof(instructions), "%lld", bench->instructions);
+        }
+        printf("%-20s %10.2f %10.2f %10.2f %10.2f %16s%s\n", name, bench->median, bench->min, bench->mean,
+               bench->stddev, instructions, bench->failed ? "  (erro)" : "");
+        fflush(stdout);
+    }
+    printf("(tempos em ms; %d repetições, %d de aquecimento; %s %s)\n", iterations, warmup, phtml, flags);
+    if (!counted)
+    {
+        printf("(instruções indisponíveis: perf_event_open não permitido; ver /proc/sys/kernel/perf_event_paranoid)\n");
+    }
+
+    if (jsonPath && !writeJson(jsonPath, phtml, flags, iterations, benches, count))
+    {
+        failures++;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        free(benches[i].times);
+        free(benches[i].counts);
+    }
+    free(benches);
+    free(flagCopy);
+    return failures ? 1 : 0;
+}
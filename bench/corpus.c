@@ -0,0 +1,492 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "corpus.h"
+
+// Variáveis locais de cada função (além dos contadores dos laços)
+//
+// As variáveis são procuradas também no ambiente de quem chamou (ver
+// findVariable), então um <var> ou parâmetro com o nome de uma variável do
+// chamador a alteraria. Por isso todos os nomes levam o número da função:
+// parâmetros a3, b3 e s3, locais v3_0 a v3_2, contadores w3_0, w3_1, ... e t3.
+#define CORPUS_INT_VARS 3
+
+static const char *words[] = {
+    "produto", "cliente", "pedido", "total", "item", "preco", "nome", "cidade",
+    "estoque", "entrega", "pagina", "lista", "valor", "codigo", "frete", "azul"};
+
+#define CORPUS_WORDS (int)(sizeof(words) / sizeof(words[0]))
+
+typedef enum
+{
+    FUNCTION_LEAF,   // int folhaN(int a, int b), sem chamadas
+    FUNCTION_TEXT,   // string textoN(int a, string s), sem chamadas
+    FUNCTION_CALLER  // int funcaoN(int a, int b), chama folhas
+} FunctionKind;
+
+typedef struct
+{
+    FILE *out;
+    size_t written;
+    unsigned long long state;
+    const CorpusOptions *options;
+
+    // Funções geradas até agora
+    FunctionKind *kinds;
+    int count;
+    int capacity;
+
+    // Função em geração
+    FunctionKind kind;
+    int index;
+    int assigned; // locais inteiras que já receberam valor (v0 .. v{assigned-1})
+    int inMain;
+} Corpus;
+
+static void emit(Corpus *corpus, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int length = vfprintf(corpus->out, format, args);
+    va_end(args);
+    if (length > 0)
+    {
+        corpus->written += length;
+    }
+}
+
+static void indent(Corpus *corpus, int level)
+{
+    emit(corpus, "%*s", 2 * level, "");
+}
+
+// xorshift64*: rápido e igual em qualquer plataforma
+static unsigned random32(Corpus *corpus)
+{
+    corpus->state ^= corpus->state >> 12;
+    corpus->state ^= corpus->state << 25;
+    corpus->state ^= corpus->state >> 27;
+    return (unsigned)((corpus->state * 2685821657736338717ULL) >> 32);
+}
+
+static int below(Corpus *corpus, int limit)
+{
+    return (int)(random32(corpus) % (unsigned)limit);
+}
+
+static const char *functionPrefix(FunctionKind kind)
+{
+    switch (kind)
+    {
+    case FUNCTION_LEAF:
+        return "folha";
+    case FUNCTION_TEXT:
+        return "texto";
+    default:
+        return "funcao";
+    }
+}
+
+// Sorteia uma função já gerada do tipo pedido; retorna -1 se não houver
+static int pickFunction(Corpus *corpus, FunctionKind kind)
+{
+    int start = below(corpus, corpus->count > 0 ? corpus->count : 1);
+    for (int i = 0; i < corpus->count; i++)
+    {
+        int index = (start + i) % corpus->count;
+        if (corpus->kinds[index] == kind)
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+// Parâmetro ou local inteira já atribuída, sorteada
+static void intVariable(Corpus *corpus)
+{
+    int params = corpus->kind == FUNCTION_TEXT ? 1 : 2; // textoN não tem 'b'
+    int choice = below(corpus, params + corpus->assigned);
+    if (choice < params)
+    {
+        emit(corpus, "%c%d", choice ? 'b' : 'a', corpus->index);
+    }
+    else
+    {
+        emit(corpus, "v%d_%d", corpus->index, choice - params);
+    }
+}
+
+// Termo inteiro: parâmetro, variável, número ou número vezes variável
+static void intTerm(Corpus *corpus)
+{
+    if (corpus->inMain)
+    {
+        emit(corpus, "%d", below(corpus, 100));
+        return;
+    }
+    switch (below(corpus, 4))
+    {
+    case 0:
+        emit(corpus, "%d", below(corpus, 100));
+        break;
+    case 1:
+        emit(corpus, "%d * ", 1 + below(corpus, 9));
+        intVariable(corpus);
+        break;
+    default:
+        intVariable(corpus);
+        break;
+    }
+}
+
+// Expressão inteira com 'terms' termos somados ou subtraídos; a divisão no fim
+// mantém o resultado na mesma ordem de grandeza dos termos
+static void intExpression(Corpus *corpus)
+{
+    int terms = corpus->options->terms > 0 ? corpus->options->terms : 1;
+    emit(corpus, "(");
+    for (int i = 0; i < terms; i++)
+    {
+        if (i > 0)
+        {
+            emit(corpus, below(corpus, 2) ? " + " : " - ");
+        }
+        intTerm(corpus);
+    }
+    emit(corpus, ") / %d", 10 * terms);
+}
+
+static void condition(Corpus *corpus)
+{
+    static const char *operators[] = {"<", ">", "<=", ">=", "==", "!="};
+    intTerm(corpus);
+    emit(corpus, " %s ", operators[below(corpus, 6)]);
+    intTerm(corpus);
+    if (below(corpus, 3) == 0)
+    {
+        emit(corpus, below(corpus, 2) ? " && " : " || ");
+        intTerm(corpus);
+        emit(corpus, " %s ", operators[below(corpus, 6)]);
+        intTerm(corpus);
+    }
+}
+
+// Concatenação de palavras e números; a string anterior aparece no máximo uma
+// vez, para que o tamanho cresça só linearmente nos laços
+static void stringExpression(Corpus *corpus)
+{
+    int terms = corpus->options->terms > 1 ? corpus->options->terms / 2 : 1;
+    if (below(corpus, 3) == 0)
+    {
+        emit(corpus, "t%d + ", corpus->index);
+    }
+    emit(corpus, "\"%s \"", words[below(corpus, CORPUS_WORDS)]);
+    for (int i = 0; i < terms; i++)
+    {
+        emit(corpus, " + ");
+        if (below(corpus, 2))
+        {
+            emit(corpus, "\"%s\"", words[below(corpus, CORPUS_WORDS)]);
+        }
+        else
+        {
+            intTerm(corpus);
+        }
+    }
+}
+
+static void intCall(Corpus *corpus, int index)
+{
+    emit(corpus, "<call name='%s%d'><args><arg>", functionPrefix(corpus->kinds[index]), index);
+    intExpression(corpus);
+    emit(corpus, "</arg><arg>");
+    intExpression(corpus);
+    emit(corpus, "</arg></args></call>");
+}
+
+static void textCall(Corpus *corpus, int index)
+{
+    emit(corpus, "<call name='texto%d'><args><arg>", index);
+    intExpression(corpus);
+    emit(corpus, "</arg><arg>\"%s\"</arg></args></call>", words[below(corpus, CORPUS_WORDS)]);
+}
+
+static void block(Corpus *corpus, int level, int nesting);
+
+// Atribuição a uma variável local, com uma conta ou uma string
+static void assignment(Corpus *corpus, int strings)
+{
+    if (strings)
+    {
+        emit(corpus, "<assign var='t%d'>", corpus->index);
+        stringExpression(corpus);
+    }
+    else
+    {
+        emit(corpus, "<assign var='v%d_%d'>", corpus->index, below(corpus, CORPUS_INT_VARS));
+        intExpression(corpus);
+    }
+    emit(corpus, "</assign>\n");
+}
+
+// Chamada de uma folha, guardada em uma variável local; retorna 0 se não houver folha
+static int callCommand(Corpus *corpus, int strings)
+{
+    int index = pickFunction(corpus, strings ? FUNCTION_TEXT : FUNCTION_LEAF);
+    if (index < 0)
+    {
+        return 0;
+    }
+    if (strings)
+    {
+        emit(corpus, "<assign var='t%d'>", corpus->index);
+        textCall(corpus, index);
+    }
+    else
+    {
+        emit(corpus, "<assign var='v%d_%d'>", corpus->index, below(corpus, CORPUS_INT_VARS));
+        intCall(corpus, index);
+    }
+    emit(corpus, "</assign>\n");
+    return 1;
+}
+
+// Um comando do corpo de uma função, no nível de indentação 'level'
+static void command(Corpus *corpus, int level, int nesting)
+{
+    int strings = below(corpus, 100) < corpus->options->stringDensity;
+
+    // <if> e <while> (escolhas 0 e 1) só entram abaixo da profundidade máxima
+    int choice;
+    do
+    {
+        choice = below(corpus, 6);
+    } while (choice < 2 && nesting >= corpus->options->depth);
+
+    indent(corpus, level);
+    switch (choice)
+    {
+    case 0:
+        emit(corpus, "<if cond='");
+        condition(corpus);
+        emit(corpus, "'>\n");
+        block(corpus, level + 1, nesting + 1);
+        indent(corpus, level);
+        emit(corpus, "</if>\n");
+        if (below(corpus, 2))
+        {
+            indent(corpus, level);
+            emit(corpus, "<else>\n");
+            block(corpus, level + 1, nesting + 1);
+            indent(corpus, level);
+            emit(corpus, "</else>\n");
+        }
+        break;
+    case 1:
+        // Cada nível de aninhamento tem seu contador, zerado antes do laço
+        emit(corpus, "<assign var='w%d_%d'>0</assign>\n", corpus->index, nesting);
+        indent(corpus, level);
+        emit(corpus, "<while cond='w%d_%d < 3'>\n", corpus->index, nesting);
+        block(corpus, level + 1, nesting + 1);
+        indent(corpus, level + 1);
+        emit(corpus, "<assign var='w%d_%d'>w%d_%d + 1</assign>\n", corpus->index, nesting, corpus->index,
+             nesting);
+        indent(corpus, level);
+        emit(corpus, "</while>\n");
+        break;
+    case 2:
+        emit(corpus, "<print>");
+        if (strings)
+        {
+            stringExpression(corpus);
+        }
+        else
+        {
+            intExpression(corpus);
+        }
+        emit(corpus, "</print>\n");
+        break;
+    case 3:
+        if (corpus->kind == FUNCTION_CALLER && callCommand(corpus, strings))
+        {
+            break;
+        }
+        assignment(corpus, strings);
+        break;
+    default:
+        assignment(corpus, strings);
+        break;
+    }
+}
+
+// Bloco com pelo menos dois comandos: um bloco de um comando só executaria de
+// novo uma chamada aninhada (ver evaluateCommandList)
+static void block(Corpus *corpus, int level, int nesting)
+{
+    int commands = 2 + below(corpus, 3);
+    for (int i = 0; i < commands; i++)
+    {
+        command(corpus, level, nesting);
+    }
+}
+
+static void function(Corpus *corpus, FunctionKind kind)
+{
+    int index = corpus->count;
+    corpus->kind = kind;
+    corpus->index = index;
+    corpus->assigned = 0;
+    if (kind == FUNCTION_TEXT)
+    {
+        emit(corpus, "<function name='texto%d' return='string'>\n"
+                     "  <params>\n"
+                     "    <param type='int'>a%d</param>\n"
+                     "    <param type='string'>s%d</param>\n"
+                     "  </params>\n",
+             index, index, index);
+    }
+    else
+    {
+        emit(corpus, "<function name='%s%d' return='int'>\n"
+                     "  <params>\n"
+                     "    <param type='int'>a%d</param>\n"
+                     "    <param type='int'>b%d</param>\n"
+                     "  </params>\n",
+             functionPrefix(kind), index, index, index);
+    }
+
+    for (int i = 0; i < CORPUS_INT_VARS; i++)
+    {
+        emit(corpus, "  <var type='int'>v%d_%d</var>\n", index, i);
+    }
+    for (int i = 0; i < corpus->options->depth; i++)
+    {
+        emit(corpus, "  <var type='int'>w%d_%d</var>\n", index, i);
+    }
+    emit(corpus, "  <var type='string'>t%d</var>\n", index);
+    // Cada local é atribuída antes de ser lida
+    for (int i = 0; i < CORPUS_INT_VARS; i++)
+    {
+        emit(corpus, "  <assign var='v%d_%d'>", index, i);
+        intExpression(corpus);
+        emit(corpus, "</assign>\n");
+        corpus->assigned++;
+    }
+    emit(corpus, "  <assign var='t%d'>\"%s\"</assign>\n", index, words[below(corpus, CORPUS_WORDS)]);
+
+    block(corpus, 1, 0);
+
+    if (kind == FUNCTION_TEXT)
+    {
+        emit(corpus, "  <return>t%d + \" \" + s%d + a%d</return>\n", index, index, index);
+    }
+    else
+    {
+        emit(corpus, "  <return>");
+        intExpression(corpus);
+        emit(corpus, "</return>\n");
+    }
+    emit(corpus, "</function>\n\n");
+
+    if (corpus->count == corpus->capacity)
+    {
+        corpus->capacity = corpus->capacity ? corpus->capacity * 2 : 64;
+        corpus->kinds = realloc(corpus->kinds, sizeof(FunctionKind) * corpus->capacity);
+    }
+    corpus->kinds[corpus->count++] = kind;
+}
+
+// A main chama cada função uma vez e imprime o resultado
+static void mainFunction(Corpus *corpus)
+{
+    corpus->inMain = 1;
+    emit(corpus, "<function name='main' return='void'>\n"
+                 "  <var type='int'>r</var>\n"
+                 "  <var type='string'>m</var>\n");
+    for (int i = 0; i < corpus->count; i++)
+    {
+        if (corpus->kinds[i] == FUNCTION_TEXT)
+        {
+            emit(corpus, "  <assign var='m'>");
+            textCall(corpus, i);
+            emit(corpus, "</assign>\n  <print>m</print>\n");
+        }
+        else
+        {
+            emit(corpus, "  <assign var='r'>");
+            intCall(corpus, i);
+            emit(corpus, "</assign>\n  <print>r</print>\n");
+        }
+    }
+    emit(corpus, "</function>\n");
+    corpus->inMain = 0;
+}
+
+void corpusDefaults(CorpusOptions *options)
+{
+    options->functions = 20;
+    options->depth = 2;
+    options->terms = 4;
+    options->stringDensity = 20;
+    options->bytes = 0;
+    options->seed = 1;
+}
+
+size_t corpusGenerate(FILE *out, const CorpusOptions *options)
+{
+    Corpus corpus;
+    memset(&corpus, 0, sizeof(corpus));
+    corpus.out = out;
+    corpus.options = options;
+    corpus.state = 0x9E3779B97F4A7C15ULL ^ options->seed;
+    if (corpus.state == 0)
+    {
+        corpus.state = 1;
+    }
+
+    // Duas folhas para cada função que chama; parte das folhas trabalha com strings
+    for (int i = 0; options->bytes > 0 ? corpus.written < options->bytes : i < options->functions; i++)
+    {
+        FunctionKind kind = FUNCTION_CALLER;
+        if (i % 3 != 2)
+        {
+            kind = below(&corpus, 100) < options->stringDensity ? FUNCTION_TEXT : FUNCTION_LEAF;
+        }
+        function(&corpus, kind);
+    }
+    mainFunction(&corpus);
+
+    free(corpus.kinds);
+    return corpus.written;
+}
+
+size_t corpusParseSize(const char *text)
+{
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value < 0)
+    {
+        return 0;
+    }
+    switch (*end)
+    {
+    case 'k':
+    case 'K':
+        value *= 1024;
+        end++;
+        break;
+    case 'm':
+    case 'M':
+        value *= 1024 * 1024;
+        end++;
+        break;
+    case 'g':
+    case 'G':
+        value *= 1024.0 * 1024 * 1024;
+        end++;
+        break;
+    }
+    return *end == '\0' ? (size_t)value : 0;
+}
@@ -0,0 +1,31 @@
+#ifndef PHTML_CORPUS_H
+#define PHTML_CORPUS_H
+
+#include <stdio.h>
+
+// Gerador de programas PHTML sintéticos (usado por gerador.c e parse.c)
+//
+// Os programas são válidos e bem tipados e sempre terminam: os laços contam até
+// 3, as funções só chamam funções "folha" (que não chamam outras) e toda conta
+// com inteiros é dividida no fim, então os valores não estouram. A mesma semente
+// gera sempre o mesmo programa.
+
+typedef struct
+{
+    int functions;     // funções além da main (ignorado quando 'bytes' > 0)
+    int depth;         // profundidade máxima de <if> e <while> aninhados
+    int terms;         // termos em cada expressão
+    int stringDensity; // porcentagem dos comandos que trabalham com strings (0 a 100)
+    size_t bytes;      // tamanho mínimo do programa; as funções são geradas até alcançá-lo
+    unsigned seed;
+} CorpusOptions;
+
+void corpusDefaults(CorpusOptions *options);
+
+// Escreve o programa em 'out' e retorna a quantidade de bytes
+size_t corpusGenerate(FILE *out, const CorpusOptions *options);
+
+// Lê tamanhos como 512, 64K, 10M ou 1G; retorna 0 se o texto não for um tamanho
+size_t corpusParseSize(const char *text);
+
+#endif
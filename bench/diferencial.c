@@ -0,0 +1,508 @@
+// Teste diferencial dos modos de execução
+//
+//     phtml-diff [-p ./phtml] [-c cc] [-g programas] [-r semente] [-n repetições] [-t segundos] [-j saida.json] [arquivos...]
+//     phtml-diff exemplos/*.phtml bench/*.phtml
+//     phtml-diff -g 200 -r 1000
+//
+// Cada arquivo e cada programa gerado (ver corpus.h; -g programas, 20 se não
+// informado, com sementes a partir de -r) é executado pelo interpretador de
+// árvore, a referência, e pelos outros modos: -O, --jit, -O --jit e --emit-c
+// (compilado com o compilador de -c; "-c -" pula esse modo). O JIT compila cada
+// função já na primeira chamada (--jit-threshold=1), para que o corpo de todas
+// passe pelo código nativo.
+//
+// A saída padrão de cada modo é comparada byte a byte com a da referência; um
+// modo que termina por sinal ou estoura o tempo (-t) também diverge. Para cada
+// programa é impresso o tempo da referência (mediana de -n execuções) e a
+// aceleração de cada modo (tempo da referência / tempo do modo, com o processo
+// inteiro, incluindo a montagem da gramática); no fim, a média geométrica das
+// acelerações e as divergências de cada modo. Os programas gerados que divergem
+// são guardados em divergente-SEMENTE.phtml, no diretório atual.
+//
+// Se o interpretador de -p não puder ser executado, nada é comparado e o código
+// de saída é 1. Um programa em que a própria referência termina por sinal ou
+// estoura o tempo conta como divergência de todos os modos; o código de saída é
+// 1 se houve alguma divergência.
+//
+//     gcc -O2 -o phtml-diff bench/diferencial.c bench/corpus.c bench/medida.c -lm
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "medida.h"
+
+// Modo de execução comparado com a referência
+typedef struct
+{
+    const char *name;
+    const char *flags[4];
+    int emitted; // o programa é traduzido com --emit-c, compilado e executado
+
+    // Totais de todos os programas
+    double logSpeedup;
+    int compared;
+    int divergences;
+} Engine;
+
+static Engine engines[] = {
+    {"árvore", {NULL}, 0, 0, 0, 0},
+    {"-O", {"-O", NULL}, 0, 0, 0, 0},
+    {"--jit", {"--jit-threshold=1", NULL}, 0, 0, 0, 0},
+    {"-O --jit", {"-O", "--jit-threshold=1", NULL}, 0, 0, 0, 0},
+    {"--emit-c", {"--emit-c", NULL}, 1, 0, 0, 0},
+};
+
+#define ENGINE_COUNT (int)(sizeof(engines) / sizeof(engines[0]))
+
+// Resultado de uma execução
+typedef struct
+{
+    char *output;
+    size_t length;
+    double milliseconds;
+    int ok; // terminou com exit (qualquer código), sem sinal nem tempo esgotado
+} Run;
+
+static const char *phtml = "./phtml";
+static const char *compiler = "cc";
+static int iterations = 1;
+static int timeLimit = 60;
+
+// Executa 'command' guardando a saída padrão; a saída de erro é descartada
+static Run runCommand(char **command)
+{
+    Run run = {NULL, 0, 0, 0};
+    int pipes[2];
+    if (pipe(pipes) != 0)
+    {
+        return run;
+    }
+    double start = measureNow();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(pipes[0]);
+        close(pipes[1]);
+        return run;
+    }
+    if (pid == 0)
+    {
+        close(pipes[0]);
+        dup2(pipes[1], STDOUT_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDERR_FILENO);
+        // O alarme continua valendo depois do exec e encerra um programa que não termina
+        alarm(timeLimit);
+        execvp(command[0], command);
+        _exit(127);
+    }
+    close(pipes[1]);
+
+    size_t capacity = 4096;
+    run.output = malloc(capacity);
+    for (;;)
+    {
+        if (run.length == capacity)
+        {
+            capacity *= 2;
+            run.output = realloc(run.output, capacity);
+        }
+        ssize_t count = read(pipes[0], run.output + run.length, capacity - run.length);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        run.length += count;
+    }
+    close(pipes[0]);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    run.milliseconds = (measureNow() - start) * 1e3;
+    run.ok = WIFEXITED(status) && WEXITSTATUS(status) != 127;
+    return run;
+}
+
+// Executa 'iterations' vezes; a saída é a da primeira e o tempo é a mediana
+static Run runRepeated(char **command)
+{
+    Run first = runCommand(command);
+    if (!first.ok || iterations == 1)
+    {
+        return first;
+    }
+    double *times = malloc(sizeof(double) * iterations);
+    times[0] = first.milliseconds;
+    for (int i = 1; i < iterations; i++)
+    {
+        Run run = runCommand(command);
+        times[i] = run.milliseconds;
+        free(run.output);
+    }
+    first.milliseconds = measureMedian(times, iterations);
+    free(times);
+    return first;
+}
+
+static int writeFile(const char *path, const char *data, size_t length)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return 0;
+    }
+    int ok = fwrite(data, 1, length, file) == length;
+    return fclose(file) == 0 && ok;
+}
+
+// Executa 'file' em um modo; com --emit-c, traduz, compila e executa o binário
+static Run runEngine(const Engine *engine, const char *file)
+{
+    char *command[8];
+    int count = 0;
+    command[count++] = (char *)phtml;
+    for (int i = 0; engine->flags[i]; i++)
+    {
+        command[count++] = (char *)engine->flags[i];
+    }
+    command[count++] = (char *)file;
+    command[count] = NULL;
+    if (!engine->emitted)
+    {
+        return runRepeated(command);
+    }
+
+    Run failed = {NULL, 0, 0, 0};
+    Run source = runCommand(command);
+    char sourcePath[] = "/tmp/phtml-diff-XXXXXX.c";
+    int descriptor = mkstemps(sourcePath, 2);
+    if (!source.ok || descriptor < 0)
+    {
+        free(source.output);
+        return failed;
+    }
+    close(descriptor);
+    int written = writeFile(sourcePath, source.output, source.length);
+    free(source.output);
+
+    char binaryPath[sizeof(sourcePath)];
+    snprintf(binaryPath, sizeof(binaryPath), "%s", sourcePath);
+    binaryPath[strlen(binaryPath) - 2] = '\0';
+    char *compile[] = {(char *)compiler, "-O2", "-w", "-o", binaryPath, sourcePath, "-lm", NULL};
+    Run build = written ? runCommand(compile) : failed;
+    free(build.output);
+    unlink(sourcePath);
+    if (!build.ok || access(binaryPath, X_OK) != 0)
+    {
+        unlink(binaryPath);
+        return failed;
+    }
+    char *binary[] = {binaryPath, NULL};
+    Run run = runRepeated(binary);
+    unlink(binaryPath);
+    return run;
+}
+
+// Primeira linha em que as saídas diferem, para a mensagem de divergência
+static void describeDifference(const char *name, const Engine *engine, const Run *expected, const Run *actual)
+{
+    if (!actual->ok)
+    {
+        fprintf(stderr, "%s: %s não terminou normalmente (sinal, tempo esgotado ou erro de compilação)\n",
+                name, engine->name);
+        return;
+    }
+    size_t offset = 0;
+    size_t line = 1;
+    size_t lineStart = 0;
+    while (offset < expected->length && offset < actual->length &&
+           expected->output[offset] == actual->output[offset])
+    {
+        if (expected->output[offset] == '\n')
+        {
+            line++;
+            lineStart = offset + 1;
+        }
+        offset++;
+    }
+    fprintf(stderr, "%s: %s difere na linha %zu (byte %zu)\n", name, engine->name, line, offset);
+    const Run *runs[] = {expected, actual};
+    const char *labels[] = {"esperado", "obtido"};
+    for (int i = 0; i < 2; i++)
+    {
+        size_t end = lineStart;
+        while (end < runs[i]->length && runs[i]->output[end] != '\n' && end - lineStart < 100)
+        {
+            end++;
+        }
+        fprintf(stderr, "  %-8s %.*s%s\n", labels[i], (int)(end - lineStart), runs[i]->output + lineStart,
+                end >= runs[i]->length ? " (fim da saída)" : "");
+    }
+}
+
+static void writeString(FILE *out, const char *text)
+{
+    fputc('"', out);
+    for (; *text; text++)
+    {
+        if (*text == '"' || *text == '\\')
+        {
+            fputc('\\', out);
+        }
+        fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+// Compara um programa em todos os modos; retorna a quantidade de divergências
+static int compareProgram(const char *name, const char *file, FILE *json, int *first)
+{
+    Run reference = runEngine(&engines[0], file);
+    if (!reference.ok)
+    {
+        // Sem referência não há o que comparar; todos os modos divergem
+        fprintf(stderr, "%s: a referência não terminou normalmente (sinal ou tempo esgotado)\n", name);
+        printf("%-24s %10s\n", name, "erro");
+        int divergences = 0;
+        for (int i = 1; i < ENGINE_COUNT; i++)
+        {
+            if (!engines[i].emitted || strcmp(compiler, "-") != 0)
+            {
+                engines[i].divergences++;
+                divergences++;
+            }
+        }
+        free(reference.output);
+        return divergences;
+    }
+    printf("%-24s %10.2f", name, reference.milliseconds);
+    if (json)
+    {
+        fprintf(json, "%s\n    {\"name\": ", *first ? "" : ",");
+        writeString(json, name);
+        fprintf(json, ", \"referenceMs\": %.3f, \"engines\": [", reference.milliseconds);
+        *first = 0;
+    }
+
+    int divergences = 0;
+    for (int i = 1; i < ENGINE_COUNT; i++)
+    {
+        Engine *engine = &engines[i];
+        if (engine->emitted && strcmp(compiler, "-") == 0)
+        {
+            printf(" %10s", "-");
+            continue;
+        }
+        Run run = runEngine(engine, file);
+        int same = run.ok && run.length == reference.length &&
+                   memcmp(run.output, reference.output, run.length) == 0;
+        if (same)
+        {
+            double speedup = reference.milliseconds / run.milliseconds;
+            engine->logSpeedup += log(speedup);
+            engine->compared++;
+            printf(" %9.2fx", speedup);
+        }
+        else
+        {
+            engine->divergences++;
+            divergences++;
+            printf(" %10s", "DIFERE");
+            describeDifference(name, engine, &reference, &run);
+        }
+        if (json)
+        {
+            fprintf(json, "%s{\"engine\": ", i > 1 ? ", " : "");
+            writeString(json, engine->name);
+            fprintf(json, ", \"same\": %s, \"ms\": %.3f}", same ? "true" : "false", run.milliseconds);
+        }
+        free(run.output);
+    }
+    printf("\n");
+    fflush(stdout);
+    if (json)
+    {
+        fprintf(json, "]}");
+    }
+    free(reference.output);
+    return divergences;
+}
+
+// Opções do gerador variadas pela semente, para cobrir formatos diferentes
+static void generatedOptions(CorpusOptions *options, unsigned seed)
+{
+    corpusDefaults(options);
+    options->seed = seed;
+    options->functions = 5 + seed % 20;
+    options->depth = 1 + seed % 3;
+    options->terms = 2 + seed % 5;
+    options->stringDensity = (seed * 13) % 60;
+}
+
+int main(int argc, char **argv)
+{
+    int generated = 20;
+    unsigned seed = 1;
+    const char *jsonPath = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:c:g:r:n:t:j:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            phtml = optarg;
+            break;
+        case 'c':
+            compiler = optarg;
+            break;
+        case 'g':
+            generated = atoi(optarg);
+            break;
+        case 'r':
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 't':
+            timeLimit = atoi(optarg);
+            break;
+        case 'j':
+            jsonPath = optarg;
+            break;
+        default:
+            generated = -1;
+        }
+    }
+    if (generated < 0 || iterations < 1 || timeLimit < 1)
+    {
+        fprintf(stderr, "Uso: %s [-p ./phtml] [-c cc] [-g programas] [-r semente] [-n repetições] [-t segundos] [-j saida.json] [arquivos...]\n",
+                argv[0]);
+        return 2;
+    }
+
+    // Sem o interpretador, toda referência falharia; melhor parar aqui
+    char *probe[] = {(char *)phtml, NULL};
+    Run probeRun = runCommand(probe);
+    free(probeRun.output);
+    if (!probeRun.ok)
+    {
+        fprintf(stderr, "Erro: não foi possível executar '%s'\n", phtml);
+        return 1;
+    }
+
+    FILE *json = NULL;
+    if (jsonPath)
+    {
+        json = fopen(jsonPath, "w");
+        if (!json)
+        {
+            fprintf(stderr, "Erro: não foi possível criar '%s': %s\n", jsonPath, strerror(errno));
+            return 1;
+        }
+        fprintf(json, "{\n  \"phtml\": ");
+        writeString(json, phtml);
+        fprintf(json, ",\n  \"iterations\": %d,\n  \"programs\": [", iterations);
+    }
+
+    printf("%-25s %10s", "programa", "árvore ms");
+    for (int i = 1; i < ENGINE_COUNT; i++)
+    {
+        printf(" %10s", engines[i].name);
+    }
+    printf("\n");
+
+    int divergences = 0;
+    int first = 1;
+    for (int i = optind; i < argc; i++)
+    {
+        divergences += compareProgram(argv[i], argv[i], json, &first) > 0;
+    }
+
+    char path[] = "/tmp/phtml-diff-XXXXXX.phtml";
+    int descriptor = mkstemps(path, 6);
+    if (descriptor < 0)
+    {
+        fprintf(stderr, "Erro: não foi possível criar o arquivo temporário: %s\n", strerror(errno));
+        return 1;
+    }
+    close(descriptor);
+    for (int i = 0; i < generated; i++)
+    {
+        CorpusOptions options;
+        generatedOptions(&options, seed + i);
+        FILE *out = fopen(path, "w");
+        corpusGenerate(out, &options);
+        fclose(out);
+
+        char name[64];
+        snprintf(name, sizeof(name), "gerado %u", options.seed);
+        if (compareProgram(name, path, json, &first) > 0)
+        {
+            divergences++;
+            char copy[64];
+            snprintf(copy, sizeof(copy), "divergente-%u.phtml", options.seed);
+            if (rename(path, copy) != 0)
+            {
+                fprintf(stderr, "Erro: não foi possível guardar '%s': %s\n", copy, strerror(errno));
+            }
+            fprintf(stderr, "  programa guardado em %s\n", copy);
+        }
+    }
+    unlink(path);
+
+    printf("\n%-25s %10s", "média geométrica", "");
+    for (int i = 1; i < ENGINE_COUNT; i++)
+    {
+        if (engines[i].compared > 0)
+        {
+            printf(" %9.2fx", exp(engines[i].logSpeedup / engines[i].compared));
+        }
+        else
+        {
+            printf(" %10s", "-");
+        }
+    }
+    printf("\n%-25s %10s", "divergências", "");
+    for (int i = 1; i < ENGINE_COUNT; i++)
+    {
+        printf(" %10d", engines[i].divergences);
+    }
+    printf("\n");
+
+    if (json)
+    {
+        fprintf(json, "\n  ],\n  \"summary\": [");
+        for (int i = 1; i < ENGINE_COUNT; i++)
+        {
+            fprintf(json, "%s\n    {\"engine\": ", i > 1 ? "," : "");
+            writeString(json, engines[i].name);
+            fprintf(json, ", \"geometricMeanSpeedup\": ");
+            if (engines[i].compared > 0)
+            {
+                fprintf(json, "%.4f", exp(engines[i].logSpeedup / engines[i].compared));
+            }
+            else
+            {
+                fprintf(json, "null");
+            }
+            fprintf(json, ", \"divergences\": %d}", engines[i].divergences);
+        }
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+    }
+    return divergences ? 1 : 0;
+}
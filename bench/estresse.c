@@ -0,0 +1,210 @@
+// Teste de estresse da biblioteca com várias threads (libphtml.h)
+//
+//     phtml-stress [-t threads] [-n execuções] [-g programas] [-r semente] [arquivos...]
+//     phtml-stress exemplos/*.phtml
+//     phtml-stress -t 16 -n 20000 -g 50
+//
+// Cada arquivo e cada programa gerado (ver corpus.h; -g programas, 20 se não
+// informado, com sementes a partir de -r) é compilado uma vez. A main de cada
+// um é executada em uma thread só, e a saída e o status dessa execução são a
+// referência. Depois -t threads (padrão: uma por processador) fazem juntas -n
+// execuções (padrão: 200 por programa), usando os mesmos programas compilados;
+// a thread t começa pelo programa t e segue pela lista, então as threads rodam
+// programas diferentes e também o mesmo programa ao mesmo tempo.
+//
+// Toda saída é comparada byte a byte com a da referência. No fim são impressas
+// as execuções por segundo da referência e das threads, a aceleração e as
+// divergências; o código de saída é 1 se alguma execução divergiu.
+//
+//     gcc -O2 -o phtml-stress bench/estresse.c bench/corpus.c bench/medida.c libphtml.c phtml.c mpc.c grammar.c error.c jit.c emitc.c ir.c opt.c output.c format.c array.c simd.c map.c builtin.c profile.c stats.c trace.c alloc.c budget.c -lm -lpthread
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "medida.h"
+#include "../libphtml.h"
+
+// Programa compilado e a sua execução de referência
+typedef struct
+{
+    char name[64];
+    PhtmlProgram *program;
+    PhtmlStatus status;
+    char *output;
+    size_t length;
+} Script;
+
+typedef struct
+{
+    Script *scripts;
+    int count;
+    int runs;      // execuções feitas pelas threads juntas
+    int nextRun;   // próxima execução a ser feita (atômico)
+    int divergent; // execuções que diferem da referência (atômico)
+} Stress;
+
+typedef struct
+{
+    Stress *stress;
+    int index;
+} Worker;
+
+// Opções do gerador variadas pela semente, como no phtml-diff
+static void generatedOptions(CorpusOptions *options, unsigned seed)
+{
+    corpusDefaults(options);
+    options->seed = seed;
+    options->functions = 5 + seed % 20;
+    options->depth = 1 + seed % 3;
+    options->terms = 2 + seed % 5;
+    options->stringDensity = (seed * 13) % 60;
+}
+
+static void *runWorker(void *argument)
+{
+    Worker *worker = argument;
+    Stress *stress = worker->stress;
+    char *output = NULL;
+    size_t capacity = 0;
+    size_t length;
+    int position = worker->index;
+    while (__atomic_fetch_add(&stress->nextRun, 1, __ATOMIC_RELAXED) < stress->runs)
+    {
+        Script *script = &stress->scripts[position++ % stress->count];
+        PhtmlStatus status = phtmlRunBuffered(script->program, "main", NULL, 0, &output, &capacity, &length, NULL);
+        if (status != script->status || length != script->length || memcmp(output, script->output, length) != 0)
+        {
+            if (__atomic_fetch_add(&stress->divergent, 1, __ATOMIC_RELAXED) == 0)
+            {
+                fprintf(stderr, "%s: a thread %d obteve %s e %zu bytes; a referência, %s e %zu bytes\n",
+                        script->name, worker->index, phtmlStatusString(status), length,
+                        phtmlStatusString(script->status), script->length);
+            }
+        }
+    }
+    free(output);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int runs = 0;
+    int generated = 20;
+    unsigned seed = 1;
+    int opt;
+    int invalid = 0;
+    while ((opt = getopt(argc, argv, "t:n:g:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            threads = atoi(optarg);
+            break;
+        case 'n':
+            runs = atoi(optarg);
+            break;
+        case 'g':
+            generated = atoi(optarg);
+            break;
+        case 'r':
+            seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            invalid = 1;
+        }
+    }
+    int count = argc - optind + generated;
+    if (invalid || threads < 1 || runs < 0 || generated < 0 || count == 0)
+    {
+        fprintf(stderr, "Uso: %s [-t threads] [-n execuções] [-g programas] [-r semente] [arquivos...]\n", argv[0]);
+        return 2;
+    }
+
+    PhtmlRuntime *runtime = phtmlCreateRuntime();
+    Script *scripts = calloc(count, sizeof(Script));
+    for (int i = 0; i < count; i++)
+    {
+        Script *script = &scripts[i];
+        PhtmlStatus status;
+        if (optind + i < argc)
+        {
+            snprintf(script->name, sizeof(script->name), "%s", argv[optind + i]);
+            status = phtmlCompileFile(runtime, argv[optind + i], &script->program);
+        }
+        else
+        {
+            CorpusOptions options;
+            generatedOptions(&options, seed + (unsigned)(i - (argc - optind)));
+            char *source;
+            size_t size;
+            FILE *out = open_memstream(&source, &size);
+            corpusGenerate(out, &options);
+            fclose(out);
+            snprintf(script->name, sizeof(script->name), "gerado %u", options.seed);
+            status = phtmlCompile(runtime, script->name, source, &script->program);
+            free(source);
+        }
+        if (status != PHTML_OK)
+        {
+            fprintf(stderr, "%s: %s\n", script->name, phtmlError(runtime));
+            return 2;
+        }
+    }
+
+    // Referência: cada programa uma vez, em uma thread só; o tempo por execução
+    // vem de uma volta completa pela lista depois dessa
+    for (int i = 0; i < count; i++)
+    {
+        size_t capacity = 0;
+        scripts[i].status = phtmlRunBuffered(scripts[i].program, "main", NULL, 0, &scripts[i].output, &capacity,
+                                             &scripts[i].length, NULL);
+    }
+    char *output = NULL;
+    size_t capacity = 0;
+    size_t length;
+    double start = measureNow();
+    for (int i = 0; i < count; i++)
+    {
+        phtmlRunBuffered(scripts[i].program, "main", NULL, 0, &output, &capacity, &length, NULL);
+    }
+    double single = (measureNow() - start) / count;
+    free(output);
+
+    Stress stress = {scripts, count, runs > 0 ? runs : 200 * count, 0, 0};
+    pthread_t *ids = malloc(sizeof(pthread_t) * threads);
+    Worker *workers = malloc(sizeof(Worker) * threads);
+    start = measureNow();
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].stress = &stress;
+        workers[i].index = i;
+        pthread_create(&ids[i], NULL, runWorker, &workers[i]);
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = measureNow() - start;
+
+    printf("%d programas, %d execuções em %d threads\n", count, stress.runs, threads);
+    printf("%-24s %12.0f execuções/s\n", "referência (1 thread)", 1 / single);
+    printf("%-24s %12.0f execuções/s\n", "threads", stress.runs / elapsed);
+    printf("%-24s %11.1fx\n", "aceleração", stress.runs / elapsed * single);
+    printf("divergências: %d\n", stress.divergent);
+
+    for (int i = 0; i < count; i++)
+    {
+        phtmlDestroyProgram(scripts[i].program);
+        free(scripts[i].output);
+    }
+    free(scripts);
+    free(ids);
+    free(workers);
+    phtmlDestroyRuntime(runtime);
+    return stress.divergent > 0 ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+// Gerador de programas PHTML sintéticos (ver corpus.h)
+//
+//     phtml-gen [-f funções] [-d profundidade] [-e termos] [-s densidade] [-b tamanho] [-r semente]
+//     phtml-gen -b 10M -e 8 > grande.phtml
+//
+// O programa vai para a saída padrão. Com -b, são geradas funções até o arquivo
+// ter pelo menos esse tamanho (512, 64K, 10M...) e -f é ignorado.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "corpus.h"
+
+int main(int argc, char **argv)
+{
+    CorpusOptions options;
+    corpusDefaults(&options);
+    int opt;
+    int invalid = 0;
+    while ((opt = getopt(argc, argv, "f:d:e:s:b:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            options.functions = atoi(optarg);
+            break;
+        case 'd':
+            options.depth = atoi(optarg);
+            break;
+        case 'e':
+            options.terms = atoi(optarg);
+            break;
+        case 's':
+            options.stringDensity = atoi(optarg);
+            break;
+        case 'b':
+            options.bytes = corpusParseSize(optarg);
+            invalid |= options.bytes == 0;
+            break;
+        case 'r':
+            options.seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            invalid = 1;
+        }
+    }
+    if (invalid || optind != argc || options.functions < 0 || options.depth < 0 || options.terms < 1)
+    {
+        fprintf(stderr, "Uso: %s [-f funções] [-d profundidade] [-e termos] [-s densidade] [-b tamanho] [-r semente]\n",
+                argv[0]);
+        return 2;
+    }
+    corpusGenerate(stdout, &options);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include <stdlib.h>
+#include <time.h>
+#include "medida.h"
+
+double measureNow(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+int measureCompareDoubles(const void *a, const void *b)
+{
+    double left = *(const double *)a;
+    double right = *(const double *)b;
+    return (left > right) - (left < right);
+}
+
+double measureMedian(double *values, int count)
+{
+    qsort(values, count, sizeof(double), measureCompareDoubles);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
@@ -0,0 +1,15 @@
+#ifndef PHTML_MEDIDA_H
+#define PHTML_MEDIDA_H
+
+// Medição de tempo comum às ferramentas de bench/ e ao phtml-load
+
+// Relógio monotônico, em segundos
+double measureNow(void);
+
+// Comparação de doubles para o qsort (ordem crescente)
+int measureCompareDoubles(const void *a, const void *b);
+
+// Ordena 'values' e retorna a mediana (a média dos dois do meio quando 'count' é par)
+double measureMedian(double *values, int count);
+
+#endif
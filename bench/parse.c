@@ -0,0 +1,265 @@
+// Benchmark do parser: só a gramática e mpc_parse_contents, sem executar nada
+//
+//     phtml-parse [-n repetições] [-m tamanho máximo] [-f -d -e -s -r (ver gerador.c)] [arquivos...]
+//     phtml-parse -m 100M -e 8
+//     phtml-parse exemplos/*.phtml
+//
+// Primeiro mede a montagem da gramática (mpca_lang), que todo programa paga uma
+// vez. Depois, sem arquivos, gera programas sintéticos (ver corpus.h) de 1K,
+// 10K, 100K... até o tamanho máximo (1M se -m não for usado), grava cada um em
+// um arquivo temporário e o analisa com mpc_parse_contents, como o interpretador
+// faz; com arquivos, analisa esses arquivos. Para cada entrada são impressos a
+// mediana do tempo, a vazão em MB/s e as alocações (quantidade e bytes) por KB
+// de entrada. O mpc analisa algo como 0,2 MB/s, então -m 100M leva horas e
+// precisa de vários GB para a AST.
+//
+// As alocações são contadas trocando malloc, calloc, realloc e free na ligação:
+//
+//     gcc -O2 -o phtml-parse bench/parse.c bench/corpus.c bench/medida.c grammar.c mpc.c -lm -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "medida.h"
+#include "../grammar.h"
+#include "../mpc.h"
+
+// Uma repetição a mais só é feita se o total ainda estiver abaixo deste tempo,
+// para que as entradas grandes não demorem minutos
+#define PARSE_TIME_BUDGET 2.0
+
+// Contadores das alocações (ver __wrap_malloc)
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void __real_free(void *pointer);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    allocatedBytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocations++;
+    allocatedBytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    allocations++;
+    allocatedBytes += size;
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void *pointer)
+{
+    __real_free(pointer);
+}
+
+typedef struct
+{
+    double seconds;     // mediana
+    double allocations; // por análise
+    double bytes;       // alocados por análise
+    int ok;
+} ParseResult;
+
+// Analisa 'path' até 'iterations' vezes; só o mpc_parse_contents é medido,
+// a liberação da AST fica fora do tempo e das alocações
+static ParseResult parseFile(Grammar *grammar, const char *path, int iterations)
+{
+    ParseResult result = {0, 0, 0, 1};
+    double *times = malloc(sizeof(double) * iterations);
+    size_t totalAllocations = 0;
+    size_t totalBytes = 0;
+    double total = 0;
+    int runs = 0;
+    while (runs < iterations && (runs == 0 || total < PARSE_TIME_BUDGET))
+    {
+        mpc_result_t r;
+        size_t beforeAllocations = allocations;
+        size_t beforeBytes = allocatedBytes;
+        double start = measureNow();
+        int parsed = mpc_parse_contents(path, grammar->code, &r);
+        double elapsed = measureNow() - start;
+        totalAllocations += allocations - beforeAllocations;
+        totalBytes += allocatedBytes - beforeBytes;
+        if (!parsed)
+        {
+            mpc_err_print(r.error);
+            mpc_err_delete(r.error);
+            result.ok = 0;
+            break;
+        }
+        mpc_ast_delete((mpc_ast_t *)r.output);
+        times[runs++] = elapsed;
+        total += elapsed;
+    }
+    if (runs > 0)
+    {
+        result.seconds = measureMedian(times, runs);
+        result.allocations = (double)totalAllocations / runs;
+        result.bytes = (double)totalBytes / runs;
+    }
+    free(times);
+    return result;
+}
+
+static long fileSize(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static void printSize(char *text, size_t length, double bytes)
+{
+    if (bytes >= 1024 * 1024)
+    {
+        snprintf(text, length, "%.1fM", bytes / (1024 * 1024));
+    }
+    else if (bytes >= 1024)
+    {
+        snprintf(text, length, "%.1fK", bytes / 1024);
+    }
+    else
+    {
+        snprintf(text, length, "%.0f", bytes);
+    }
+}
+
+static int report(const char *name, double bytes, ParseResult result)
+{
+    char size[32];
+    printSize(size, sizeof(size), bytes);
+    if (!result.ok)
+    {
+        printf("%-24s %8s  (erro de sintaxe)\n", name, size);
+        return 0;
+    }
+    double kilobytes = bytes / 1024;
+    printf("%-24s %8s %12.3f %10.2f %12.1f %12.0f\n", name, size, result.seconds * 1e3,
+           bytes / (1024 * 1024) / result.seconds, result.allocations / kilobytes, result.bytes / kilobytes);
+    fflush(stdout);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    CorpusOptions options;
+    corpusDefaults(&options);
+    int iterations = 5;
+    size_t maximum = 1024 * 1024;
+    int invalid = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:m:f:d:e:s:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 'm':
+            maximum = corpusParseSize(optarg);
+            invalid |= maximum == 0;
+            break;
+        case 'f':
+            options.functions = atoi(optarg);
+            break;
+        case 'd':
+            options.depth = atoi(optarg);
+            break;
+        case 'e':
+            options.terms = atoi(optarg);
+            break;
+        case 's':
+            options.stringDensity = atoi(optarg);
+            break;
+        case 'r':
+            options.seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            invalid = 1;
+        }
+    }
+    if (invalid || iterations < 1 || options.depth < 0 || options.terms < 1)
+    {
+        fprintf(stderr, "Uso: %s [-n repetições] [-m tamanho máximo] [-f funções] [-d profundidade] [-e termos] [-s densidade] [-r semente] [arquivos...]\n",
+                argv[0]);
+        return 2;
+    }
+
+    // A gramática é montada uma vez, como no interpretador
+    size_t beforeAllocations = allocations;
+    double start = measureNow();
+    Grammar *grammar = grammarCreate();
+    double grammarTime = measureNow() - start;
+    printf("gramática: %.3f ms, %zu alocações\n\n", grammarTime * 1e3, allocations - beforeAllocations);
+
+    printf("%-24s %8s %12s %10s %13s %12s\n", "entrada", "tamanho", "mediana ms", "MB/s", "alocações/KB", "bytes/KB");
+    int failures = 0;
+    if (optind < argc)
+    {
+        for (int i = optind; i < argc; i++)
+        {
+            long size = fileSize(argv[i]);
+            if (size <= 0)
+            {
+                fprintf(stderr, "Erro: não foi possível ler '%s'\n", argv[i]);
+                failures++;
+                continue;
+            }
+            failures += !report(argv[i], size, parseFile(grammar, argv[i], iterations));
+        }
+    }
+    else
+    {
+        char path[] = "/tmp/phtml-parse-XXXXXX";
+        int descriptor = mkstemp(path);
+        if (descriptor < 0)
+        {
+            fprintf(stderr, "Erro: não foi possível criar o arquivo temporário: %s\n", strerror(errno));
+            return 1;
+        }
+        close(descriptor);
+        for (size_t target = 1024; target <= maximum; target *= 10)
+        {
+            FILE *out = fopen(path, "w");
+            options.bytes = target;
+            size_t written = corpusGenerate(out, &options);
+            fclose(out);
+
+            char name[32];
+            if (target >= 1024 * 1024)
+            {
+                snprintf(name, sizeof(name), "%zuM", target / (1024 * 1024));
+            }
+            else
+            {
+                snprintf(name, sizeof(name), "%zuK", target / 1024);
+            }
+            failures += !report(name, written, parseFile(grammar, path, iterations));
+        }
+        unlink(path);
+    }
+    printf("(mediana de até %d repetições; alocações e bytes alocados por KB de entrada)\n", iterations);
+
+    grammarDestroy(grammar);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// Benchmark da recompilação incremental (phtmlRecompile, ver libphtml.h)
+//
+//     phtml-reload [-n repetições] [-f -d -e -s -r (ver gerador.c)]
+//     phtml-reload -f 10000 -d 1
+//
+// Gera um programa sintético (ver corpus.h) e o compila com phtmlCompile. Depois
+// edita a função do meio do arquivo (uma quebra de linha a mais no corpo, que
+// muda o texto sem mudar o significado) e compila a versão editada de duas
+// formas: do zero, com phtmlCompile, e a partir da original, com
+// phtmlRecompile. São impressas as medianas de -n repetições de cada uma e a
+// aceleração. A main das duas versões é executada e as saídas são comparadas; o
+// código de saída é 1 se forem diferentes.
+//
+//     gcc -O2 -o phtml-reload bench/recompila.c bench/corpus.c bench/medida.c libphtml.c phtml.c mpc.c grammar.c error.c jit.c emitc.c ir.c opt.c output.c format.c array.c simd.c map.c builtin.c profile.c stats.c trace.c alloc.c budget.c -lm -lpthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "medida.h"
+#include "../libphtml.h"
+
+// Cópia do programa com uma quebra de linha depois do cabeçalho da função do meio
+static char *editMiddleFunction(const char *source)
+{
+    int count = 0;
+    for (const char *cursor = source; (cursor = strstr(cursor, "<function name='")); cursor++)
+    {
+        count++;
+    }
+    const char *target = source;
+    for (int i = 0; i <= count / 2; i++)
+    {
+        target = strstr(i == 0 ? target : target + 1, "<function name='");
+    }
+    const char *header = strstr(target, "'>") + 2;
+
+    size_t length = strlen(source);
+    size_t prefix = (size_t)(header - source);
+    char *edited = malloc(length + 2);
+    memcpy(edited, source, prefix);
+    edited[prefix] = '\n';
+    memcpy(edited + prefix + 1, header, length - prefix + 1);
+    return edited;
+}
+
+static char *runMain(PhtmlProgram *program, PhtmlStatus *status)
+{
+    char *output = NULL;
+    size_t capacity = 0;
+    size_t length;
+    *status = phtmlRunBuffered(program, "main", NULL, 0, &output, &capacity, &length, NULL);
+    return output;
+}
+
+int main(int argc, char **argv)
+{
+    CorpusOptions options;
+    corpusDefaults(&options);
+    options.functions = 1000;
+    int repetitions = 3;
+    int opt;
+    int invalid = 0;
+    while ((opt = getopt(argc, argv, "n:f:d:e:s:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            repetitions = atoi(optarg);
+            break;
+        case 'f':
+            options.functions = atoi(optarg);
+            break;
+        case 'd':
+            options.depth = atoi(optarg);
+            break;
+        case 'e':
+            options.terms = atoi(optarg);
+            break;
+        case 's':
+            options.stringDensity = atoi(optarg);
+            break;
+        case 'r':
+            options.seed = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            invalid = 1;
+        }
+    }
+    if (invalid || optind != argc || repetitions < 1 || options.functions < 1 || options.depth < 0 ||
+        options.terms < 1)
+    {
+        fprintf(stderr, "Uso: %s [-n repetições] [-f funções] [-d profundidade] [-e termos] [-s densidade] [-r semente]\n",
+                argv[0]);
+        return 2;
+    }
+
+    char *source;
+    size_t size;
+    FILE *out = open_memstream(&source, &size);
+    corpusGenerate(out, &options);
+    fclose(out);
+    char *edited = editMiddleFunction(source);
+
+    PhtmlRuntime *runtime = phtmlCreateRuntime();
+    PhtmlProgram *original;
+    double start = measureNow();
+    if (phtmlCompile(runtime, "original.phtml", source, &original) != PHTML_OK)
+    {
+        fprintf(stderr, "%s\n", phtmlError(runtime));
+        return 2;
+    }
+    printf("programa: %d funções, %zu bytes; compilação inicial em %.3f ms\n", options.functions + 1, size,
+           (measureNow() - start) * 1000);
+
+    double *fullTimes = malloc(sizeof(double) * repetitions);
+    double *incrementalTimes = malloc(sizeof(double) * repetitions);
+    PhtmlProgram *full = NULL;
+    PhtmlProgram *incremental = NULL;
+    for (int i = 0; i < repetitions; i++)
+    {
+        phtmlDestroyProgram(full);
+        phtmlDestroyProgram(incremental);
+        start = measureNow();
+        PhtmlStatus fullStatus = phtmlCompile(runtime, "editado.phtml", edited, &full);
+        fullTimes[i] = measureNow() - start;
+        start = measureNow();
+        PhtmlStatus incrementalStatus = phtmlRecompile(runtime, original, "editado.phtml", edited, &incremental);
+        incrementalTimes[i] = measureNow() - start;
+        if (fullStatus != PHTML_OK || incrementalStatus != PHTML_OK)
+        {
+            fprintf(stderr, "%s\n", phtmlError(runtime));
+            return 2;
+        }
+    }
+    double fullTime = measureMedian(fullTimes, repetitions);
+    double incrementalTime = measureMedian(incrementalTimes, repetitions);
+    printf("%-28s %12.3f ms\n", "phtmlCompile (tudo)", fullTime * 1000);
+    printf("%-28s %12.3f ms\n", "phtmlRecompile (1 função)", incrementalTime * 1000);
+    printf("%-28s %11.1fx\n", "aceleração", fullTime / incrementalTime);
+
+    PhtmlStatus fullStatus;
+    PhtmlStatus incrementalStatus;
+    char *fullOutput = runMain(full, &fullStatus);
+    char *incrementalOutput = runMain(incremental, &incrementalStatus);
+    int same = fullStatus == incrementalStatus && strcmp(fullOutput, incrementalOutput) == 0;
+    printf("saída da main: %s\n", same ? "igual" : "DIFERENTE");
+
+    free(fullOutput);
+    free(incrementalOutput);
+    free(fullTimes);
+    free(incrementalTimes);
+    phtmlDestroyProgram(full);
+    phtmlDestroyProgram(incremental);
+    phtmlDestroyProgram(original);
+    phtmlDestroyRuntime(runtime);
+    free(edited);
+    free(source);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include <time.h>
+#include "alloc.h"
+#include "budget.h"
+#include "error.h"
+
+__thread int budgetActive = 0;
+__thread int budgetDepth = 0;
+__thread int budgetDepthLimit = BUDGET_DEFAULT_DEPTH;
+
+static __thread unsigned long long steps = 0;
+static __thread unsigned long long stepLimit = 0;
+static __thread long timeLimit = 0;
+static __thread struct timespec deadline;
+static __thread int exceeded = 0;
+
+void budgetStart(const Budget *budget)
+{
+    steps = 0;
+    stepLimit = budget->steps;
+    timeLimit = budget->milliseconds;
+    exceeded = 0;
+    budgetDepth = 0;
+    budgetDepthLimit = budget->depth > 0 ? budget->depth : BUDGET_DEFAULT_DEPTH;
+    if (timeLimit > 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeLimit / 1000;
+        deadline.tv_nsec += (timeLimit % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    budgetActive = stepLimit > 0 || timeLimit > 0;
+    allocLimitStart(budget->heapBytes);
+}
+
+void budgetStop(void)
+{
+    budgetActive = 0;
+    allocLimitStop();
+}
+
+// Desliga os limites antes do fail(), para que o tratamento do erro não os
+// dispare de novo
+static void stop(void)
+{
+    exceeded = 1;
+    budgetStop();
+}
+
+void budgetStep(void)
+{
+    steps++;
+    if (stepLimit > 0 && steps > stepLimit)
+    {
+        stop();
+        fail("Erro: limite de %llu passos excedido\n", stepLimit);
+    }
+    if (timeLimit > 0 && (steps & (BUDGET_CLOCK_STEPS - 1)) == 0)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))
+        {
+            stop();
+            fail("Erro: limite de tempo de %ld ms excedido\n", timeLimit);
+        }
+    }
+}
+
+// O limite de memória é conferido em alloc.c, que marca o erro por aqui
+void budgetHeapExceeded(size_t limit)
+{
+    stop();
+    fail("Erro: limite de memória de %zu bytes excedido\n", limit);
+}
+
+void budgetDepthExceeded(void)
+{
+    int limit = budgetDepthLimit;
+    stop();
+    budgetDepth = 0;
+    fail("Erro: limite de %d chamadas aninhadas excedido\n", limit);
+}
+
+int budgetExceeded(void)
+{
+    return exceeded;
+}
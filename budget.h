@@ -0,0 +1,83 @@
+#ifndef PHTML_BUDGET_H
+#define PHTML_BUDGET_H
+
+#include <stddef.h>
+
+// Limites de uma execução (--max-steps, --max-time, --max-heap, --max-depth; PhtmlLimits na
+// biblioteca)
+//
+// Um passo é uma volta de <while> ou uma chamada de função do programa. Os
+// passos são contados por BUDGET_STEP nesses dois pontos, no interpretador de
+// árvore e na IR (-O), e o relógio é consultado a cada BUDGET_CLOCK_STEPS
+// passos. A memória é a soma dos blocos vivos alocados pelas macros ALLOC_* (ver
+// alloc.h) desde budgetStart, conferida a cada alocação. Ao passar de um limite,
+// a execução termina por fail(), como qualquer outro erro: a linha de comando
+// mostra a mensagem e sai com código 1 e a biblioteca retorna
+// PHTML_ERROR_LIMIT.
+//
+// A profundidade das chamadas (--max-depth) tem limite mesmo sem os outros:
+// cada chamada do programa usa a pilha de C do interpretador, e uma recursão
+// sem fim derrubaria o processo. BUDGET_ENTER e BUDGET_LEAVE cercam a execução
+// do corpo de cada chamada no interpretador de árvore e na IR; o C gerado por
+// --emit-c tem o mesmo contador no seu runtime.
+//
+// O estado é da thread que executa. O código nativo do JIT não conta passos,
+// então a linha de comando não ativa o JIT quando há limites. Ele também não
+// faz chamadas, então não muda a profundidade.
+
+// Passos entre duas consultas ao relógio (potência de 2)
+#define BUDGET_CLOCK_STEPS 1024
+
+// Chamadas aninhadas permitidas quando o limite não é informado; cada nível usa
+// de algumas centenas de bytes a alguns KB da pilha, conforme o aninhamento dos
+// comandos, e 2000 níveis cabem com folga nos 8 MB das threads
+#define BUDGET_DEFAULT_DEPTH 2000
+
+typedef struct
+{
+    unsigned long long steps; // 0: sem limite
+    long milliseconds;        // tempo de relógio; 0: sem limite
+    size_t heapBytes;         // 0: sem limite
+    int depth;                // chamadas aninhadas; 0: BUDGET_DEFAULT_DEPTH
+} Budget;
+
+// Diferente de zero entre budgetStart e budgetStop, se algum limite foi dado
+extern __thread int budgetActive;
+
+// Chamadas em andamento e o limite delas (valem também fora de budgetStart)
+extern __thread int budgetDepth;
+extern __thread int budgetDepthLimit;
+
+#define BUDGET_ENTER()                          \
+    do                                          \
+    {                                           \
+        if (++budgetDepth > budgetDepthLimit)   \
+            budgetDepthExceeded();              \
+    } while (0)
+
+#define BUDGET_LEAVE() ((void)budgetDepth--)
+
+#define BUDGET_STEP()        \
+    do                       \
+    {                        \
+        if (budgetActive)    \
+            budgetStep();    \
+    } while (0)
+
+// Início e fim de uma execução limitada na thread atual
+void budgetStart(const Budget *budget);
+void budgetStop(void);
+
+// Conta um passo; chama fail() se o limite de passos ou o prazo passou
+void budgetStep(void);
+
+// Diferente de zero se o último fail() da thread veio de um limite
+int budgetExceeded(void);
+
+// Chamada por alloc.c quando a memória passa do limite
+void budgetHeapExceeded(size_t limit) __attribute__((noreturn));
+
+// Chamada por BUDGET_ENTER quando a profundidade passa do limite
+void budgetDepthExceeded(void) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,217 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phtml.h"
+#include "error.h"
+#include "array.h"
+#include "builtin.h"
+#include "alloc.h"
+
+static void argumentError(const char *name, int position, const char *expected, Value value)
+{
+    fail("Erro: argumento %d de '%s' deve ser %s, recebido %s\n",
+         position + 1, name, expected, getTypeString(value.type));
+}
+
+static const char *stringArgument(const char *name, const Value *args, int position)
+{
+    if (args[position].type != TYPE_STRING)
+    {
+        argumentError(name, position, "string", args[position]);
+    }
+    return args[position].value.stringValue;
+}
+
+static long long intArgument(const char *name, const Value *args, int position)
+{
+    if (args[position].type == TYPE_INT)
+    {
+        return args[position].value.intValue;
+    }
+    if (args[position].type != TYPE_LONG)
+    {
+        argumentError(name, position, "int", args[position]);
+    }
+    return args[position].value.longValue;
+}
+
+static double numberArgument(const char *name, const Value *args, int position)
+{
+    switch (args[position].type)
+    {
+    case TYPE_INT:
+        return args[position].value.intValue;
+    case TYPE_FLOAT:
+        return args[position].value.floatValue;
+    case TYPE_LONG:
+        return (double)args[position].value.longValue;
+    case TYPE_DOUBLE:
+        return args[position].value.doubleValue;
+    default:
+        argumentError(name, position, "um número", args[position]);
+        return 0;
+    }
+}
+
+static Value intResult(int value)
+{
+    Value val;
+    val.type = TYPE_INT;
+    val.value.intValue = value;
+    return val;
+}
+
+static Value doubleResult(double value)
+{
+    Value val;
+    val.type = TYPE_DOUBLE;
+    val.value.doubleValue = value;
+    return val;
+}
+
+// Strings
+
+static Value builtinLength(const Value *args)
+{
+    return valueLength(args[0]);
+}
+
+// substring(s, início, quantidade); a quantidade é limitada ao fim da string
+static Value builtinSubstring(const Value *args)
+{
+    const char *text = stringArgument("substring", args, 0);
+    long long start = intArgument("substring", args, 1);
+    long long count = intArgument("substring", args, 2);
+    long long length = (long long)strlen(text);
+    if (start < 0 || start > length || count < 0)
+    {
+        fail("Erro: substring(%lld, %lld) fora dos limites da string (tamanho %lld)\n", start, count, length);
+    }
+    if (count > length - start)
+    {
+        count = length - start;
+    }
+
+    Value val;
+    val.type = TYPE_STRING;
+    val.value.stringValue = ALLOC_STRING(count + 1);
+    memcpy(val.value.stringValue, text + start, count);
+    val.value.stringValue[count] = '\0';
+    return val;
+}
+
+// Posição da primeira ocorrência, ou -1
+static Value builtinFind(const Value *args)
+{
+    const char *text = stringArgument("find", args, 0);
+    const char *found = strstr(text, stringArgument("find", args, 1));
+    return intResult(found ? (int)(found - text) : -1);
+}
+
+static Value builtinUpper(const Value *args)
+{
+    Value val;
+    val.type = TYPE_STRING;
+    val.value.stringValue = ALLOC_STRING_COPY(stringArgument("upper", args, 0));
+    for (char *c = val.value.stringValue; *c; c++)
+    {
+        *c = (char)toupper((unsigned char)*c);
+    }
+    return val;
+}
+
+// Matemática: sqrt e pow retornam double; abs e floor mantêm o tipo do argumento
+
+static Value builtinSqrt(const Value *args)
+{
+    return doubleResult(sqrt(numberArgument("sqrt", args, 0)));
+}
+
+static Value builtinPow(const Value *args)
+{
+    return doubleResult(pow(numberArgument("pow", args, 0), numberArgument("pow", args, 1)));
+}
+
+static Value builtinAbs(const Value *args)
+{
+    Value val = args[0];
+    switch (val.type)
+    {
+    case TYPE_INT:
+        // Como nas demais operações, o estouro de -2147483648 dá a volta
+        if (val.value.intValue < 0)
+            val.value.intValue = (int)(0u - (unsigned)val.value.intValue);
+        break;
+    case TYPE_LONG:
+        if (val.value.longValue < 0)
+            val.value.longValue = (long long)(0ull - (unsigned long long)val.value.longValue);
+        break;
+    case TYPE_FLOAT:
+        val.value.floatValue = fabsf(val.value.floatValue);
+        break;
+    case TYPE_DOUBLE:
+        val.value.doubleValue = fabs(val.value.doubleValue);
+        break;
+    default:
+        argumentError("abs", 0, "um número", val);
+    }
+    return val;
+}
+
+static Value builtinFloor(const Value *args)
+{
+    Value val = args[0];
+    switch (val.type)
+    {
+    case TYPE_INT:
+    case TYPE_LONG:
+        break;
+    case TYPE_FLOAT:
+        val.value.floatValue = floorf(val.value.floatValue);
+        break;
+    case TYPE_DOUBLE:
+        val.value.doubleValue = floor(val.value.doubleValue);
+        break;
+    default:
+        argumentError("floor", 0, "um número", val);
+    }
+    return val;
+}
+
+// Ordenada por nome para a busca binária
+static const Builtin builtins[] = {
+    {"abs", 1, builtinAbs},
+    {"find", 2, builtinFind},
+    {"floor", 1, builtinFloor},
+    {"length", 1, builtinLength},
+    {"pow", 2, builtinPow},
+    {"sqrt", 1, builtinSqrt},
+    {"substring", 3, builtinSubstring},
+    {"upper", 1, builtinUpper},
+};
+
+const Builtin *findBuiltin(const char *name)
+{
+    int low = 0;
+    int high = (int)(sizeof(builtins) / sizeof(builtins[0])) - 1;
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+        int order = strcmp(name, builtins[middle].name);
+        if (order == 0)
+        {
+            return &builtins[middle];
+        }
+        if (order < 0)
+        {
+            high = middle - 1;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    return NULL;
+}
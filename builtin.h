@@ -0,0 +1,26 @@
+#ifndef PHTML_BUILTIN_H
+#define PHTML_BUILTIN_H
+
+#include "phtml.h"
+
+// Funções nativas (<call name='sqrt'>...)
+//
+// Um <call> cujo nome não é de uma <function> do programa procura nesta tabela;
+// funções do programa com o mesmo nome têm prioridade. Os argumentos chegam já
+// avaliados, na quantidade certa, em um vetor na pilha de quem chama (nada é
+// alocado por chamada). Strings recebidas continuam pertencendo ao chamador e o
+// valor retornado é sempre novo.
+
+#define BUILTIN_MAX_PARAMS 3
+
+typedef struct Builtin
+{
+    const char *name;
+    int paramCount;
+    Value (*function)(const Value *args);
+} Builtin;
+
+// Função nativa com o nome dado, ou NULL
+const Builtin *findBuiltin(const char *name);
+
+#endif
@@ -0,0 +1,2162 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "mpc.h"
+#include "phtml.h"
+#include "builtin.h"
+#include "emitc.h"
+#include "alloc.h"
+
+// Tradutor de PHTML para C (--emit-c)
+//
+// Cada função carregada por loadFunctions vira uma função C que recebe o
+// ambiente da chamada. O programa gerado inclui um runtime pequeno com a mesma
+// semântica do interpretador (escopo dinâmico, conversão de "true"/"false",
+// mensagens de erro), para que a saída seja idêntica à de ./phtml.
+// As expressões são traduzidas para temporários em sequência, preservando a
+// ordem de avaliação da árvore.
+
+typedef struct
+{
+    FILE *out;
+    Environment *env;
+    int temp;
+    int indent;
+} Emitter;
+
+// Runtime copiado no início de todo programa gerado
+static const char *runtimeSource[] = {
+    "#include <ctype.h>",
+    "#include <math.h>",
+    "#include <stdio.h>",
+    "#include <stdlib.h>",
+    "#include <string.h>",
+    "",
+    "typedef enum",
+    "{",
+    "    TYPE_INT,",
+    "    TYPE_FLOAT,",
+    "    TYPE_CHAR,",
+    "    TYPE_BOOL,",
+    "    TYPE_STRING,",
+    "    TYPE_VOID,",
+    "    TYPE_LONG,",
+    "    TYPE_DOUBLE,",
+    "    TYPE_ARRAY,",
+    "    TYPE_MAP",
+    "} ValueType;",
+    "",
+    "typedef struct",
+    "{",
+    "    ValueType type;",
+    "    union",
+    "    {",
+    "        int intValue;",
+    "        float floatValue;",
+    "        char charValue;",
+    "        int boolValue;",
+    "        char *stringValue;",
+    "        long long longValue;",
+    "        double doubleValue;",
+    "        struct Array *arrayValue;",
+    "        struct Map *mapValue;",
+    "    } value;",
+    "} Value;",
+    "",
+    "typedef struct Array",
+    "{",
+    "    ValueType elementType;",
+    "    int length;",
+    "    int capacity;",
+    "    void *items;",
+    "} Array;",
+    "",
+    "typedef struct",
+    "{",
+    "    unsigned hash;",
+    "    Value key;",
+    "    Value value;",
+    "} MapEntry;",
+    "",
+    "typedef struct Map",
+    "{",
+    "    ValueType keyType;",
+    "    int count;",
+    "    int used;",
+    "    int capacity;",
+    "    int tableSize;",
+    "    int *table;",
+    "    MapEntry *entries;",
+    "} Map;",
+    "",
+    "typedef struct Variable",
+    "{",
+    "    char *name;",
+    "    Value value;",
+    "    struct Variable *next;",
+    "} Variable;",
+    "",
+    "typedef struct Environment",
+    "{",
+    "    Variable *variables;",
+    "    struct Environment *parent;",
+    "} Environment;",
+    "",
+    "enum",
+    "{",
+    "    OP_OR,",
+    "    OP_AND,",
+    "    OP_EQ,",
+    "    OP_NE,",
+    "    OP_LT,",
+    "    OP_GT,",
+    "    OP_LE,",
+    "    OP_GE,",
+    "    OP_ADD,",
+    "    OP_SUB,",
+    "    OP_MUL,",
+    "    OP_DIV",
+    "};",
+    "",
+    "static inline void rtFail(const char *message)",
+    "{",
+    "    printf(\"%s\", message);",
+    "    exit(1);",
+    "}",
+    "",
+    "static inline const char *rtTypeString(ValueType type)",
+    "{",
+    "    switch (type)",
+    "    {",
+    "    case TYPE_INT:",
+    "        return \"int\";",
+    "    case TYPE_FLOAT:",
+    "        return \"float\";",
+    "    case TYPE_CHAR:",
+    "        return \"char\";",
+    "    case TYPE_BOOL:",
+    "        return \"bool\";",
+    "    case TYPE_STRING:",
+    "        return \"string\";",
+    "    case TYPE_VOID:",
+    "        return \"void\";",
+    "    case TYPE_LONG:",
+    "        return \"long\";",
+    "    case TYPE_DOUBLE:",
+    "        return \"double\";",
+    "    case TYPE_ARRAY:",
+    "        return \"array\";",
+    "    case TYPE_MAP:",
+    "        return \"map\";",
+    "    default:",
+    "        return \"unknown\";",
+    "    }",
+    "}",
+    "",
+    "static inline Environment *rtEnvironment(Environment *parent)",
+    "{",
+    "    Environment *env = malloc(sizeof(Environment));",
+    "    env->variables = NULL;",
+    "    env->parent = parent;",
+    "    return env;",
+    "}",
+    "",
+    "static inline Variable *rtFind(Environment *env, const char *name)",
+    "{",
+    "    for (; env; env = env->parent)",
+    "    {",
+    "        for (Variable *current = env->variables; current; current = current->next)",
+    "        {",
+    "            if (strcmp(current->name, name) == 0)",
+    "            {",
+    "                return current;",
+    "            }",
+    "        }",
+    "    }",
+    "    return NULL;",
+    "}",
+    "",
+    "static inline Value rtFix(Value value)",
+    "{",
+    "    if (value.type == TYPE_STRING && value.value.stringValue != NULL)",
+    "    {",
+    "        if (strcmp(value.value.stringValue, \"true\") == 0)",
+    "        {",
+    "            free(value.value.stringValue);",
+    "            value.type = TYPE_BOOL;",
+    "            value.value.boolValue = 1;",
+    "        }",
+    "        else if (strcmp(value.value.stringValue, \"false\") == 0)",
+    "        {",
+    "            free(value.value.stringValue);",
+    "            value.type = TYPE_BOOL;",
+    "            value.value.boolValue = 0;",
+    "        }",
+    "    }",
+    "    return value;",
+    "}",
+    "",
+    "static inline Value rtWiden(ValueType target, Value value)",
+    "{",
+    "    if (target == TYPE_LONG && value.type == TYPE_INT)",
+    "    {",
+    "        value.type = TYPE_LONG;",
+    "        value.value.longValue = value.value.intValue;",
+    "    }",
+    "    else if (target == TYPE_DOUBLE)",
+    "    {",
+    "        if (value.type == TYPE_INT)",
+    "            value.value.doubleValue = value.value.intValue;",
+    "        else if (value.type == TYPE_FLOAT)",
+    "            value.value.doubleValue = value.value.floatValue;",
+    "        else if (value.type == TYPE_LONG)",
+    "            value.value.doubleValue = (double)value.value.longValue;",
+    "        else",
+    "            return value;",
+    "        value.type = TYPE_DOUBLE;",
+    "    }",
+    "    return value;",
+    "}",
+    "",
+    "static inline void rtSet(Environment *env, const char *name, Value value)",
+    "{",
+    "    value = rtFix(value);",
+    "",
+    "    Variable *var = rtFind(env, name);",
+    "    if (!var)",
+    "    {",
+    "        var = malloc(sizeof(Variable));",
+    "        var->name = strdup(name);",
+    "        var->next = env->variables;",
+    "        env->variables = var;",
+    "    }",
+    "    else",
+    "    {",
+    "        value = rtWiden(var->value.type, value);",
+    "        if (var->value.type == TYPE_STRING)",
+    "        {",
+    "            free(var->value.value.stringValue);",
+    "        }",
+    "    }",
+    "",
+    "    var->value = value;",
+    "    if (value.type == TYPE_STRING)",
+    "    {",
+    "        var->value.value.stringValue = strdup(value.value.stringValue);",
+    "    }",
+    "}",
+    "",
+    "static inline Value rtLoad(Environment *env, const char *name)",
+    "{",
+    "    Variable *var = rtFind(env, name);",
+    "    if (!var)",
+    "    {",
+    "        printf(\"Erro: variável '%s' não encontrada\\n\", name);",
+    "        exit(1);",
+    "    }",
+    "    if (var->value.type == TYPE_STRING && var->value.value.stringValue != NULL &&",
+    "        (strcmp(var->value.value.stringValue, \"true\") == 0 || strcmp(var->value.value.stringValue, \"false\") == 0))",
+    "    {",
+    "        var->value = rtFix(var->value);",
+    "    }",
+    "    return var->value;",
+    "}",
+    "",
+    "static inline Value rtNewArray(ValueType elementType)",
+    "{",
+    "    Array *array = malloc(sizeof(Array));",
+    "    array->elementType = elementType;",
+    "    array->length = 0;",
+    "    array->capacity = 0;",
+    "    array->items = NULL;",
+    "",
+    "    Value val;",
+    "    val.type = TYPE_ARRAY;",
+    "    val.value.arrayValue = array;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtNewMap(void)",
+    "{",
+    "    Map *map = calloc(1, sizeof(Map));",
+    "    map->keyType = TYPE_VOID;",
+    "",
+    "    Value val;",
+    "    val.type = TYPE_MAP;",
+    "    val.value.mapValue = map;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtDefault(ValueType type)",
+    "{",
+    "    Value val;",
+    "    memset(&val, 0, sizeof(val));",
+    "    val.type = type;",
+    "    if (type == TYPE_STRING)",
+    "    {",
+    "        val.value.stringValue = strdup(\"\");",
+    "    }",
+    "    else if (type == TYPE_ARRAY)",
+    "    {",
+    "        val = rtNewArray(TYPE_VOID);",
+    "    }",
+    "    else if (type == TYPE_MAP)",
+    "    {",
+    "        val = rtNewMap();",
+    "    }",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtInt(int value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_INT;",
+    "    val.value.intValue = value;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtFloat(float value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_FLOAT;",
+    "    val.value.floatValue = value;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtLong(long long value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_LONG;",
+    "    val.value.longValue = value;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtDouble(double value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_DOUBLE;",
+    "    val.value.doubleValue = value;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtChar(char value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_CHAR;",
+    "    val.value.charValue = value;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtBool(int value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_BOOL;",
+    "    val.value.boolValue = value;",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtString(const char *value)",
+    "{",
+    "    Value val;",
+    "    val.type = TYPE_STRING;",
+    "    val.value.stringValue = strdup(value);",
+    "    return val;",
+    "}",
+    "",
+    "static inline size_t rtElementSize(ValueType type)",
+    "{",
+    "    switch (type)",
+    "    {",
+    "    case TYPE_CHAR:",
+    "        return sizeof(char);",
+    "    case TYPE_FLOAT:",
+    "        return sizeof(float);",
+    "    case TYPE_STRING:",
+    "        return sizeof(char *);",
+    "    case TYPE_LONG:",
+    "        return sizeof(long long);",
+    "    case TYPE_DOUBLE:",
+    "        return sizeof(double);",
+    "    default:",
+    "        return sizeof(int);",
+    "    }",
+    "}",
+    "",
+    "static inline Array *rtRequireArray(Value value)",
+    "{",
+    "    if (value.type != TYPE_ARRAY)",
+    "    {",
+    "        printf(\"Erro: valor do tipo %s não é um array\\n\", rtTypeString(value.type));",
+    "        exit(1);",
+    "    }",
+    "    return value.value.arrayValue;",
+    "}",
+    "",
+    "static inline int rtCheckIndex(Array *array, Value index)",
+    "{",
+    "    long long i;",
+    "    if (index.type == TYPE_INT)",
+    "    {",
+    "        i = index.value.intValue;",
+    "    }",
+    "    else if (index.type == TYPE_LONG)",
+    "    {",
+    "        i = index.value.longValue;",
+    "    }",
+    "    else",
+    "    {",
+    "        printf(\"Erro: índice de array deve ser int, recebido %s\\n\", rtTypeString(index.type));",
+    "        exit(1);",
+    "    }",
+    "",
+    "    if (i < 0 || i >= array->length)",
+    "    {",
+    "        printf(\"Erro: índice %lld fora dos limites do array (tamanho %d)\\n\", i, array->length);",
+    "        exit(1);",
+    "    }",
+    "    return (int)i;",
+    "}",
+    "",
+    "static inline Value rtConvertElement(Array *array, Value value)",
+    "{",
+    "    if (array->elementType == TYPE_VOID && value.type != TYPE_VOID && value.type != TYPE_ARRAY)",
+    "    {",
+    "        array->elementType = value.type;",
+    "    }",
+    "",
+    "    if (array->elementType == TYPE_FLOAT && value.type == TYPE_INT)",
+    "    {",
+    "        value.type = TYPE_FLOAT;",
+    "        value.value.floatValue = value.value.intValue;",
+    "    }",
+    "    else",
+    "    {",
+    "        value = rtWiden(array->elementType, value);",
+    "    }",
+    "",
+    "    if (value.type != array->elementType || value.type == TYPE_VOID)",
+    "    {",
+    "        printf(\"Erro: valor do tipo %s não pode ser guardado em um array de %s\\n\",",
+    "               rtTypeString(value.type), rtTypeString(array->elementType));",
+    "        exit(1);",
+    "    }",
+    "    return value;",
+    "}",
+    "",
+    "static inline Value rtElement(Array *array, int index)",
+    "{",
+    "    Value val;",
+    "    val.type = array->elementType;",
+    "    switch (array->elementType)",
+    "    {",
+    "    case TYPE_INT:",
+    "        val.value.intValue = ((int *)array->items)[index];",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        val.value.floatValue = ((float *)array->items)[index];",
+    "        break;",
+    "    case TYPE_CHAR:",
+    "        val.value.charValue = ((char *)array->items)[index];",
+    "        break;",
+    "    case TYPE_BOOL:",
+    "        val.value.boolValue = ((int *)array->items)[index];",
+    "        break;",
+    "    case TYPE_STRING:",
+    "        val.value.stringValue = ((char **)array->items)[index];",
+    "        break;",
+    "    case TYPE_LONG:",
+    "        val.value.longValue = ((long long *)array->items)[index];",
+    "        break;",
+    "    case TYPE_DOUBLE:",
+    "        val.value.doubleValue = ((double *)array->items)[index];",
+    "        break;",
+    "    default:",
+    "        break;",
+    "    }",
+    "    return val;",
+    "}",
+    "",
+    "static inline void rtStoreElement(Array *array, int index, Value value, int replace)",
+    "{",
+    "    switch (array->elementType)",
+    "    {",
+    "    case TYPE_INT:",
+    "        ((int *)array->items)[index] = value.value.intValue;",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        ((float *)array->items)[index] = value.value.floatValue;",
+    "        break;",
+    "    case TYPE_CHAR:",
+    "        ((char *)array->items)[index] = value.value.charValue;",
+    "        break;",
+    "    case TYPE_BOOL:",
+    "        ((int *)array->items)[index] = value.value.boolValue;",
+    "        break;",
+    "    case TYPE_STRING:",
+    "    {",
+    "        char **items = array->items;",
+    "        char *copy = strdup(value.value.stringValue);",
+    "        if (replace)",
+    "        {",
+    "            free(items[index]);",
+    "        }",
+    "        items[index] = copy;",
+    "        break;",
+    "    }",
+    "    case TYPE_LONG:",
+    "        ((long long *)array->items)[index] = value.value.longValue;",
+    "        break;",
+    "    case TYPE_DOUBLE:",
+    "        ((double *)array->items)[index] = value.value.doubleValue;",
+    "        break;",
+    "    default:",
+    "        break;",
+    "    }",
+    "}",
+    "",
+    "static inline Map *rtRequireMap(Value value)",
+    "{",
+    "    if (value.type != TYPE_MAP)",
+    "    {",
+    "        printf(\"Erro: valor do tipo %s não é um map\\n\", rtTypeString(value.type));",
+    "        exit(1);",
+    "    }",
+    "    return value.value.mapValue;",
+    "}",
+    "",
+    "static inline unsigned rtHashKey(Value key)",
+    "{",
+    "    if (key.type != TYPE_INT && key.type != TYPE_STRING)",
+    "    {",
+    "        printf(\"Erro: chave de map deve ser int ou string, recebido %s\\n\", rtTypeString(key.type));",
+    "        exit(1);",
+    "    }",
+    "    if (key.type == TYPE_INT)",
+    "    {",
+    "        unsigned long long h = (unsigned long long)(unsigned)key.value.intValue * 0x9E3779B97F4A7C15ULL;",
+    "        return (unsigned)(h >> 32) ^ (unsigned)h;",
+    "    }",
+    "    unsigned h = 2166136261u;",
+    "    for (const char *c = key.value.stringValue; *c; c++)",
+    "    {",
+    "        h = (h ^ (unsigned char)*c) * 16777619u;",
+    "    }",
+    "    return h;",
+    "}",
+    "",
+    "// Posição na tabela da chave, ou -1",
+    "static inline int rtFindSlot(Map *map, Value key, unsigned hash)",
+    "{",
+    "    if (map->tableSize == 0 || key.type != map->keyType)",
+    "    {",
+    "        return -1;",
+    "    }",
+    "    unsigned mask = (unsigned)map->tableSize - 1;",
+    "    for (unsigned i = hash & mask;; i = (i + 1) & mask)",
+    "    {",
+    "        int index = map->table[i];",
+    "        if (index == -1)",
+    "        {",
+    "            return -1;",
+    "        }",
+    "        if (index >= 0 && map->entries[index].hash == hash &&",
+    "            (key.type == TYPE_INT ? map->entries[index].key.value.intValue == key.value.intValue",
+    "                                  : strcmp(map->entries[index].key.value.stringValue, key.value.stringValue) == 0))",
+    "        {",
+    "            return (int)i;",
+    "        }",
+    "    }",
+    "}",
+    "",
+    "static inline void rtRebuildMap(Map *map, int tableSize)",
+    "{",
+    "    int live = 0;",
+    "    for (int i = 0; i < map->used; i++)",
+    "    {",
+    "        if (map->entries[i].key.type != TYPE_VOID)",
+    "        {",
+    "            map->entries[live++] = map->entries[i];",
+    "        }",
+    "    }",
+    "    map->used = live;",
+    "    map->capacity = tableSize / 3 * 2;",
+    "    map->entries = realloc(map->entries, sizeof(MapEntry) * map->capacity);",
+    "",
+    "    free(map->table);",
+    "    map->tableSize = tableSize;",
+    "    map->table = malloc(sizeof(int) * tableSize);",
+    "    memset(map->table, 0xFF, sizeof(int) * tableSize);",
+    "",
+    "    unsigned mask = (unsigned)tableSize - 1;",
+    "    for (int index = 0; index < live; index++)",
+    "    {",
+    "        unsigned i = map->entries[index].hash & mask;",
+    "        while (map->table[i] != -1)",
+    "        {",
+    "            i = (i + 1) & mask;",
+    "        }",
+    "        map->table[i] = index;",
+    "    }",
+    "}",
+    "",
+    "static inline Value rtMapGet(Map *map, Value key)",
+    "{",
+    "    int slot = rtFindSlot(map, key, rtHashKey(key));",
+    "    if (slot < 0)",
+    "    {",
+    "        if (key.type == TYPE_INT)",
+    "            printf(\"Erro: chave %d não encontrada no map\\n\", key.value.intValue);",
+    "        else",
+    "            printf(\"Erro: chave \\\"%s\\\" não encontrada no map\\n\", key.value.stringValue);",
+    "        exit(1);",
+    "    }",
+    "    return map->entries[map->table[slot]].value;",
+    "}",
+    "",
+    "static inline void rtMapSet(Map *map, Value key, Value value)",
+    "{",
+    "    unsigned hash = rtHashKey(key);",
+    "    if (map->keyType == TYPE_VOID)",
+    "    {",
+    "        map->keyType = key.type;",
+    "    }",
+    "    if (key.type != map->keyType)",
+    "    {",
+    "        printf(\"Erro: chave do tipo %s em um map de chaves %s\\n\", rtTypeString(key.type), rtTypeString(map->keyType));",
+    "        exit(1);",
+    "    }",
+    "    if (value.type == TYPE_VOID)",
+    "    {",
+    "        rtFail(\"Erro: valor void não pode ser guardado em um map\\n\");",
+    "    }",
+    "    if (value.type == TYPE_STRING)",
+    "    {",
+    "        value.value.stringValue = strdup(value.value.stringValue);",
+    "    }",
+    "",
+    "    int slot = rtFindSlot(map, key, hash);",
+    "    if (slot >= 0)",
+    "    {",
+    "        MapEntry *entry = &map->entries[map->table[slot]];",
+    "        if (entry->value.type == TYPE_STRING)",
+    "        {",
+    "            free(entry->value.value.stringValue);",
+    "        }",
+    "        entry->value = value;",
+    "        return;",
+    "    }",
+    "",
+    "    if (map->used == map->capacity)",
+    "    {",
+    "        int tableSize = map->tableSize ? map->tableSize : 16;",
+    "        if (map->count * 2 > map->capacity)",
+    "        {",
+    "            tableSize = map->tableSize * 2;",
+    "        }",
+    "        rtRebuildMap(map, tableSize);",
+    "    }",
+    "",
+    "    int index = map->used++;",
+    "    MapEntry *entry = &map->entries[index];",
+    "    entry->hash = hash;",
+    "    entry->key = key;",
+    "    if (key.type == TYPE_STRING)",
+    "    {",
+    "        entry->key.value.stringValue = strdup(key.value.stringValue);",
+    "    }",
+    "    entry->value = value;",
+    "",
+    "    unsigned mask = (unsigned)map->tableSize - 1;",
+    "    unsigned i = hash & mask;",
+    "    while (map->table[i] >= 0)",
+    "    {",
+    "        i = (i + 1) & mask;",
+    "    }",
+    "    map->table[i] = index;",
+    "    map->count++;",
+    "}",
+    "",
+    "static inline Value rtHas(Value map, Value key)",
+    "{",
+    "    Map *m = rtRequireMap(map);",
+    "    return rtBool(rtFindSlot(m, key, rtHashKey(key)) >= 0);",
+    "}",
+    "",
+    "static inline void rtDelete(Value map, Value key)",
+    "{",
+    "    Map *m = rtRequireMap(map);",
+    "    int slot = rtFindSlot(m, key, rtHashKey(key));",
+    "    if (slot < 0)",
+    "    {",
+    "        return;",
+    "    }",
+    "    MapEntry *entry = &m->entries[m->table[slot]];",
+    "    if (entry->key.type == TYPE_STRING)",
+    "    {",
+    "        free(entry->key.value.stringValue);",
+    "    }",
+    "    if (entry->value.type == TYPE_STRING)",
+    "    {",
+    "        free(entry->value.value.stringValue);",
+    "    }",
+    "    entry->key.type = TYPE_VOID;",
+    "    m->table[slot] = -2;",
+    "    m->count--;",
+    "}",
+    "",
+    "static inline void rtPush(Value array, Value value);",
+    "",
+    "static inline Value rtKeys(Value map)",
+    "{",
+    "    Map *m = rtRequireMap(map);",
+    "    Value keys = rtNewArray(m->keyType);",
+    "    for (int i = 0; i < m->used; i++)",
+    "    {",
+    "        if (m->entries[i].key.type != TYPE_VOID)",
+    "        {",
+    "            rtPush(keys, m->entries[i].key);",
+    "        }",
+    "    }",
+    "    return keys;",
+    "}",
+    "",
+    "static inline Value rtIndex(Value array, Value index)",
+    "{",
+    "    if (array.type == TYPE_MAP)",
+    "    {",
+    "        return rtMapGet(array.value.mapValue, index);",
+    "    }",
+    "    Array *a = rtRequireArray(array);",
+    "    return rtElement(a, rtCheckIndex(a, index));",
+    "}",
+    "",
+    "static inline void rtStore(Value array, Value index, Value value)",
+    "{",
+    "    if (array.type == TYPE_MAP)",
+    "    {",
+    "        rtMapSet(array.value.mapValue, index, value);",
+    "        return;",
+    "    }",
+    "    Array *a = rtRequireArray(array);",
+    "    int i = rtCheckIndex(a, index);",
+    "    rtStoreElement(a, i, rtConvertElement(a, value), 1);",
+    "}",
+    "",
+    "static inline void rtPush(Value array, Value value)",
+    "{",
+    "    Array *a = rtRequireArray(array);",
+    "    value = rtConvertElement(a, value);",
+    "    if (a->length == a->capacity)",
+    "    {",
+    "        a->capacity = a->capacity ? a->capacity * 2 : 8;",
+    "        a->items = realloc(a->items, rtElementSize(a->elementType) * a->capacity);",
+    "    }",
+    "    rtStoreElement(a, a->length, value, 0);",
+    "    a->length++;",
+    "}",
+    "",
+    "static inline Value rtLength(Value value)",
+    "{",
+    "    if (value.type == TYPE_ARRAY)",
+    "    {",
+    "        return rtInt(value.value.arrayValue->length);",
+    "    }",
+    "    if (value.type == TYPE_MAP)",
+    "    {",
+    "        return rtInt(value.value.mapValue->count);",
+    "    }",
+    "    if (value.type != TYPE_STRING)",
+    "    {",
+    "        printf(\"Erro: <length> espera um array, um map ou uma string, recebido %s\\n\", rtTypeString(value.type));",
+    "        exit(1);",
+    "    }",
+    "    return rtInt((int)strlen(value.value.stringValue));",
+    "}",
+    "",
+    "enum",
+    "{",
+    "    ARRAY_SUM,",
+    "    ARRAY_MIN,",
+    "    ARRAY_MAX,",
+    "    ARRAY_DOT,",
+    "    ARRAY_ADD,",
+    "    ARRAY_MUL,",
+    "    ARRAY_COUNT",
+    "};",
+    "",
+    "// Operações em bloco com as mesmas 8 faixas das rotinas vetoriais do interpretador,",
+    "// para que somas de float e double deem o mesmo resultado",
+    "#define RT_PICK(x, m, max) (((max) ? (x) > (m) : (x) < (m)) ? (x) : (m))",
+    "#define RT_COMPARE(x, op, t)          \\",
+    "    ((op) == OP_EQ   ? (x) == (t)     \\",
+    "     : (op) == OP_NE ? (x) != (t)     \\",
+    "     : (op) == OP_LT ? (x) < (t)      \\",
+    "     : (op) == OP_GT ? (x) > (t)      \\",
+    "     : (op) == OP_LE ? (x) <= (t)     \\",
+    "                     : (x) >= (t))",
+    "#define RT_ARRAY_KERNELS(Name, T, A)                                                   \\",
+    "    static T rtSum##Name(const T *a, const T *b, int n)                                \\",
+    "    {                                                                                  \\",
+    "        A acc[8] = {0};                                                                \\",
+    "        int i = 0;                                                                     \\",
+    "        for (; i + 8 <= n; i += 8)                                                     \\",
+    "        {                                                                              \\",
+    "            for (int j = 0; j < 8; j++)                                                \\",
+    "            {                                                                          \\",
+    "                A x = b ? (A)a[i + j] * (A)b[i + j] : (A)a[i + j];                     \\",
+    "                acc[j] += x;                                                           \\",
+    "            }                                                                          \\",
+    "        }                                                                              \\",
+    "        A total = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7])); \\",
+    "        for (; i < n; i++)                                                             \\",
+    "        {                                                                              \\",
+    "            A x = b ? (A)a[i] * (A)b[i] : (A)a[i];                                     \\",
+    "            total += x;                                                                \\",
+    "        }                                                                              \\",
+    "        return (T)total;                                                               \\",
+    "    }                                                                                  \\",
+    "    static T rtPick##Name(const T *v, int n, int max)                                  \\",
+    "    {                                                                                  \\",
+    "        T result = v[0];                                                               \\",
+    "        int i = 0;                                                                     \\",
+    "        if (n >= 8)                                                                    \\",
+    "        {                                                                              \\",
+    "            T m[8];                                                                    \\",
+    "            memcpy(m, v, sizeof(m));                                                   \\",
+    "            for (i = 8; i + 8 <= n; i += 8)                                            \\",
+    "            {                                                                          \\",
+    "                for (int j = 0; j < 8; j++)                                            \\",
+    "                {                                                                      \\",
+    "                    m[j] = RT_PICK(v[i + j], m[j], max);                               \\",
+    "                }                                                                      \\",
+    "            }                                                                          \\",
+    "            result = m[0];                                                             \\",
+    "            for (int j = 1; j < 8; j++)                                                \\",
+    "            {                                                                          \\",
+    "                result = RT_PICK(m[j], result, max);                                   \\",
+    "            }                                                                          \\",
+    "        }                                                                              \\",
+    "        for (; i < n; i++)                                                             \\",
+    "        {                                                                              \\",
+    "            result = RT_PICK(v[i], result, max);                                       \\",
+    "        }                                                                              \\",
+    "        return result;                                                                 \\",
+    "    }                                                                                  \\",
+    "    static void rtMap##Name(T *out, const T *v, int n, int op, T k)                    \\",
+    "    {                                                                                  \\",
+    "        for (int i = 0; i < n; i++)                                                    \\",
+    "        {                                                                              \\",
+    "            out[i] = (T)(op == OP_ADD ? (A)v[i] + (A)k : (A)v[i] * (A)k);              \\",
+    "        }                                                                              \\",
+    "    }                                                                                  \\",
+    "    static int rtCount##Name(const T *v, int n, int op, T t)                           \\",
+    "    {                                                                                  \\",
+    "        int total = 0;                                                                 \\",
+    "        for (int i = 0; i < n; i++)                                                    \\",
+    "        {                                                                              \\",
+    "            total += RT_COMPARE(v[i], op, t);                                          \\",
+    "        }                                                                              \\",
+    "        return total;                                                                  \\",
+    "    }",
+    "",
+    "RT_ARRAY_KERNELS(Int, int, unsigned)",
+    "RT_ARRAY_KERNELS(Long, long long, unsigned long long)",
+    "RT_ARRAY_KERNELS(Float, float, float)",
+    "RT_ARRAY_KERNELS(Double, double, double)",
+    "",
+    "static inline const char *rtOperationName(int op)",
+    "{",
+    "    static const char *names[] = {\"<sum>\", \"<min>\", \"<max>\", \"<dot>\", \"<add>\", \"<mul>\", \"<count>\"};",
+    "    return names[op];",
+    "}",
+    "",
+    "static inline ValueType rtNumericType(int op, Array *array)",
+    "{",
+    "    ValueType type = array->elementType == TYPE_VOID ? TYPE_INT : array->elementType;",
+    "    if (type != TYPE_INT && type != TYPE_LONG && type != TYPE_FLOAT && type != TYPE_DOUBLE)",
+    "    {",
+    "        printf(\"Erro: %s espera um array de números, recebido um array de %s\\n\",",
+    "               rtOperationName(op), rtTypeString(type));",
+    "        exit(1);",
+    "    }",
+    "    return type;",
+    "}",
+    "",
+    "static inline Value rtArrayOp(int op, int compare, Value left, Value right)",
+    "{",
+    "    Array *a = rtRequireArray(left);",
+    "    ValueType type = rtNumericType(op, a);",
+    "    int n = a->length;",
+    "",
+    "    if (op == ARRAY_SUM || op == ARRAY_DOT)",
+    "    {",
+    "        const void *b = NULL;",
+    "        if (op == ARRAY_DOT)",
+    "        {",
+    "            Array *other = rtRequireArray(right);",
+    "            if (rtNumericType(op, other) != type || other->length != n)",
+    "            {",
+    "                printf(\"Erro: <dot> espera arrays do mesmo tipo e tamanho, recebidos %s[%d] e %s[%d]\\n\",",
+    "                       rtTypeString(type), n, rtTypeString(rtNumericType(op, other)), other->length);",
+    "                exit(1);",
+    "            }",
+    "            b = other->items;",
+    "        }",
+    "        switch (type)",
+    "        {",
+    "        case TYPE_INT:",
+    "            return rtInt(rtSumInt(a->items, b, n));",
+    "        case TYPE_LONG:",
+    "            return rtLong(rtSumLong(a->items, b, n));",
+    "        case TYPE_FLOAT:",
+    "            return rtFloat(rtSumFloat(a->items, b, n));",
+    "        default:",
+    "            return rtDouble(rtSumDouble(a->items, b, n));",
+    "        }",
+    "    }",
+    "",
+    "    if (op == ARRAY_MIN || op == ARRAY_MAX)",
+    "    {",
+    "        if (n == 0)",
+    "        {",
+    "            printf(\"Erro: %s de um array vazio\\n\", rtOperationName(op));",
+    "            exit(1);",
+    "        }",
+    "        int max = op == ARRAY_MAX;",
+    "        switch (type)",
+    "        {",
+    "        case TYPE_INT:",
+    "            return rtInt(rtPickInt(a->items, n, max));",
+    "        case TYPE_LONG:",
+    "            return rtLong(rtPickLong(a->items, n, max));",
+    "        case TYPE_FLOAT:",
+    "            return rtFloat(rtPickFloat(a->items, n, max));",
+    "        default:",
+    "            return rtDouble(rtPickDouble(a->items, n, max));",
+    "        }",
+    "    }",
+    "",
+    "    Value scalar = right;",
+    "    if (type == TYPE_FLOAT && scalar.type == TYPE_INT)",
+    "    {",
+    "        scalar = rtFloat(scalar.value.intValue);",
+    "    }",
+    "    else",
+    "    {",
+    "        scalar = rtWiden(type, scalar);",
+    "    }",
+    "    if (scalar.type != type)",
+    "    {",
+    "        printf(\"Erro: %s não aceita um valor do tipo %s com um array de %s\\n\",",
+    "               rtOperationName(op), rtTypeString(scalar.type), rtTypeString(type));",
+    "        exit(1);",
+    "    }",
+    "",
+    "    if (op == ARRAY_COUNT)",
+    "    {",
+    "        switch (type)",
+    "        {",
+    "        case TYPE_INT:",
+    "            return rtInt(rtCountInt(a->items, n, compare, scalar.value.intValue));",
+    "        case TYPE_LONG:",
+    "            return rtInt(rtCountLong(a->items, n, compare, scalar.value.longValue));",
+    "        case TYPE_FLOAT:",
+    "            return rtInt(rtCountFloat(a->items, n, compare, scalar.value.floatValue));",
+    "        default:",
+    "            return rtInt(rtCountDouble(a->items, n, compare, scalar.value.doubleValue));",
+    "        }",
+    "    }",
+    "",
+    "    int arithmetic = op == ARRAY_ADD ? OP_ADD : OP_MUL;",
+    "    Value result = rtNewArray(type);",
+    "    Array *out = result.value.arrayValue;",
+    "    out->length = n;",
+    "    out->capacity = n;",
+    "    out->items = n > 0 ? malloc(rtElementSize(type) * n) : NULL;",
+    "    switch (type)",
+    "    {",
+    "    case TYPE_INT:",
+    "        rtMapInt(out->items, a->items, n, arithmetic, scalar.value.intValue);",
+    "        break;",
+    "    case TYPE_LONG:",
+    "        rtMapLong(out->items, a->items, n, arithmetic, scalar.value.longValue);",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        rtMapFloat(out->items, a->items, n, arithmetic, scalar.value.floatValue);",
+    "        break;",
+    "    default:",
+    "        rtMapDouble(out->items, a->items, n, arithmetic, scalar.value.doubleValue);",
+    "        break;",
+    "    }",
+    "    return result;",
+    "}",
+    "",
+    "static inline char *rtToString(Value value);",
+    "",
+    "// Elementos separados por \", \" entre colchetes",
+    "static inline char *rtArrayText(Array *array)",
+    "{",
+    "    size_t length = 1;",
+    "    char *text = malloc(2);",
+    "    text[0] = '[';",
+    "    for (int i = 0; i < array->length; i++)",
+    "    {",
+    "        char *item = rtToString(rtElement(array, i));",
+    "        size_t itemLength = strlen(item);",
+    "        text = realloc(text, length + itemLength + 4);",
+    "        if (i > 0)",
+    "        {",
+    "            memcpy(text + length, \", \", 2);",
+    "            length += 2;",
+    "        }",
+    "        memcpy(text + length, item, itemLength);",
+    "        length += itemLength;",
+    "        free(item);",
+    "    }",
+    "    text[length++] = ']';",
+    "    text[length] = '\\0';",
+    "    return text;",
+    "}",
+    "",
+    "// \"chave: valor\" na ordem de inserção, separados por \", \" entre chaves",
+    "static inline char *rtMapText(Map *map)",
+    "{",
+    "    size_t length = 1;",
+    "    char *text = malloc(2);",
+    "    text[0] = '{';",
+    "    for (int i = 0; i < map->used; i++)",
+    "    {",
+    "        if (map->entries[i].key.type == TYPE_VOID)",
+    "        {",
+    "            continue;",
+    "        }",
+    "        char *key = rtToString(map->entries[i].key);",
+    "        char *item = rtToString(map->entries[i].value);",
+    "        size_t keyLength = strlen(key);",
+    "        size_t itemLength = strlen(item);",
+    "        text = realloc(text, length + keyLength + itemLength + 6);",
+    "        if (length > 1)",
+    "        {",
+    "            memcpy(text + length, \", \", 2);",
+    "            length += 2;",
+    "        }",
+    "        memcpy(text + length, key, keyLength);",
+    "        length += keyLength;",
+    "        memcpy(text + length, \": \", 2);",
+    "        length += 2;",
+    "        memcpy(text + length, item, itemLength);",
+    "        length += itemLength;",
+    "        free(key);",
+    "        free(item);",
+    "    }",
+    "    text[length++] = '}';",
+    "    text[length] = '\\0';",
+    "    return text;",
+    "}",
+    "",
+    "static inline char *rtToString(Value value)",
+    "{",
+    "    char buffer[512];",
+    "    switch (value.type)",
+    "    {",
+    "    case TYPE_INT:",
+    "        sprintf(buffer, \"%d\", value.value.intValue);",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        sprintf(buffer, \"%f\", value.value.floatValue);",
+    "        break;",
+    "    case TYPE_CHAR:",
+    "        sprintf(buffer, \"%c\", value.value.charValue);",
+    "        break;",
+    "    case TYPE_BOOL:",
+    "        strcpy(buffer, value.value.boolValue ? \"true\" : \"false\");",
+    "        break;",
+    "    case TYPE_STRING:",
+    "        return strdup(value.value.stringValue ? value.value.stringValue : \"\");",
+    "    case TYPE_LONG:",
+    "        sprintf(buffer, \"%lld\", value.value.longValue);",
+    "        break;",
+    "    case TYPE_DOUBLE:",
+    "        sprintf(buffer, \"%f\", value.value.doubleValue);",
+    "        break;",
+    "    case TYPE_ARRAY:",
+    "        return rtArrayText(value.value.arrayValue);",
+    "    case TYPE_MAP:",
+    "        return rtMapText(value.value.mapValue);",
+    "    default:",
+    "        return strdup(\"\");",
+    "    }",
+    "    return strdup(buffer);",
+    "}",
+    "",
+    "static inline int rtCompare(int op, double left, double right)",
+    "{",
+    "    switch (op)",
+    "    {",
+    "    case OP_EQ:",
+    "        return left == right;",
+    "    case OP_NE:",
+    "        return left != right;",
+    "    case OP_LT:",
+    "        return left < right;",
+    "    case OP_GT:",
+    "        return left > right;",
+    "    case OP_LE:",
+    "        return left <= right;",
+    "    default:",
+    "        return left >= right;",
+    "    }",
+    "}",
+    "",
+    "static inline int rtIsWide(Value value)",
+    "{",
+    "    return value.type == TYPE_LONG || value.type == TYPE_DOUBLE;",
+    "}",
+    "",
+    "static inline int rtIsNumeric(Value value)",
+    "{",
+    "    return value.type == TYPE_INT || value.type == TYPE_FLOAT || rtIsWide(value);",
+    "}",
+    "",
+    "static inline double rtToDouble(Value value)",
+    "{",
+    "    switch (value.type)",
+    "    {",
+    "    case TYPE_INT:",
+    "        return value.value.intValue;",
+    "    case TYPE_FLOAT:",
+    "        return value.value.floatValue;",
+    "    case TYPE_LONG:",
+    "        return (double)value.value.longValue;",
+    "    default:",
+    "        return value.value.doubleValue;",
+    "    }",
+    "}",
+    "",
+    "static inline long long rtToLong(Value value)",
+    "{",
+    "    return value.type == TYPE_INT ? value.value.intValue : value.value.longValue;",
+    "}",
+    "",
+    "static inline Value rtWideBinary(int op, Value left, Value right)",
+    "{",
+    "    int floating = left.type == TYPE_FLOAT || left.type == TYPE_DOUBLE ||",
+    "                   right.type == TYPE_FLOAT || right.type == TYPE_DOUBLE;",
+    "",
+    "    if (op == OP_DIV && rtToDouble(right) == 0.0)",
+    "    {",
+    "        rtFail(\"Erro: divisão por zero\\n\");",
+    "    }",
+    "",
+    "    if (op >= OP_EQ && op <= OP_GE)",
+    "    {",
+    "        if (floating)",
+    "        {",
+    "            double l = rtToDouble(left);",
+    "            double r = rtToDouble(right);",
+    "            if (l != l || r != r)",
+    "            {",
+    "                return rtBool(op == OP_NE);",
+    "            }",
+    "            return rtBool(rtCompare(op, (l > r) - (l < r), 0));",
+    "        }",
+    "        long long l = rtToLong(left);",
+    "        long long r = rtToLong(right);",
+    "        return rtBool(rtCompare(op, (l > r) - (l < r), 0));",
+    "    }",
+    "",
+    "    if (floating)",
+    "    {",
+    "        double l = rtToDouble(left);",
+    "        double r = rtToDouble(right);",
+    "        if (op == OP_ADD)",
+    "            return rtDouble(l + r);",
+    "        if (op == OP_SUB)",
+    "            return rtDouble(l - r);",
+    "        if (op == OP_MUL)",
+    "            return rtDouble(l * r);",
+    "        return rtDouble(l / r);",
+    "    }",
+    "",
+    "    unsigned long long l = (unsigned long long)rtToLong(left);",
+    "    unsigned long long r = (unsigned long long)rtToLong(right);",
+    "    if (op == OP_ADD)",
+    "        return rtLong((long long)(l + r));",
+    "    if (op == OP_SUB)",
+    "        return rtLong((long long)(l - r));",
+    "    if (op == OP_MUL)",
+    "        return rtLong((long long)(l * r));",
+    "    if ((long long)r == -1)",
+    "        return rtLong((long long)(0ULL - l));",
+    "    return rtLong((long long)l / (long long)r);",
+    "}",
+    "",
+    "static inline Value rtBinary(int op, Value left, Value right)",
+    "{",
+    "    // Combinações sem regra no interpretador resultam em void",
+    "    Value result = rtDefault(TYPE_VOID);",
+    "",
+    "    if (op >= OP_EQ && op <= OP_DIV && rtIsNumeric(left) && rtIsNumeric(right) &&",
+    "        (rtIsWide(left) || rtIsWide(right)))",
+    "    {",
+    "        return rtWideBinary(op, left, right);",
+    "    }",
+    "",
+    "    switch (op)",
+    "    {",
+    "    case OP_OR:",
+    "        return rtBool(left.value.boolValue || right.value.boolValue);",
+    "    case OP_AND:",
+    "        if (left.type != TYPE_BOOL || right.type != TYPE_BOOL)",
+    "        {",
+    "            printf(\"Erro: operador && requer operandos do tipo boolean (tipos: %s e %s)\\n\",",
+    "                   rtTypeString(left.type), rtTypeString(right.type));",
+    "            exit(1);",
+    "        }",
+    "        return rtBool(left.value.boolValue && right.value.boolValue);",
+    "    case OP_EQ:",
+    "    case OP_NE:",
+    "    case OP_LT:",
+    "    case OP_GT:",
+    "    case OP_LE:",
+    "    case OP_GE:",
+    "        result.type = TYPE_BOOL;",
+    "        if (left.type == TYPE_INT && right.type == TYPE_INT)",
+    "            result.value.boolValue = rtCompare(op, left.value.intValue, right.value.intValue);",
+    "        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)",
+    "            result.value.boolValue = rtCompare(op, left.value.floatValue, right.value.floatValue);",
+    "        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)",
+    "            result.value.boolValue = rtCompare(op, left.value.charValue, right.value.charValue);",
+    "        else if ((op == OP_EQ || op == OP_NE) && left.type == TYPE_BOOL && right.type == TYPE_BOOL)",
+    "            result.value.boolValue = rtCompare(op, left.value.boolValue, right.value.boolValue);",
+    "        else if ((op == OP_EQ || op == OP_NE) && left.type == TYPE_STRING && right.type == TYPE_STRING)",
+    "            result.value.boolValue = rtCompare(op, strcmp(left.value.stringValue, right.value.stringValue), 0);",
+    "        return result;",
+    "    case OP_DIV:",
+    "        if ((right.type == TYPE_INT && right.value.intValue == 0) ||",
+    "            (right.type == TYPE_FLOAT && right.value.floatValue == 0.0))",
+    "        {",
+    "            rtFail(\"Erro: divisão por zero\\n\");",
+    "        }",
+    "        /* fallthrough */",
+    "    default:",
+    "        if (left.type == TYPE_INT && right.type == TYPE_INT)",
+    "        {",
+    "            result.type = TYPE_INT;",
+    "            if (op == OP_ADD)",
+    "                result.value.intValue = left.value.intValue + right.value.intValue;",
+    "            else if (op == OP_SUB)",
+    "                result.value.intValue = left.value.intValue - right.value.intValue;",
+    "            else if (op == OP_MUL)",
+    "                result.value.intValue = left.value.intValue * right.value.intValue;",
+    "            else if (right.value.intValue == -1)",
+    "                result.value.intValue = (int)(0U - (unsigned)left.value.intValue);",
+    "            else",
+    "                result.value.intValue = left.value.intValue / right.value.intValue;",
+    "        }",
+    "        else if ((left.type == TYPE_INT || left.type == TYPE_FLOAT) &&",
+    "                 (right.type == TYPE_INT || right.type == TYPE_FLOAT))",
+    "        {",
+    "            float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;",
+    "            float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;",
+    "            result.type = TYPE_FLOAT;",
+    "            if (op == OP_ADD)",
+    "                result.value.floatValue = leftVal + rightVal;",
+    "            else if (op == OP_SUB)",
+    "                result.value.floatValue = leftVal - rightVal;",
+    "            else if (op == OP_MUL)",
+    "                result.value.floatValue = leftVal * rightVal;",
+    "            else",
+    "                result.value.floatValue = leftVal / rightVal;",
+    "        }",
+    "        else if (op == OP_ADD && (left.type == TYPE_STRING || right.type == TYPE_STRING))",
+    "        {",
+    "            char *leftStr = rtToString(left);",
+    "            char *rightStr = rtToString(right);",
+    "            size_t leftLen = strlen(leftStr);",
+    "            size_t rightLen = strlen(rightStr);",
+    "            result.type = TYPE_STRING;",
+    "            result.value.stringValue = malloc(leftLen + rightLen + 1);",
+    "            memcpy(result.value.stringValue, leftStr, leftLen);",
+    "            memcpy(result.value.stringValue + leftLen, rightStr, rightLen + 1);",
+    "            free(leftStr);",
+    "            free(rightStr);",
+    "        }",
+    "        return result;",
+    "    }",
+    "}",
+    "",
+    "static inline Value rtUnary(char op, Value val)",
+    "{",
+    "    Value result = rtDefault(TYPE_VOID);",
+    "    if (op == '-')",
+    "    {",
+    "        if (val.type == TYPE_INT)",
+    "            return rtInt(-val.value.intValue);",
+    "        if (val.type == TYPE_FLOAT)",
+    "            return rtFloat(-val.value.floatValue);",
+    "        if (val.type == TYPE_LONG)",
+    "            return rtLong((long long)(0ULL - (unsigned long long)val.value.longValue));",
+    "        if (val.type == TYPE_DOUBLE)",
+    "            return rtDouble(-val.value.doubleValue);",
+    "        return result;",
+    "    }",
+    "    return rtBool(!val.value.boolValue);",
+    "}",
+    "",
+    "static inline int rtCondition(Value val)",
+    "{",
+    "    if (val.type != TYPE_BOOL)",
+    "    {",
+    "        rtFail(\"Erro: condição deve ser do tipo bool\\n\");",
+    "    }",
+    "    return val.value.boolValue;",
+    "}",
+    "",
+    "static inline void rtPrint(Value val)",
+    "{",
+    "    switch (val.type)",
+    "    {",
+    "    case TYPE_INT:",
+    "        printf(\"%d\\n\", val.value.intValue);",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        printf(\"%f\\n\", val.value.floatValue);",
+    "        break;",
+    "    case TYPE_CHAR:",
+    "        printf(\"%c\\n\", val.value.charValue);",
+    "        break;",
+    "    case TYPE_BOOL:",
+    "        printf(\"%s\\n\", val.value.boolValue ? \"true\" : \"false\");",
+    "        break;",
+    "    case TYPE_STRING:",
+    "        printf(\"%s\\n\", val.value.stringValue);",
+    "        break;",
+    "    case TYPE_VOID:",
+    "        printf(\"void\\n\");",
+    "        break;",
+    "    case TYPE_LONG:",
+    "        printf(\"%lld\\n\", val.value.longValue);",
+    "        break;",
+    "    case TYPE_DOUBLE:",
+    "        printf(\"%f\\n\", val.value.doubleValue);",
+    "        break;",
+    "    case TYPE_ARRAY:",
+    "    case TYPE_MAP:",
+    "    {",
+    "        char *text = rtToString(val);",
+    "        printf(\"%s\\n\", text);",
+    "        free(text);",
+    "        break;",
+    "    }",
+    "    }",
+    "}",
+    "",
+    "static inline void rtArgCount(const char *name, int expected, int received)",
+    "{",
+    "    printf(\"Erro: função '%s' espera %d argumentos, mas recebeu %d\\n\", name, expected, received);",
+    "    exit(1);",
+    "}",
+    "",
+    "static inline Value rtReturn(ValueType returnType, Environment *callEnv)",
+    "{",
+    "    Value returnValue = rtDefault(returnType);",
+    "    if (returnType != TYPE_VOID)",
+    "    {",
+    "        Variable *returnVar = rtFind(callEnv, \"return\");",
+    "        if (returnVar)",
+    "        {",
+    "            if (returnVar->value.type == TYPE_STRING && returnValue.type == TYPE_STRING)",
+    "            {",
+    "                free(returnValue.value.stringValue);",
+    "                returnValue.value.stringValue = strdup(returnVar->value.value.stringValue);",
+    "            }",
+    "            else",
+    "            {",
+    "                returnValue = rtWiden(returnType, returnVar->value);",
+    "            }",
+    "        }",
+    "    }",
+    "    return returnValue;",
+    "}",
+    "",
+    "static inline void rtMissing(const char *name)",
+    "{",
+    "    if (!name)",
+    "    {",
+    "        rtFail(\"Erro: nome da função não encontrado\\n\");",
+    "    }",
+    "    printf(\"Erro: função '%s' não encontrada\\n\", name);",
+    "    exit(1);",
+    "}",
+    "",
+    "static inline void rtArgumentError(const char *name, int position, const char *expected, Value value)",
+    "{",
+    "    printf(\"Erro: argumento %d de '%s' deve ser %s, recebido %s\\n\", position + 1, name, expected, rtTypeString(value.type));",
+    "    exit(1);",
+    "}",
+    "",
+    "static inline const char *rtStringArgument(const char *name, Value value, int position)",
+    "{",
+    "    if (value.type != TYPE_STRING)",
+    "    {",
+    "        rtArgumentError(name, position, \"string\", value);",
+    "    }",
+    "    return value.value.stringValue;",
+    "}",
+    "",
+    "static inline long long rtIntArgument(const char *name, Value value, int position)",
+    "{",
+    "    if (value.type == TYPE_INT)",
+    "    {",
+    "        return value.value.intValue;",
+    "    }",
+    "    if (value.type != TYPE_LONG)",
+    "    {",
+    "        rtArgumentError(name, position, \"int\", value);",
+    "    }",
+    "    return value.value.longValue;",
+    "}",
+    "",
+    "static inline double rtNumberArgument(const char *name, Value value, int position)",
+    "{",
+    "    if (!rtIsNumeric(value))",
+    "    {",
+    "        rtArgumentError(name, position, \"um número\", value);",
+    "    }",
+    "    return rtToDouble(value);",
+    "}",
+    "",
+    "static inline Value rtBuiltinLength(Value s)",
+    "{",
+    "    return rtLength(s);",
+    "}",
+    "",
+    "static inline Value rtBuiltinSubstring(Value s, Value from, Value size)",
+    "{",
+    "    const char *text = rtStringArgument(\"substring\", s, 0);",
+    "    long long start = rtIntArgument(\"substring\", from, 1);",
+    "    long long count = rtIntArgument(\"substring\", size, 2);",
+    "    long long length = (long long)strlen(text);",
+    "    if (start < 0 || start > length || count < 0)",
+    "    {",
+    "        printf(\"Erro: substring(%lld, %lld) fora dos limites da string (tamanho %lld)\\n\", start, count, length);",
+    "        exit(1);",
+    "    }",
+    "    if (count > length - start)",
+    "    {",
+    "        count = length - start;",
+    "    }",
+    "    Value val;",
+    "    val.type = TYPE_STRING;",
+    "    val.value.stringValue = malloc(count + 1);",
+    "    memcpy(val.value.stringValue, text + start, count);",
+    "    val.value.stringValue[count] = '\\0';",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtBuiltinFind(Value s, Value part)",
+    "{",
+    "    const char *text = rtStringArgument(\"find\", s, 0);",
+    "    const char *found = strstr(text, rtStringArgument(\"find\", part, 1));",
+    "    return rtInt(found ? (int)(found - text) : -1);",
+    "}",
+    "",
+    "static inline Value rtBuiltinUpper(Value s)",
+    "{",
+    "    Value val = rtString(rtStringArgument(\"upper\", s, 0));",
+    "    for (char *c = val.value.stringValue; *c; c++)",
+    "    {",
+    "        *c = (char)toupper((unsigned char)*c);",
+    "    }",
+    "    return val;",
+    "}",
+    "",
+    "static inline Value rtBuiltinSqrt(Value x)",
+    "{",
+    "    return rtDouble(sqrt(rtNumberArgument(\"sqrt\", x, 0)));",
+    "}",
+    "",
+    "static inline Value rtBuiltinPow(Value x, Value y)",
+    "{",
+    "    return rtDouble(pow(rtNumberArgument(\"pow\", x, 0), rtNumberArgument(\"pow\", y, 1)));",
+    "}",
+    "",
+    "static inline Value rtBuiltinAbs(Value x)",
+    "{",
+    "    switch (x.type)",
+    "    {",
+    "    case TYPE_INT:",
+    "        if (x.value.intValue < 0)",
+    "            x.value.intValue = (int)(0u - (unsigned)x.value.intValue);",
+    "        break;",
+    "    case TYPE_LONG:",
+    "        if (x.value.longValue < 0)",
+    "            x.value.longValue = (long long)(0ull - (unsigned long long)x.value.longValue);",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        x.value.floatValue = fabsf(x.value.floatValue);",
+    "        break;",
+    "    case TYPE_DOUBLE:",
+    "        x.value.doubleValue = fabs(x.value.doubleValue);",
+    "        break;",
+    "    default:",
+    "        rtArgumentError(\"abs\", 0, \"um número\", x);",
+    "    }",
+    "    return x;",
+    "}",
+    "",
+    "static inline Value rtBuiltinFloor(Value x)",
+    "{",
+    "    switch (x.type)",
+    "    {",
+    "    case TYPE_INT:",
+    "    case TYPE_LONG:",
+    "        break;",
+    "    case TYPE_FLOAT:",
+    "        x.value.floatValue = floorf(x.value.floatValue);",
+    "        break;",
+    "    case TYPE_DOUBLE:",
+    "        x.value.doubleValue = floor(x.value.doubleValue);",
+    "        break;",
+    "    default:",
+    "        rtArgumentError(\"floor\", 0, \"um número\", x);",
+    "    }",
+    "    return x;",
+    "}",
+    "",
+};
+
+// Escreve uma linha do programa gerado com a indentação atual
+static void emitLine(Emitter *e, const char *format, ...)
+{
+    va_list args;
+
+    for (int i = 0; i < e->indent; i++)
+    {
+        fputs("    ", e->out);
+    }
+
+    va_start(args, format);
+    vfprintf(e->out, format, args);
+    va_end(args);
+    fputc('\n', e->out);
+}
+
+// Escreve um texto como literal de string C
+static void emitStringLiteral(FILE *out, const char *str, size_t length)
+{
+    fputc('"', out);
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = (unsigned char)str[i];
+        if (c == '\\' || c == '"' || c == '?')
+        {
+            fprintf(out, "\\%c", c);
+        }
+        else if (c < 32 || c >= 127)
+        {
+            // Octal com três dígitos para não absorver o caractere seguinte
+            fprintf(out, "\\%03o", c);
+        }
+        else
+        {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static const char *typeConstant(ValueType type)
+{
+    switch (type)
+    {
+    case TYPE_INT:
+        return "TYPE_INT";
+    case TYPE_FLOAT:
+        return "TYPE_FLOAT";
+    case TYPE_CHAR:
+        return "TYPE_CHAR";
+    case TYPE_BOOL:
+        return "TYPE_BOOL";
+    case TYPE_STRING:
+        return "TYPE_STRING";
+    case TYPE_LONG:
+        return "TYPE_LONG";
+    case TYPE_DOUBLE:
+        return "TYPE_DOUBLE";
+    case TYPE_ARRAY:
+        return "TYPE_ARRAY";
+    case TYPE_MAP:
+        return "TYPE_MAP";
+    default:
+        return "TYPE_VOID";
+    }
+}
+
+static const char *operatorConstant(Operator op)
+{
+    static const char *names[] = {
+        "OP_OR", "OP_AND", "OP_EQ", "OP_NE", "OP_LT", "OP_GT",
+        "OP_LE", "OP_GE", "OP_ADD", "OP_SUB", "OP_MUL", "OP_DIV"};
+    return names[op];
+}
+
+static int emitExpression(Emitter *e, mpc_ast_t *ast);
+static void emitCommandList(Emitter *e, mpc_ast_t *ast);
+
+// Expressão que o interpretador não reconhece: o erro só acontece se ela for executada
+static int emitInvalid(Emitter *e)
+{
+    int result = e->temp++;
+    emitLine(e, "rtFail(\"Erro: expressão não reconhecida\\n\");");
+    emitLine(e, "Value t%d = rtDefault(TYPE_VOID);", result);
+    return result;
+}
+
+// Função nativa: chamada direta de rtBuiltin<Nome> do runtime, com os argumentos por valor
+// Com discard (chamada como comando) o resultado não vai para um temporário e o retorno é -1
+static int emitBuiltinCall(Emitter *e, mpc_ast_t *ast, const Builtin *builtin, int discard)
+{
+    mpc_ast_t **argNodes;
+    int argCount = getCallArguments(ast, &argNodes);
+    int result;
+
+    if (argCount != builtin->paramCount)
+    {
+        ALLOC_FREE(argNodes);
+        emitLine(e, "rtArgCount(\"%s\", %d, %d);", builtin->name, builtin->paramCount, argCount);
+        if (discard)
+        {
+            return -1;
+        }
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtDefault(TYPE_VOID);", result);
+        return result;
+    }
+
+    int args[BUILTIN_MAX_PARAMS];
+    for (int i = 0; i < argCount; i++)
+    {
+        args[i] = argNodes[i] ? emitExpression(e, argNodes[i]) : emitInvalid(e);
+    }
+    ALLOC_FREE(argNodes);
+
+    char call[256];
+    int length = snprintf(call, sizeof(call), "rtBuiltin%c%s(", toupper((unsigned char)builtin->name[0]),
+                          builtin->name + 1);
+    for (int i = 0; i < argCount; i++)
+    {
+        length += snprintf(call + length, sizeof(call) - length, "%st%d", i > 0 ? ", " : "", args[i]);
+    }
+
+    if (discard)
+    {
+        emitLine(e, "%s);", call);
+        return -1;
+    }
+    result = e->temp++;
+    emitLine(e, "Value t%d = %s);", result, call);
+    return result;
+}
+
+// Chamada de função, na mesma ordem de evaluateCall: argumentos, parâmetros e retorno
+// Com discard o retorno não é lido, já que rtReturn não tem efeitos além do valor
+static int emitCall(Emitter *e, mpc_ast_t *ast, int discard)
+{
+    char *functionName = getCallName(ast);
+    Function *function = functionName ? findFunction(e->env, functionName) : NULL;
+    const Builtin *builtin = functionName && !function ? findBuiltin(functionName) : NULL;
+    int result;
+
+    if (builtin)
+    {
+        return emitBuiltinCall(e, ast, builtin, discard);
+    }
+
+    if (!function)
+    {
+        if (functionName)
+        {
+            emitLine(e, "rtMissing(\"%s\");", functionName);
+        }
+        else
+        {
+            emitLine(e, "rtMissing(NULL);");
+        }
+        if (discard)
+        {
+            return -1;
+        }
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtDefault(TYPE_VOID);", result);
+        return result;
+    }
+
+    mpc_ast_t **argNodes;
+    int argCount = getCallArguments(ast, &argNodes);
+    int *args = malloc(sizeof(int) * (argCount + 1));
+    for (int i = 0; i < argCount; i++)
+    {
+        args[i] = argNodes[i] ? emitExpression(e, argNodes[i]) : emitInvalid(e);
+    }
+    ALLOC_FREE(argNodes);
+
+    result = discard ? -1 : e->temp++;
+    if (argCount != function->paramCount)
+    {
+        emitLine(e, "rtArgCount(\"%s\", %d, %d);", functionName, function->paramCount, argCount);
+        if (!discard)
+        {
+            emitLine(e, "Value t%d = rtDefault(TYPE_VOID);", result);
+        }
+        free(args);
+        return result;
+    }
+
+    if (!discard)
+    {
+        emitLine(e, "Value t%d;", result);
+    }
+    emitLine(e, "{");
+    e->indent++;
+    emitLine(e, "Environment *callEnv = rtEnvironment(env);");
+    for (int i = 0; i < argCount; i++)
+    {
+        emitLine(e, "rtSet(callEnv, \"%s\", rtWiden(%s, t%d));", function->parameters[i].name,
+                 typeConstant(function->parameters[i].type), args[i]);
+    }
+    emitLine(e, "rtEnter();");
+    emitLine(e, "fn_%d(callEnv);", (int)(function - e->env->functions));
+    emitLine(e, "rtDepth--;");
+    if (!discard)
+    {
+        emitLine(e, "t%d = rtReturn(%s, callEnv);", result, typeConstant(function->returnType));
+    }
+    e->indent--;
+    emitLine(e, "}");
+
+    free(args);
+    return result;
+}
+
+// Traduz uma expressão e retorna o número do temporário com o resultado
+static int emitExpression(Emitter *e, mpc_ast_t *ast)
+{
+    ExpressionKind kind = getExpressionKind(ast);
+    int result;
+
+    switch (kind)
+    {
+    case EXPR_CALL:
+        return emitCall(e, ast, 0);
+
+    case EXPR_IDENTIFIER:
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtLoad(env, \"%s\");", result, ast->contents);
+        return result;
+
+    case EXPR_NUMBER:
+    {
+        Value number = parseNumber(ast->contents);
+        result = e->temp++;
+        if (number.type == TYPE_LONG)
+        {
+            emitLine(e, "Value t%d = rtLong(%lldLL);", result, number.value.longValue);
+        }
+        else if (number.type == TYPE_DOUBLE)
+        {
+            emitLine(e, "Value t%d = rtDouble(%.17g);", result, number.value.doubleValue);
+        }
+        else if (number.type == TYPE_FLOAT)
+        {
+            emitLine(e, "Value t%d = rtFloat(%s);", result, ast->contents);
+        }
+        else
+        {
+            emitLine(e, "Value t%d = rtInt(%d);", result, number.value.intValue);
+        }
+        return result;
+    }
+
+    case EXPR_STRING:
+        result = e->temp++;
+    {
+        // O conteúdo do literal é o texto entre as aspas
+        size_t length = strlen(ast->contents);
+        for (int i = 0; i < e->indent; i++)
+        {
+            fputs("    ", e->out);
+        }
+        fprintf(e->out, "Value t%d = rtString(", result);
+        emitStringLiteral(e->out, ast->contents + 1, length >= 2 ? length - 2 : 0);
+        fprintf(e->out, ");\n");
+        return result;
+    }
+
+    case EXPR_CHAR:
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtChar(%d);", result, ast->contents[1]);
+        return result;
+
+    case EXPR_BOOLEAN:
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtBool(%d);", result, strcmp(ast->contents, "true") == 0);
+        return result;
+
+    case EXPR_PAREN:
+        for (int i = 0; i < ast->children_num; i++)
+        {
+            if (strstr(ast->children[i]->tag, "expression"))
+            {
+                return emitExpression(e, ast->children[i]);
+            }
+        }
+        return emitInvalid(e);
+
+    case EXPR_BINARY:
+    {
+        int i = findOperatorIndex(ast);
+        Operator op = getOperator(ast->children[i]->contents);
+        int left = emitExpression(e, ast->children[i - 1]);
+        int right = emitExpression(e, ast->children[i + 1]);
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtBinary(%s, t%d, t%d);", result, operatorConstant(op), left, right);
+        return result;
+    }
+
+    case EXPR_UNARY:
+    {
+        char op = ast->children[0]->contents[0];
+        int operand = emitExpression(e, ast->children[1]);
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtUnary('%c', t%d);", result, op, operand);
+        return result;
+    }
+
+    case EXPR_INDEX:
+    {
+        char *varName;
+        mpc_ast_t *indexNode;
+        mpc_ast_t *exprNode;
+        getIndexParts(ast, &varName, &indexNode, &exprNode);
+
+        int array = e->temp++;
+        emitLine(e, "Value t%d = rtLoad(env, \"%s\");", array, varName);
+        int index = emitExpression(e, indexNode);
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtIndex(t%d, t%d);", result, array, index);
+        return result;
+    }
+
+    case EXPR_LENGTH:
+    {
+        int operand = emitExpression(e, getCommandExpression(ast));
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtLength(t%d);", result, operand);
+        return result;
+    }
+
+    case EXPR_ARRAY_OP:
+    {
+        static const char *names[] = {
+            "ARRAY_SUM", "ARRAY_MIN", "ARRAY_MAX", "ARRAY_DOT", "ARRAY_ADD", "ARRAY_MUL", "ARRAY_COUNT"};
+        Operator compare;
+        mpc_ast_t *leftNode;
+        mpc_ast_t *rightNode;
+        ArrayOp op = getArrayOpParts(ast, &compare, &leftNode, &rightNode);
+
+        int left = emitExpression(e, leftNode);
+        int right = rightNode ? emitExpression(e, rightNode) : -1;
+        result = e->temp++;
+        if (right < 0)
+        {
+            right = e->temp++;
+            emitLine(e, "Value t%d = rtDefault(TYPE_VOID);", right);
+        }
+        emitLine(e, "Value t%d = rtArrayOp(%s, %s, t%d, t%d);", result, names[op],
+                 compare == OP_NONE ? "0" : operatorConstant(compare), left, right);
+        return result;
+    }
+
+    case EXPR_HAS:
+    {
+        mpc_ast_t *mapNode;
+        mpc_ast_t *keyNode;
+        getOperandParts(ast, &mapNode, &keyNode);
+
+        int map = emitExpression(e, mapNode);
+        int key = emitExpression(e, keyNode);
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtHas(t%d, t%d);", result, map, key);
+        return result;
+    }
+
+    case EXPR_KEYS:
+    {
+        int operand = emitExpression(e, getCommandExpression(ast));
+        result = e->temp++;
+        emitLine(e, "Value t%d = rtKeys(t%d);", result, operand);
+        return result;
+    }
+
+    default:
+        return emitInvalid(e);
+    }
+}
+
+// Traduz um comando, seguindo evaluateCommand
+static void emitCommand(Emitter *e, mpc_ast_t *ast)
+{
+    CommandKind kind = getCommandKind(ast);
+
+    if (kind == COMMAND_VAR_DECL)
+    {
+        char *varType;
+        char *varName;
+        getDeclarationParts(ast, &varType, &varName);
+
+        if (varType && varName && getType(varType) == TYPE_ARRAY)
+        {
+            emitLine(e, "rtSet(env, \"%s\", rtNewArray(%s));", varName, typeConstant(getElementType(varType)));
+        }
+        else if (varType && varName)
+        {
+            emitLine(e, "rtSet(env, \"%s\", rtDefault(%s));", varName, typeConstant(getType(varType)));
+        }
+    }
+    else if (kind == COMMAND_INDEX_ASSIGN)
+    {
+        char *varName;
+        mpc_ast_t *indexNode;
+        mpc_ast_t *exprNode;
+        getIndexParts(ast, &varName, &indexNode, &exprNode);
+
+        if (varName && indexNode && exprNode)
+        {
+            int array = e->temp++;
+            emitLine(e, "Value t%d = rtLoad(env, \"%s\");", array, varName);
+            int index = emitExpression(e, indexNode);
+            int value = emitExpression(e, exprNode);
+            emitLine(e, "rtStore(t%d, t%d, t%d);", array, index, value);
+        }
+    }
+    else if (kind == COMMAND_ASSIGN)
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getAssignmentParts(ast, &varName, &exprNode);
+
+        if (varName && exprNode)
+        {
+            int value = emitExpression(e, exprNode);
+            emitLine(e, "rtSet(env, \"%s\", t%d);", varName, value);
+        }
+    }
+    else if (kind == COMMAND_IF)
+    {
+        mpc_ast_t *condNode;
+        mpc_ast_t *thenNode;
+        mpc_ast_t *elseNode;
+        getIfParts(ast, &condNode, &thenNode, &elseNode);
+
+        if (condNode && thenNode)
+        {
+            int cond = emitExpression(e, condNode);
+            emitLine(e, "if (rtCondition(t%d))", cond);
+            emitLine(e, "{");
+            e->indent++;
+            emitCommandList(e, thenNode);
+            e->indent--;
+            emitLine(e, "}");
+            if (elseNode)
+            {
+                emitLine(e, "else");
+                emitLine(e, "{");
+                e->indent++;
+                emitCommandList(e, elseNode);
+                e->indent--;
+                emitLine(e, "}");
+            }
+        }
+    }
+    else if (kind == COMMAND_WHILE)
+    {
+        mpc_ast_t *condNode;
+        mpc_ast_t *bodyNode;
+        getWhileParts(ast, &condNode, &bodyNode);
+
+        if (condNode && bodyNode)
+        {
+            emitLine(e, "while (1)");
+            emitLine(e, "{");
+            e->indent++;
+            int cond = emitExpression(e, condNode);
+            emitLine(e, "if (!rtCondition(t%d))", cond);
+            emitLine(e, "    break;");
+            emitCommandList(e, bodyNode);
+            e->indent--;
+            emitLine(e, "}");
+        }
+    }
+    else if (kind == COMMAND_CALL)
+    {
+        emitCall(e, ast, 1);
+    }
+    else if (kind == COMMAND_RETURN)
+    {
+        mpc_ast_t *exprNode = getCommandExpression(ast);
+        if (exprNode)
+        {
+            int value = emitExpression(e, exprNode);
+            emitLine(e, "rtSet(env, \"return\", t%d);", value);
+        }
+    }
+    else if (kind == COMMAND_PRINT)
+    {
+        mpc_ast_t *exprNode = getCommandExpression(ast);
+        if (exprNode)
+        {
+            int value = emitExpression(e, exprNode);
+            emitLine(e, "rtPrint(t%d);", value);
+        }
+    }
+    else if (kind == COMMAND_FLUSH)
+    {
+        emitLine(e, "fflush(stdout);");
+    }
+    else if (kind == COMMAND_PUSH)
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getPushParts(ast, &varName, &exprNode);
+
+        if (varName && exprNode)
+        {
+            int array = e->temp++;
+            emitLine(e, "Value t%d = rtLoad(env, \"%s\");", array, varName);
+            int value = emitExpression(e, exprNode);
+            emitLine(e, "rtPush(t%d, t%d);", array, value);
+        }
+    }
+    else if (kind == COMMAND_DELETE)
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getPushParts(ast, &varName, &exprNode);
+
+        if (varName && exprNode)
+        {
+            int map = e->temp++;
+            emitLine(e, "Value t%d = rtLoad(env, \"%s\");", map, varName);
+            int key = emitExpression(e, exprNode);
+            emitLine(e, "rtDelete(t%d, t%d);", map, key);
+        }
+    }
+}
+
+// Mesma estrutura de evaluateCommandList, inclusive a execução do próprio nó
+static void emitCommandList(Emitter *e, mpc_ast_t *ast)
+{
+    if (strstr(ast->tag, "command_list") && strstr(ast->tag, "command"))
+    {
+        emitCommand(e, ast);
+    }
+
+    for (int i = 0; i < ast->children_num; i++)
+    {
+        emitCommand(e, ast->children[i]);
+    }
+}
+
+// Marca as funções alcançáveis a partir de ast, para não emitir fn_N que nunca é chamada
+static void markReachable(Environment *env, mpc_ast_t *ast, char *reached)
+{
+    if (strstr(ast->tag, "function_call"))
+    {
+        char *functionName = getCallName(ast);
+        Function *function = functionName ? findFunction(env, functionName) : NULL;
+        if (function && !reached[function - env->functions])
+        {
+            reached[function - env->functions] = 1;
+            markReachable(env, function->body, reached);
+        }
+    }
+    for (int i = 0; i < ast->children_num; i++)
+    {
+        markReachable(env, ast->children[i], reached);
+    }
+}
+
+void emitProgram(FILE *out, Environment *env, int maxDepth)
+{
+    Emitter e;
+    e.out = out;
+    e.env = env;
+    e.temp = 0;
+    e.indent = 0;
+
+    fprintf(out, "// Gerado por phtml --emit-c\n");
+    for (size_t i = 0; i < sizeof(runtimeSource) / sizeof(runtimeSource[0]); i++)
+    {
+        fprintf(out, "%s\n", runtimeSource[i]);
+    }
+    // Profundidade de chamadas, com o mesmo limite e a mesma mensagem do
+    // interpretador (budget.h); o limite fica fixo no programa gerado
+    fprintf(out, "\nstatic int rtDepth = 0;\n");
+    fprintf(out, "\nstatic inline void rtEnter(void)\n{\n");
+    fprintf(out, "    if (++rtDepth > %d)\n    {\n", maxDepth);
+    fprintf(out, "        rtFail(\"Erro: limite de %d chamadas aninhadas excedido\\n\");\n", maxDepth);
+    fprintf(out, "    }\n}\n");
+
+    Function *mainFunc = findFunction(env, "main");
+    char *reached = calloc(env->functionCount + 1, 1);
+    if (mainFunc)
+    {
+        reached[mainFunc - env->functions] = 1;
+        markReachable(env, mainFunc->body, reached);
+    }
+
+    // Protótipos, já que as funções podem se chamar em qualquer ordem
+    fprintf(out, "\n");
+    for (int i = 0; i < env->functionCount; i++)
+    {
+        if (reached[i])
+        {
+            fprintf(out, "static void fn_%d(Environment *env); // %s\n", i, env->functions[i].name);
+        }
+    }
+
+    for (int i = 0; i < env->functionCount; i++)
+    {
+        if (!reached[i])
+        {
+            continue;
+        }
+        fprintf(out, "\n// %s\n", env->functions[i].name);
+        fprintf(out, "static void fn_%d(Environment *env)\n{\n", i);
+        // Nem toda função usa o ambiente; evita o aviso de parâmetro não usado
+        fprintf(out, "    (void)env;\n");
+        e.indent = 1;
+        emitCommandList(&e, env->functions[i].body);
+        fprintf(out, "}\n");
+    }
+    free(reached);
+
+    // A main roda direto no ambiente global, como no interpretador
+    fprintf(out, "\nint main(void)\n{\n");
+    // Como no interpretador, a saída só é enviada com o buffer cheio, no fim ou em <flush/>
+    fprintf(out, "    setvbuf(stdout, NULL, _IOFBF, 1 << 16);\n");
+    if (mainFunc)
+    {
+        fprintf(out, "    Environment *global = rtEnvironment(NULL);\n");
+        fprintf(out, "    fn_%d(global);\n", (int)(mainFunc - env->functions));
+    }
+    else
+    {
+        fprintf(out, "    printf(\"Erro: função 'main' não encontrada\\n\");\n");
+    }
+    fprintf(out, "    return 0;\n}\n");
+}
@@ -0,0 +1,11 @@
+#ifndef PHTML_EMITC_H
+#define PHTML_EMITC_H
+
+#include <stdio.h>
+#include "phtml.h"
+
+// Escreve em 'out' um programa C equivalente às funções carregadas em 'env';
+// 'maxDepth' é o limite de chamadas aninhadas do programa gerado (--max-depth)
+void emitProgram(FILE *out, Environment *env, int maxDepth);
+
+#endif
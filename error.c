@@ -0,0 +1,44 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+
+// Cada thread tem sua pilha de handlers (ver libphtml.h)
+static __thread FailHandler *current = NULL;
+
+void failPush(FailHandler *handler)
+{
+    handler->message[0] = '\0';
+    handler->previous = current;
+    current = handler;
+}
+
+void failPop(FailHandler *handler)
+{
+    current = handler->previous;
+}
+
+void fail(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    if (!current)
+    {
+        vprintf(format, args);
+        va_end(args);
+        exit(1);
+    }
+
+    FailHandler *handler = current;
+    vsnprintf(handler->message, sizeof(handler->message), format, args);
+    va_end(args);
+
+    size_t length = strlen(handler->message);
+    if (length > 0 && handler->message[length - 1] == '\n')
+    {
+        handler->message[length - 1] = '\0';
+    }
+    longjmp(handler->jump, 1);
+}
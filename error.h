@@ -0,0 +1,33 @@
+#ifndef PHTML_ERROR_H
+#define PHTML_ERROR_H
+
+#include <setjmp.h>
+
+// Erros do interpretador
+//
+// Todo erro passa por fail(). Na linha de comando a mensagem sai depois do que o
+// programa já imprimiu e o processo termina com código 1. Dentro da biblioteca
+// (libphtml.h) a função da API registra um FailHandler antes de executar: fail()
+// guarda a mensagem nele e volta para o setjmp, que retorna um código de erro.
+
+#define FAIL_MESSAGE_MAX 512
+
+typedef struct FailHandler
+{
+    jmp_buf jump;
+    char message[FAIL_MESSAGE_MAX]; // sem a quebra de linha final
+    struct FailHandler *previous;
+} FailHandler;
+
+// Uso:
+//     FailHandler handler;
+//     failPush(&handler);
+//     if (setjmp(handler.jump)) { failPop(&handler); ... handler.message ... }
+//     ...
+//     failPop(&handler);
+void failPush(FailHandler *handler);
+void failPop(FailHandler *handler);
+
+void fail(const char *format, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+#endif
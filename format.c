@@ -0,0 +1,149 @@
+#include "format.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Pares de dígitos de 00 a 99: cada divisão por 100 produz dois caracteres
+static const char digitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static int digitCount(uint64_t value)
+{
+    int count = 1;
+    for (;;)
+    {
+        if (value < 10)
+            return count;
+        if (value < 100)
+            return count + 1;
+        if (value < 1000)
+            return count + 2;
+        if (value < 10000)
+            return count + 3;
+        value /= 10000;
+        count += 4;
+    }
+}
+
+// Escreve os dígitos de trás para frente, terminando em 'end'
+static void writeDigits(char *end, uint64_t value)
+{
+    while (value >= 100)
+    {
+        unsigned index = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--end = digitPairs[index + 1];
+        *--end = digitPairs[index];
+    }
+    if (value >= 10)
+    {
+        unsigned index = (unsigned)value * 2;
+        *--end = digitPairs[index + 1];
+        *--end = digitPairs[index];
+    }
+    else
+    {
+        *--end = (char)('0' + value);
+    }
+}
+
+int formatUnsigned(char *out, uint64_t value)
+{
+    int length = digitCount(value);
+    writeDigits(out + length, value);
+    return length;
+}
+
+int formatLong(char *out, long long value)
+{
+    if (value < 0)
+    {
+        *out = '-';
+        return 1 + formatUnsigned(out + 1, 0ULL - (uint64_t)value);
+    }
+    return formatUnsigned(out, (uint64_t)value);
+}
+
+int formatInt(char *out, int value)
+{
+    return formatLong(out, value);
+}
+
+int formatFixed(char *out, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    int negative = (int)(bits >> 63);
+    int exponent = (int)((bits >> 52) & 0x7FF);
+    uint64_t mantissa = bits & ((1ULL << 52) - 1);
+
+    // value = mantissa * 2^-shift
+    int shift;
+    if (exponent == 0x7FF || exponent > 1075 + 11)
+    {
+        // NaN, infinito e valores acima de 2^64 ficam com o printf
+        return snprintf(out, FORMAT_FIXED_MAX + 1, "%f", value);
+    }
+    if (exponent == 0)
+    {
+        // Zero e subnormais: arredondam para zero
+        mantissa = 0;
+        shift = 0;
+    }
+    else
+    {
+        mantissa |= 1ULL << 52;
+        shift = 1075 - exponent;
+    }
+
+    uint64_t integer = 0;
+    uint64_t fraction = 0; // seis casas decimais
+    if (shift <= 0)
+    {
+        integer = mantissa << -shift;
+    }
+    else if (shift <= 108)
+    {
+        // Parte fracionária exata vezes 10^6 cabe em 128 bits: 2^108 * 10^6 < 2^128
+        unsigned __int128 mask = ((unsigned __int128)1 << shift) - 1;
+        unsigned __int128 scaled = ((unsigned __int128)mantissa & mask) * 1000000;
+        unsigned __int128 rest = scaled & mask;
+        unsigned __int128 half = (unsigned __int128)1 << (shift - 1);
+
+        integer = shift < 64 ? mantissa >> shift : 0;
+        fraction = (uint64_t)(scaled >> shift);
+        if (rest > half || (rest == half && (fraction & 1)))
+        {
+            fraction++;
+            if (fraction == 1000000)
+            {
+                fraction = 0;
+                integer++;
+            }
+        }
+    }
+    // Com shift maior que 108 o valor é menor que 2^-55 e arredonda para zero
+
+    char *p = out;
+    if (negative)
+    {
+        *p++ = '-';
+    }
+    p += formatUnsigned(p, integer);
+    *p++ = '.';
+    unsigned high = (unsigned)(fraction / 10000) * 2;
+    unsigned middle = (unsigned)(fraction / 100 % 100) * 2;
+    unsigned low = (unsigned)(fraction % 100) * 2;
+    p[0] = digitPairs[high];
+    p[1] = digitPairs[high + 1];
+    p[2] = digitPairs[middle];
+    p[3] = digitPairs[middle + 1];
+    p[4] = digitPairs[low];
+    p[5] = digitPairs[low + 1];
+    return (int)(p + 6 - out);
+}
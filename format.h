@@ -0,0 +1,25 @@
+#ifndef PHTML_FORMAT_H
+#define PHTML_FORMAT_H
+
+#include <stdint.h>
+
+// Formatação de números para <print> e concatenação
+//
+// As funções escrevem o texto diretamente em 'out', sem o '\0' final, e
+// retornam o número de bytes escritos. O texto é o mesmo de printf com
+// %d, %lld e %f.
+
+// Tamanho máximo do texto de cada formato
+#define FORMAT_INT_MAX 11   // "-2147483648"
+#define FORMAT_LONG_MAX 20  // "-9223372036854775808"
+#define FORMAT_FIXED_MAX 320 // "-" + 309 dígitos de DBL_MAX + ".000000"
+
+int formatUnsigned(char *out, uint64_t value);
+int formatInt(char *out, int value);
+int formatLong(char *out, long long value);
+
+// Seis casas decimais, arredondadas a partir do valor binário exato
+// (como o printf faz, com empate para o dígito par)
+int formatFixed(char *out, double value);
+
+#endif
@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include "mpc.h"
+#include "grammar.h"
+
+Grammar *grammarCreate(void)
+{
+    // Definição dos parsers usando a gramática BNF
+    mpc_parser_t *Code = mpc_new("code");
+    mpc_parser_t *FunctionList = mpc_new("function_list");
+    mpc_parser_t *FunctionDecl = mpc_new("function_declaration");
+    mpc_parser_t *ParamList = mpc_new("parameter_list");
+    mpc_parser_t *Parameter = mpc_new("parameter");
+    mpc_parser_t *CmdList = mpc_new("command_list");
+    mpc_parser_t *Command = mpc_new("command");
+    mpc_parser_t *VarDecl = mpc_new("variable_declaration");
+    mpc_parser_t *Assignment = mpc_new("assignment");
+    mpc_parser_t *IfStruct = mpc_new("if_structure");
+    mpc_parser_t *ElseOpt = mpc_new("else_optional");
+    mpc_parser_t *WhileStruct = mpc_new("while_structure");
+    mpc_parser_t *FunctionCall = mpc_new("function_call");
+    mpc_parser_t *ArgsBlock = mpc_new("args_block");
+    mpc_parser_t *ArgList = mpc_new("arg_list");
+    mpc_parser_t *Arg = mpc_new("arg");
+    mpc_parser_t *Return = mpc_new("return");
+    mpc_parser_t *Print = mpc_new("print");
+    mpc_parser_t *Flush = mpc_new("flush");
+    mpc_parser_t *Push = mpc_new("push");
+    mpc_parser_t *IndexAssignment = mpc_new("index_assignment");
+    mpc_parser_t *ArrayIndex = mpc_new("array_index");
+    mpc_parser_t *Length = mpc_new("length");
+    mpc_parser_t *ArrayOperation = mpc_new("array_op");
+    mpc_parser_t *ArrayType = mpc_new("array_type");
+    mpc_parser_t *Has = mpc_new("has");
+    mpc_parser_t *Keys = mpc_new("keys");
+    mpc_parser_t *Delete = mpc_new("delete");
+    mpc_parser_t *Expression = mpc_new("expression");
+    mpc_parser_t *LogicalOr = mpc_new("logical_or");
+    mpc_parser_t *LogicalAnd = mpc_new("logical_and");
+    mpc_parser_t *Equality = mpc_new("equality");
+    mpc_parser_t *Relational = mpc_new("relational");
+    mpc_parser_t *Sum = mpc_new("sum");
+    mpc_parser_t *Product = mpc_new("product");
+    mpc_parser_t *Unary = mpc_new("unary");
+    mpc_parser_t *Primary = mpc_new("primary");
+    mpc_parser_t *Type = mpc_new("type");
+    mpc_parser_t *PrimitiveType = mpc_new("primitive_type");
+    mpc_parser_t *String = mpc_new("string");
+    mpc_parser_t *Identifier = mpc_new("identifier");
+    mpc_parser_t *Number = mpc_new("number");
+    mpc_parser_t *Character = mpc_new("character");
+    mpc_parser_t *Boolean = mpc_new("boolean");
+
+    // Gramática da linguagem
+    mpca_lang(MPCA_LANG_DEFAULT,
+              "code          : /^/ <function_list> /$/ ;\n"
+              "function_list : <function_declaration>+ ;\n"
+              "function_declaration : \"<function name='\" <identifier> \"' return='\" <type> \"'>\" <parameter_list>? <command_list>? \"</function>\" ;\n"
+              "parameter_list : \"<params>\" <parameter>+ \"</params>\" ;\n"
+              "parameter     : \"<param type='\" <type> \"'>\" <identifier> \"</param>\" ;\n"
+              "command_list  : <command>+ ;\n"
+              "command       : <return>\n"
+              "              | <print>\n"
+              "              | <variable_declaration>\n"
+              "              | <index_assignment>\n"
+              "              | <assignment>\n"
+              "              | <if_structure>\n"
+              "              | <while_structure>\n"
+              "              | <function_call>\n"
+              "              | <flush>\n"
+              "              | <push>\n"
+              "              | <delete> ;\n"
+              "variable_declaration : \"<var type='\" <type> \"'>\" <identifier> \"</var>\" ;\n"
+              "assignment    : \"<assign var='\" <identifier> \"'>\" <expression> \"</assign>\" ;\n"
+              "index_assignment : \"<assign var='\" <identifier> \"[\" <expression> \"]'>\" <expression> \"</assign>\" ;\n"
+              "push          : \"<push var='\" <identifier> \"'>\" <expression> \"</push>\" ;\n"
+              "delete        : \"<delete var='\" <identifier> \"'>\" <expression> \"</delete>\" ;\n"
+              "if_structure  : \"<if cond='\" <expression> \"'>\" <command_list>? \"</if>\" <else_optional>? ;\n"
+              "else_optional : \"<else>\" <command_list>? \"</else>\" ;\n"
+              "while_structure : \"<while cond='\" <expression> \"'>\" <command_list>? \"</while>\" ;\n"
+              "function_call : \"<call name='\" <identifier> \"'>\" <args_block>? \"</call>\" ;\n"
+              "args_block    : \"<args>\" <arg_list> \"</args>\" ;\n"
+              "arg_list      : <arg>+ ;\n"
+              "arg           : \"<arg>\" <expression> \"</arg>\" ;\n"
+              "return        : \"<return>\" <expression> \"</return>\" ;\n"
+              "print         : \"<print>\" <expression> \"</print>\" ;\n"
+              "flush         : \"<flush/>\" ;\n"
+              "expression    : <logical_or> ;\n"
+              "logical_or    : <logical_and> (\"||\" <logical_or>)* ;\n"
+              "logical_and   : <equality> (\"&&\" <logical_and>)* ;\n"
+              "equality      : <relational> ((\"==\" | \"!=\") <equality>)* ;\n"
+              "relational    : <sum> ((\"<=\" | \">=\" | \"<\" | \">\") <relational>)* ;\n"
+              "sum           : <product> ((\"+\" | \"-\") <sum>)* ;\n"
+              "product       : <unary> ((\"*\" | \"/\") <product>)* ;\n"
+              "unary         : (\"-\" | \"!\") <unary> | <primary> ;    \n"
+              "primary       : <number> | <character> | <boolean> | <string> | <array_index> | <identifier> | \"(\" <expression> \")\" | <function_call> | <length> | <array_op> | <has> | <keys> ;\n"
+              "array_index   : <identifier> \"[\" <expression> \"]\" ;\n"
+              "length        : \"<length>\" <expression> \"</length>\" ;\n"
+              "array_op      : \"<sum>\" <expression> \"</sum>\"\n"
+              "              | \"<min>\" <expression> \"</min>\"\n"
+              "              | \"<max>\" <expression> \"</max>\"\n"
+              "              | \"<dot>\" <expression> \",\" <expression> \"</dot>\"\n"
+              "              | \"<add>\" <expression> \",\" <expression> \"</add>\"\n"
+              "              | \"<mul>\" <expression> \",\" <expression> \"</mul>\"\n"
+              "              | \"<count op='\" /(==|!=|<=|>=|<|>)/ \"'>\" <expression> \",\" <expression> \"</count>\" ;\n"
+              "has           : \"<has>\" <expression> \",\" <expression> \"</has>\" ;\n"
+              "keys          : \"<keys>\" <expression> \"</keys>\" ;\n"
+              "type          : <array_type> | <primitive_type> ;\n"
+              "array_type    : /(int|float|char|bool|string|long|double)\\[\\]/ ;\n"
+              "primitive_type : \"int\" | \"float\" | \"char\" | \"bool\" | \"string\" | \"void\" | \"long\" | \"double\" | \"map\" ;\n"
+              "string        : /\"([^\"])*\"/ ;\n"
+              "identifier    : /[a-zA-Z][a-zA-Z0-9_]*/ ;\n"
+              "number        : /[0-9]+(\\.[0-9]+)?[LD]?/ ;\n"
+              "character     : /\'[a-zA-Z]\'/ ;\n"
+              "boolean       : \"true\" | \"false\" ;\n",
+              Code, FunctionList, FunctionDecl, ParamList, Parameter,
+              CmdList, Command, Return, Print, Flush, Push, Delete, VarDecl, Assignment, IndexAssignment, IfStruct,
+              ElseOpt, WhileStruct, FunctionCall, ArgsBlock, ArgList, Arg,
+              Expression, LogicalOr, LogicalAnd, Equality, Relational,
+              Sum, Product, Unary, Primary, ArrayIndex, Length, ArrayOperation, Has, Keys, Type, PrimitiveType,
+              ArrayType, String, Identifier, Number, Character, Boolean);
+
+    Grammar *grammar = malloc(sizeof(Grammar));
+    grammar->code = Code;
+    grammar->rules[0] = Code;
+    grammar->rules[1] = FunctionList;
+    grammar->rules[2] = FunctionDecl;
+    grammar->rules[3] = ParamList;
+    grammar->rules[4] = Parameter;
+    grammar->rules[5] = CmdList;
+    grammar->rules[6] = Command;
+    grammar->rules[7] = VarDecl;
+    grammar->rules[8] = Assignment;
+    grammar->rules[9] = IndexAssignment;
+    grammar->rules[10] = IfStruct;
+    grammar->rules[11] = ElseOpt;
+    grammar->rules[12] = WhileStruct;
+    grammar->rules[13] = FunctionCall;
+    grammar->rules[14] = ArgsBlock;
+    grammar->rules[15] = ArgList;
+    grammar->rules[16] = Arg;
+    grammar->rules[17] = Return;
+    grammar->rules[18] = Print;
+    grammar->rules[19] = Flush;
+    grammar->rules[20] = Push;
+    grammar->rules[21] = Delete;
+    grammar->rules[22] = Expression;
+    grammar->rules[23] = LogicalOr;
+    grammar->rules[24] = LogicalAnd;
+    grammar->rules[25] = Equality;
+    grammar->rules[26] = Relational;
+    grammar->rules[27] = Sum;
+    grammar->rules[28] = Product;
+    grammar->rules[29] = Unary;
+    grammar->rules[30] = Primary;
+    grammar->rules[31] = ArrayIndex;
+    grammar->rules[32] = Length;
+    grammar->rules[33] = ArrayOperation;
+    grammar->rules[34] = Has;
+    grammar->rules[35] = Keys;
+    grammar->rules[36] = Type;
+    grammar->rules[37] = PrimitiveType;
+    grammar->rules[38] = ArrayType;
+    grammar->rules[39] = String;
+    grammar->rules[40] = Identifier;
+    grammar->rules[41] = Number;
+    grammar->rules[42] = Character;
+    grammar->rules[43] = Boolean;
+    return grammar;
+}
+
+// Mesma sequência de mpc_cleanup: primeiro desfaz as referências entre as regras
+void grammarDestroy(Grammar *grammar)
+{
+    for (int i = 0; i < GRAMMAR_RULES; i++)
+    {
+        mpc_undefine(grammar->rules[i]);
+    }
+    for (int i = 0; i < GRAMMAR_RULES; i++)
+    {
+        mpc_delete(grammar->rules[i]);
+    }
+    free(grammar);
+}
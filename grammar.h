@@ -0,0 +1,21 @@
+#ifndef PHTML_GRAMMAR_H
+#define PHTML_GRAMMAR_H
+
+#include "mpc.h"
+
+// Gramática da linguagem (ver gramatica_bnf.txt)
+// Montar os parsers do mpc é caro; quem compila vários programas cria a
+// gramática uma vez e a reaproveita
+
+#define GRAMMAR_RULES 44
+
+typedef struct Grammar
+{
+    mpc_parser_t *code; // regra inicial: um arquivo .phtml inteiro
+    mpc_parser_t *rules[GRAMMAR_RULES];
+} Grammar;
+
+Grammar *grammarCreate(void);
+void grammarDestroy(Grammar *grammar);
+
+#endif
@@ -0,0 +1,823 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpc.h"
+#include "phtml.h"
+#include "error.h"
+#include "ir.h"
+#include "jit.h"
+#include "output.h"
+#include "array.h"
+#include "map.h"
+#include "builtin.h"
+#include "alloc.h"
+#include "budget.h"
+
+// Conversão da AST para a IR e execução da IR
+
+IrNode *irNewNode(IrKind kind)
+{
+    IrNode *node = ALLOC_CALLOC(1, sizeof(IrNode));
+    node->kind = kind;
+    node->op = OP_NONE;
+    node->slot = -1;
+    return node;
+}
+
+static void addItem(IrNode *node, IrNode *item)
+{
+    node->itemCount++;
+    node->items = ALLOC_REALLOC(node->items, sizeof(IrNode *) * node->itemCount);
+    node->items[node->itemCount - 1] = item;
+}
+
+static IrNode *lowerExpression(mpc_ast_t *ast, Environment *env);
+static IrNode *lowerCommandList(mpc_ast_t *ast, Environment *env);
+
+// Expressão que continua sendo avaliada pela árvore (inclusive os erros)
+static IrNode *lowerTree(mpc_ast_t *ast)
+{
+    IrNode *node = irNewNode(IR_TREE);
+    node->ast = ast;
+    return node;
+}
+
+// Só chamadas com função conhecida e quantidade certa de argumentos viram IR_CALL
+// (ou IR_BUILTIN); as demais terminam em erro e ficam com evaluateCall para manter
+// as mensagens
+static IrNode *lowerCall(mpc_ast_t *ast, Environment *env)
+{
+    char *functionName = getCallName(ast);
+    Function *function = functionName ? findFunction(env, functionName) : NULL;
+    const Builtin *builtin = functionName && !function ? findBuiltin(functionName) : NULL;
+    if (!function && !builtin)
+    {
+        return lowerTree(ast);
+    }
+
+    mpc_ast_t **argNodes;
+    int argCount = getCallArguments(ast, &argNodes);
+    int valid = argCount == (function ? function->paramCount : builtin->paramCount);
+    for (int i = 0; valid && i < argCount; i++)
+    {
+        valid = argNodes[i] != NULL;
+    }
+
+    if (!valid)
+    {
+        ALLOC_FREE(argNodes);
+        return lowerTree(ast);
+    }
+
+    IrNode *node;
+    if (function)
+    {
+        node = irNewNode(IR_CALL);
+        node->function = function;
+        node->name = function->name;
+    }
+    else
+    {
+        node = irNewNode(IR_BUILTIN);
+        node->builtin = builtin;
+    }
+    for (int i = 0; i < argCount; i++)
+    {
+        addItem(node, lowerExpression(argNodes[i], env));
+    }
+    ALLOC_FREE(argNodes);
+    return node;
+}
+
+// Mesma classificação de evaluateExpression
+static IrNode *lowerExpression(mpc_ast_t *ast, Environment *env)
+{
+    IrNode *node;
+
+    switch (getExpressionKind(ast))
+    {
+    case EXPR_CALL:
+        return lowerCall(ast, env);
+
+    case EXPR_IDENTIFIER:
+        node = irNewNode(IR_LOAD);
+        node->name = ast->contents;
+        return node;
+
+    case EXPR_NUMBER:
+        node = irNewNode(IR_CONST);
+        node->value = parseNumber(ast->contents);
+        return node;
+
+    case EXPR_STRING:
+    {
+        // Remove as aspas do literal
+        size_t length = strlen(ast->contents);
+        node = irNewNode(IR_STRING);
+        node->value.type = TYPE_STRING;
+        node->value.value.stringValue = ALLOC_STRDUP(ast->contents + 1);
+        if (length >= 2)
+        {
+            node->value.value.stringValue[length - 2] = '\0';
+        }
+        return node;
+    }
+
+    case EXPR_CHAR:
+        node = irNewNode(IR_CONST);
+        node->value.type = TYPE_CHAR;
+        node->value.value.charValue = ast->contents[1];
+        return node;
+
+    case EXPR_BOOLEAN:
+        node = irNewNode(IR_CONST);
+        node->value.type = TYPE_BOOL;
+        node->value.value.boolValue = strcmp(ast->contents, "true") == 0;
+        return node;
+
+    case EXPR_PAREN:
+        for (int i = 0; i < ast->children_num; i++)
+        {
+            if (strstr(ast->children[i]->tag, "expression"))
+            {
+                return lowerExpression(ast->children[i], env);
+            }
+        }
+        return lowerTree(ast);
+
+    case EXPR_BINARY:
+    {
+        int i = findOperatorIndex(ast);
+        node = irNewNode(IR_BINARY);
+        node->op = getOperator(ast->children[i]->contents);
+        node->left = lowerExpression(ast->children[i - 1], env);
+        node->right = lowerExpression(ast->children[i + 1], env);
+        return node;
+    }
+
+    case EXPR_UNARY:
+        node = irNewNode(IR_UNARY);
+        node->op = strcmp(ast->children[0]->contents, "-") == 0 ? OP_NEG : OP_NOT;
+        node->left = lowerExpression(ast->children[1], env);
+        return node;
+
+    case EXPR_INDEX:
+    {
+        char *varName;
+        mpc_ast_t *indexNode;
+        mpc_ast_t *exprNode;
+        getIndexParts(ast, &varName, &indexNode, &exprNode);
+        node = irNewNode(IR_INDEX);
+        node->left = irNewNode(IR_LOAD);
+        node->left->name = varName;
+        node->right = lowerExpression(indexNode, env);
+        return node;
+    }
+
+    case EXPR_LENGTH:
+        node = irNewNode(IR_LENGTH);
+        node->left = lowerExpression(getCommandExpression(ast), env);
+        return node;
+
+    case EXPR_ARRAY_OP:
+    {
+        mpc_ast_t *leftNode;
+        mpc_ast_t *rightNode;
+        node = irNewNode(IR_ARRAY_OP);
+        node->arrayOp = getArrayOpParts(ast, &node->op, &leftNode, &rightNode);
+        node->left = lowerExpression(leftNode, env);
+        node->right = rightNode ? lowerExpression(rightNode, env) : NULL;
+        return node;
+    }
+
+    case EXPR_HAS:
+    {
+        mpc_ast_t *mapNode;
+        mpc_ast_t *keyNode;
+        getOperandParts(ast, &mapNode, &keyNode);
+        node = irNewNode(IR_HAS);
+        node->left = lowerExpression(mapNode, env);
+        node->right = lowerExpression(keyNode, env);
+        return node;
+    }
+
+    case EXPR_KEYS:
+        node = irNewNode(IR_KEYS);
+        node->left = lowerExpression(getCommandExpression(ast), env);
+        return node;
+
+    default:
+        return lowerTree(ast);
+    }
+}
+
+// Mesma classificação de evaluateCommand; comandos sem efeito retornam NULL
+static IrNode *lowerCommand(mpc_ast_t *ast, Environment *env)
+{
+    IrNode *node = NULL;
+
+    switch (getCommandKind(ast))
+    {
+    case COMMAND_VAR_DECL:
+    {
+        char *varType;
+        char *varName;
+        getDeclarationParts(ast, &varType, &varName);
+        if (varType && varName)
+        {
+            node = irNewNode(IR_DECL);
+            node->name = varName;
+            node->type = getType(varType);
+            if (node->type == TYPE_ARRAY)
+            {
+                node->elementType = getElementType(varType);
+            }
+        }
+        break;
+    }
+
+    case COMMAND_INDEX_ASSIGN:
+    {
+        char *varName;
+        mpc_ast_t *indexNode;
+        mpc_ast_t *exprNode;
+        getIndexParts(ast, &varName, &indexNode, &exprNode);
+        if (varName && indexNode && exprNode)
+        {
+            node = irNewNode(IR_STORE);
+            node->name = varName;
+            node->right = lowerExpression(indexNode, env);
+            node->left = lowerExpression(exprNode, env);
+        }
+        break;
+    }
+
+    case COMMAND_ASSIGN:
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getAssignmentParts(ast, &varName, &exprNode);
+        if (varName && exprNode)
+        {
+            node = irNewNode(IR_ASSIGN);
+            node->name = varName;
+            node->left = lowerExpression(exprNode, env);
+        }
+        break;
+    }
+
+    case COMMAND_IF:
+    {
+        mpc_ast_t *condNode;
+        mpc_ast_t *thenNode;
+        mpc_ast_t *elseNode;
+        getIfParts(ast, &condNode, &thenNode, &elseNode);
+        if (condNode && thenNode)
+        {
+            node = irNewNode(IR_IF);
+            node->left = lowerExpression(condNode, env);
+            node->right = lowerCommandList(thenNode, env);
+            node->other = elseNode ? lowerCommandList(elseNode, env) : NULL;
+        }
+        break;
+    }
+
+    case COMMAND_WHILE:
+    {
+        mpc_ast_t *condNode;
+        mpc_ast_t *bodyNode;
+        getWhileParts(ast, &condNode, &bodyNode);
+        if (condNode && bodyNode)
+        {
+            node = irNewNode(IR_WHILE);
+            node->left = lowerExpression(condNode, env);
+            node->right = lowerCommandList(bodyNode, env);
+        }
+        break;
+    }
+
+    case COMMAND_CALL:
+        node = irNewNode(IR_EVAL);
+        node->left = lowerCall(ast, env);
+        break;
+
+    case COMMAND_RETURN:
+    {
+        // <return> é uma atribuição à variável "return"
+        mpc_ast_t *exprNode = getCommandExpression(ast);
+        if (exprNode)
+        {
+            node = irNewNode(IR_ASSIGN);
+            node->name = "return";
+            node->left = lowerExpression(exprNode, env);
+        }
+        break;
+    }
+
+    case COMMAND_PRINT:
+    {
+        mpc_ast_t *exprNode = getCommandExpression(ast);
+        if (exprNode)
+        {
+            node = irNewNode(IR_PRINT);
+            node->left = lowerExpression(exprNode, env);
+        }
+        break;
+    }
+
+    case COMMAND_FLUSH:
+        node = irNewNode(IR_FLUSH);
+        break;
+
+    case COMMAND_PUSH:
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getPushParts(ast, &varName, &exprNode);
+        if (varName && exprNode)
+        {
+            node = irNewNode(IR_PUSH);
+            node->name = varName;
+            node->left = lowerExpression(exprNode, env);
+        }
+        break;
+    }
+
+    case COMMAND_DELETE:
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getPushParts(ast, &varName, &exprNode);
+        if (varName && exprNode)
+        {
+            node = irNewNode(IR_DELETE);
+            node->name = varName;
+            node->left = lowerExpression(exprNode, env);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return node;
+}
+
+// Mesma estrutura de evaluateCommandList, inclusive a execução do próprio nó
+static IrNode *lowerCommandList(mpc_ast_t *ast, Environment *env)
+{
+    IrNode *block = irNewNode(IR_BLOCK);
+    IrNode *command;
+
+    if (strstr(ast->tag, "command_list") && strstr(ast->tag, "command"))
+    {
+        command = lowerCommand(ast, env);
+        if (command)
+        {
+            addItem(block, command);
+        }
+    }
+
+    for (int i = 0; i < ast->children_num; i++)
+    {
+        command = lowerCommand(ast->children[i], env);
+        if (command)
+        {
+            addItem(block, command);
+        }
+    }
+
+    return block;
+}
+
+IrProgram *irLower(Environment *env)
+{
+    IrProgram *program = ALLOC_MALLOC(sizeof(IrProgram));
+    program->env = env;
+    program->functionCount = env->functionCount;
+    program->bodies = ALLOC_MALLOC(sizeof(IrNode *) * (env->functionCount + 1));
+
+    for (int i = 0; i < env->functionCount; i++)
+    {
+        program->bodies[i] = lowerCommandList(env->functions[i].body, env);
+    }
+
+    return program;
+}
+
+// Execução
+
+static Value evaluate(IrProgram *program, IrNode *node, Environment *env, Variable *frame);
+static void execute(IrProgram *program, IrNode *node, Environment *env, Variable *frame);
+
+// Busca a variável usando o cache do nó
+static Variable *lookupVariable(IrNode *node, Environment *env)
+{
+    unsigned long version = getChainVersion(env);
+    if (node->cacheVar && node->cacheEnv == env && node->cacheVersion == version)
+    {
+        return node->cacheVar;
+    }
+
+    Variable *var = findVariable(env, node->name);
+    if (var)
+    {
+        node->cacheEnv = env;
+        node->cacheVersion = version;
+        node->cacheVar = var;
+    }
+    return var;
+}
+
+// Variável lida por IR_LOAD, IR_STORE, IR_PUSH e IR_DELETE; encerra o programa se não existir
+static Variable *requireVariable(IrNode *node, Environment *env, Variable *frame)
+{
+    Variable *var;
+    if (node->slot >= 0)
+    {
+        var = frame[node->slot].name ? &frame[node->slot] : NULL;
+    }
+    else
+    {
+        var = lookupVariable(node, env);
+    }
+
+    if (!var)
+    {
+        fail("Erro: variável '%s' não encontrada\n", node->name);
+    }
+    return var;
+}
+
+// Atribuição com a semântica de setVariable, em uma variável local ou no ambiente
+static void storeVariable(IrNode *node, Environment *env, Variable *frame, Value value)
+{
+    if (node->slot >= 0)
+    {
+        Variable *var = &frame[node->slot];
+        value = fixValueType(value);
+        if (var->name)
+        {
+            assignVariable(var, value);
+        }
+        else
+        {
+            var->name = node->name;
+            var->value = copyValue(value);
+        }
+        return;
+    }
+
+    Variable *var = lookupVariable(node, env);
+    if (var)
+    {
+        assignVariable(var, fixValueType(value));
+    }
+    else
+    {
+        setVariable(env, node->name, value);
+    }
+}
+
+// Verifica se nenhum nome local da função embutida existe na cadeia do chamador;
+// caso exista, a chamada precisa do ambiente real para reproduzir o escopo dinâmico
+static int inlineAllowed(IrInline *inlined, Environment *env)
+{
+    unsigned long version = getChainVersion(env);
+    if (inlined->guardEnv == env && inlined->guardVersion == version)
+    {
+        return inlined->guardOk;
+    }
+
+    int ok = 1;
+    for (int i = 0; ok && i < inlined->slotCount; i++)
+    {
+        ok = findVariable(env, inlined->slotNames[i]) == NULL;
+    }
+
+    inlined->guardEnv = env;
+    inlined->guardVersion = version;
+    inlined->guardOk = ok;
+    return ok;
+}
+
+// Chamada de função, na mesma ordem de evaluateCall
+static Value evaluateCallNode(IrProgram *program, IrNode *node, Environment *env, Variable *frame)
+{
+    Function *function = node->function;
+    int argCount = node->itemCount;
+    Value args[argCount > 0 ? argCount : 1];
+    BUDGET_STEP();
+
+    for (int i = 0; i < argCount; i++)
+    {
+        args[i] = evaluate(program, node->items[i], env, frame);
+    }
+
+    // Corpo embutido: parâmetros e locais ficam em um vetor, sem criar ambiente
+    IrInline *inlined = node->inlined;
+    if (inlined && inlineAllowed(inlined, env))
+    {
+        Variable locals[inlined->slotCount];
+        memset(locals, 0, sizeof(locals));
+
+        for (int i = 0; i < argCount; i++)
+        {
+            Variable *param = &locals[i];
+            param->name = inlined->slotNames[i];
+            param->value = copyValue(fixValueType(widenValue(function->parameters[i].type, args[i])));
+        }
+
+        BUDGET_ENTER();
+        execute(program, inlined->body, env, locals);
+        BUDGET_LEAVE();
+
+        Variable *returnVar = &locals[inlined->returnSlot];
+        return getReturnValue(function->returnType, returnVar->name ? returnVar : NULL);
+    }
+
+    Value jitResult;
+    if (jitTryCall(function, args, argCount, env, &jitResult))
+    {
+        return jitResult;
+    }
+
+    Environment *funcEnv = createEnvironment(env);
+    for (int i = 0; i < argCount; i++)
+    {
+        setVariable(funcEnv, function->parameters[i].name, widenValue(function->parameters[i].type, args[i]));
+    }
+
+    BUDGET_ENTER();
+    execute(program, program->bodies[function - program->env->functions], funcEnv, NULL);
+    BUDGET_LEAVE();
+
+    return getReturnValue(function->returnType, findVariable(funcEnv, "return"));
+}
+
+// Produto pela variável de indução: calculado por multiplicação na primeira vez e depois
+// mantido pelas atribuições da variável (ver updateReduced)
+static Value evaluateReduced(IrProgram *program, IrNode *node, Environment *env, Variable *frame)
+{
+    IrNode *product = node->left;
+    Value left = evaluate(program, product->left, env, frame);
+    Value right = evaluate(program, product->right, env, frame);
+    Value result = applyBinaryOperator(OP_MUL, left, right);
+
+    if (left.type == TYPE_INT && right.type == TYPE_INT)
+    {
+        int factor = node->other == product->left ? left.value.intValue : right.value.intValue;
+        node->memo = result;
+        node->memoStep = (int)((unsigned)node->increment * (unsigned)factor);
+        node->memoValid = 1;
+    }
+    return result;
+}
+
+// Depois de 'i = i + c', cada produto i * k passa a valer o anterior mais c * k
+static void updateReduced(IrNode *node, Value value)
+{
+    for (int i = 0; i < node->reducedCount; i++)
+    {
+        IrNode *reduced = node->reduced[i];
+        if (value.type != TYPE_INT)
+        {
+            reduced->memoValid = 0;
+        }
+        else if (reduced->memoValid)
+        {
+            reduced->memo.value.intValue = (int)((unsigned)reduced->memo.value.intValue + (unsigned)reduced->memoStep);
+        }
+    }
+}
+
+static Value evaluate(IrProgram *program, IrNode *node, Environment *env, Variable *frame)
+{
+    switch (node->kind)
+    {
+    case IR_HOISTED:
+        if (!node->memoValid)
+        {
+            Value value = evaluate(program, node->left, env, frame);
+
+            // Strings não são guardadas: cada avaliação precisa de uma cópia própria
+            if (value.type == TYPE_STRING)
+            {
+                return value;
+            }
+            node->memo = value;
+            node->memoValid = 1;
+        }
+        return node->memo;
+
+    case IR_REDUCED:
+        if (node->memoValid)
+        {
+            return node->memo;
+        }
+        return evaluateReduced(program, node, env, frame);
+
+    case IR_CONST:
+        return node->value;
+
+    case IR_STRING:
+        return copyValue(node->value);
+
+    case IR_LOAD:
+        return readVariable(requireVariable(node, env, frame));
+
+    case IR_INDEX:
+    {
+        Value container = evaluate(program, node->left, env, frame);
+        Value index = evaluate(program, node->right, env, frame);
+        return indexGet(container, index);
+    }
+
+    case IR_LENGTH:
+        return valueLength(evaluate(program, node->left, env, frame));
+
+    case IR_ARRAY_OP:
+    {
+        Value left = evaluate(program, node->left, env, frame);
+        Value right;
+        right.type = TYPE_VOID;
+        if (node->right)
+        {
+            right = evaluate(program, node->right, env, frame);
+        }
+        return arrayOperation(node->arrayOp, node->op, left, right);
+    }
+
+    case IR_HAS:
+    {
+        Value map = evaluate(program, node->left, env, frame);
+        return mapHas(map, evaluate(program, node->right, env, frame));
+    }
+
+    case IR_KEYS:
+        return mapKeys(evaluate(program, node->left, env, frame));
+
+    case IR_BINARY:
+    {
+        Value left = evaluate(program, node->left, env, frame);
+        Value right = evaluate(program, node->right, env, frame);
+        return applyBinaryOperator(node->op, left, right);
+    }
+
+    case IR_UNARY:
+        return applyUnaryOperator(node->op, evaluate(program, node->left, env, frame));
+
+    case IR_CALL:
+        return evaluateCallNode(program, node, env, frame);
+
+    case IR_BUILTIN:
+    {
+        Value args[BUILTIN_MAX_PARAMS];
+        for (int i = 0; i < node->itemCount; i++)
+        {
+            args[i] = evaluate(program, node->items[i], env, frame);
+        }
+        return node->builtin->function(args);
+    }
+
+    default:
+        return evaluateExpression(node->ast, env);
+    }
+}
+
+static int evaluateCondition(IrProgram *program, IrNode *node, Environment *env, Variable *frame)
+{
+    Value condVal = evaluate(program, node, env, frame);
+    if (condVal.type != TYPE_BOOL)
+    {
+        fail("Erro: condição deve ser do tipo bool\n");
+    }
+    return condVal.value.boolValue;
+}
+
+static void execute(IrProgram *program, IrNode *node, Environment *env, Variable *frame)
+{
+    switch (node->kind)
+    {
+    case IR_BLOCK:
+        for (int i = 0; i < node->itemCount; i++)
+        {
+            execute(program, node->items[i], env, frame);
+        }
+        break;
+
+    case IR_DECL:
+        if (node->type == TYPE_ARRAY)
+        {
+            storeVariable(node, env, frame, newArray(node->elementType));
+        }
+        else
+        {
+            storeVariable(node, env, frame, defaultValue(node->type));
+        }
+        break;
+
+    case IR_STORE:
+    {
+        // Mesma ordem do interpretador: variável, índice e valor
+        Variable *var = requireVariable(node, env, frame);
+        Value index = evaluate(program, node->right, env, frame);
+        Value value = evaluate(program, node->left, env, frame);
+        indexSet(readVariable(var), index, value);
+        break;
+    }
+
+    case IR_PUSH:
+    {
+        Variable *var = requireVariable(node, env, frame);
+        arrayPush(readVariable(var), evaluate(program, node->left, env, frame));
+        break;
+    }
+
+    case IR_DELETE:
+    {
+        Variable *var = requireVariable(node, env, frame);
+        mapDelete(readVariable(var), evaluate(program, node->left, env, frame));
+        break;
+    }
+
+    case IR_ASSIGN:
+    {
+        Value value = evaluate(program, node->left, env, frame);
+        storeVariable(node, env, frame, value);
+        if (node->reducedCount > 0)
+        {
+            updateReduced(node, value);
+        }
+        break;
+    }
+
+    case IR_IF:
+        if (evaluateCondition(program, node->left, env, frame))
+        {
+            execute(program, node->right, env, frame);
+        }
+        else if (node->other)
+        {
+            execute(program, node->other, env, frame);
+        }
+        break;
+
+    case IR_WHILE:
+    {
+        // Os valores guardados valem só para esta execução do laço; os anteriores são
+        // restaurados na saída porque uma chamada recursiva pode entrar no mesmo laço
+        int tempCount = node->loopTempCount;
+        Value savedMemo[tempCount > 0 ? tempCount : 1];
+        int savedValid[tempCount > 0 ? tempCount : 1];
+        for (int i = 0; i < tempCount; i++)
+        {
+            savedMemo[i] = node->loopTemps[i]->memo;
+            savedValid[i] = node->loopTemps[i]->memoValid;
+            node->loopTemps[i]->memoValid = 0;
+        }
+
+        while (evaluateCondition(program, node->left, env, frame))
+        {
+            BUDGET_STEP();
+            execute(program, node->right, env, frame);
+        }
+
+        for (int i = 0; i < tempCount; i++)
+        {
+            node->loopTemps[i]->memo = savedMemo[i];
+            node->loopTemps[i]->memoValid = savedValid[i];
+        }
+        break;
+    }
+
+    case IR_EVAL:
+        evaluate(program, node->left, env, frame);
+        break;
+
+    case IR_PRINT:
+        printValue(evaluate(program, node->left, env, frame));
+        break;
+
+    case IR_FLUSH:
+        outputFlush();
+        break;
+
+    default:
+        break;
+    }
+}
+
+void irRun(IrProgram *program)
+{
+    Function *mainFunc = findFunction(program->env, "main");
+    if (mainFunc)
+    {
+        execute(program, program->bodies[mainFunc - program->env->functions], program->env, NULL);
+    }
+    else
+    {
+        printf("Erro: função 'main' não encontrada\n");
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef PHTML_IR_H
+#define PHTML_IR_H
+
+#include "phtml.h"
+
+// Representação intermediária usada pelo otimizador (-O)
+//
+// A AST do mpc é convertida uma única vez em nós já classificados: operadores,
+// literais e funções chamadas ficam resolvidos, e a execução não precisa mais
+// comparar tags. A semântica é a mesma do interpretador, inclusive a execução
+// dupla de evaluateCommandList e o escopo dinâmico.
+
+typedef enum
+{
+    // Expressões
+    IR_CONST,  // número, caractere ou booleano
+    IR_STRING, // literal de string (copiado a cada avaliação)
+    IR_LOAD,   // leitura de variável
+    IR_BINARY,
+    IR_UNARY,
+    IR_CALL,
+    IR_BUILTIN, // função nativa, resolvida na conversão (ver builtin.h)
+    IR_TREE,    // expressão não reconhecida: fica com o interpretador
+    IR_HOISTED, // expressão invariante de um laço, calculada uma vez por execução do laço
+    IR_REDUCED, // produto pela variável de indução, atualizado por soma (ver opt.c)
+    IR_INDEX,   // elemento de array ou valor de um map
+    IR_LENGTH,
+    IR_ARRAY_OP, // <sum>, <dot>, <count>, ... (ver array.h)
+    IR_HAS,
+    IR_KEYS,
+
+    // Comandos
+    IR_DECL,
+    IR_ASSIGN,
+    IR_IF,
+    IR_WHILE,
+    IR_EVAL, // chamada usada como comando
+    IR_PRINT,
+    IR_FLUSH,
+    IR_STORE, // atribuição de um elemento de array ou de uma chave de map
+    IR_PUSH,
+    IR_DELETE,
+    IR_BLOCK
+} IrKind;
+
+typedef struct IrNode
+{
+    IrKind kind;
+    Operator op;       // IR_BINARY, IR_UNARY e o operador de <count>
+    ArrayOp arrayOp;   // IR_ARRAY_OP
+    Value value;       // IR_CONST e IR_STRING
+    ValueType type;    // IR_DECL
+    ValueType elementType; // IR_DECL de um array
+    char *name;        // variável lida ou escrita
+    int slot;          // variável local de um corpo embutido (-1 quando fica no ambiente)
+    Function *function; // IR_CALL
+    const struct Builtin *builtin; // IR_BUILTIN
+
+    struct IrNode *left;  // operando, condição ou expressão atribuída
+    struct IrNode *right; // segundo operando, índice ou bloco do if/while
+    struct IrNode *other; // bloco do else
+
+    struct IrNode **items; // comandos de um bloco ou argumentos de uma chamada
+    int itemCount;
+
+    mpc_ast_t *ast; // IR_TREE
+
+    // Cache da busca de variável: válido enquanto nenhuma variável nova surgir na cadeia
+    Environment *cacheEnv;
+    unsigned long cacheVersion;
+    Variable *cacheVar;
+
+    // Corpo da função substituído no local da chamada (ver opt.c)
+    struct IrInline *inlined;
+
+    // Valor guardado durante uma execução do laço (IR_HOISTED e IR_REDUCED)
+    Value memo;
+    int memoValid;
+    int memoStep;  // IR_REDUCED: quanto o produto muda a cada passo da variável de indução
+    int increment; // IR_REDUCED: passo da variável de indução
+
+    // IR_ASSIGN da variável de indução: produtos atualizados junto com ela
+    struct IrNode **reduced;
+    int reducedCount;
+
+    // IR_WHILE: nós com valor guardado, reiniciados a cada entrada no laço
+    struct IrNode **loopTemps;
+    int loopTempCount;
+} IrNode;
+
+typedef struct IrInline
+{
+    IrNode *body;
+    int slotCount;
+    char **slotNames; // parâmetros primeiro, "return" por último
+    int returnSlot;
+
+    // Cache da verificação de que nenhum nome local existe no chamador
+    Environment *guardEnv;
+    unsigned long guardVersion;
+    int guardOk;
+} IrInline;
+
+typedef struct
+{
+    Environment *env;
+    IrNode **bodies; // um corpo por função, na ordem de env->functions
+    int functionCount;
+} IrProgram;
+
+// Converte todas as funções carregadas em 'env'
+IrProgram *irLower(Environment *env);
+
+// Executa a função main no ambiente global
+void irRun(IrProgram *program);
+
+IrNode *irNewNode(IrKind kind);
+
+#endif
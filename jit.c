@@ -0,0 +1,739 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "phtml.h"
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+// Compilador JIT para funções numéricas
+//
+// Funções que usam apenas int e bool, sem chamadas nem print, são traduzidas
+// para um bytecode de pilha tipado. Cada instrução do bytecode é copiada de um
+// molde (stencil) de código x86-64 e tem seus operandos corrigidos no lugar.
+// Qualquer construção fora desse subconjunto faz a função continuar no
+// interpretador.
+
+// Limite de variáveis por função (cada uma ocupa um bit no conjunto de declaradas)
+#define JIT_MAX_SLOTS 62
+
+typedef enum
+{
+    JOP_CONST,
+    JOP_LOAD,
+    JOP_STORE,
+    JOP_ADD,
+    JOP_SUB,
+    JOP_MUL,
+    JOP_DIV,
+    JOP_AND,
+    JOP_OR,
+    JOP_EQ,
+    JOP_NE,
+    JOP_LT,
+    JOP_GT,
+    JOP_LE,
+    JOP_GE,
+    JOP_NEG,
+    JOP_NOT,
+    JOP_JUMP,
+    JOP_JUMP_IF_FALSE,
+    JOP_RETURN
+} JitOp;
+
+typedef struct
+{
+    JitOp op;
+    int arg;
+} JitInstr;
+
+// Código nativo de uma função (ou o registro de que ela não pode ser compilada)
+typedef struct JitCode
+{
+    int failed;
+    int (*entry)(int32_t *slots);
+    size_t size;
+    int slotCount;
+    char *names[JIT_MAX_SLOTS];
+    ValueType types[JIT_MAX_SLOTS];
+    ValueType resultType;
+} JitCode;
+
+typedef struct
+{
+    Function *function;
+    JitCode *code;
+    JitInstr *instrs;
+    int count;
+    int capacity;
+    int hasReturn;
+} JitCompiler;
+
+static int jitThreshold = 0;
+
+void jitEnable(int threshold)
+{
+    jitThreshold = threshold > 0 ? threshold : 1;
+}
+
+// Front-end: AST -> bytecode
+
+static int emit(JitCompiler *c, JitOp op, int arg)
+{
+    if (c->count == c->capacity)
+    {
+        c->capacity = c->capacity ? c->capacity * 2 : 64;
+        c->instrs = realloc(c->instrs, sizeof(JitInstr) * c->capacity);
+    }
+    c->instrs[c->count].op = op;
+    c->instrs[c->count].arg = arg;
+    return c->count++;
+}
+
+static int findSlot(JitCompiler *c, const char *name)
+{
+    for (int i = 0; i < c->code->slotCount; i++)
+    {
+        if (strcmp(c->code->names[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Compila uma expressão e retorna seu tipo estático (-1 se não suportada)
+static int compileExpression(JitCompiler *c, mpc_ast_t *ast, uint64_t defined)
+{
+    switch (getExpressionKind(ast))
+    {
+    case EXPR_IDENTIFIER:
+    {
+        int slot = findSlot(c, ast->contents);
+        if (slot < 0 || !(defined & (1ULL << slot)))
+        {
+            return -1;
+        }
+        emit(c, JOP_LOAD, slot);
+        return c->code->types[slot];
+    }
+    case EXPR_NUMBER:
+    {
+        Value number = parseNumber(ast->contents);
+        if (number.type != TYPE_INT)
+        {
+            return -1;
+        }
+        emit(c, JOP_CONST, number.value.intValue);
+        return TYPE_INT;
+    }
+    case EXPR_BOOLEAN:
+        emit(c, JOP_CONST, strcmp(ast->contents, "true") == 0);
+        return TYPE_BOOL;
+    case EXPR_PAREN:
+        for (int i = 0; i < ast->children_num; i++)
+        {
+            if (strstr(ast->children[i]->tag, "expression"))
+            {
+                return compileExpression(c, ast->children[i], defined);
+            }
+        }
+        return -1;
+    case EXPR_BINARY:
+    {
+        int i = findOperatorIndex(ast);
+        Operator op = getOperator(ast->children[i]->contents);
+        int left = compileExpression(c, ast->children[i - 1], defined);
+        if (left < 0)
+        {
+            return -1;
+        }
+        int right = compileExpression(c, ast->children[i + 1], defined);
+        if (right < 0 || left != right)
+        {
+            return -1;
+        }
+
+        switch (op)
+        {
+        case OP_OR:
+        case OP_AND:
+            if (left != TYPE_BOOL)
+                return -1;
+            emit(c, op == OP_OR ? JOP_OR : JOP_AND, 0);
+            return TYPE_BOOL;
+        case OP_EQ:
+            emit(c, JOP_EQ, 0);
+            return TYPE_BOOL;
+        case OP_NE:
+            emit(c, JOP_NE, 0);
+            return TYPE_BOOL;
+        case OP_LT:
+        case OP_GT:
+        case OP_LE:
+        case OP_GE:
+            if (left != TYPE_INT)
+                return -1;
+            emit(c, op == OP_LT ? JOP_LT : op == OP_GT ? JOP_GT : op == OP_LE ? JOP_LE : JOP_GE, 0);
+            return TYPE_BOOL;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+            if (left != TYPE_INT)
+                return -1;
+            emit(c, op == OP_ADD ? JOP_ADD : op == OP_SUB ? JOP_SUB : op == OP_MUL ? JOP_MUL : JOP_DIV, 0);
+            return TYPE_INT;
+        default:
+            return -1;
+        }
+    }
+    case EXPR_UNARY:
+    {
+        int negate = strcmp(ast->children[0]->contents, "-") == 0;
+        int type = compileExpression(c, ast->children[1], defined);
+        if (negate && type == TYPE_INT)
+        {
+            emit(c, JOP_NEG, 0);
+            return TYPE_INT;
+        }
+        if (!negate && type == TYPE_BOOL)
+        {
+            emit(c, JOP_NOT, 0);
+            return TYPE_BOOL;
+        }
+        return -1;
+    }
+    default:
+        return -1;
+    }
+}
+
+static int compileCommand(JitCompiler *c, mpc_ast_t *ast, uint64_t *defined);
+
+// Compila uma lista de comandos seguindo o mesmo percurso de evaluateCommandList
+static int compileCommandList(JitCompiler *c, mpc_ast_t *ast, uint64_t *defined)
+{
+    if (strstr(ast->tag, "command_list") && strstr(ast->tag, "command"))
+    {
+        if (!compileCommand(c, ast, defined))
+        {
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < ast->children_num; i++)
+    {
+        if (!compileCommand(c, ast->children[i], defined))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int compileCommand(JitCompiler *c, mpc_ast_t *ast, uint64_t *defined)
+{
+    switch (getCommandKind(ast))
+    {
+    case COMMAND_NONE:
+        return 1;
+
+    case COMMAND_VAR_DECL:
+    {
+        char *varType;
+        char *varName;
+        getDeclarationParts(ast, &varType, &varName);
+        if (!varType || !varName)
+        {
+            return 1;
+        }
+
+        ValueType type;
+        if (strcmp(varType, "int") == 0)
+            type = TYPE_INT;
+        else if (strcmp(varType, "bool") == 0)
+            type = TYPE_BOOL;
+        else
+            return 0;
+
+        int slot = findSlot(c, varName);
+        if (slot < 0)
+        {
+            if (c->code->slotCount == JIT_MAX_SLOTS || strcmp(varName, "return") == 0)
+            {
+                return 0;
+            }
+            slot = c->code->slotCount++;
+            c->code->names[slot] = strdup(varName);
+            c->code->types[slot] = type;
+        }
+        else if (c->code->types[slot] != type)
+        {
+            return 0;
+        }
+
+        emit(c, JOP_CONST, 0);
+        emit(c, JOP_STORE, slot);
+        *defined |= 1ULL << slot;
+        return 1;
+    }
+
+    case COMMAND_ASSIGN:
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getAssignmentParts(ast, &varName, &exprNode);
+        if (!varName || !exprNode)
+        {
+            return 1;
+        }
+
+        int slot = findSlot(c, varName);
+        if (slot < 0 || !(*defined & (1ULL << slot)))
+        {
+            return 0;
+        }
+        if (compileExpression(c, exprNode, *defined) != (int)c->code->types[slot])
+        {
+            return 0;
+        }
+        emit(c, JOP_STORE, slot);
+        return 1;
+    }
+
+    case COMMAND_IF:
+    {
+        mpc_ast_t *condNode;
+        mpc_ast_t *thenNode;
+        mpc_ast_t *elseNode;
+        getIfParts(ast, &condNode, &thenNode, &elseNode);
+        if (!condNode || !thenNode)
+        {
+            return 1;
+        }
+
+        if (compileExpression(c, condNode, *defined) != TYPE_BOOL)
+        {
+            return 0;
+        }
+        int jumpToElse = emit(c, JOP_JUMP_IF_FALSE, -1);
+
+        uint64_t thenDefined = *defined;
+        if (!compileCommandList(c, thenNode, &thenDefined))
+        {
+            return 0;
+        }
+
+        uint64_t elseDefined = *defined;
+        if (elseNode)
+        {
+            int jumpToEnd = emit(c, JOP_JUMP, -1);
+            c->instrs[jumpToElse].arg = c->count;
+            if (!compileCommandList(c, elseNode, &elseDefined))
+            {
+                return 0;
+            }
+            c->instrs[jumpToEnd].arg = c->count;
+        }
+        else
+        {
+            c->instrs[jumpToElse].arg = c->count;
+        }
+
+        // Só continuam declaradas as variáveis declaradas nos dois caminhos
+        *defined = thenDefined & elseDefined;
+        return 1;
+    }
+
+    case COMMAND_WHILE:
+    {
+        mpc_ast_t *condNode;
+        mpc_ast_t *bodyNode;
+        getWhileParts(ast, &condNode, &bodyNode);
+        if (!condNode || !bodyNode)
+        {
+            return 1;
+        }
+
+        int loopStart = c->count;
+        if (compileExpression(c, condNode, *defined) != TYPE_BOOL)
+        {
+            return 0;
+        }
+        int jumpToEnd = emit(c, JOP_JUMP_IF_FALSE, -1);
+
+        // O corpo pode não executar: declarações dentro dele não valem depois do laço
+        uint64_t bodyDefined = *defined;
+        if (!compileCommandList(c, bodyNode, &bodyDefined))
+        {
+            return 0;
+        }
+        emit(c, JOP_JUMP, loopStart);
+        c->instrs[jumpToEnd].arg = c->count;
+        return 1;
+    }
+
+    case COMMAND_RETURN:
+    {
+        mpc_ast_t *exprNode = getCommandExpression(ast);
+        if (!exprNode)
+        {
+            return 1;
+        }
+
+        int type = compileExpression(c, exprNode, *defined);
+        if (type < 0 || (c->hasReturn && type != (int)c->code->resultType))
+        {
+            return 0;
+        }
+        c->hasReturn = 1;
+        c->code->resultType = type;
+        emit(c, JOP_RETURN, 0);
+        return 1;
+    }
+
+    default:
+        // Chamadas e print dependem do interpretador
+        return 0;
+    }
+}
+
+#if JIT_SUPPORTED
+
+// Back-end: bytecode -> x86-64 por cópia de moldes
+//
+// Convenções: rdi aponta para os slots (int32), a pilha de operandos é a pilha
+// da máquina e rbp guarda o topo da pilha na entrada para permitir a saída
+// antecipada (deopt) no meio de uma expressão.
+
+typedef enum
+{
+    PATCH_NONE,
+    PATCH_IMM32,
+    PATCH_SLOT,
+    PATCH_RESULT_SLOT,
+    PATCH_FLAG_SLOT,
+    PATCH_JUMP,
+    PATCH_DEOPT
+} PatchKind;
+
+typedef struct
+{
+    const unsigned char *bytes;
+    int length;
+    struct
+    {
+        int offset;
+        PatchKind kind;
+    } patches[2];
+} Stencil;
+
+static const unsigned char stencilConst[] = {0xB8, 0, 0, 0, 0, 0x50};             // mov eax, imm32; push rax
+static const unsigned char stencilLoad[] = {0x8B, 0x87, 0, 0, 0, 0, 0x50};        // mov eax, [rdi+d]; push rax
+static const unsigned char stencilStore[] = {0x58, 0x89, 0x87, 0, 0, 0, 0};       // pop rax; mov [rdi+d], eax
+static const unsigned char stencilAdd[] = {0x59, 0x58, 0x01, 0xC8, 0x50};         // add eax, ecx
+static const unsigned char stencilSub[] = {0x59, 0x58, 0x29, 0xC8, 0x50};         // sub eax, ecx
+static const unsigned char stencilMul[] = {0x59, 0x58, 0x0F, 0xAF, 0xC1, 0x50};   // imul eax, ecx
+static const unsigned char stencilAnd[] = {0x59, 0x58, 0x21, 0xC8, 0x50};         // and eax, ecx
+static const unsigned char stencilOr[] = {0x59, 0x58, 0x09, 0xC8, 0x50};          // or eax, ecx
+static const unsigned char stencilNeg[] = {0x58, 0xF7, 0xD8, 0x50};               // neg eax
+static const unsigned char stencilNot[] = {0x58, 0x83, 0xF0, 0x01, 0x50};         // xor eax, 1
+static const unsigned char stencilJump[] = {0xE9, 0, 0, 0, 0};                    // jmp rel32
+static const unsigned char stencilJumpIfFalse[] = {0x58, 0x85, 0xC0, 0x0F, 0x84, 0, 0, 0, 0};
+
+// Divisor zero ou -1 sai para o interpretador, que reporta o erro como sempre
+static const unsigned char stencilDiv[] = {
+    0x59, 0x58,                         // pop rcx; pop rax
+    0x85, 0xC9, 0x0F, 0x84, 0, 0, 0, 0, // test ecx, ecx; jz deopt
+    0x83, 0xF9, 0xFF, 0x0F, 0x84, 0, 0, 0, 0, // cmp ecx, -1; je deopt
+    0x99, 0xF7, 0xF9, 0x50              // cdq; idiv ecx; push rax
+};
+
+// Comparações: cmp eax, ecx; setcc al; movzx eax, al
+#define COMPARE_STENCIL(name, cc) \
+    static const unsigned char name[] = {0x59, 0x58, 0x39, 0xC8, 0x0F, cc, 0xC0, 0x0F, 0xB6, 0xC0, 0x50}
+COMPARE_STENCIL(stencilEq, 0x94);
+COMPARE_STENCIL(stencilNe, 0x95);
+COMPARE_STENCIL(stencilLt, 0x9C);
+COMPARE_STENCIL(stencilGt, 0x9F);
+COMPARE_STENCIL(stencilLe, 0x9E);
+COMPARE_STENCIL(stencilGe, 0x9D);
+
+// pop rax; mov [rdi+resultado], eax; mov dword [rdi+marcador], 1
+static const unsigned char stencilReturn[] = {
+    0x58, 0x89, 0x87, 0, 0, 0, 0, 0xC7, 0x87, 0, 0, 0, 0, 0x01, 0x00, 0x00, 0x00};
+
+static const unsigned char prologue[] = {0x55, 0x48, 0x89, 0xE5};                  // push rbp; mov rbp, rsp
+static const unsigned char epilogue[] = {0x31, 0xC0, 0x48, 0x89, 0xEC, 0x5D, 0xC3}; // xor eax, eax; mov rsp, rbp; pop rbp; ret
+static const unsigned char deoptExit[] = {0xB8, 0x01, 0, 0, 0, 0x48, 0x89, 0xEC, 0x5D, 0xC3};
+
+#define STENCIL(bytes, ...) {bytes, sizeof(bytes), {__VA_ARGS__}}
+
+static const Stencil stencils[] = {
+    [JOP_CONST] = STENCIL(stencilConst, {1, PATCH_IMM32}),
+    [JOP_LOAD] = STENCIL(stencilLoad, {2, PATCH_SLOT}),
+    [JOP_STORE] = STENCIL(stencilStore, {3, PATCH_SLOT}),
+    [JOP_ADD] = STENCIL(stencilAdd, {0, PATCH_NONE}),
+    [JOP_SUB] = STENCIL(stencilSub, {0, PATCH_NONE}),
+    [JOP_MUL] = STENCIL(stencilMul, {0, PATCH_NONE}),
+    [JOP_DIV] = STENCIL(stencilDiv, {6, PATCH_DEOPT}, {15, PATCH_DEOPT}),
+    [JOP_AND] = STENCIL(stencilAnd, {0, PATCH_NONE}),
+    [JOP_OR] = STENCIL(stencilOr, {0, PATCH_NONE}),
+    [JOP_EQ] = STENCIL(stencilEq, {0, PATCH_NONE}),
+    [JOP_NE] = STENCIL(stencilNe, {0, PATCH_NONE}),
+    [JOP_LT] = STENCIL(stencilLt, {0, PATCH_NONE}),
+    [JOP_GT] = STENCIL(stencilGt, {0, PATCH_NONE}),
+    [JOP_LE] = STENCIL(stencilLe, {0, PATCH_NONE}),
+    [JOP_GE] = STENCIL(stencilGe, {0, PATCH_NONE}),
+    [JOP_NEG] = STENCIL(stencilNeg, {0, PATCH_NONE}),
+    [JOP_NOT] = STENCIL(stencilNot, {0, PATCH_NONE}),
+    [JOP_JUMP] = STENCIL(stencilJump, {1, PATCH_JUMP}),
+    [JOP_JUMP_IF_FALSE] = STENCIL(stencilJumpIfFalse, {5, PATCH_JUMP}),
+    [JOP_RETURN] = STENCIL(stencilReturn, {3, PATCH_RESULT_SLOT}, {9, PATCH_FLAG_SLOT}),
+};
+
+static void writeInt32(unsigned char *at, int32_t value)
+{
+    memcpy(at, &value, sizeof(value));
+}
+
+// Registra o código gerado em /tmp/perf-<pid>.map para o perf resolver os símbolos
+static void writePerfMap(void *address, size_t size, const char *name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+    FILE *map = fopen(path, "a");
+    if (map)
+    {
+        fprintf(map, "%lx %lx phtml:%s\n", (unsigned long)address, (unsigned long)size, name);
+        fclose(map);
+    }
+}
+
+static int assemble(JitCompiler *c)
+{
+    JitCode *code = c->code;
+    size_t capacity = sizeof(prologue) + sizeof(epilogue) + sizeof(deoptExit) + (size_t)c->count * 24;
+    unsigned char *buffer = malloc(capacity);
+    int *offsets = malloc(sizeof(int) * (c->count + 1));
+    size_t length = 0;
+
+    memcpy(buffer, prologue, sizeof(prologue));
+    length += sizeof(prologue);
+
+    // Primeira passagem: copia os moldes e corrige os operandos conhecidos
+    for (int i = 0; i < c->count; i++)
+    {
+        const Stencil *stencil = &stencils[c->instrs[i].op];
+        offsets[i] = (int)length;
+        memcpy(buffer + length, stencil->bytes, stencil->length);
+
+        for (int p = 0; p < 2; p++)
+        {
+            unsigned char *at = buffer + length + stencil->patches[p].offset;
+            switch (stencil->patches[p].kind)
+            {
+            case PATCH_IMM32:
+                writeInt32(at, c->instrs[i].arg);
+                break;
+            case PATCH_SLOT:
+                writeInt32(at, c->instrs[i].arg * 4);
+                break;
+            case PATCH_RESULT_SLOT:
+                writeInt32(at, code->slotCount * 4);
+                break;
+            case PATCH_FLAG_SLOT:
+                writeInt32(at, (code->slotCount + 1) * 4);
+                break;
+            default:
+                break;
+            }
+        }
+        length += stencil->length;
+    }
+
+    offsets[c->count] = (int)length;
+    memcpy(buffer + length, epilogue, sizeof(epilogue));
+    length += sizeof(epilogue);
+    int deoptOffset = (int)length;
+    memcpy(buffer + length, deoptExit, sizeof(deoptExit));
+    length += sizeof(deoptExit);
+
+    // Segunda passagem: desvios relativos
+    for (int i = 0; i < c->count; i++)
+    {
+        const Stencil *stencil = &stencils[c->instrs[i].op];
+        for (int p = 0; p < 2; p++)
+        {
+            int at = offsets[i] + stencil->patches[p].offset;
+            if (stencil->patches[p].kind == PATCH_JUMP)
+            {
+                writeInt32(buffer + at, offsets[c->instrs[i].arg] - (at + 4));
+            }
+            else if (stencil->patches[p].kind == PATCH_DEOPT)
+            {
+                writeInt32(buffer + at, deoptOffset - (at + 4));
+            }
+        }
+    }
+    free(offsets);
+
+    // Copia para memória executável (nunca gravável e executável ao mesmo tempo)
+    void *memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        free(buffer);
+        return 0;
+    }
+    memcpy(memory, buffer, length);
+    free(buffer);
+    if (mprotect(memory, length, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, length);
+        return 0;
+    }
+
+    code->entry = (int (*)(int32_t *))memory;
+    code->size = length;
+    writePerfMap(memory, length, c->function->name);
+    return 1;
+}
+
+#else
+
+static int assemble(JitCompiler *c)
+{
+    (void)c;
+    return 0;
+}
+
+#endif
+
+// Compila uma função; o resultado fica em function->jitCode mesmo em caso de falha
+static JitCode *compileFunction(Function *function)
+{
+    JitCompiler c;
+    memset(&c, 0, sizeof(c));
+    c.function = function;
+    c.code = calloc(1, sizeof(JitCode));
+    c.code->failed = 1;
+    function->jitCode = c.code;
+
+    if (function->returnType != TYPE_INT && function->returnType != TYPE_BOOL)
+    {
+        return c.code;
+    }
+
+    // Os parâmetros ocupam os primeiros slots e já chegam declarados
+    uint64_t defined = 0;
+    if (function->paramCount > JIT_MAX_SLOTS)
+    {
+        return c.code;
+    }
+    for (int i = 0; i < function->paramCount; i++)
+    {
+        ValueType type = function->parameters[i].type;
+        if ((type != TYPE_INT && type != TYPE_BOOL) || findSlot(&c, function->parameters[i].name) >= 0)
+        {
+            return c.code;
+        }
+        c.code->names[i] = strdup(function->parameters[i].name);
+        c.code->types[i] = type;
+        c.code->slotCount++;
+        defined |= 1ULL << i;
+    }
+
+    if (compileCommandList(&c, function->body, &defined) && assemble(&c))
+    {
+        c.code->failed = 0;
+    }
+    free(c.instrs);
+    return c.code;
+}
+
+int jitTryCall(Function *function, Value *args, int argCount, Environment *env, Value *result)
+{
+    if (!JIT_SUPPORTED || jitThreshold == 0)
+    {
+        return 0;
+    }
+
+    JitCode *code = function->jitCode;
+    if (!code)
+    {
+        if (++function->callCount < jitThreshold)
+        {
+            return 0;
+        }
+        code = compileFunction(function);
+    }
+    if (code->failed)
+    {
+        return 0;
+    }
+
+    // Os argumentos precisam ter os tipos para os quais o código foi gerado
+    for (int i = 0; i < argCount; i++)
+    {
+        if (args[i].type != code->types[i])
+        {
+            return 0;
+        }
+    }
+
+    // Com escopo dinâmico, nomes visíveis no chamador seriam alterados pela
+    // função; nesses casos o interpretador reproduz o comportamento exato
+    for (int i = 0; i < code->slotCount; i++)
+    {
+        if (findVariable(env, code->names[i]))
+        {
+            return 0;
+        }
+    }
+    if (findVariable(env, "return"))
+    {
+        return 0;
+    }
+
+    int32_t slots[JIT_MAX_SLOTS + 2];
+    memset(slots, 0, sizeof(int32_t) * (code->slotCount + 2));
+    for (int i = 0; i < argCount; i++)
+    {
+        slots[i] = args[i].type == TYPE_INT ? args[i].value.intValue : args[i].value.boolValue;
+    }
+
+    // Saída antecipada: a função não tem efeitos visíveis, então o
+    // interpretador pode executá-la novamente desde o início
+    if (code->entry(slots) != 0)
+    {
+        return 0;
+    }
+
+    if (slots[code->slotCount + 1])
+    {
+        result->type = code->resultType;
+    }
+    else
+    {
+        // Nenhum <return> executado: valor padrão do tipo de retorno
+        result->type = function->returnType;
+        slots[code->slotCount] = 0;
+    }
+    if (result->type == TYPE_INT)
+    {
+        result->value.intValue = slots[code->slotCount];
+    }
+    else
+    {
+        result->value.boolValue = slots[code->slotCount];
+    }
+    return 1;
+}
@@ -0,0 +1,18 @@
+#ifndef PHTML_JIT_H
+#define PHTML_JIT_H
+
+#include "phtml.h"
+
+// Quantidade de chamadas até uma função ser compilada para código nativo
+#define JIT_DEFAULT_THRESHOLD 2
+
+// Ativa o JIT: funções passam a ser compiladas depois de 'threshold' chamadas
+// O JIT altera as funções (contador de chamadas e código gerado), então só a linha
+// de comando o ativa; a biblioteca compartilha as funções entre threads
+void jitEnable(int threshold);
+
+// Tenta executar a chamada com o código nativo da função
+// Retorna 0 quando a chamada deve seguir pelo interpretador
+int jitTryCall(Function *function, Value *args, int argCount, Environment *env, Value *result);
+
+#endif
@@ -0,0 +1,804 @@
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libphtml.h"
+#include "mpc.h"
+#include "phtml.h"
+#include "error.h"
+#include "grammar.h"
+#include "output.h"
+#include "budget.h"
+
+// A gramática só é lida durante a análise, então um runtime serve várias threads
+struct PhtmlRuntime
+{
+    Grammar *grammar;
+    PhtmlLimits limits;
+};
+
+// Declaração de função analisada sozinha. As versões de um arquivo compiladas
+// por phtmlRecompile compartilham as declarações cujo texto não mudou, então
+// cada uma é liberada quando o último programa que a usa é destruído
+typedef struct
+{
+    char *text; // de "<function" até "</function>", terminado em '\0'
+    size_t length;
+    uint64_t fingerprint;
+    mpc_ast_t *ast;
+    Function function; // carregada uma vez e copiada para cada programa
+    int hasFunction;   // 0 se a declaração não tem corpo (loadFunction a ignora)
+    int refs;
+} PhtmlUnit;
+
+// Trecho de uma declaração no código-fonte
+typedef struct
+{
+    const char *start;
+    size_t length;
+} SourceSpan;
+
+// Programa compilado: as declarações (ou, se o texto não pôde ser separado nelas,
+// a AST do arquivo inteiro) e o ambiente global com as funções carregadas
+// Nada aqui muda depois de phtmlCompile; o estado de uma execução fica no ambiente
+// criado por phtmlRun e nos dados de thread (saída, erros)
+struct PhtmlProgram
+{
+    mpc_ast_t *ast;
+    PhtmlUnit **units; // na ordem do arquivo
+    int unitCount;
+    Environment *env;
+    const PhtmlRuntime *runtime; // limites das execuções
+};
+
+// Tamanho inicial do buffer de phtmlRunBuffered
+#define PHTML_OUTPUT_INITIAL (64 * 1024)
+
+// Mensagem do último erro, separada por thread como errno
+static __thread char lastError[FAIL_MESSAGE_MAX];
+
+const char *phtmlStatusString(PhtmlStatus status)
+{
+    switch (status)
+    {
+    case PHTML_OK:
+        return "ok";
+    case PHTML_ERROR_SYNTAX:
+        return "erro de sintaxe";
+    case PHTML_ERROR_RUNTIME:
+        return "erro de execução";
+    case PHTML_ERROR_NOT_FOUND:
+        return "função não encontrada";
+    case PHTML_ERROR_ARGUMENTS:
+        return "argumentos inválidos";
+    case PHTML_ERROR_TRUNCATED:
+        return "saída truncada";
+    case PHTML_ERROR_IO:
+        return "erro de entrada/saída";
+    case PHTML_ERROR_LIMIT:
+        return "limite excedido";
+    default:
+        return "desconhecido";
+    }
+}
+
+PhtmlValue phtmlInt(int value)
+{
+    PhtmlValue val;
+    val.type = PHTML_INT;
+    val.value.intValue = value;
+    return val;
+}
+
+PhtmlValue phtmlLong(long long value)
+{
+    PhtmlValue val;
+    val.type = PHTML_LONG;
+    val.value.longValue = value;
+    return val;
+}
+
+PhtmlValue phtmlDouble(double value)
+{
+    PhtmlValue val;
+    val.type = PHTML_DOUBLE;
+    val.value.doubleValue = value;
+    return val;
+}
+
+PhtmlValue phtmlBool(int value)
+{
+    PhtmlValue val;
+    val.type = PHTML_BOOL;
+    val.value.boolValue = value != 0;
+    return val;
+}
+
+PhtmlValue phtmlString(const char *value)
+{
+    PhtmlValue val;
+    val.type = PHTML_STRING;
+    val.value.stringValue = value;
+    return val;
+}
+
+PhtmlValue phtmlParseArgument(const char *text)
+{
+    if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0)
+    {
+        return phtmlBool(text[0] == 't');
+    }
+
+    // strtod aceitaria "inf", "nan" e espaços; só textos com cara de número são convertidos
+    const char *digits = text + (text[0] == '-' || text[0] == '+');
+    if (isdigit((unsigned char)digits[0]) || (digits[0] == '.' && isdigit((unsigned char)digits[1])))
+    {
+        char *end;
+        errno = 0;
+        long long integer = strtoll(text, &end, 10);
+        if (*end == '\0' && errno == 0)
+        {
+            return integer >= INT_MIN && integer <= INT_MAX ? phtmlInt((int)integer) : phtmlLong(integer);
+        }
+        double real = strtod(text, &end);
+        if (*end == '\0')
+        {
+            return phtmlDouble(real);
+        }
+    }
+    return phtmlString(text);
+}
+
+PhtmlRuntime *phtmlCreateRuntime(void)
+{
+    PhtmlRuntime *runtime = malloc(sizeof(PhtmlRuntime));
+    runtime->grammar = grammarCreate();
+    memset(&runtime->limits, 0, sizeof(runtime->limits));
+    return runtime;
+}
+
+void phtmlDestroyRuntime(PhtmlRuntime *runtime)
+{
+    if (!runtime)
+    {
+        return;
+    }
+    grammarDestroy(runtime->grammar);
+    free(runtime);
+}
+
+void phtmlSetLimits(PhtmlRuntime *runtime, const PhtmlLimits *limits)
+{
+    runtime->limits = *limits;
+}
+
+const char *phtmlError(const PhtmlRuntime *runtime)
+{
+    (void)runtime;
+    return lastError;
+}
+
+static void freeFunction(Function *function)
+{
+    for (int j = 0; j < function->paramCount; j++)
+    {
+        free(function->parameters[j].name);
+    }
+    free(function->parameters);
+    free(function->name);
+}
+
+static void freeFunctions(Environment *env)
+{
+    for (int i = 0; i < env->functionCount; i++)
+    {
+        freeFunction(&env->functions[i]);
+    }
+    free(env->functions);
+    free(env);
+}
+
+// Impressão digital de uma declaração, 8 bytes por vez; as colisões são
+// resolvidas comparando o texto
+static uint64_t fingerprint(const char *text, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL ^ length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, text + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)text[i]) * 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    return hash ^ (hash >> 33);
+}
+
+static void releaseUnits(PhtmlUnit **units, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (__atomic_sub_fetch(&units[i]->refs, 1, __ATOMIC_ACQ_REL) == 0)
+        {
+            if (units[i]->hasFunction)
+            {
+                freeFunction(&units[i]->function);
+            }
+            mpc_ast_delete(units[i]->ast);
+            free(units[i]->text);
+            free(units[i]);
+        }
+    }
+    free(units);
+}
+
+// Separa as declarações de função sem usar a gramática: entre elas só pode haver
+// espaços, e cada uma termina no primeiro "</function>" fora de uma string (as
+// strings não têm escapes e nenhum outro token contém aspas duplas). Retorna a
+// quantidade de trechos, ou -1 se o texto não tem essa forma; ele então é
+// analisado inteiro, e o erro sai do mpc.
+static int splitFunctions(const char *source, SourceSpan **spans)
+{
+    static const char open[] = "<function name='";
+    static const char close[] = "</function>";
+    int count = 0;
+    int capacity = 64;
+    *spans = malloc(sizeof(SourceSpan) * capacity);
+
+    const char *cursor = source;
+    for (;;)
+    {
+        while (isspace((unsigned char)*cursor))
+        {
+            cursor++;
+        }
+        if (*cursor == '\0')
+        {
+            break;
+        }
+        if (strncmp(cursor, open, sizeof(open) - 1) != 0)
+        {
+            free(*spans);
+            return -1;
+        }
+        // Um "</function>" só fecha a declaração se houver um número par de aspas antes dele
+        const char *end = cursor + sizeof(open) - 1;
+        int inString = 0;
+        for (;;)
+        {
+            const char *candidate = strstr(end, close);
+            if (!candidate)
+            {
+                free(*spans);
+                return -1;
+            }
+            for (const char *quote = end; (quote = memchr(quote, '"', (size_t)(candidate - quote))); quote++)
+            {
+                inString = !inString;
+            }
+            end = candidate + sizeof(close) - 1;
+            if (!inString)
+            {
+                break;
+            }
+        }
+
+        if (count == capacity)
+        {
+            capacity *= 2;
+            *spans = realloc(*spans, sizeof(SourceSpan) * capacity);
+        }
+        (*spans)[count].start = cursor;
+        (*spans)[count].length = (size_t)(end - cursor);
+        count++;
+        cursor = end;
+    }
+    if (count == 0)
+    {
+        free(*spans);
+        return -1;
+    }
+    return count;
+}
+
+// Copia a mensagem de erro do mpc para lastError, sem a quebra de linha final
+static void setSyntaxError(mpc_err_t *error)
+{
+    char *message = mpc_err_string(error);
+    snprintf(lastError, sizeof(lastError), "%s", message);
+    size_t length = strlen(lastError);
+    if (length > 0 && lastError[length - 1] == '\n')
+    {
+        lastError[length - 1] = '\0';
+    }
+    free(message);
+    mpc_err_delete(error);
+}
+
+static PhtmlProgram *newProgram(PhtmlRuntime *runtime, mpc_ast_t *ast, PhtmlUnit **units, int unitCount,
+                               Environment *env)
+{
+    PhtmlProgram *compiled = malloc(sizeof(PhtmlProgram));
+    compiled->ast = ast;
+    compiled->units = units;
+    compiled->unitCount = unitCount;
+    compiled->env = env;
+    compiled->runtime = runtime;
+    return compiled;
+}
+
+// Programa da AST do arquivo inteiro, quando ele não pôde ser separado em declarações
+static PhtmlStatus compileWhole(PhtmlRuntime *runtime, const char *name, const char *source, PhtmlProgram **program)
+{
+    mpc_result_t r;
+    if (!mpc_parse(name, source, runtime->grammar->code, &r))
+    {
+        setSyntaxError(r.error);
+        return PHTML_ERROR_SYNTAX;
+    }
+
+    mpc_ast_t *ast = r.output;
+    Environment *env = createEnvironment(NULL);
+
+    // Tipos desconhecidos nas declarações são detectados ao carregar as funções
+    FailHandler handler;
+    failPush(&handler);
+    if (setjmp(handler.jump))
+    {
+        failPop(&handler);
+        snprintf(lastError, sizeof(lastError), "%s", handler.message);
+        freeFunctions(env);
+        mpc_ast_delete(ast);
+        return PHTML_ERROR_RUNTIME;
+    }
+    loadFunctions(ast, env);
+    failPop(&handler);
+
+    *program = newProgram(runtime, ast, NULL, 0, env);
+    return PHTML_OK;
+}
+
+// Tabela das declarações de 'previous' por impressão digital (endereçamento
+// aberto com sondagem linear; 'mask' + 1 posições)
+static PhtmlUnit **indexUnits(const PhtmlProgram *previous, size_t *mask)
+{
+    size_t capacity = 16;
+    while (capacity < (size_t)previous->unitCount * 2)
+    {
+        capacity *= 2;
+    }
+    PhtmlUnit **index = calloc(capacity, sizeof(PhtmlUnit *));
+    *mask = capacity - 1;
+    for (int i = 0; i < previous->unitCount; i++)
+    {
+        size_t slot = previous->units[i]->fingerprint & *mask;
+        while (index[slot])
+        {
+            slot = (slot + 1) & *mask;
+        }
+        index[slot] = previous->units[i];
+    }
+    return index;
+}
+
+static PhtmlUnit *findUnit(PhtmlUnit **index, size_t mask, uint64_t print, const SourceSpan *span)
+{
+    for (size_t slot = print & mask; index[slot]; slot = (slot + 1) & mask)
+    {
+        PhtmlUnit *unit = index[slot];
+        if (unit->fingerprint == print && unit->length == span->length &&
+            memcmp(unit->text, span->start, span->length) == 0)
+        {
+            return unit;
+        }
+    }
+    return NULL;
+}
+
+// Analisa uma declaração sozinha e carrega a sua função; NULL em um erro, com
+// PHTML_ERROR_SYNTAX (sem mensagem) ou PHTML_ERROR_RUNTIME em 'status'
+static PhtmlUnit *parseUnit(PhtmlRuntime *runtime, const char *name, const SourceSpan *span, uint64_t print,
+                            PhtmlStatus *status)
+{
+    char *text = malloc(span->length + 1);
+    memcpy(text, span->start, span->length);
+    text[span->length] = '\0';
+
+    mpc_result_t r;
+    if (!mpc_parse(name, text, runtime->grammar->code, &r))
+    {
+        mpc_err_delete(r.error);
+        free(text);
+        *status = PHTML_ERROR_SYNTAX;
+        return NULL;
+    }
+
+    // Tipos desconhecidos nas declarações são detectados ao carregar a função
+    Environment *scratch = createEnvironment(NULL);
+    FailHandler handler;
+    failPush(&handler);
+    if (setjmp(handler.jump))
+    {
+        failPop(&handler);
+        snprintf(lastError, sizeof(lastError), "%s", handler.message);
+        freeFunctions(scratch);
+        mpc_ast_delete(r.output);
+        free(text);
+        *status = PHTML_ERROR_RUNTIME;
+        return NULL;
+    }
+    loadFunctions(r.output, scratch);
+    failPop(&handler);
+
+    PhtmlUnit *unit = malloc(sizeof(PhtmlUnit));
+    unit->text = text;
+    unit->length = span->length;
+    unit->fingerprint = print;
+    unit->ast = r.output;
+    unit->hasFunction = scratch->functionCount > 0;
+    if (unit->hasFunction)
+    {
+        unit->function = scratch->functions[0];
+    }
+    unit->refs = 1;
+    free(scratch->functions);
+    free(scratch);
+    return unit;
+}
+
+PhtmlStatus phtmlRecompile(PhtmlRuntime *runtime, const PhtmlProgram *previous, const char *name,
+                           const char *source, PhtmlProgram **program)
+{
+    *program = NULL;
+    lastError[0] = '\0';
+
+    SourceSpan *spans;
+    int count = splitFunctions(source, &spans);
+    if (count < 0)
+    {
+        return compileWhole(runtime, name, source, program);
+    }
+
+    PhtmlStatus status;
+    size_t mask = 0;
+    PhtmlUnit **index = previous && previous->unitCount > 0 ? indexUnits(previous, &mask) : NULL;
+    PhtmlUnit **units = malloc(sizeof(PhtmlUnit *) * count);
+    for (int i = 0; i < count; i++)
+    {
+        uint64_t print = fingerprint(spans[i].start, spans[i].length);
+        PhtmlUnit *unit = index ? findUnit(index, mask, print, &spans[i]) : NULL;
+        if (unit)
+        {
+            __atomic_add_fetch(&unit->refs, 1, __ATOMIC_RELAXED);
+        }
+        else if (!(unit = parseUnit(runtime, name, &spans[i], print, &status)))
+        {
+            releaseUnits(units, i);
+            free(index);
+            free(spans);
+            // A mensagem de um erro de sintaxe vem da análise do arquivo inteiro,
+            // com a linha e a coluna no arquivo e não na declaração
+            return status == PHTML_ERROR_SYNTAX ? compileWhole(runtime, name, source, program) : status;
+        }
+        units[i] = unit;
+    }
+    free(index);
+    free(spans);
+
+    // As funções já estão carregadas nas declarações; o programa só copia as entradas
+    Environment *env = createEnvironment(NULL);
+    for (int i = 0; i < count; i++)
+    {
+        if (units[i]->hasFunction)
+        {
+            addFunction(env, units[i]->function);
+        }
+    }
+    *program = newProgram(runtime, NULL, units, count, env);
+    return PHTML_OK;
+}
+
+PhtmlStatus phtmlCompile(PhtmlRuntime *runtime, const char *name, const char *source, PhtmlProgram **program)
+{
+    return phtmlRecompile(runtime, NULL, name, source, program);
+}
+
+// Conteúdo do arquivo terminado em '\0'; NULL em um erro, com a mensagem em lastError
+static char *readSource(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        snprintf(lastError, sizeof(lastError), "Erro: não foi possível abrir '%s'", path);
+        return NULL;
+    }
+
+    size_t length = 0;
+    size_t capacity = 4096;
+    char *source = malloc(capacity);
+    size_t count;
+    while ((count = fread(source + length, 1, capacity - length - 1, file)) > 0)
+    {
+        length += count;
+        if (capacity - length == 1)
+        {
+            capacity *= 2;
+            source = realloc(source, capacity);
+        }
+    }
+    int failed = ferror(file);
+    fclose(file);
+    if (failed)
+    {
+        free(source);
+        snprintf(lastError, sizeof(lastError), "Erro: falha ao ler '%s'", path);
+        return NULL;
+    }
+    source[length] = '\0';
+    return source;
+}
+
+PhtmlStatus phtmlRecompileFile(PhtmlRuntime *runtime, const PhtmlProgram *previous, const char *path,
+                               PhtmlProgram **program)
+{
+    *program = NULL;
+    char *source = readSource(path);
+    if (!source)
+    {
+        return PHTML_ERROR_IO;
+    }
+    PhtmlStatus status = phtmlRecompile(runtime, previous, path, source, program);
+    free(source);
+    return status;
+}
+
+PhtmlStatus phtmlCompileFile(PhtmlRuntime *runtime, const char *path, PhtmlProgram **program)
+{
+    return phtmlRecompileFile(runtime, NULL, path, program);
+}
+
+void phtmlDestroyProgram(PhtmlProgram *program)
+{
+    if (!program)
+    {
+        return;
+    }
+    if (program->units)
+    {
+        // Os nomes e parâmetros das funções são das declarações
+        free(program->env->functions);
+        free(program->env);
+        releaseUnits(program->units, program->unitCount);
+    }
+    else
+    {
+        freeFunctions(program->env);
+        mpc_ast_delete(program->ast);
+    }
+    free(program);
+}
+
+// Converte um argumento para o tipo do parâmetro, como widenValue faz em um <call>
+static int convertArgument(PhtmlValue arg, ValueType target, Value *out)
+{
+    Value val;
+    switch (arg.type)
+    {
+    case PHTML_INT:
+        val.type = TYPE_INT;
+        val.value.intValue = arg.value.intValue;
+        break;
+    case PHTML_LONG:
+        val.type = TYPE_LONG;
+        val.value.longValue = arg.value.longValue;
+        break;
+    case PHTML_DOUBLE:
+        val.type = TYPE_DOUBLE;
+        val.value.doubleValue = arg.value.doubleValue;
+        break;
+    case PHTML_BOOL:
+        val.type = TYPE_BOOL;
+        val.value.boolValue = arg.value.boolValue;
+        break;
+    case PHTML_STRING:
+        if (!arg.value.stringValue)
+        {
+            return 0;
+        }
+        val.type = TYPE_STRING;
+        val.value.stringValue = (char *)arg.value.stringValue; // setVariable copia
+        break;
+    default:
+        return 0;
+    }
+
+    // Parâmetros float recebem double sem a conversão explícita que C exigiria
+    if (target == TYPE_FLOAT && (val.type == TYPE_INT || val.type == TYPE_DOUBLE))
+    {
+        float value = val.type == TYPE_INT ? (float)val.value.intValue : (float)val.value.doubleValue;
+        val.type = TYPE_FLOAT;
+        val.value.floatValue = value;
+    }
+    val = widenValue(target, val);
+    if (val.type != target)
+    {
+        return 0;
+    }
+    *out = val;
+    return 1;
+}
+
+static PhtmlValue exportValue(Value value)
+{
+    PhtmlValue val;
+    switch (value.type)
+    {
+    case TYPE_INT:
+        return phtmlInt(value.value.intValue);
+    case TYPE_LONG:
+        return phtmlLong(value.value.longValue);
+    case TYPE_FLOAT:
+        return phtmlDouble(value.value.floatValue);
+    case TYPE_DOUBLE:
+        return phtmlDouble(value.value.doubleValue);
+    case TYPE_BOOL:
+        return phtmlBool(value.value.boolValue);
+    case TYPE_CHAR:
+    {
+        char *text = malloc(2);
+        text[0] = value.value.charValue;
+        text[1] = '\0';
+        return phtmlString(text);
+    }
+    case TYPE_STRING:
+        // O valor de getReturnValue já é uma cópia; passa a pertencer a quem chamou
+        return phtmlString(value.value.stringValue);
+    default:
+        // Arrays e maps não têm representação na API
+        val.type = PHTML_VOID;
+        return val;
+    }
+}
+
+// Execução comum a phtmlRun e phtmlRunBuffered; com 'growing' a saída amplia o
+// buffer em vez de ser cortada, então a função nunca precisa ser executada de novo
+static PhtmlStatus runEntry(PhtmlProgram *program, const char *entry, const PhtmlValue *args, int argCount,
+                            char **output, size_t *capacity, int growing, size_t *length, PhtmlValue *result)
+{
+    lastError[0] = '\0';
+    *length = 0;
+    if (*capacity > 0)
+    {
+        (*output)[0] = '\0';
+    }
+    if (result)
+    {
+        result->type = PHTML_VOID;
+    }
+
+    Function *function = findFunction(program->env, entry);
+    if (!function)
+    {
+        snprintf(lastError, sizeof(lastError), "Erro: função '%s' não encontrada", entry);
+        return PHTML_ERROR_NOT_FOUND;
+    }
+    if (argCount != function->paramCount)
+    {
+        snprintf(lastError, sizeof(lastError), "Erro: função '%s' espera %d argumentos, mas recebeu %d",
+                 entry, function->paramCount, argCount);
+        return PHTML_ERROR_ARGUMENTS;
+    }
+
+    // O ambiente da execução fica abaixo do global, como o de um <call>
+    Environment *runEnv = createEnvironment(program->env);
+    for (int i = 0; i < argCount; i++)
+    {
+        Value val;
+        if (!convertArgument(args[i], function->parameters[i].type, &val))
+        {
+            snprintf(lastError, sizeof(lastError),
+                     "Erro: argumento %d de '%s' não pode ser convertido para %s",
+                     i + 1, entry, getTypeString(function->parameters[i].type));
+            freeEnvironment(runEnv);
+            return PHTML_ERROR_ARGUMENTS;
+        }
+        setVariable(runEnv, function->parameters[i].name, val);
+    }
+
+    PhtmlStatus status = PHTML_OK;
+    if (growing)
+    {
+        outputCaptureGrowing(output, capacity);
+    }
+    else
+    {
+        outputCapture(*output, *capacity);
+    }
+
+    const PhtmlLimits *limits = &program->runtime->limits;
+    Budget budget = {limits->steps, limits->milliseconds, limits->heapBytes, limits->callDepth};
+
+    FailHandler handler;
+    failPush(&handler);
+    if (setjmp(handler.jump) == 0)
+    {
+        budgetStart(&budget);
+        evaluateCommandList(function->body, runEnv);
+        Value returned = getReturnValue(function->returnType, findVariable(runEnv, "return"));
+        if (result)
+        {
+            *result = exportValue(returned);
+        }
+        else if (returned.type == TYPE_STRING)
+        {
+            free(returned.value.stringValue);
+        }
+    }
+    else
+    {
+        snprintf(lastError, sizeof(lastError), "%s", handler.message);
+        status = budgetExceeded() ? PHTML_ERROR_LIMIT : PHTML_ERROR_RUNTIME;
+    }
+    budgetStop();
+    failPop(&handler);
+
+    *length = outputRelease();
+    if (*length < *capacity)
+    {
+        (*output)[*length] = '\0';
+    }
+    else if (status == PHTML_OK)
+    {
+        snprintf(lastError, sizeof(lastError),
+                 "Erro: a saída tem %zu bytes e o buffer, %zu", *length, *capacity);
+        status = PHTML_ERROR_TRUNCATED;
+    }
+    freeEnvironment(runEnv);
+    return status;
+}
+
+PhtmlStatus phtmlRun(PhtmlProgram *program, const char *entry, const PhtmlValue *args, int argCount,
+                     char *output, size_t capacity, size_t *length, PhtmlValue *result)
+{
+    return runEntry(program, entry, args, argCount, &output, &capacity, 0, length, result);
+}
+
+PhtmlStatus phtmlRunBuffered(PhtmlProgram *program, const char *entry, const PhtmlValue *args, int argCount,
+                             char **output, size_t *capacity, size_t *length, PhtmlValue *result)
+{
+    if (!*output)
+    {
+        *capacity = PHTML_OUTPUT_INITIAL;
+        *output = malloc(*capacity);
+    }
+
+    PhtmlStatus status = runEntry(program, entry, args, argCount, output, capacity, 1, length, result);
+
+    // Só sem memória para ampliar o buffer a saída fica cortada; '*length' passa a
+    // ser o que de fato está no buffer
+    if (*length >= *capacity)
+    {
+        *length = *capacity - 1;
+        (*output)[*length] = '\0';
+    }
+    return status;
+}
+
+void phtmlReleaseValue(PhtmlValue *value)
+{
+    if (value->type == PHTML_STRING)
+    {
+        free((char *)value->value.stringValue);
+        value->value.stringValue = NULL;
+    }
+    value->type = PHTML_VOID;
+}
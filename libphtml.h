@@ -0,0 +1,156 @@
+#ifndef LIBPHTML_H
+#define LIBPHTML_H
+
+#include <stddef.h>
+
+// Interface para embutir o interpretador em outro programa (libphtml.so)
+//
+//     PhtmlRuntime *runtime = phtmlCreateRuntime();
+//     PhtmlProgram *program;
+//     if (phtmlCompileFile(runtime, "pagina.phtml", &program) != PHTML_OK)
+//         fprintf(stderr, "%s\n", phtmlError(runtime));
+//
+//     PhtmlValue args[] = {phtmlString("Ana"), phtmlInt(3)};
+//     char out[4096];
+//     size_t length;
+//     phtmlRun(program, "render", args, 2, out, sizeof(out), &length, NULL);
+//
+//     phtmlDestroyProgram(program);
+//     phtmlDestroyRuntime(runtime);
+//
+// Nenhuma função encerra o processo: erros de sintaxe e de execução retornam um
+// PhtmlStatus e a mensagem fica disponível em phtmlError. O programa compilado
+// não muda entre execuções, então pode ser executado quantas vezes for preciso
+// sem ser analisado de novo.
+//
+// Threads: o runtime e os programas compilados podem ser compartilhados. Várias
+// threads podem compilar e executar ao mesmo tempo, inclusive o mesmo programa;
+// o estado de cada execução (variáveis, buffer de saída, erro) é da thread que
+// chamou phtmlRun. Só a destruição exige que ninguém mais use o objeto.
+
+// Com -fvisibility=hidden, só as funções marcadas com PHTML_API são exportadas
+// pela libphtml.so; o resto do interpretador fica interno à biblioteca
+#if defined(__GNUC__)
+#define PHTML_API __attribute__((visibility("default")))
+#else
+#define PHTML_API
+#endif
+
+typedef struct PhtmlRuntime PhtmlRuntime;
+typedef struct PhtmlProgram PhtmlProgram;
+
+typedef enum
+{
+    PHTML_OK,
+    PHTML_ERROR_SYNTAX,    // o texto não segue a gramática
+    PHTML_ERROR_RUNTIME,   // erro ao carregar ou executar (ex.: divisão por zero)
+    PHTML_ERROR_NOT_FOUND, // a função de entrada não existe
+    PHTML_ERROR_ARGUMENTS, // quantidade ou tipo de argumentos incompatível com a função
+    PHTML_ERROR_TRUNCATED, // a saída não coube no buffer (o tamanho total é informado)
+    PHTML_ERROR_IO,        // o arquivo de phtmlCompileFile não pôde ser lido
+    PHTML_ERROR_LIMIT      // a execução passou de um dos limites de phtmlSetLimits
+} PhtmlStatus;
+
+// Nome curto do status para mensagens ("ok", "erro de sintaxe", ...)
+PHTML_API const char *phtmlStatusString(PhtmlStatus status);
+
+typedef enum
+{
+    PHTML_VOID,
+    PHTML_INT,
+    PHTML_LONG,
+    PHTML_DOUBLE,
+    PHTML_BOOL,
+    PHTML_STRING
+} PhtmlType;
+
+typedef struct
+{
+    PhtmlType type;
+    union
+    {
+        int intValue;
+        long long longValue;
+        double doubleValue;
+        int boolValue;
+        const char *stringValue;
+    } value;
+} PhtmlValue;
+
+PHTML_API PhtmlValue phtmlInt(int value);
+PHTML_API PhtmlValue phtmlLong(long long value);
+PHTML_API PhtmlValue phtmlDouble(double value);
+PHTML_API PhtmlValue phtmlBool(int value);
+PHTML_API PhtmlValue phtmlString(const char *value); // não copia: a string deve durar até o fim de phtmlRun
+
+// Valor de um argumento escrito como texto (linha de comando, lista do --batch):
+// "true"/"false" viram bool, inteiros viram int (ou long, se não couberem),
+// números com ponto ou expoente viram double e o resto é string (sem cópia)
+PHTML_API PhtmlValue phtmlParseArgument(const char *text);
+
+// O runtime guarda a gramática, montada uma vez
+PHTML_API PhtmlRuntime *phtmlCreateRuntime(void);
+PHTML_API void phtmlDestroyRuntime(PhtmlRuntime *runtime);
+
+// Mensagem do último erro na thread que chamou (como errno)
+PHTML_API const char *phtmlError(const PhtmlRuntime *runtime);
+
+// Limites de cada execução, para scripts que não são de confiança; 0 é sem limite
+// Um passo é uma volta de <while> ou uma chamada de função. A memória conta os
+// blocos vivos alocados pelo interpretador durante a execução (variáveis,
+// strings, arrays...), sem a saída. Ao passar de um limite, phtmlRun para e
+// retorna PHTML_ERROR_LIMIT, com a saída produzida até ali.
+// A profundidade de chamadas nunca fica sem limite: com 0 vale o padrão (2000),
+// para que uma recursão sem fim não estoure a pilha da thread que executa.
+typedef struct
+{
+    unsigned long long steps;
+    long milliseconds; // tempo de relógio
+    size_t heapBytes;
+    int callDepth; // chamadas aninhadas; 0: o padrão
+} PhtmlLimits;
+
+// Vale para as execuções seguintes dos programas compilados por 'runtime'; deve
+// ser chamada antes de executar, não durante execuções em outras threads
+PHTML_API void phtmlSetLimits(PhtmlRuntime *runtime, const PhtmlLimits *limits);
+
+// 'name' aparece nas mensagens de erro de sintaxe
+PHTML_API PhtmlStatus phtmlCompile(PhtmlRuntime *runtime, const char *name, const char *source, PhtmlProgram **program);
+PHTML_API PhtmlStatus phtmlCompileFile(PhtmlRuntime *runtime, const char *path, PhtmlProgram **program);
+PHTML_API void phtmlDestroyProgram(PhtmlProgram *program);
+
+// Compila uma nova versão do arquivo de 'previous' (recarga depois de uma edição)
+// Cada declaração de função é identificada pelo seu texto: só as que mudaram ou
+// são novas passam pela gramática, e as outras reaproveitam a análise de
+// 'previous'. O resultado é um programa independente: 'previous' continua válido,
+// inclusive para execuções em andamento, e pode ser destruído antes ou depois
+// dele. Com 'previous' NULL, é o mesmo que phtmlCompile.
+PHTML_API PhtmlStatus phtmlRecompile(PhtmlRuntime *runtime, const PhtmlProgram *previous, const char *name,
+                                     const char *source, PhtmlProgram **program);
+PHTML_API PhtmlStatus phtmlRecompileFile(PhtmlRuntime *runtime, const PhtmlProgram *previous, const char *path,
+                                         PhtmlProgram **program);
+
+// Executa a função 'entry' com os argumentos dados, convertidos para os tipos dos
+// parâmetros como em um <call> (int vira long ou double, por exemplo)
+//
+// A saída do <print> vai para 'output', como em snprintf: até 'capacity' bytes,
+// terminada em '\0' quando houver espaço, e '*length' recebe o tamanho total. Se
+// não sobrar espaço para o '\0' o status é PHTML_ERROR_TRUNCATED. Em um erro de
+// execução, a saída produzida até o erro continua em 'output'.
+//
+// Se 'result' não for NULL, recebe o valor retornado pela função; strings devem
+// ser liberadas com phtmlReleaseValue.
+PHTML_API PhtmlStatus phtmlRun(PhtmlProgram *program, const char *entry, const PhtmlValue *args, int argCount,
+                               char *output, size_t capacity, size_t *length, PhtmlValue *result);
+
+// Como phtmlRun, mas com um buffer de saída que cresce (com realloc) durante a
+// execução, que acontece uma vez só. '*output' pode começar NULL e ser
+// reaproveitado entre execuções; quem chamou libera com free. A saída fica
+// completa e terminada em '\0'; só se faltar memória para ampliar o buffer ela é
+// cortada, com PHTML_ERROR_TRUNCATED e '*length' igual ao que coube.
+PHTML_API PhtmlStatus phtmlRunBuffered(PhtmlProgram *program, const char *entry, const PhtmlValue *args, int argCount,
+                                       char **output, size_t *capacity, size_t *length, PhtmlValue *result);
+
+PHTML_API void phtmlReleaseValue(PhtmlValue *value);
+
+#endif
@@ -0,0 +1,290 @@
+// Gerador de carga para o servidor (phtml --serve)
+//
+//     phtml-load [-c conexões] [-n pedidos | -d segundos] <socket> <pedido>
+//     phtml-load -c 8 -d 5 /tmp/phtml.sock 'paginas/produto.phtml 42 "Cadeira azul"'
+//
+// Cada conexão tem uma thread que envia o pedido, espera a resposta completa e
+// envia o próximo (carga em malha fechada). No fim são impressos os pedidos por
+// segundo e a latência (p50, p90, p99, p99.9 e máxima), medida do envio até o
+// último byte da resposta. A primeira resposta de um arquivo inclui a análise.
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "bench/medida.h"
+
+#define LOAD_BUFFER 65536
+
+typedef struct
+{
+    const char *socketPath;
+    const char *request;
+    size_t requestLength;
+    long remaining;  // pedidos ainda não iniciados, com -n
+    double deadline; // fim da medição, com -d (segundos no relógio monotônico)
+} Load;
+
+typedef struct
+{
+    Load *load;
+    double *latencies; // microssegundos
+    long count;
+    long capacity;
+    long errors;   // respostas com status diferente de 0
+    int failed;    // a conexão caiu
+    size_t bytes;  // saída recebida
+} Client;
+
+// Leitura com buffer de uma conexão
+typedef struct
+{
+    int fd;
+    char data[LOAD_BUFFER];
+    size_t start;
+    size_t end;
+} Reader;
+
+static int fill(Reader *reader)
+{
+    if (reader->start == reader->end)
+    {
+        reader->start = reader->end = 0;
+    }
+    ssize_t received;
+    do
+    {
+        received = recv(reader->fd, reader->data + reader->end, sizeof(reader->data) - reader->end, 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0)
+    {
+        return 0;
+    }
+    reader->end += received;
+    return 1;
+}
+
+// Lê "status tamanho\n" e descarta a saída; retorna 0 se a conexão caiu
+static int readResponse(Reader *reader, int *status, size_t *length)
+{
+    char header[64];
+    size_t headerLength = 0;
+    for (;;)
+    {
+        if (reader->start == reader->end && !fill(reader))
+        {
+            return 0;
+        }
+        char c = reader->data[reader->start++];
+        if (c == '\n')
+        {
+            break;
+        }
+        if (headerLength + 1 >= sizeof(header))
+        {
+            return 0;
+        }
+        header[headerLength++] = c;
+    }
+    header[headerLength] = '\0';
+    if (sscanf(header, "%d %zu", status, length) != 2)
+    {
+        return 0;
+    }
+
+    size_t left = *length;
+    while (left > 0)
+    {
+        if (reader->start == reader->end && !fill(reader))
+        {
+            return 0;
+        }
+        size_t available = reader->end - reader->start;
+        size_t used = available < left ? available : left;
+        reader->start += used;
+        left -= used;
+    }
+    return 1;
+}
+
+static int connectTo(const char *socketPath)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+static int takeRequest(Load *load)
+{
+    if (load->deadline > 0)
+    {
+        return measureNow() < load->deadline;
+    }
+    return __atomic_sub_fetch(&load->remaining, 1, __ATOMIC_RELAXED) >= 0;
+}
+
+static void *runClient(void *argument)
+{
+    Client *client = argument;
+    Load *load = client->load;
+    Reader *reader = malloc(sizeof(Reader));
+    reader->start = reader->end = 0;
+    reader->fd = connectTo(load->socketPath);
+    if (reader->fd < 0)
+    {
+        fprintf(stderr, "Erro: não foi possível conectar a '%s': %s\n", load->socketPath, strerror(errno));
+        client->failed = 1;
+        free(reader);
+        return NULL;
+    }
+
+    while (takeRequest(load))
+    {
+        double start = measureNow();
+        if (send(reader->fd, load->request, load->requestLength, MSG_NOSIGNAL) != (ssize_t)load->requestLength)
+        {
+            client->failed = 1;
+            break;
+        }
+        int status;
+        size_t length;
+        if (!readResponse(reader, &status, &length))
+        {
+            client->failed = 1;
+            break;
+        }
+        double latency = (measureNow() - start) * 1e6;
+
+        if (client->count == client->capacity)
+        {
+            client->capacity = client->capacity ? client->capacity * 2 : 4096;
+            client->latencies = realloc(client->latencies, sizeof(double) * client->capacity);
+        }
+        client->latencies[client->count++] = latency;
+        client->errors += status != 0;
+        client->bytes += length;
+    }
+
+    close(reader->fd);
+    free(reader);
+    return NULL;
+}
+
+static double percentile(const double *sorted, long count, double fraction)
+{
+    long index = (long)(fraction * count + 0.5) - 1;
+    if (index < 0)
+        index = 0;
+    if (index >= count)
+        index = count - 1;
+    return sorted[index];
+}
+
+int main(int argc, char **argv)
+{
+    int connections = 1;
+    long requests = 1000;
+    double seconds = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            connections = atoi(optarg);
+            break;
+        case 'n':
+            requests = atol(optarg);
+            break;
+        case 'd':
+            seconds = atof(optarg);
+            break;
+        default:
+            optind = argc + 1;
+        }
+    }
+    if (optind + 2 != argc || connections < 1)
+    {
+        fprintf(stderr, "Uso: %s [-c conexões] [-n pedidos | -d segundos] <socket> <pedido>\n", argv[0]);
+        return 2;
+    }
+
+    Load load;
+    load.socketPath = argv[optind];
+    size_t length = strlen(argv[optind + 1]);
+    char *request = malloc(length + 2);
+    memcpy(request, argv[optind + 1], length);
+    request[length] = '\n';
+    request[length + 1] = '\0';
+    load.request = request;
+    load.requestLength = length + 1;
+    load.remaining = requests;
+
+    Client *clients = calloc(connections, sizeof(Client));
+    pthread_t *threads = malloc(sizeof(pthread_t) * connections);
+    double start = measureNow();
+    load.deadline = seconds > 0 ? start + seconds : 0;
+    for (int i = 0; i < connections; i++)
+    {
+        clients[i].load = &load;
+        pthread_create(&threads[i], NULL, runClient, &clients[i]);
+    }
+    for (int i = 0; i < connections; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = measureNow() - start;
+
+    long count = 0;
+    long errors = 0;
+    int failed = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < connections; i++)
+    {
+        count += clients[i].count;
+        errors += clients[i].errors;
+        failed += clients[i].failed;
+        bytes += clients[i].bytes;
+    }
+    double *latencies = malloc(sizeof(double) * (count ? count : 1));
+    long position = 0;
+    for (int i = 0; i < connections; i++)
+    {
+        memcpy(latencies + position, clients[i].latencies, sizeof(double) * clients[i].count);
+        position += clients[i].count;
+        free(clients[i].latencies);
+    }
+
+    printf("%ld pedidos em %.3f s por %d conexões (%d caíram), %ld com erro, %zu bytes de saída\n",
+           count, elapsed, connections, failed, errors, bytes);
+    if (count > 0)
+    {
+        qsort(latencies, count, sizeof(double), measureCompareDoubles);
+        printf("%.0f pedidos/s\n", count / elapsed);
+        printf("latência (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  máx %.1f\n",
+               percentile(latencies, count, 0.50), percentile(latencies, count, 0.90),
+               percentile(latencies, count, 0.99), percentile(latencies, count, 0.999),
+               latencies[count - 1]);
+    }
+
+    free(latencies);
+    free(clients);
+    free(threads);
+    free(request);
+    return failed || count == 0 ? 1 : 0;
+}
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpc.h"
+#include "phtml.h"
+#include "grammar.h"
+#include "jit.h"
+#include "emitc.h"
+#include "ir.h"
+#include "opt.h"
+#include "output.h"
+#include "batch.h"
+#include "server.h"
+#include "profile.h"
+#include "stats.h"
+#include "trace.h"
+#include "alloc.h"
+#include "budget.h"
+
+// Tamanho como 512, 64K, 10M ou 1G (para --max-heap)
+static size_t parseSize(const char *text)
+{
+    char *end;
+    double value = strtod(text, &end);
+    switch (*end)
+    {
+    case 'k':
+    case 'K':
+        value *= 1024;
+        break;
+    case 'm':
+    case 'M':
+        value *= 1024 * 1024;
+        break;
+    case 'g':
+    case 'G':
+        value *= 1024.0 * 1024 * 1024;
+        break;
+    }
+    return value > 0 ? (size_t)value : 0;
+}
+
+// Linha de comando: phtml [opções] arquivo.phtml
+int main(int argc, char **argv)
+{
+    // Interpreta as opções da linha de comando
+    const char *fileName = NULL;
+    int emitC = 0;
+    int optimize = 0;
+    int inlineBudget = OPT_DEFAULT_INLINE_BUDGET;
+    int batch = 0;
+    int serve = 0;
+    int profile = 0;
+    int sampleRate = 0;
+    int showStats = 0;
+    int allocReport = 0;
+    int jitThreshold = 0;
+    const char *tracePath = NULL;
+    const char *foldedPath = NULL;
+    BatchOptions batchOptions = {0, NULL, {0, 0, 0, 0}};
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--emit-c") == 0)
+        {
+            emitC = 1;
+        }
+        else if (strcmp(argv[i], "-O") == 0)
+        {
+            optimize = 1;
+        }
+        else if (strncmp(argv[i], "--inline-budget=", 16) == 0)
+        {
+            inlineBudget = atoi(argv[i] + 16);
+        }
+        else if (strcmp(argv[i], "--jit") == 0)
+        {
+            jitThreshold = JIT_DEFAULT_THRESHOLD;
+        }
+        else if (strncmp(argv[i], "--jit-threshold=", 16) == 0)
+        {
+            jitThreshold = atoi(argv[i] + 16);
+        }
+        else if (strcmp(argv[i], "--batch") == 0)
+        {
+            batch = 1;
+        }
+        else if (strcmp(argv[i], "--serve") == 0)
+        {
+            serve = 1;
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            profile = 1;
+        }
+        else if (strncmp(argv[i], "--profile-folded=", 17) == 0)
+        {
+            foldedPath = argv[i] + 17;
+        }
+        else if (strncmp(argv[i], "--sample-profile=", 17) == 0)
+        {
+            sampleRate = atoi(argv[i] + 17);
+        }
+        else if (strncmp(argv[i], "--trace=", 8) == 0)
+        {
+            tracePath = argv[i] + 8;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            showStats = 1;
+        }
+        else if (strcmp(argv[i], "--alloc-report") == 0)
+        {
+            allocReport = 1;
+        }
+        else if (strncmp(argv[i], "--max-steps=", 12) == 0)
+        {
+            batchOptions.limits.steps = strtoull(argv[i] + 12, NULL, 10);
+        }
+        else if (strncmp(argv[i], "--max-time=", 11) == 0)
+        {
+            batchOptions.limits.milliseconds = atol(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--max-heap=", 11) == 0)
+        {
+            batchOptions.limits.heapBytes = parseSize(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--max-depth=", 12) == 0)
+        {
+            batchOptions.limits.callDepth = atoi(argv[i] + 12);
+        }
+        else if (strncmp(argv[i], "--jobs=", 7) == 0)
+        {
+            batchOptions.workers = atoi(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "--output-dir=", 13) == 0)
+        {
+            batchOptions.outputDir = argv[i] + 13;
+        }
+        else
+        {
+            fileName = argv[i];
+        }
+    }
+
+    // O código nativo do JIT não conta passos (ver budget.h), então os limites o desligam
+    // No --batch e no --serve ele também fica desligado: os contadores de chamadas
+    // e o código compilado de cada Function não são protegidos para várias threads
+    const PhtmlLimits *limits = &batchOptions.limits;
+    int limited = limits->steps > 0 || limits->milliseconds > 0 || limits->heapBytes > 0;
+    if (jitThreshold > 0 && !limited && !batch && !serve)
+    {
+        jitEnable(jitThreshold);
+    }
+
+    // Com --batch o arquivo é a lista de jobs (ver batch.h)
+    if (batch && fileName)
+    {
+        return batchRun(fileName, &batchOptions);
+    }
+
+    // Com --serve o arquivo é o caminho do socket (ver server.h)
+    if (serve && fileName)
+    {
+        return serverRun(fileName, batchOptions.workers, limits);
+    }
+
+    if (showStats && fileName)
+    {
+        statsEnable();
+    }
+    if (tracePath && fileName)
+    {
+        traceEnable(tracePath);
+    }
+    if (allocReport && fileName)
+    {
+        allocEnable();
+    }
+
+    // Definição dos parsers usando a gramática BNF
+    statsStart(STATS_GRAMMAR);
+    if (traceEnabled)
+        traceBegin("grammarCreate", "phase", NULL);
+    Grammar *grammar = grammarCreate();
+    if (traceEnabled)
+        traceEnd();
+    statsStop(STATS_GRAMMAR);
+
+    // Verifica se um arquivo foi fornecido como argumento
+    if (fileName)
+    {
+        mpc_result_t r;
+        statsStart(STATS_PARSE);
+        if (traceEnabled)
+            traceBegin("mpc_parse_contents", "phase", NULL);
+        int parsed = mpc_parse_contents(fileName, grammar->code, &r);
+        if (traceEnabled)
+            traceEnd();
+        statsStop(STATS_PARSE);
+        if (parsed)
+        {
+            mpc_ast_t *ast = (mpc_ast_t *)r.output;
+            // Inicializa o ambiente de execução
+            Environment *env = createEnvironment(NULL);
+
+            // Carrega as funções do arquivo
+            statsStart(STATS_LOAD);
+            if (traceEnabled)
+                traceBegin("loadFunctions", "phase", NULL);
+            loadFunctions(ast, env);
+            if (traceEnabled)
+                traceEnd();
+            statsStop(STATS_LOAD);
+
+            // Encontra a função main e executa
+            Function *mainFunc = findFunction(env, "main");
+            outputInit();
+
+            // O perfil mede o interpretador de árvore (ver profile.h), então -O é ignorado
+            if (sampleRate > 0 && !emitC)
+            {
+                profileEnableSampling(sampleRate, foldedPath ? foldedPath : PROFILE_SAMPLE_OUTPUT);
+                optimize = 0;
+            }
+            else if ((profile || foldedPath) && !emitC)
+            {
+                profileEnable(fileName, foldedPath);
+                optimize = 0;
+            }
+            Budget budget = {limits->steps, limits->milliseconds, limits->heapBytes, limits->callDepth};
+            statsStart(STATS_EXECUTE);
+            if (traceEnabled)
+                traceBegin("execute", "phase", NULL);
+            if (emitC)
+            {
+                // Com --emit-c o programa é traduzido para C em vez de executado
+                emitProgram(stdout, env, budget.depth > 0 ? budget.depth : BUDGET_DEFAULT_DEPTH);
+            }
+            else if (optimize)
+            {
+                // Com -O o programa é convertido para a IR e otimizado antes de executar
+                IrProgram *program = irLower(env);
+                optimizeProgram(program, inlineBudget);
+                budgetStart(&budget);
+                irRun(program);
+            }
+            else if (mainFunc)
+            {
+                // Executa a função main
+                if (profileEnabled)
+                    profileEnterCall(mainFunc);
+                if (traceEnabled)
+                    traceBeginCall(mainFunc, NULL, 0);
+                budgetStart(&budget);
+                evaluateCommandList(mainFunc->body, env);
+                if (traceEnabled)
+                    traceEnd();
+                if (profileEnabled)
+                    profileLeaveCall();
+            }
+            else
+            {
+                printf("Erro: função 'main' não encontrada\n");
+            }
+
+            budgetStop();
+
+            // Fim do programa: envia o que ficou no buffer de saída
+            outputFlush();
+            if (traceEnabled)
+                traceEnd();
+            statsStop(STATS_EXECUTE);
+            mpc_ast_delete(ast);
+        }
+        else
+        {
+            mpc_err_print(r.error);
+            mpc_err_delete(r.error);
+        }
+    }
+    else
+    {
+        printf("Uso: %s [-O] [--inline-budget=N] [--jit] [--jit-threshold=N] [--emit-c] <arquivo.phtml>\n", argv[0]);
+        printf("     %s [--profile | --sample-profile=HZ] [--profile-folded=ARQUIVO] <arquivo.phtml>\n", argv[0]);
+        printf("     %s [--stats] [--trace=SAIDA.json] [--alloc-report] [opções] <arquivo.phtml>\n", argv[0]);
+        printf("     %s [--max-steps=N] [--max-time=MS] [--max-heap=BYTES] [--max-depth=N] [opções] <arquivo.phtml>\n", argv[0]);
+        printf("     %s --batch [--jobs=N] [--output-dir=DIR] <lista.txt | ->\n", argv[0]);
+        printf("     %s --serve [--jobs=N] <socket>\n", argv[0]);
+    }
+    // Limpa os parsers
+    grammarDestroy(grammar);
+
+    return 0;
+}
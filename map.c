@@ -0,0 +1,300 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phtml.h"
+#include "error.h"
+#include "array.h"
+#include "map.h"
+#include "alloc.h"
+
+#define MAP_INITIAL_TABLE 16
+
+// Hash de inteiro por multiplicação (os bits altos do produto se espalham pela tabela)
+static unsigned hashInt(int key)
+{
+    uint64_t h = (uint64_t)(unsigned)key * 0x9E3779B97F4A7C15ULL;
+    return (unsigned)(h >> 32) ^ (unsigned)h;
+}
+
+// Hash de string lendo 8 bytes por vez
+static unsigned hashString(const char *key)
+{
+    size_t length = strlen(key);
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ length;
+    while (length >= 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, key, 8);
+        h = (h ^ chunk) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+        key += 8;
+        length -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, key, length);
+    h = (h ^ tail) * 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return (unsigned)h;
+}
+
+Value newMap(void)
+{
+    Map *map = ALLOC_MALLOC(sizeof(Map));
+    map->keyType = TYPE_VOID;
+    map->count = 0;
+    map->used = 0;
+    map->capacity = 0;
+    map->tableSize = 0;
+    map->table = NULL;
+    map->entries = NULL;
+
+    Value val;
+    val.type = TYPE_MAP;
+    val.value.mapValue = map;
+    return val;
+}
+
+static Map *requireMap(Value value)
+{
+    if (value.type != TYPE_MAP)
+    {
+        fail("Erro: valor do tipo %s não é um map\n", getTypeString(value.type));
+    }
+    return value.value.mapValue;
+}
+
+static void requireKeyType(Value key)
+{
+    if (key.type != TYPE_INT && key.type != TYPE_STRING)
+    {
+        fail("Erro: chave de map deve ser int ou string, recebido %s\n", getTypeString(key.type));
+    }
+}
+
+static unsigned hashKey(Value key)
+{
+    return key.type == TYPE_INT ? hashInt(key.value.intValue) : hashString(key.value.stringValue);
+}
+
+static int sameKey(Value a, Value b)
+{
+    if (a.type == TYPE_INT)
+    {
+        return a.value.intValue == b.value.intValue;
+    }
+    return strcmp(a.value.stringValue, b.value.stringValue) == 0;
+}
+
+// Posição na tabela da chave, ou -1; chaves de outro tipo nunca estão no map
+static int findSlot(Map *map, Value key, unsigned hash)
+{
+    if (map->tableSize == 0 || key.type != map->keyType)
+    {
+        return -1;
+    }
+
+    unsigned mask = (unsigned)map->tableSize - 1;
+    for (unsigned i = hash & mask;; i = (i + 1) & mask)
+    {
+        int index = map->table[i];
+        if (index == MAP_EMPTY)
+        {
+            return -1;
+        }
+        if (index >= 0 && map->entries[index].hash == hash && sameKey(map->entries[index].key, key))
+        {
+            return (int)i;
+        }
+    }
+}
+
+// Reconstrói a tabela com 'tableSize' posições, compactando as entradas removidas
+static void rebuild(Map *map, int tableSize)
+{
+    int live = 0;
+    for (int i = 0; i < map->used; i++)
+    {
+        if (map->entries[i].key.type != TYPE_VOID)
+        {
+            map->entries[live++] = map->entries[i];
+        }
+    }
+    map->used = live;
+
+    map->capacity = tableSize / 3 * 2;
+    map->entries = ALLOC_REALLOC(map->entries, sizeof(MapEntry) * map->capacity);
+
+    ALLOC_FREE(map->table);
+    map->tableSize = tableSize;
+    map->table = ALLOC_MALLOC(sizeof(int) * tableSize);
+    memset(map->table, 0xFF, sizeof(int) * tableSize); // MAP_EMPTY
+
+    unsigned mask = (unsigned)tableSize - 1;
+    for (int index = 0; index < live; index++)
+    {
+        unsigned i = map->entries[index].hash & mask;
+        while (map->table[i] != MAP_EMPTY)
+        {
+            i = (i + 1) & mask;
+        }
+        map->table[i] = index;
+    }
+}
+
+Value mapGet(Value map, Value key)
+{
+    Map *m = requireMap(map);
+    requireKeyType(key);
+
+    int slot = findSlot(m, key, hashKey(key));
+    if (slot < 0)
+    {
+        if (key.type == TYPE_INT)
+            fail("Erro: chave %d não encontrada no map\n", key.value.intValue);
+        else
+            fail("Erro: chave \"%s\" não encontrada no map\n", key.value.stringValue);
+    }
+    // Strings continuam pertencendo ao map, como em readVariable
+    return m->entries[m->table[slot]].value;
+}
+
+void mapSet(Value map, Value key, Value value)
+{
+    Map *m = requireMap(map);
+    requireKeyType(key);
+    if (m->keyType == TYPE_VOID)
+    {
+        m->keyType = key.type;
+    }
+    if (key.type != m->keyType)
+    {
+        fail("Erro: chave do tipo %s em um map de chaves %s\n",
+             getTypeString(key.type), getTypeString(m->keyType));
+    }
+    if (value.type == TYPE_VOID)
+    {
+        fail("Erro: valor void não pode ser guardado em um map\n");
+    }
+
+    Value stored = value;
+    if (value.type == TYPE_STRING)
+    {
+        stored.value.stringValue = ALLOC_STRING_COPY(value.value.stringValue);
+    }
+
+    unsigned hash = hashKey(key);
+    int slot = findSlot(m, key, hash);
+    if (slot >= 0)
+    {
+        MapEntry *entry = &m->entries[m->table[slot]];
+        if (entry->value.type == TYPE_STRING)
+        {
+            ALLOC_FREE(entry->value.value.stringValue);
+        }
+        entry->value = stored;
+        return;
+    }
+
+    // Sem espaço: dobra a tabela, ou só compacta se metade das entradas foi removida
+    if (m->used == m->capacity)
+    {
+        int tableSize = m->tableSize ? m->tableSize : MAP_INITIAL_TABLE;
+        if (m->count * 2 > m->capacity)
+        {
+            tableSize = m->tableSize * 2;
+        }
+        rebuild(m, tableSize);
+    }
+
+    int index = m->used++;
+    MapEntry *entry = &m->entries[index];
+    entry->hash = hash;
+    entry->key = key;
+    if (key.type == TYPE_STRING)
+    {
+        entry->key.value.stringValue = ALLOC_STRING_COPY(key.value.stringValue);
+    }
+    entry->value = stored;
+
+    // Reaproveita a primeira posição removida do caminho de sondagem
+    unsigned mask = (unsigned)m->tableSize - 1;
+    unsigned i = hash & mask;
+    while (m->table[i] >= 0)
+    {
+        i = (i + 1) & mask;
+    }
+    m->table[i] = index;
+    m->count++;
+}
+
+Value mapHas(Value map, Value key)
+{
+    Map *m = requireMap(map);
+    requireKeyType(key);
+
+    Value val;
+    val.type = TYPE_BOOL;
+    val.value.boolValue = findSlot(m, key, hashKey(key)) >= 0;
+    return val;
+}
+
+void mapDelete(Value map, Value key)
+{
+    Map *m = requireMap(map);
+    requireKeyType(key);
+
+    int slot = findSlot(m, key, hashKey(key));
+    if (slot < 0)
+    {
+        return;
+    }
+
+    MapEntry *entry = &m->entries[m->table[slot]];
+    if (entry->key.type == TYPE_STRING)
+    {
+        ALLOC_FREE(entry->key.value.stringValue);
+    }
+    if (entry->value.type == TYPE_STRING)
+    {
+        ALLOC_FREE(entry->value.value.stringValue);
+    }
+    entry->key.type = TYPE_VOID;
+    m->table[slot] = MAP_REMOVED;
+    m->count--;
+}
+
+Value mapKeys(Value map)
+{
+    Map *m = requireMap(map);
+    Value keys = newArray(m->keyType);
+    for (int i = 0; i < m->used; i++)
+    {
+        if (m->entries[i].key.type != TYPE_VOID)
+        {
+            arrayPush(keys, m->entries[i].key);
+        }
+    }
+    return keys;
+}
+
+Value indexGet(Value container, Value index)
+{
+    if (container.type == TYPE_MAP)
+    {
+        return mapGet(container, index);
+    }
+    return arrayGet(container, index);
+}
+
+void indexSet(Value container, Value index, Value value)
+{
+    if (container.type == TYPE_MAP)
+    {
+        mapSet(container, index, value);
+        return;
+    }
+    arraySet(container, index, value);
+}
@@ -0,0 +1,37 @@
+#ifndef PHTML_MAP_H
+#define PHTML_MAP_H
+
+#include "phtml.h"
+
+// Maps (<var type='map'>)
+//
+// As chaves são todas int ou todas string (o tipo é definido pela primeira) e os
+// valores podem ser de qualquer tipo. As entradas ficam em um vetor compacto, na
+// ordem de inserção, com o hash de cada chave guardado junto; a tabela de busca
+// guarda só a posição da entrada (4 bytes por posição, 16 por linha de cache) e
+// usa endereçamento aberto com sondagem linear. Uma busca percorre posições
+// vizinhas da tabela e só compara strings quando o hash coincide. A tabela cresce
+// antes de passar de 2/3 de ocupação, e as entradas removidas são descartadas
+// quando ela é reconstruída.
+
+#define MAP_EMPTY -1
+#define MAP_REMOVED -2
+
+Value newMap(void);
+
+// m[k] e <assign var='m[k]'>; ler uma chave ausente encerra o programa
+Value mapGet(Value map, Value key);
+void mapSet(Value map, Value key, Value value);
+
+// <has>m, k</has> (bool) e <delete var='m'>k</delete>
+Value mapHas(Value map, Value key);
+void mapDelete(Value map, Value key);
+
+// <keys>m</keys>: array com as chaves, na ordem de inserção
+Value mapKeys(Value map);
+
+// a[i] e m[k] usam a mesma sintaxe: escolhe entre array e map pelo tipo do valor
+Value indexGet(Value container, Value index);
+void indexSet(Value container, Value index, Value value);
+
+#endif
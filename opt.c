@@ -0,0 +1,595 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phtml.h"
+#include "ir.h"
+#include "opt.h"
+
+// Otimizações sobre a IR
+//
+// Substituição de chamadas (inlining): funções folha pequenas (sem chamadas e
+// sem nós que dependam da árvore) têm o corpo copiado para o local da chamada.
+// Parâmetros, variáveis locais e "return" passam a morar em um vetor na pilha,
+// evitando a criação do ambiente e as buscas por nome. Quando algum desses
+// nomes existe no escopo do chamador a chamada segue pelo caminho normal, pois
+// o escopo dinâmico faria a função alterar a variável do chamador.
+//
+// Laços: subexpressões de um <while> que só leem variáveis não alteradas no
+// laço viram IR_HOISTED, calculadas na primeira vez que são usadas em cada
+// execução do laço (o cálculo acontece no mesmo ponto do original, então erros
+// como divisão por zero aparecem na mesma ordem). Produtos i * k, em que i só
+// muda por 'i = i + c' e k é invariante, viram IR_REDUCED: depois do primeiro
+// cálculo o valor é atualizado somando c * k a cada incremento de i.
+
+static int countNodes(IrNode *node)
+{
+    if (!node)
+    {
+        return 0;
+    }
+
+    int count = 1 + countNodes(node->left) + countNodes(node->right) + countNodes(node->other);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        count += countNodes(node->items[i]);
+    }
+    return count;
+}
+
+// Função folha: não chama outras funções nem depende do interpretador
+static int isLeaf(IrNode *node)
+{
+    if (!node)
+    {
+        return 1;
+    }
+    if (node->kind == IR_CALL || node->kind == IR_TREE)
+    {
+        return 0;
+    }
+
+    if (!isLeaf(node->left) || !isLeaf(node->right) || !isLeaf(node->other))
+    {
+        return 0;
+    }
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        if (!isLeaf(node->items[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int findSlot(IrInline *inlined, const char *name)
+{
+    for (int i = 0; i < inlined->slotCount; i++)
+    {
+        if (strcmp(inlined->slotNames[i], name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int addSlot(IrInline *inlined, char *name)
+{
+    int slot = findSlot(inlined, name);
+    if (slot < 0)
+    {
+        slot = inlined->slotCount++;
+        inlined->slotNames = realloc(inlined->slotNames, sizeof(char *) * inlined->slotCount);
+        inlined->slotNames[slot] = name;
+    }
+    return slot;
+}
+
+// Toda variável declarada ou atribuída no corpo é local da chamada
+static void collectLocals(IrNode *node, IrInline *inlined)
+{
+    if (!node)
+    {
+        return;
+    }
+    if (node->kind == IR_DECL || node->kind == IR_ASSIGN)
+    {
+        addSlot(inlined, node->name);
+    }
+
+    collectLocals(node->left, inlined);
+    collectLocals(node->right, inlined);
+    collectLocals(node->other, inlined);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        collectLocals(node->items[i], inlined);
+    }
+}
+
+// Copia o corpo, ligando as variáveis locais às posições do vetor
+static IrNode *cloneNode(IrNode *node, IrInline *inlined)
+{
+    if (!node)
+    {
+        return NULL;
+    }
+
+    IrNode *copy = irNewNode(node->kind);
+    *copy = *node;
+    copy->cacheEnv = NULL;
+    copy->cacheVar = NULL;
+    copy->left = cloneNode(node->left, inlined);
+    copy->right = cloneNode(node->right, inlined);
+    copy->other = cloneNode(node->other, inlined);
+
+    if (node->itemCount > 0)
+    {
+        copy->items = malloc(sizeof(IrNode *) * node->itemCount);
+        for (int i = 0; i < node->itemCount; i++)
+        {
+            copy->items[i] = cloneNode(node->items[i], inlined);
+        }
+    }
+
+    if (node->kind == IR_LOAD || node->kind == IR_DECL || node->kind == IR_ASSIGN ||
+        node->kind == IR_STORE || node->kind == IR_PUSH || node->kind == IR_DELETE)
+    {
+        copy->slot = findSlot(inlined, node->name);
+    }
+    return copy;
+}
+
+// Verifica se a função pode ser embutida dentro do orçamento de tamanho
+static int canInline(IrProgram *program, Function *function, int budget)
+{
+    IrNode *body = program->bodies[function - program->env->functions];
+
+    if (countNodes(body) > budget || !isLeaf(body))
+    {
+        return 0;
+    }
+
+    // Parâmetros repetidos ocupariam a mesma posição do vetor
+    for (int i = 0; i < function->paramCount; i++)
+    {
+        for (int j = i + 1; j < function->paramCount; j++)
+        {
+            if (strcmp(function->parameters[i].name, function->parameters[j].name) == 0)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static IrInline *buildInline(IrProgram *program, Function *function)
+{
+    IrNode *body = program->bodies[function - program->env->functions];
+    IrInline *inlined = calloc(1, sizeof(IrInline));
+
+    for (int i = 0; i < function->paramCount; i++)
+    {
+        addSlot(inlined, function->parameters[i].name);
+    }
+    collectLocals(body, inlined);
+    inlined->returnSlot = addSlot(inlined, "return");
+
+    inlined->body = cloneNode(body, inlined);
+    return inlined;
+}
+
+static void inlineCalls(IrProgram *program, IrNode *node, int budget)
+{
+    if (!node)
+    {
+        return;
+    }
+
+    if (node->kind == IR_CALL && canInline(program, node->function, budget))
+    {
+        node->inlined = buildInline(program, node->function);
+    }
+
+    inlineCalls(program, node->left, budget);
+    inlineCalls(program, node->right, budget);
+    inlineCalls(program, node->other, budget);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        inlineCalls(program, node->items[i], budget);
+    }
+}
+
+// Conjunto de nomes de variáveis
+typedef struct
+{
+    char **names;
+    int count;
+} NameSet;
+
+static int nameSetHas(NameSet *set, const char *name)
+{
+    for (int i = 0; i < set->count; i++)
+    {
+        if (strcmp(set->names[i], name) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void nameSetAdd(NameSet *set, char *name)
+{
+    if (!nameSetHas(set, name))
+    {
+        set->count++;
+        set->names = realloc(set->names, sizeof(char *) * set->count);
+        set->names[set->count - 1] = name;
+    }
+}
+
+// Variáveis que um laço pode alterar
+typedef struct
+{
+    NameSet direct;   // atribuídas ou declaradas no próprio laço
+    NameSet indirect; // alteradas pelas funções chamadas (escopo dinâmico)
+    int *visited;     // funções já percorridas
+    int opaque;       // o laço tem nós avaliados pela árvore, que podem chamar qualquer função
+} LoopWrites;
+
+static void collectFunctionWrites(IrProgram *program, IrNode *node, LoopWrites *writes);
+
+static void collectCallWrites(IrProgram *program, Function *function, LoopWrites *writes)
+{
+    int index = function - program->env->functions;
+    if (writes->visited[index])
+    {
+        return;
+    }
+    writes->visited[index] = 1;
+
+    for (int i = 0; i < function->paramCount; i++)
+    {
+        nameSetAdd(&writes->indirect, function->parameters[i].name);
+    }
+    nameSetAdd(&writes->indirect, "return");
+    collectFunctionWrites(program, program->bodies[index], writes);
+}
+
+// Escritas dentro das funções chamadas
+static void collectFunctionWrites(IrProgram *program, IrNode *node, LoopWrites *writes)
+{
+    if (!node)
+    {
+        return;
+    }
+    if (node->kind == IR_DECL || node->kind == IR_ASSIGN)
+    {
+        nameSetAdd(&writes->indirect, node->name);
+    }
+    else if (node->kind == IR_CALL)
+    {
+        collectCallWrites(program, node->function, writes);
+    }
+    else if (node->kind == IR_TREE)
+    {
+        writes->opaque = 1;
+    }
+
+    collectFunctionWrites(program, node->left, writes);
+    collectFunctionWrites(program, node->right, writes);
+    collectFunctionWrites(program, node->other, writes);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        collectFunctionWrites(program, node->items[i], writes);
+    }
+}
+
+// Escritas do próprio laço
+static void collectLoopWrites(IrProgram *program, IrNode *node, LoopWrites *writes)
+{
+    if (!node)
+    {
+        return;
+    }
+    if (node->kind == IR_DECL || node->kind == IR_ASSIGN)
+    {
+        nameSetAdd(&writes->direct, node->name);
+    }
+    else if (node->kind == IR_CALL)
+    {
+        collectCallWrites(program, node->function, writes);
+    }
+    else if (node->kind == IR_TREE)
+    {
+        writes->opaque = 1;
+    }
+
+    collectLoopWrites(program, node->left, writes);
+    collectLoopWrites(program, node->right, writes);
+    collectLoopWrites(program, node->other, writes);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        collectLoopWrites(program, node->items[i], writes);
+    }
+}
+
+static int isWritten(LoopWrites *writes, const char *name)
+{
+    return nameSetHas(&writes->direct, name) || nameSetHas(&writes->indirect, name);
+}
+
+static int isInvariant(IrNode *node, LoopWrites *writes)
+{
+    switch (node->kind)
+    {
+    case IR_CONST:
+    case IR_STRING:
+    case IR_HOISTED:
+        return 1;
+    case IR_LOAD:
+        return !isWritten(writes, node->name);
+    case IR_BINARY:
+        return isInvariant(node->left, writes) && isInvariant(node->right, writes);
+    case IR_UNARY:
+        return isInvariant(node->left, writes);
+    default:
+        return 0;
+    }
+}
+
+static void addLoopTemp(IrNode *loop, IrNode *temp)
+{
+    loop->loopTempCount++;
+    loop->loopTemps = realloc(loop->loopTemps, sizeof(IrNode *) * loop->loopTempCount);
+    loop->loopTemps[loop->loopTempCount - 1] = temp;
+}
+
+// Troca as maiores subexpressões invariantes por IR_HOISTED
+static IrNode *hoistInvariants(IrNode *node, IrNode *loop, LoopWrites *writes)
+{
+    if (!node)
+    {
+        return NULL;
+    }
+
+    // Só operações valem a pena; constantes e leituras já são baratas
+    if ((node->kind == IR_BINARY || node->kind == IR_UNARY) && isInvariant(node, writes))
+    {
+        IrNode *hoisted = irNewNode(IR_HOISTED);
+        hoisted->left = node;
+        addLoopTemp(loop, hoisted);
+        return hoisted;
+    }
+
+    if (node->kind == IR_HOISTED || node->kind == IR_REDUCED)
+    {
+        return node;
+    }
+
+    node->left = hoistInvariants(node->left, loop, writes);
+    node->right = hoistInvariants(node->right, loop, writes);
+    node->other = hoistInvariants(node->other, loop, writes);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        node->items[i] = hoistInvariants(node->items[i], loop, writes);
+    }
+    return node;
+}
+
+static int isLoadOf(IrNode *node, const char *name)
+{
+    return node->kind == IR_LOAD && strcmp(node->name, name) == 0;
+}
+
+// Passo de uma atribuição 'name = name + c', 'name = c + name' ou 'name = name - c'
+// Retorna 0 quando a atribuição não tem essa forma
+static int inductionStep(IrNode *assign, const char *name, int *step)
+{
+    IrNode *expr = assign->left;
+    if (assign->kind != IR_ASSIGN || expr->kind != IR_BINARY)
+    {
+        return 0;
+    }
+
+    if (expr->op == OP_ADD && isLoadOf(expr->left, name) &&
+        expr->right->kind == IR_CONST && expr->right->value.type == TYPE_INT)
+    {
+        *step = expr->right->value.value.intValue;
+        return 1;
+    }
+    if (expr->op == OP_ADD && isLoadOf(expr->right, name) &&
+        expr->left->kind == IR_CONST && expr->left->value.type == TYPE_INT)
+    {
+        *step = expr->left->value.value.intValue;
+        return 1;
+    }
+    if (expr->op == OP_SUB && isLoadOf(expr->left, name) &&
+        expr->right->kind == IR_CONST && expr->right->value.type == TYPE_INT)
+    {
+        *step = (int)(0u - (unsigned)expr->right->value.value.intValue);
+        return 1;
+    }
+    return 0;
+}
+
+// Coleta as escritas de 'name' no laço; falha se alguma não for um incremento constante
+// ou se os incrementos forem diferentes
+static int collectInductionSites(IrNode *node, const char *name, IrNode ***sites, int *siteCount, int *step)
+{
+    if (!node)
+    {
+        return 1;
+    }
+
+    if ((node->kind == IR_DECL || node->kind == IR_ASSIGN) && strcmp(node->name, name) == 0)
+    {
+        int siteStep;
+        if (!inductionStep(node, name, &siteStep) || (*siteCount > 0 && siteStep != *step))
+        {
+            return 0;
+        }
+        *step = siteStep;
+        (*siteCount)++;
+        *sites = realloc(*sites, sizeof(IrNode *) * *siteCount);
+        (*sites)[*siteCount - 1] = node;
+    }
+
+    if (!collectInductionSites(node->left, name, sites, siteCount, step) ||
+        !collectInductionSites(node->right, name, sites, siteCount, step) ||
+        !collectInductionSites(node->other, name, sites, siteCount, step))
+    {
+        return 0;
+    }
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        if (!collectInductionSites(node->items[i], name, sites, siteCount, step))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct
+{
+    char *name;
+    int step;
+    IrNode **sites;
+    int siteCount;
+} Induction;
+
+// Troca 'i * k' e 'k * i' por IR_REDUCED
+static IrNode *reduceProducts(IrNode *node, IrNode *loop, Induction *induction, LoopWrites *writes)
+{
+    if (!node || node->kind == IR_HOISTED || node->kind == IR_REDUCED)
+    {
+        return node;
+    }
+
+    if (node->kind == IR_BINARY && node->op == OP_MUL)
+    {
+        IrNode *factor = NULL;
+        if (isLoadOf(node->left, induction->name) && isInvariant(node->right, writes))
+        {
+            factor = node->right;
+        }
+        else if (isLoadOf(node->right, induction->name) && isInvariant(node->left, writes))
+        {
+            factor = node->left;
+        }
+
+        if (factor)
+        {
+            IrNode *reduced = irNewNode(IR_REDUCED);
+            reduced->left = node;
+            reduced->other = factor;
+            reduced->increment = induction->step;
+            addLoopTemp(loop, reduced);
+
+            for (int i = 0; i < induction->siteCount; i++)
+            {
+                IrNode *site = induction->sites[i];
+                site->reducedCount++;
+                site->reduced = realloc(site->reduced, sizeof(IrNode *) * site->reducedCount);
+                site->reduced[site->reducedCount - 1] = reduced;
+            }
+            return reduced;
+        }
+    }
+
+    node->left = reduceProducts(node->left, loop, induction, writes);
+    node->right = reduceProducts(node->right, loop, induction, writes);
+    node->other = reduceProducts(node->other, loop, induction, writes);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        node->items[i] = reduceProducts(node->items[i], loop, induction, writes);
+    }
+    return node;
+}
+
+static void optimizeLoop(IrProgram *program, IrNode *loop)
+{
+    LoopWrites writes;
+    memset(&writes, 0, sizeof(writes));
+    writes.visited = calloc(program->functionCount + 1, sizeof(int));
+
+    collectLoopWrites(program, loop->left, &writes);
+    collectLoopWrites(program, loop->right, &writes);
+
+    if (!writes.opaque)
+    {
+        loop->left = hoistInvariants(loop->left, loop, &writes);
+        loop->right = hoistInvariants(loop->right, loop, &writes);
+
+        // Variáveis de indução: alteradas só por incrementos constantes no próprio laço
+        for (int i = 0; i < writes.direct.count; i++)
+        {
+            Induction induction;
+            induction.name = writes.direct.names[i];
+            induction.step = 0;
+            induction.sites = NULL;
+            induction.siteCount = 0;
+
+            if (!nameSetHas(&writes.indirect, induction.name) &&
+                collectInductionSites(loop->right, induction.name, &induction.sites, &induction.siteCount, &induction.step) &&
+                collectInductionSites(loop->left, induction.name, &induction.sites, &induction.siteCount, &induction.step) &&
+                induction.siteCount > 0)
+            {
+                loop->left = reduceProducts(loop->left, loop, &induction, &writes);
+                loop->right = reduceProducts(loop->right, loop, &induction, &writes);
+            }
+            free(induction.sites);
+        }
+    }
+
+    free(writes.direct.names);
+    free(writes.indirect.names);
+    free(writes.visited);
+}
+
+// Otimiza os laços de fora para dentro: o que é invariante no laço externo sai dele,
+// e os laços internos tratam o que sobrou
+static void optimizeLoops(IrProgram *program, IrNode *node)
+{
+    if (!node)
+    {
+        return;
+    }
+
+    if (node->kind == IR_WHILE)
+    {
+        optimizeLoop(program, node);
+    }
+
+    if (node->kind == IR_CALL && node->inlined)
+    {
+        optimizeLoops(program, node->inlined->body);
+    }
+
+    optimizeLoops(program, node->left);
+    optimizeLoops(program, node->right);
+    optimizeLoops(program, node->other);
+    for (int i = 0; i < node->itemCount; i++)
+    {
+        optimizeLoops(program, node->items[i]);
+    }
+}
+
+void optimizeProgram(IrProgram *program, int inlineBudget)
+{
+    if (inlineBudget > 0)
+    {
+        for (int i = 0; i < program->functionCount; i++)
+        {
+            inlineCalls(program, program->bodies[i], inlineBudget);
+        }
+    }
+
+    for (int i = 0; i < program->functionCount; i++)
+    {
+        optimizeLoops(program, program->bodies[i]);
+    }
+}
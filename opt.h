@@ -0,0 +1,13 @@
+#ifndef PHTML_OPT_H
+#define PHTML_OPT_H
+
+#include "ir.h"
+
+// Tamanho máximo (em nós da IR) de uma função para ela ser embutida nas chamadas
+#define OPT_DEFAULT_INLINE_BUDGET 16
+
+// Aplica as otimizações sobre a IR do programa
+// Com inlineBudget igual a 0 nenhuma função é embutida
+void optimizeProgram(IrProgram *program, int inlineBudget);
+
+#endif
@@ -0,0 +1,227 @@
+#include "output.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "stats.h"
+#include "trace.h"
+
+// O buffer e a captura são de cada thread: execuções em paralelo pela biblioteca
+// não disputam nem misturam a saída
+static __thread char buffer[OUTPUT_BUFFER_SIZE];
+static __thread size_t used = 0;
+static int initialized = 0;
+
+// Captura ativa (outputCapture)
+static __thread int capturing = 0;
+static __thread char *captureTarget = NULL;
+static __thread size_t captureCapacity = 0;
+static __thread size_t captureLength = 0;
+
+// Com outputCaptureGrowing, o buffer de quem chamou é ampliado em vez de cortar a saída
+static __thread char **growTarget = NULL;
+static __thread size_t *growCapacity = NULL;
+
+// Amplia o buffer para caber 'needed' bytes e o '\0'; se faltar memória, a
+// captura continua com o buffer atual e o resto é descartado
+static void captureGrow(size_t needed)
+{
+    size_t capacity = captureCapacity ? captureCapacity : 1;
+    while (capacity <= needed)
+    {
+        capacity *= 2;
+    }
+    char *target = realloc(captureTarget, capacity);
+    if (!target)
+    {
+        return;
+    }
+    captureTarget = *growTarget = target;
+    captureCapacity = *growCapacity = capacity;
+}
+
+static void captureAll(struct iovec *parts, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (growTarget && captureLength + parts[i].iov_len >= captureCapacity)
+        {
+            captureGrow(captureLength + parts[i].iov_len);
+        }
+        if (captureLength < captureCapacity)
+        {
+            size_t room = captureCapacity - captureLength;
+            memcpy(captureTarget + captureLength, parts[i].iov_base,
+                   parts[i].iov_len < room ? parts[i].iov_len : room);
+        }
+        captureLength += parts[i].iov_len;
+    }
+}
+
+// Escreve todos os trechos, continuando de onde parou em escritas parciais
+static void sendAll(struct iovec *parts, int count)
+{
+    while (count > 0)
+    {
+        ssize_t written = writev(STDOUT_FILENO, parts, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // Sem ter para onde escrever (ex.: descritor fechado) a saída é descartada
+            return;
+        }
+
+        while (count > 0 && (size_t)written >= parts->iov_len)
+        {
+            written -= parts->iov_len;
+            parts++;
+            count--;
+        }
+        if (count > 0)
+        {
+            parts->iov_base = (char *)parts->iov_base + written;
+            parts->iov_len -= written;
+        }
+    }
+}
+
+// Entrega os trechos à captura ou ao descritor 1
+static void writeAll(struct iovec *parts, int count)
+{
+    STATS_COUNT(outputWrites);
+    for (int i = 0; i < count; i++)
+    {
+        STATS_ADD(outputBytes, parts[i].iov_len);
+    }
+
+    if (capturing)
+    {
+        captureAll(parts, count);
+        return;
+    }
+
+    // O rastro é só da linha de comando, que nunca captura a saída
+    if (traceEnabled)
+    {
+        size_t total = 0;
+        for (int i = 0; i < count; i++)
+        {
+            total += parts[i].iov_len;
+        }
+        char args[64];
+        snprintf(args, sizeof(args), "\"bytes\": %zu", total);
+        traceBegin("flush", "output", args);
+        sendAll(parts, count);
+        traceEnd();
+        return;
+    }
+    sendAll(parts, count);
+}
+
+void outputFlush(void)
+{
+    if (used > 0)
+    {
+        struct iovec part = {buffer, used};
+        used = 0;
+        writeAll(&part, 1);
+    }
+}
+
+void outputCapture(char *target, size_t capacity)
+{
+    outputFlush();
+    capturing = 1;
+    captureTarget = target;
+    captureCapacity = capacity;
+    captureLength = 0;
+    growTarget = NULL;
+    growCapacity = NULL;
+}
+
+void outputCaptureGrowing(char **target, size_t *capacity)
+{
+    outputCapture(*target, *capacity);
+    growTarget = target;
+    growCapacity = capacity;
+}
+
+size_t outputRelease(void)
+{
+    outputFlush();
+    capturing = 0;
+    growTarget = NULL;
+    growCapacity = NULL;
+    return captureLength;
+}
+
+void outputInit(void)
+{
+    if (initialized)
+    {
+        return;
+    }
+    initialized = 1;
+
+    // As mensagens de fail() usam printf e terminam com exit: o stdio passa a ser
+    // totalmente bufferizado e o buffer da saída é esvaziado antes dele, no atexit
+    setvbuf(stdout, NULL, _IOFBF, BUFSIZ);
+    atexit(outputFlush);
+}
+
+void outputWrite(const char *text, size_t length)
+{
+    if (length >= OUTPUT_DIRECT_MIN)
+    {
+        struct iovec parts[2] = {{buffer, used}, {(char *)text, length}};
+        used = 0;
+        writeAll(parts, 2);
+        return;
+    }
+
+    if (used + length > OUTPUT_BUFFER_SIZE)
+    {
+        outputFlush();
+    }
+    memcpy(buffer + used, text, length);
+    used += length;
+}
+
+void outputLine(const char *text, size_t length)
+{
+    if (length >= OUTPUT_DIRECT_MIN)
+    {
+        struct iovec parts[3] = {{buffer, used}, {(char *)text, length}, {"\n", 1}};
+        used = 0;
+        writeAll(parts, 3);
+        return;
+    }
+
+    if (used + length + 1 > OUTPUT_BUFFER_SIZE)
+    {
+        outputFlush();
+    }
+    memcpy(buffer + used, text, length);
+    used += length;
+    buffer[used++] = '\n';
+}
+
+char *outputReserve(size_t length)
+{
+    if (used + length > OUTPUT_BUFFER_SIZE)
+    {
+        outputFlush();
+    }
+    return buffer + used;
+}
+
+void outputCommit(size_t length)
+{
+    used += length;
+}
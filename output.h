@@ -0,0 +1,51 @@
+#ifndef PHTML_OUTPUT_H
+#define PHTML_OUTPUT_H
+
+#include <stddef.h>
+
+// Saída do programa (<print>)
+//
+// Os textos impressos são acumulados em um buffer e enviados ao descritor 1 de
+// uma só vez: quando o buffer enche, no fim do programa ou em <flush/>. Strings
+// longas não são copiadas para o buffer; seguem junto com ele em um único writev.
+
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// Strings a partir desse tamanho vão direto para o writev
+#define OUTPUT_DIRECT_MIN 4096
+
+// Espaço máximo usado pela formatação de um número (um double com %f cabe com folga)
+#define OUTPUT_FORMAT_MAX 512
+
+// Prepara o buffer; deve ser chamada antes da execução do programa
+// Mensagens de erro do interpretador (fail, ver error.h) continuam saindo
+// depois de tudo que já foi impresso
+void outputInit(void);
+
+// Acrescenta um texto à saída
+void outputWrite(const char *text, size_t length);
+
+// Acrescenta um texto seguido de quebra de linha
+void outputLine(const char *text, size_t length);
+
+// Espaço livre para escrever até 'length' bytes diretamente no buffer
+// O texto escrito só passa a fazer parte da saída depois de outputCommit
+char *outputReserve(size_t length);
+void outputCommit(size_t length);
+
+// Envia o conteúdo pendente
+void outputFlush(void);
+
+// Saída capturada pela biblioteca (libphtml.h): enquanto a captura está ativa, o
+// conteúdo enviado vai para 'target' em vez do descritor 1; o que não couber em
+// 'capacity' é descartado, mas continua contado
+void outputCapture(char *target, size_t capacity);
+
+// Como outputCapture, mas o buffer (alocado com malloc) é ampliado com realloc
+// quando a saída não cabe; '*target' e '*capacity' são atualizados na hora
+void outputCaptureGrowing(char **target, size_t *capacity);
+
+// Envia o conteúdo pendente, encerra a captura e retorna o total produzido
+size_t outputRelease(void);
+
+#endif
@@ -2,68 +2,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include "mpc.h"
-
-// Definição das estruturas para os tipos da linguagem
-typedef enum
-{
-    TYPE_INT,
-    TYPE_FLOAT,
-    TYPE_CHAR,
-    TYPE_BOOL,
-    TYPE_STRING,
-    TYPE_VOID
-} ValueType;
-
-typedef struct
-{
-    ValueType type;
-    union
-    {
-        int intValue;
-        float floatValue;
-        char charValue;
-        int boolValue;
-        char *stringValue;
-    } value;
-} Value;
-
-// Estrutura para parâmetros de função
-typedef struct
-{
-    char *name;
-    ValueType type;
-} Parameter;
-
-// Estrutura para armazenar funções
-typedef struct Function
-{
-    char *name;
-    ValueType returnType;
-    int paramCount;
-    Parameter *parameters;
-    mpc_ast_t *body;
-} Function;
-
-// Estrutura para armazenar variáveis
-typedef struct Variable
-{
-    char *name;
-    Value value;
-    struct Variable *next;
-} Variable;
-
-// Ambiente de execução
-typedef struct Environment
-{
-    Variable *variables;
-    Function *functions;
-    int functionCount;
-    struct Environment *parent;
-} Environment;
+#include "phtml.h"
+#include "error.h"
+#include "jit.h"
+#include "output.h"
+#include "format.h"
+#include "array.h"
+#include "map.h"
+#include "builtin.h"
+#include "profile.h"
+#include "stats.h"
+#include "trace.h"
+#include "alloc.h"
+#include "budget.h"
 
 // Funções utilitárias
-Value fixValueType(Value value);
-
 ValueType getType(const char *typeStr)
 {
     if (strcmp(typeStr, "int") == 0)
@@ -78,9 +31,33 @@ ValueType getType(const char *typeStr)
         return TYPE_STRING;
     if (strcmp(typeStr, "void") == 0)
         return TYPE_VOID;
+    if (strcmp(typeStr, "long") == 0)
+        return TYPE_LONG;
+    if (strcmp(typeStr, "double") == 0)
+        return TYPE_DOUBLE;
+    if (strcmp(typeStr, "map") == 0)
+        return TYPE_MAP;
+
+    // Arrays: "int[]", "string[]", ...
+    size_t length = strlen(typeStr);
+    if (length > 2 && strcmp(typeStr + length - 2, "[]") == 0)
+        return TYPE_ARRAY;
+
+    fail("Tipo desconhecido: %s\n", typeStr);
+}
 
-    printf("Tipo desconhecido: %s\n", typeStr);
-    exit(1);
+// Tipo dos elementos de um tipo de array ("int[]" -> int)
+ValueType getElementType(const char *typeStr)
+{
+    char base[16];
+    size_t length = strlen(typeStr);
+    if (length < 3 || length - 2 >= sizeof(base))
+    {
+        fail("Tipo desconhecido: %s\n", typeStr);
+    }
+    memcpy(base, typeStr, length - 2);
+    base[length - 2] = '\0';
+    return getType(base);
 }
 
 char *getTypeString(ValueType type)
@@ -99,6 +76,14 @@ char *getTypeString(ValueType type)
         return "string";
     case TYPE_VOID:
         return "void";
+    case TYPE_LONG:
+        return "long";
+    case TYPE_DOUBLE:
+        return "double";
+    case TYPE_ARRAY:
+        return "array";
+    case TYPE_MAP:
+        return "map";
     default:
         return "unknown";
     }
@@ -107,87 +92,124 @@ char *getTypeString(ValueType type)
 // Cria um novo ambiente
 Environment *createEnvironment(Environment *parent)
 {
-    Environment *env = malloc(sizeof(Environment));
+    Environment *env = ALLOC_COUNTED(environments, sizeof(Environment));
     env->variables = NULL;
     env->functions = NULL;
     env->functionCount = 0;
+    env->version = 0;
     env->parent = parent;
     return env;
 }
 
-// Procura uma variável no ambiente
-Variable *findVariable(Environment *env, const char *name)
+// Libera um ambiente e as suas variáveis (as funções ficam com o programa)
+// Arrays e mapas são compartilhados entre variáveis e não são liberados aqui
+void freeEnvironment(Environment *env)
 {
-
-    Variable *current = env->variables;
-    while (current != NULL)
+    Variable *var = env->variables;
+    while (var)
     {
-        if (strcmp(current->name, name) == 0)
+        Variable *next = var->next;
+        if (var->value.type == TYPE_STRING)
         {
-            return current;
+            ALLOC_FREE(var->value.value.stringValue);
         }
-        current = current->next;
+        ALLOC_FREE(var->name);
+        ALLOC_FREE(var);
+        var = next;
     }
+    ALLOC_FREE(env);
+}
+
+// Procura uma variável no ambiente
+Variable *findVariable(Environment *env, const char *name)
+{
+    STATS_COUNT(lookups);
     // Procura no ambiente pai se não encontrar no ambiente atual
-    if (env->parent)
+    for (; env; env = env->parent)
     {
-        return findVariable(env->parent, name);
+        STATS_COUNT(lookupScopes);
+        for (Variable *current = env->variables; current != NULL; current = current->next)
+        {
+            STATS_COUNT(lookupCompares);
+            if (strcmp(current->name, name) == 0)
+            {
+                return current;
+            }
+        }
     }
 
     return NULL;
 }
 
+// Cópia de um valor para ser guardado em uma variável (strings são duplicadas)
+Value copyValue(Value value)
+{
+    if (value.type == TYPE_STRING)
+    {
+        value.value.stringValue = ALLOC_STRING_COPY(value.value.stringValue);
+    }
+    return value;
+}
+
+// Substitui o valor de uma variável existente, liberando a string anterior
+// Variáveis long e double mantêm o tipo ao receber números menores
+// Booleanos guardados como string ("true"/"false") são corrigidos aqui, na escrita
+void assignVariable(Variable *var, Value value)
+{
+    value = widenValue(var->value.type, value);
+    if (var->value.type == TYPE_STRING)
+    {
+        ALLOC_FREE(var->value.value.stringValue);
+    }
+    var->value = fixValueType(copyValue(value));
+}
+
+// Valor de uma variável; a leitura nunca altera o ambiente, então várias threads
+// podem ler o mesmo programa ao mesmo tempo
+Value readVariable(Variable *var)
+{
+    return var->value;
+}
+
+// Contador usado para versionar os ambientes (ver Environment.version)
+// É de cada thread: os ambientes de uma execução são criados pela thread que a
+// executa, e o ambiente global de um programa compilado não recebe variáveis
+static __thread unsigned long variableEpoch = 0;
+
 // Adiciona ou atualiza uma variável no ambiente
+// O valor é copiado; a string recebida continua pertencendo a quem chamou
 void setVariable(Environment *env, const char *name, Value value)
 {
-    // Corrige o tipo antes de atribuir
-    value = fixValueType(value);
-
     Variable *var = findVariable(env, name);
     if (var)
     {
         // Atualiza variável existente
-        if (var->value.type == TYPE_STRING && value.type != TYPE_STRING)
-        {
-            free(var->value.value.stringValue);
-        }
-
-        if (value.type == TYPE_STRING)
-        {
-            if (var->value.type == TYPE_STRING)
-            {
-                // Se ambos são strings, temos que liberar o antigo antes de atribuir o novo
-                free(var->value.value.stringValue);
-            }
-            // Atribui o novo valor string (sempre fazendo uma cópia)
-            var->value.type = TYPE_STRING;
-            var->value.value.stringValue = strdup(value.value.stringValue);
-        }
-        else
-        {
-            // Para outros tipos, copiamos o valor diretamente
-            var->value = value;
-        }
+        assignVariable(var, value);
     }
     else
     {
         // Cria nova variável
-        var = malloc(sizeof(Variable));
-        var->name = strdup(name);
+        var = ALLOC_COUNTED(variables, sizeof(Variable));
+        var->name = ALLOC_STRDUP(name);
+        var->value = fixValueType(copyValue(value));
+        var->next = env->variables;
+        env->variables = var;
+        env->version = ++variableEpoch;
+    }
+}
 
-        if (value.type == TYPE_STRING)
-        {
-            var->value.type = TYPE_STRING;
-            var->value.value.stringValue = strdup(value.value.stringValue);
-        }
-        else
+// Versão da cadeia de ambientes: muda sempre que uma variável é criada em algum deles
+unsigned long getChainVersion(Environment *env)
+{
+    unsigned long version = 0;
+    for (; env; env = env->parent)
+    {
+        if (env->version > version)
         {
-            var->value = value;
+            version = env->version;
         }
-
-        var->next = env->variables;
-        env->variables = var;
     }
+    return version;
 }
 
 // Procura uma função no ambiente
@@ -200,14 +222,25 @@ Function *findFunction(Environment *env, const char *name)
             return &env->functions[i];
         }
     }
+    // As funções ficam no ambiente global; chamadas feitas dentro de funções procuram nos ambientes pais
+    if (env->parent)
+    {
+        return findFunction(env->parent, name);
+    }
     return NULL;
 }
 
 // Adiciona uma função ao ambiente
 void addFunction(Environment *env, Function func)
 {
+    // A tabela dobra quando functionCount chega a uma potência de 2, para que
+    // programas com milhares de funções não copiem a tabela a cada declaração
+    if ((env->functionCount & (env->functionCount - 1)) == 0)
+    {
+        int capacity = env->functionCount ? env->functionCount * 2 : 1;
+        env->functions = ALLOC_REALLOC(env->functions, sizeof(Function) * capacity);
+    }
     env->functionCount++;
-    env->functions = realloc(env->functions, sizeof(Function) * env->functionCount);
     env->functions[env->functionCount - 1] = func;
 }
 
@@ -240,694 +273,1405 @@ Value parseValue(const char *str, ValueType type)
         }
         else
         {
-            printf("Erro: valor booleano inválido: %s\n", str);
-            exit(1);
+            fail("Erro: valor booleano inválido: %s\n", str);
         }
         break;
     case TYPE_STRING:
-        val.value.stringValue = strdup(str);
+        val.value.stringValue = ALLOC_STRING_COPY(str);
         break;
     case TYPE_VOID:
         break;
+    case TYPE_LONG:
+        val.value.longValue = strtoll(str, NULL, 10);
+        break;
+    case TYPE_DOUBLE:
+        val.value.doubleValue = strtod(str, NULL);
+        break;
+    case TYPE_ARRAY:
+        val = newArray(TYPE_VOID);
+        break;
+    case TYPE_MAP:
+        val = newMap();
+        break;
     }
 
     return val;
 }
 
-// Converte um valor para string
-char *valueToString(Value value)
+// Converte um literal numérico: inteiros são int, com ponto são float,
+// e os sufixos L e D indicam long e double
+Value parseNumber(const char *text)
 {
-    char buffer[256];
+    Value val;
+    size_t length = strlen(text);
+    char suffix = length > 0 ? text[length - 1] : '\0';
 
-    switch (value.type)
+    if (suffix == 'L')
+    {
+        val.type = TYPE_LONG;
+        val.value.longValue = strtoll(text, NULL, 10);
+    }
+    else if (suffix == 'D')
+    {
+        val.type = TYPE_DOUBLE;
+        val.value.doubleValue = strtod(text, NULL);
+    }
+    else if (strchr(text, '.'))
+    {
+        val.type = TYPE_FLOAT;
+        val.value.floatValue = atof(text);
+    }
+    else
+    {
+        val.type = TYPE_INT;
+        val.value.intValue = atoi(text);
+    }
+    return val;
+}
+
+// Converte números para long ou double quando o destino (variável, parâmetro ou
+// retorno) tem um desses tipos; outros valores não mudam
+Value widenValue(ValueType target, Value value)
+{
+    if (target == TYPE_LONG && value.type == TYPE_INT)
+    {
+        value.type = TYPE_LONG;
+        value.value.longValue = value.value.intValue;
+    }
+    else if (target == TYPE_DOUBLE)
+    {
+        if (value.type == TYPE_INT)
+            value.value.doubleValue = value.value.intValue;
+        else if (value.type == TYPE_FLOAT)
+            value.value.doubleValue = value.value.floatValue;
+        else if (value.type == TYPE_LONG)
+            value.value.doubleValue = (double)value.value.longValue;
+        else
+            return value;
+        value.type = TYPE_DOUBLE;
+    }
+    return value;
+}
+
+// Valor inicial de uma variável ou retorno do tipo indicado
+Value defaultValue(ValueType type)
+{
+    Value val;
+    val.type = type;
+
+    switch (type)
     {
     case TYPE_INT:
-        sprintf(buffer, "%d", value.value.intValue);
+        val.value.intValue = 0;
         break;
     case TYPE_FLOAT:
-        sprintf(buffer, "%f", value.value.floatValue);
+        val.value.floatValue = 0.0;
         break;
     case TYPE_CHAR:
-        sprintf(buffer, "%c", value.value.charValue);
+        val.value.charValue = '\0';
         break;
     case TYPE_BOOL:
-        if (value.value.boolValue)
-        {
-            strcpy(buffer, "true");
-        }
-        else
-        {
-            strcpy(buffer, "false");
-        }
+        val.value.boolValue = 0;
         break;
     case TYPE_STRING:
-        if (value.value.stringValue)
-        {
-            // Garante que fazemos uma cópia profunda da string
-            char *result = malloc(strlen(value.value.stringValue) + 1);
-            strcpy(result, value.value.stringValue);
-            return result;
-        }
-        else
-        {
-            return strdup("");
-        }
+        val.value.stringValue = ALLOC_STRING_COPY("");
+        break;
     case TYPE_VOID:
-        return strdup("");
+        // Nada a fazer para void
+        break;
+    case TYPE_LONG:
+        val.value.longValue = 0;
+        break;
+    case TYPE_DOUBLE:
+        val.value.doubleValue = 0.0;
+        break;
+    case TYPE_ARRAY:
+        // Sem o tipo declarado (retorno ou parâmetro), os elementos definem o tipo
+        val = newArray(TYPE_VOID);
+        break;
+    case TYPE_MAP:
+        val = newMap();
+        break;
     }
 
-    // Para outros tipos, fazemos uma cópia do buffer
-    char *result = malloc(strlen(buffer) + 1);
-    strcpy(result, buffer);
-    return result;
+    return val;
 }
 
-// Forward declaration para funções de avaliação
-Value evaluateExpression(mpc_ast_t *ast, Environment *env);
-void evaluateCommandList(mpc_ast_t *ast, Environment *env);
-void evaluateCommand(mpc_ast_t *ast, Environment *env);
-
-// Avalia uma chamada de função
-Value evaluateCall(mpc_ast_t *ast, Environment *env)
+// Tamanho máximo do texto de um valor que não é string (ver formatScalar)
+static size_t scalarMaxLength(ValueType type)
 {
-    char *functionName = NULL;
+    switch (type)
+    {
+    case TYPE_INT:
+        return FORMAT_INT_MAX;
+    case TYPE_LONG:
+        return FORMAT_LONG_MAX;
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+        return FORMAT_FIXED_MAX;
+    default:
+        return 5; // "false"
+    }
+}
 
-    // Encontra o nome da função
-    for (int i = 0; i < ast->children_num; i++)
+// Escreve em 'out' o texto usado na concatenação de um valor que não é string
+// e retorna o tamanho; void não produz texto, nem o caractere nulo de um char
+// não inicializado
+static int formatScalar(char *out, Value value)
+{
+    switch (value.type)
     {
-        if (strstr(ast->children[i]->tag, "identifier"))
+    case TYPE_INT:
+        return formatInt(out, value.value.intValue);
+    case TYPE_FLOAT:
+        return formatFixed(out, value.value.floatValue);
+    case TYPE_CHAR:
+        out[0] = value.value.charValue;
+        return value.value.charValue ? 1 : 0;
+    case TYPE_BOOL:
+        if (value.value.boolValue)
         {
-            functionName = ast->children[i]->contents;
-            break;
+            memcpy(out, "true", 4);
+            return 4;
         }
+        memcpy(out, "false", 5);
+        return 5;
+    case TYPE_LONG:
+        return formatLong(out, value.value.longValue);
+    case TYPE_DOUBLE:
+        return formatFixed(out, value.value.doubleValue);
+    default:
+        return 0;
     }
+}
 
-    if (!functionName)
-    {
-        printf("Erro: nome da função não encontrado\n");
-        exit(1);
-    }
+static size_t formatText(char *out, Value value);
 
-    Function *function = findFunction(env, functionName);
-    if (!function)
-    {
-        printf("Erro: função '%s' não encontrada\n", functionName);
-        exit(1);
-    }
+// Texto de um array: os elementos separados por ", " entre colchetes
+// Com 'out' igual a NULL apenas calcula o tamanho
+static size_t formatArray(char *out, Array *array)
+{
+    size_t length = 0;
 
-    // Avalia os argumentos
-    Value *args = NULL;
-    int argCount = 0;
+    if (out)
+        out[length] = '[';
+    length++;
 
-    //  Procura por tags args_block
-    for (int i = 0; i < ast->children_num; i++)
+    for (int i = 0; i < array->length; i++)
     {
-        if (strstr(ast->children[i]->tag, "args_block"))
+        if (i > 0)
         {
-            mpc_ast_t *argsBlockNode = ast->children[i];
-
-            // Procura por args dentro do args_block
-            for (int j = 0; j < argsBlockNode->children_num; j++)
-            {
-                if (strstr(argsBlockNode->children[j]->tag, "arg_list"))
-                {
-                    mpc_ast_t *argListNode = argsBlockNode->children[j];
-
-                    // Na nova estrutura, arg_list pode ser um único arg
-                    if (strstr(argListNode->tag, "|arg"))
-                    {
-                        argCount = 1; // temos um argumento direto
+            if (out)
+                memcpy(out + length, ", ", 2);
+            length += 2;
+        }
 
-                        args = malloc(sizeof(Value) * argCount);
+        length += formatText(out ? out + length : NULL, arrayElement(array, i));
+    }
 
-                        // Procura expressão dentro do argumento
-                        for (int k = 0; k < argListNode->children_num; k++)
-                        {
-                            if (strstr(argListNode->children[k]->tag, "expression"))
-                            {
-                                args[0] = evaluateExpression(argListNode->children[k], env);
-                                break;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        // Estrutura mais complexa onde arg_list contém vários args
-                        // Conta os argumentos
+    if (out)
+        out[length] = ']';
+    return length + 1;
+}
 
-                        for (int k = 0; k < argListNode->children_num; k++)
-                        {
-                            if (strstr(argListNode->children[k]->tag, "arg"))
-                            {
-                                argCount++;
-                            }
-                        }
+// Texto de um map: "chave: valor" na ordem de inserção, separados por ", " entre chaves
+static size_t formatMap(char *out, Map *map)
+{
+    size_t length = 0;
 
-                        args = malloc(sizeof(Value) * argCount);
-                        int argIndex = 0;
+    if (out)
+        out[length] = '{';
+    length++;
 
-                        // Avalia cada expressão dentro de <arg>
-                        for (int k = 0; k < argListNode->children_num; k++)
-                        {
-                            if (strstr(argListNode->children[k]->tag, "arg"))
-                            {
-                                mpc_ast_t *argNode = argListNode->children[k];
-                                // Procura expressão dentro do argumento
-                                for (int l = 0; l < argNode->children_num; l++)
-                                {
-                                    if (strstr(argNode->children[l]->tag, "expression"))
-                                    {
-                                        args[argIndex++] = evaluateExpression(argNode->children[l], env);
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+    int first = 1;
+    for (int i = 0; i < map->used; i++)
+    {
+        MapEntry *entry = &map->entries[i];
+        if (entry->key.type == TYPE_VOID)
+            continue;
 
-            break;
+        if (!first)
+        {
+            if (out)
+                memcpy(out + length, ", ", 2);
+            length += 2;
         }
+        first = 0;
+
+        length += formatText(out ? out + length : NULL, entry->key);
+        if (out)
+            memcpy(out + length, ": ", 2);
+        length += 2;
+        length += formatText(out ? out + length : NULL, entry->value);
     }
 
-    // Verifica se a quantidade de argumentos está correta
-    if (argCount != function->paramCount)
+    if (out)
+        out[length] = '}';
+    return length + 1;
+}
+
+// Texto de um valor na concatenação (strings sem aspas)
+// Com 'out' igual a NULL apenas calcula o tamanho
+static size_t formatText(char *out, Value value)
+{
+    char scratch[FORMAT_FIXED_MAX];
+
+    switch (value.type)
+    {
+    case TYPE_STRING:
     {
-        printf("Erro: função '%s' espera %d argumentos, mas recebeu %d\n",
-               functionName, function->paramCount, argCount);
-        free(args);
-        exit(1);
+        size_t length = strlen(value.value.stringValue);
+        if (out)
+            memcpy(out, value.value.stringValue, length);
+        return length;
+    }
+    case TYPE_ARRAY:
+        return formatArray(out, value.value.arrayValue);
+    case TYPE_MAP:
+        return formatMap(out, value.value.mapValue);
+    default:
+        return formatScalar(out ? out : scratch, value);
     }
+}
 
-    // Cria um novo ambiente para a execução da função
-    Environment *funcEnv = createEnvironment(env);
+// Espaço reservado para o texto de um operando da concatenação
+static size_t textCapacity(Value value)
+{
+    if (value.type == TYPE_STRING || value.type == TYPE_ARRAY || value.type == TYPE_MAP)
+        return formatText(NULL, value);
+    return scalarMaxLength(value.type);
+}
 
-    // Define os parâmetros como variáveis no ambiente da função
-    for (int i = 0; i < function->paramCount; i++)
+// Concatenação com '+' quando um dos lados é string
+// Os números são formatados direto na string resultante
+static Value concatenateValues(Value left, Value right)
+{
+    size_t capacity = textCapacity(left) + textCapacity(right);
+    char *text = ALLOC_STRING(capacity + 1);
+
+    size_t length = formatText(text, left);
+    length += formatText(text + length, right);
+    text[length] = '\0';
+
+    // Devolve o espaço reservado e não usado quando ele é grande (float e double)
+    if (capacity - length > 64)
     {
-        setVariable(funcEnv, function->parameters[i].name, args[i]);
+        text = ALLOC_REALLOC(text, length + 1);
     }
 
-    free(args);
+    Value result;
+    result.type = TYPE_STRING;
+    result.value.stringValue = text;
+    return result;
+}
 
-    // Executa o corpo da função
-    evaluateCommandList(function->body, funcEnv);
+// Identifica o comando representado por um nó da AST
+// A ordem dos testes define qual comando é executado quando a tag contém mais de um nome
+CommandKind getCommandKind(mpc_ast_t *ast)
+{
+    if (strstr(ast->tag, "variable_declaration"))
+        return COMMAND_VAR_DECL;
+    if (strstr(ast->tag, "index_assignment"))
+        return COMMAND_INDEX_ASSIGN;
+    if (strstr(ast->tag, "assignment"))
+        return COMMAND_ASSIGN;
+    if (strstr(ast->tag, "if_structure"))
+        return COMMAND_IF;
+    if (strstr(ast->tag, "while_structure"))
+        return COMMAND_WHILE;
+    if (strstr(ast->tag, "function_call"))
+        return COMMAND_CALL;
+    if (strstr(ast->tag, "return"))
+        return COMMAND_RETURN;
+    if (strstr(ast->tag, "print"))
+        return COMMAND_PRINT;
+    if (strstr(ast->tag, "flush"))
+        return COMMAND_FLUSH;
+    if (strstr(ast->tag, "push"))
+        return COMMAND_PUSH;
+    if (strstr(ast->tag, "delete"))
+        return COMMAND_DELETE;
+    return COMMAND_NONE;
+}
 
-    // Obtém o valor de retorno (se houver)
-    Value returnValue;
-    returnValue.type = function->returnType;
+// Converte o texto de um operador binário
+Operator getOperator(const char *op)
+{
+    if (strcmp(op, "||") == 0)
+        return OP_OR;
+    if (strcmp(op, "&&") == 0)
+        return OP_AND;
+    if (strcmp(op, "==") == 0)
+        return OP_EQ;
+    if (strcmp(op, "!=") == 0)
+        return OP_NE;
+    if (strcmp(op, "<") == 0)
+        return OP_LT;
+    if (strcmp(op, ">") == 0)
+        return OP_GT;
+    if (strcmp(op, "<=") == 0)
+        return OP_LE;
+    if (strcmp(op, ">=") == 0)
+        return OP_GE;
+    if (strcmp(op, "+") == 0)
+        return OP_ADD;
+    if (strcmp(op, "-") == 0)
+        return OP_SUB;
+    if (strcmp(op, "*") == 0)
+        return OP_MUL;
+    if (strcmp(op, "/") == 0)
+        return OP_DIV;
+    return OP_NONE;
+}
 
-    // Inicializa com valor padrão
-    switch (returnValue.type)
+// Procura o filho que contém o operador de uma expressão binária (-1 se não houver)
+int findOperatorIndex(mpc_ast_t *ast)
+{
+    for (int i = 1; i < ast->children_num - 1; i++)
     {
-    case TYPE_INT:
-        returnValue.value.intValue = 0;
-        break;
-    case TYPE_FLOAT:
-        returnValue.value.floatValue = 0.0;
-        break;
-    case TYPE_CHAR:
-        returnValue.value.charValue = '\0';
-        break;
-    case TYPE_BOOL:
-        returnValue.value.boolValue = 0;
-        break;
-    case TYPE_STRING:
-        returnValue.value.stringValue = strdup("");
-        break;
-    case TYPE_VOID:
-        // Nada a fazer para void
-        break;
+        if (getOperator(ast->children[i]->contents) != OP_NONE)
+        {
+            return i;
+        }
     }
-    if (function->returnType != TYPE_VOID)
+    return -1;
+}
+
+// Identifica o tipo de expressão representado por um nó da AST
+ExpressionKind getExpressionKind(mpc_ast_t *ast)
+{
+    if (strstr(ast->tag, "function_call"))
+        return EXPR_CALL;
+    if (strstr(ast->tag, "array_index"))
+        return EXPR_INDEX;
+    if (strstr(ast->tag, "length"))
+        return EXPR_LENGTH;
+    if (strstr(ast->tag, "array_op"))
+        return EXPR_ARRAY_OP;
+    if (strstr(ast->tag, "has"))
+        return EXPR_HAS;
+    if (strstr(ast->tag, "keys"))
+        return EXPR_KEYS;
+    if (strstr(ast->tag, "identifier"))
+        return EXPR_IDENTIFIER;
+    if (strstr(ast->tag, "number"))
+        return EXPR_NUMBER;
+    if (strstr(ast->tag, "string"))
     {
-        Variable *returnVar = findVariable(funcEnv, "return");
-        if (returnVar)
+        // Os literais true e false chegam com a tag string, mas sem aspas
+        if ((strcmp(ast->contents, "true") == 0 || strcmp(ast->contents, "false") == 0) &&
+            !strchr(ast->contents, '"'))
         {
+            return EXPR_BOOLEAN;
+        }
+        return EXPR_STRING;
+    }
+    if (strstr(ast->tag, "character"))
+        return EXPR_CHAR;
+    if (strstr(ast->tag, "boolean"))
+        return EXPR_BOOLEAN;
 
-            // Se tivermos um valor de retorno, usamos ele
-            if (returnVar->value.type == TYPE_STRING && returnValue.type == TYPE_STRING)
+    // Expressão entre parênteses
+    if (strstr(ast->tag, "primary") && ast->children_num > 0 &&
+        strstr(ast->children[0]->tag, "string") && ast->children[0]->contents[0] == '(')
+    {
+        for (int i = 0; i < ast->children_num; i++)
+        {
+            if (strstr(ast->children[i]->tag, "expression"))
             {
-                free(returnValue.value.stringValue); // Libera a string padrão que foi alocada acima
-                returnValue.value.stringValue = strdup(returnVar->value.value.stringValue);
+                return EXPR_PAREN;
+            }
+        }
+    }
+
+    if (ast->children_num >= 3 && findOperatorIndex(ast) >= 0)
+        return EXPR_BINARY;
+
+    if (ast->children_num >= 2 &&
+        (strcmp(ast->children[0]->contents, "-") == 0 || strcmp(ast->children[0]->contents, "!") == 0))
+        return EXPR_UNARY;
+
+    return EXPR_INVALID;
+}
+
+// Extrai o tipo e o nome de uma declaração de variável
+void getDeclarationParts(mpc_ast_t *ast, char **varType, char **varName)
+{
+    *varType = NULL;
+    *varName = NULL;
+    for (int j = 0; j < ast->children_num; j++)
+    {
+        if (strstr(ast->children[j]->tag, "type"))
+        {
+            *varType = ast->children[j]->contents;
+        }
+        else if (strstr(ast->children[j]->tag, "identifier"))
+        {
+            *varName = ast->children[j]->contents;
+        }
+    }
+}
+
+// Extrai a variável e a expressão de uma atribuição
+void getAssignmentParts(mpc_ast_t *ast, char **varName, mpc_ast_t **exprNode)
+{
+    *varName = NULL;
+    *exprNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
+    {
+        if (strstr(ast->children[j]->tag, "identifier"))
+        {
+            *varName = ast->children[j]->contents;
+        }
+        else if (strstr(ast->children[j]->tag, "expression"))
+        {
+            *exprNode = ast->children[j];
+        }
+    }
+}
+
+// Extrai o array e o valor de um <push>
+// Diferente de getAssignmentParts, o nome é o primeiro identificador, então
+// <push var='a'>x</push> funciona também quando o valor é só uma variável
+void getPushParts(mpc_ast_t *ast, char **varName, mpc_ast_t **exprNode)
+{
+    *varName = NULL;
+    *exprNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
+    {
+        if (strstr(ast->children[j]->tag, "expression"))
+        {
+            *exprNode = ast->children[j];
+        }
+        else if (strstr(ast->children[j]->tag, "identifier") && !*varName)
+        {
+            *varName = ast->children[j]->contents;
+        }
+    }
+}
+
+// Extrai o nome do array, o índice e, na atribuição de um elemento, o valor
+void getIndexParts(mpc_ast_t *ast, char **varName, mpc_ast_t **indexNode, mpc_ast_t **exprNode)
+{
+    *varName = NULL;
+    *indexNode = NULL;
+    *exprNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
+    {
+        if (strstr(ast->children[j]->tag, "identifier") && !*varName)
+        {
+            *varName = ast->children[j]->contents;
+        }
+        else if (strstr(ast->children[j]->tag, "expression"))
+        {
+            if (!*indexNode)
+            {
+                *indexNode = ast->children[j];
             }
             else
             {
-                returnValue = returnVar->value;
+                *exprNode = ast->children[j];
             }
         }
-        else
+    }
+}
+
+// Identifica a operação em bloco pela tag de abertura e extrai os operandos
+// (rightNode é NULL em <sum>, <min> e <max>; compare só vale em <count>)
+ArrayOp getArrayOpParts(mpc_ast_t *ast, Operator *compare, mpc_ast_t **leftNode, mpc_ast_t **rightNode)
+{
+    static const struct
+    {
+        const char *tag;
+        ArrayOp op;
+    } tags[] = {
+        {"<sum>", ARRAY_SUM}, {"<min>", ARRAY_MIN}, {"<max>", ARRAY_MAX}, {"<dot>", ARRAY_DOT},
+        {"<add>", ARRAY_ADD}, {"<mul>", ARRAY_MUL}, {"<count", ARRAY_COUNT},
+    };
+
+    ArrayOp op = ARRAY_SUM;
+    for (size_t i = 0; i < sizeof(tags) / sizeof(tags[0]); i++)
+    {
+        if (strncmp(ast->children[0]->contents, tags[i].tag, strlen(tags[i].tag)) == 0)
         {
-            // TODO: TRATAR
+            op = tags[i].op;
         }
     }
-    // TODO: Limpar o ambiente da função
 
-    return returnValue;
+    // Em <count op='...'> o operador é o filho logo depois da abertura
+    *compare = op == ARRAY_COUNT ? getOperator(ast->children[1]->contents) : OP_NONE;
+    getOperandParts(ast, leftNode, rightNode);
+    return op;
 }
 
-// Avalia uma expressão
-Value evaluateExpression(mpc_ast_t *ast, Environment *env)
+// Extrai os operandos separados por vírgula de <has>, <dot>, <add>, ...
+// (rightNode é NULL quando há um só)
+void getOperandParts(mpc_ast_t *ast, mpc_ast_t **leftNode, mpc_ast_t **rightNode)
 {
-    // Verifica se é uma chamada de função
-    if (strstr(ast->tag, "function_call"))
+    *leftNode = NULL;
+    *rightNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
     {
-        return evaluateCall(ast, env);
-    } // Verifica se é um identificador (variável)
-    if (strstr(ast->tag, "identifier"))
+        if (strstr(ast->children[j]->tag, "expression"))
+        {
+            if (!*leftNode)
+            {
+                *leftNode = ast->children[j];
+            }
+            else
+            {
+                *rightNode = ast->children[j];
+            }
+        }
+    }
+}
+
+// Extrai a condição e os blocos de um if
+void getIfParts(mpc_ast_t *ast, mpc_ast_t **condNode, mpc_ast_t **thenNode, mpc_ast_t **elseNode)
+{
+    *condNode = NULL;
+    *thenNode = NULL;
+    *elseNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
     {
-        Variable *var = findVariable(env, ast->contents);
-        if (!var)
+        if (strstr(ast->children[j]->tag, "expression"))
         {
-            printf("Erro: variável '%s' não encontrada\n", ast->contents);
-            exit(1);
+            *condNode = ast->children[j];
         }
-        // Garantindo que booleanos são retornados com tipo correto
-        if (var->value.type == TYPE_STRING && var->value.value.stringValue != NULL)
+        else if (strstr(ast->children[j]->tag, "command_list") && !*thenNode)
         {
-            if (strcmp(var->value.value.stringValue, "true") == 0 ||
-                strcmp(var->value.value.stringValue, "false") == 0)
+            *thenNode = ast->children[j];
+        }
+        else if (strstr(ast->children[j]->tag, "else"))
+        {
+            for (int k = 0; k < ast->children[j]->children_num; k++)
             {
-                Value correctedValue = fixValueType(var->value);
-
-                // Atualizar a variável para uso futuro
-                var->value = correctedValue;
-                return var->value;
+                if (strstr(ast->children[j]->children[k]->tag, "command_list"))
+                {
+                    *elseNode = ast->children[j]->children[k];
+                    break;
+                }
             }
         }
+    }
+}
 
-        return var->value;
+// Extrai a condição e o corpo de um while
+void getWhileParts(mpc_ast_t *ast, mpc_ast_t **condNode, mpc_ast_t **bodyNode)
+{
+    *condNode = NULL;
+    *bodyNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
+    {
+        if (strstr(ast->children[j]->tag, "expression"))
+        {
+            *condNode = ast->children[j];
+        }
+        else if (strstr(ast->children[j]->tag, "command_list"))
+        {
+            *bodyNode = ast->children[j];
+        }
     }
+}
 
-    // Verificar se é um número
-    if (strstr(ast->tag, "number"))
+// Expressão de um <return> ou <print> (a última encontrada)
+mpc_ast_t *getCommandExpression(mpc_ast_t *ast)
+{
+    mpc_ast_t *exprNode = NULL;
+    for (int j = 0; j < ast->children_num; j++)
     {
-        if (strchr(ast->contents, '.'))
+        if (strstr(ast->children[j]->tag, "expression"))
         {
-            Value val;
-            val.type = TYPE_FLOAT;
-            val.value.floatValue = atof(ast->contents);
-            return val;
+            exprNode = ast->children[j];
+        }
+    }
+    return exprNode;
+}
+
+// Nome da função de um <call>
+char *getCallName(mpc_ast_t *ast)
+{
+    for (int i = 0; i < ast->children_num; i++)
+    {
+        if (strstr(ast->children[i]->tag, "identifier"))
+        {
+            return ast->children[i]->contents;
+        }
+    }
+    return NULL;
+}
+
+// Coleta as expressões dos argumentos de um <call>, na ordem de avaliação
+// Retorna a quantidade de argumentos; o vetor deve ser liberado pelo chamador
+int getCallArguments(mpc_ast_t *ast, mpc_ast_t ***argNodes)
+{
+    mpc_ast_t **nodes = NULL;
+    int argCount = 0;
+
+    //  Procura por tags args_block
+    for (int i = 0; i < ast->children_num; i++)
+    {
+        if (strstr(ast->children[i]->tag, "args_block"))
+        {
+            mpc_ast_t *argsBlockNode = ast->children[i];
+
+            // Procura por args dentro do args_block
+            for (int j = 0; j < argsBlockNode->children_num; j++)
+            {
+                if (strstr(argsBlockNode->children[j]->tag, "arg_list"))
+                {
+                    mpc_ast_t *argListNode = argsBlockNode->children[j];
+
+                    // Na nova estrutura, arg_list pode ser um único arg
+                    if (strstr(argListNode->tag, "|arg"))
+                    {
+                        argCount = 1; // temos um argumento direto
+                        nodes = ALLOC_MALLOC(sizeof(mpc_ast_t *) * argCount);
+                        nodes[0] = getCommandExpression(argListNode);
+                    }
+                    else
+                    {
+                        // Estrutura mais complexa onde arg_list contém vários args
+                        for (int k = 0; k < argListNode->children_num; k++)
+                        {
+                            if (strstr(argListNode->children[k]->tag, "arg"))
+                            {
+                                argCount++;
+                            }
+                        }
+
+                        nodes = ALLOC_MALLOC(sizeof(mpc_ast_t *) * argCount);
+                        int argIndex = 0;
+
+                        // Guarda a expressão dentro de cada <arg>
+                        for (int k = 0; k < argListNode->children_num; k++)
+                        {
+                            if (strstr(argListNode->children[k]->tag, "arg"))
+                            {
+                                nodes[argIndex++] = getCommandExpression(argListNode->children[k]);
+                            }
+                        }
+                    }
+                }
+            }
+
+            break;
+        }
+    }
+
+    *argNodes = nodes;
+    return argCount;
+}
+
+// Valor devolvido por uma função, inicializado com o valor padrão do tipo de retorno
+Value getReturnValue(ValueType returnType, Variable *returnVar)
+{
+    Value returnValue = defaultValue(returnType);
+    if (returnType != TYPE_VOID)
+    {
+        if (returnVar)
+        {
+
+            // Se tivermos um valor de retorno, usamos ele
+            if (returnVar->value.type == TYPE_STRING && returnValue.type == TYPE_STRING)
+            {
+                ALLOC_FREE(returnValue.value.stringValue); // Libera a string padrão que foi alocada acima
+                returnValue.value.stringValue = ALLOC_STRING_COPY(returnVar->value.value.stringValue);
+            }
+            else
+            {
+                returnValue = widenValue(returnType, returnVar->value);
+            }
         }
         else
         {
-            Value val;
-            val.type = TYPE_INT;
-            val.value.intValue = atoi(ast->contents);
-            return val;
+            // TODO: TRATAR
         }
     }
-    // Verificar se é uma string
-    if (strstr(ast->tag, "string"))
+    return returnValue;
+}
+
+// Chamada de uma função nativa: os argumentos ficam em um vetor na pilha
+static Value evaluateBuiltin(const Builtin *builtin, mpc_ast_t *ast, Environment *env)
+{
+    mpc_ast_t **argNodes;
+    int argCount = getCallArguments(ast, &argNodes);
+    if (argCount != builtin->paramCount)
     {
-        // Se for string mas contém "true" ou "false" sem aspas, é um booleano
-        if ((strcmp(ast->contents, "true") == 0 || strcmp(ast->contents, "false") == 0) &&
-            !strchr(ast->contents, '"'))
+        fail("Erro: função '%s' espera %d argumentos, mas recebeu %d\n",
+             builtin->name, builtin->paramCount, argCount);
+    }
+
+    STATS_COUNT(builtinCalls);
+    Value args[BUILTIN_MAX_PARAMS];
+    for (int i = 0; i < argCount; i++)
+    {
+        args[i] = evaluateExpression(argNodes[i], env);
+    }
+    ALLOC_FREE(argNodes);
+
+    return builtin->function(args);
+}
+
+static Value invokeFunction(Function *function, Value *args, int argCount, Environment *env);
+
+// Avalia uma chamada de função
+Value evaluateCall(mpc_ast_t *ast, Environment *env)
+{
+    char *functionName = getCallName(ast);
+
+    if (!functionName)
+    {
+        fail("Erro: nome da função não encontrado\n");
+    }
+
+    Function *function = findFunction(env, functionName);
+    if (!function)
+    {
+        const Builtin *builtin = findBuiltin(functionName);
+        if (builtin)
         {
-            Value val;
-            val.type = TYPE_BOOL;
-            val.value.boolValue = (strcmp(ast->contents, "true") == 0);
-            return val;
+            return evaluateBuiltin(builtin, ast, env);
         }
+        fail("Erro: função '%s' não encontrada\n", functionName);
+    }
 
-        Value val;
-        val.type = TYPE_STRING;
+    // Avalia os argumentos
+    mpc_ast_t **argNodes;
+    int argCount = getCallArguments(ast, &argNodes);
+    Value *args = NULL;
+    if (argCount > 0)
+    {
+        args = ALLOC_MALLOC(sizeof(Value) * argCount);
+        for (int i = 0; i < argCount; i++)
+        {
+            args[i] = evaluateExpression(argNodes[i], env);
+        }
+    }
+    ALLOC_FREE(argNodes);
 
-        // Cria uma cópia do conteúdo para não modificar o original
-        char *content = strdup(ast->contents);
+    // Verifica se a quantidade de argumentos está correta
+    if (argCount != function->paramCount)
+    {
+        ALLOC_FREE(args);
+        fail("Erro: função '%s' espera %d argumentos, mas recebeu %d\n",
+             functionName, function->paramCount, argCount);
+    }
 
-        // Remove as aspas da cópia
-        char *str = content + 1;
-        str[strlen(str) - 1] = '\0';
-        // Garante que fazemos uma cópia profunda da string
-        val.value.stringValue = malloc(strlen(str) + 1);
-        strcpy(val.value.stringValue, str);
+    STATS_COUNT(calls);
+    if (!profileEnabled && !traceEnabled)
+    {
+        return invokeFunction(function, args, argCount, env);
+    }
+    if (traceEnabled)
+        traceBeginCall(function, args, argCount);
+    if (profileEnabled)
+        profileEnterCall(function);
+    Value result = invokeFunction(function, args, argCount, env);
+    if (profileEnabled)
+        profileLeaveCall();
+    if (traceEnabled)
+        traceEnd();
+    return result;
+}
 
-        // Libera a cópia temporária
-        free(content);
-        return val;
+// Executa o corpo de uma função com os argumentos já avaliados (liberados aqui)
+static Value invokeFunction(Function *function, Value *args, int argCount, Environment *env)
+{
+    BUDGET_STEP();
+
+    // Funções quentes podem ser executadas pelo código nativo gerado pelo JIT
+    Value jitResult;
+    if (jitTryCall(function, args, argCount, env, &jitResult))
+    {
+        ALLOC_FREE(args);
+        return jitResult;
     }
 
-    // Verificar se é um caractere
-    if (strstr(ast->tag, "character"))
+    // Cria um novo ambiente para a execução da função
+    Environment *funcEnv = createEnvironment(env);
+
+    // Define os parâmetros como variáveis no ambiente da função
+    for (int i = 0; i < function->paramCount; i++)
     {
-        Value val;
-        val.type = TYPE_CHAR;
-        val.value.charValue = ast->contents[1]; // Ignora a aspas inicial
-        return val;
-    } // Verificar se é um boolean
-    if (strstr(ast->tag, "boolean"))
+        setVariable(funcEnv, function->parameters[i].name, widenValue(function->parameters[i].type, args[i]));
+    }
+
+    ALLOC_FREE(args);
+
+    // Executa o corpo da função
+    BUDGET_ENTER();
+    evaluateCommandList(function->body, funcEnv);
+    BUDGET_LEAVE();
+
+    // Obtém o valor de retorno (se houver); o ambiente da função não é mais usado
+    Value returned = getReturnValue(function->returnType, findVariable(funcEnv, "return"));
+    freeEnvironment(funcEnv);
+    return returned;
+}
+
+static int isNumeric(Value value)
+{
+    return value.type == TYPE_INT || value.type == TYPE_FLOAT ||
+           value.type == TYPE_LONG || value.type == TYPE_DOUBLE;
+}
+
+static double toDouble(Value value)
+{
+    switch (value.type)
     {
-        Value val;
-        val.type = TYPE_BOOL;
-        val.value.boolValue = (strcmp(ast->contents, "true") == 0) ? 1 : 0;
+    case TYPE_INT:
+        return value.value.intValue;
+    case TYPE_FLOAT:
+        return value.value.floatValue;
+    case TYPE_LONG:
+        return (double)value.value.longValue;
+    default:
+        return value.value.doubleValue;
+    }
+}
 
-        return val;
+static long long toLong(Value value)
+{
+    return value.type == TYPE_INT ? value.value.intValue : value.value.longValue;
+}
+
+// Operações aritméticas e comparações em que algum operando é long ou double
+// Com algum operando de ponto flutuante o cálculo é feito em double; senão em long
+static Value applyWideOperator(Operator op, Value left, Value right)
+{
+    Value result;
+    int floating = left.type == TYPE_FLOAT || left.type == TYPE_DOUBLE ||
+                   right.type == TYPE_FLOAT || right.type == TYPE_DOUBLE;
+
+    if (op == OP_DIV && toDouble(right) == 0.0)
+    {
+        fail("Erro: divisão por zero\n");
     }
 
-    // Expressão entre parênteses
-    if (strstr(ast->tag, "primary") && strstr(ast->children[0]->tag, "string") && ast->children[0]->contents[0] == '(')
+    if (op >= OP_EQ && op <= OP_GE)
     {
-        for (int i = 0; i < ast->children_num; i++)
+        int cmp;
+        if (floating)
         {
-            if (strstr(ast->children[i]->tag, "expression"))
+            double l = toDouble(left);
+            double r = toDouble(right);
+            cmp = (l > r) - (l < r);
+            if (l != l || r != r)
             {
-                return evaluateExpression(ast->children[i], env);
+                // NaN: só != é verdadeiro
+                result.type = TYPE_BOOL;
+                result.value.boolValue = op == OP_NE;
+                return result;
             }
         }
+        else
+        {
+            long long l = toLong(left);
+            long long r = toLong(right);
+            cmp = (l > r) - (l < r);
+        }
+
+        result.type = TYPE_BOOL;
+        switch (op)
+        {
+        case OP_EQ:
+            result.value.boolValue = cmp == 0;
+            break;
+        case OP_NE:
+            result.value.boolValue = cmp != 0;
+            break;
+        case OP_LT:
+            result.value.boolValue = cmp < 0;
+            break;
+        case OP_GT:
+            result.value.boolValue = cmp > 0;
+            break;
+        case OP_LE:
+            result.value.boolValue = cmp <= 0;
+            break;
+        default:
+            result.value.boolValue = cmp >= 0;
+            break;
+        }
+        return result;
     }
 
-    // Operadores lógicos e aritméticos
-    if (ast->children_num >= 3)
+    if (floating)
     {
-        // Primeiro, tente encontrar operadores
-        for (int i = 1; i < ast->children_num - 1; i++)
-        {
-            char *op = ast->children[i]->contents;
+        double l = toDouble(left);
+        double r = toDouble(right);
+        result.type = TYPE_DOUBLE;
+        if (op == OP_ADD)
+            result.value.doubleValue = l + r;
+        else if (op == OP_SUB)
+            result.value.doubleValue = l - r;
+        else if (op == OP_MUL)
+            result.value.doubleValue = l * r;
+        else
+            result.value.doubleValue = l / r;
+    }
+    else
+    {
+        // Aritmética com complemento de dois, sem comportamento indefinido no estouro
+        unsigned long long l = (unsigned long long)toLong(left);
+        unsigned long long r = (unsigned long long)toLong(right);
+        result.type = TYPE_LONG;
+        if (op == OP_ADD)
+            result.value.longValue = (long long)(l + r);
+        else if (op == OP_SUB)
+            result.value.longValue = (long long)(l - r);
+        else if (op == OP_MUL)
+            result.value.longValue = (long long)(l * r);
+        else if ((long long)r == -1)
+            result.value.longValue = (long long)(0ULL - l);
+        else
+            result.value.longValue = (long long)l / (long long)r;
+    }
+    return result;
+}
 
-            if (strstr(op, "||") || strstr(op, "&&") ||
-                strstr(op, "==") || strstr(op, "!=") ||
-                strstr(op, "<") || strstr(op, ">") ||
-                strstr(op, "<=") || strstr(op, ">=") ||
-                strstr(op, "+") || strstr(op, "-") ||
-                strstr(op, "*") || strstr(op, "/"))
-            {
+// Aplica um operador binário a dois valores já avaliados
+// Combinações de tipos sem regra resultam em um valor zerado
+Value applyBinaryOperator(Operator op, Value left, Value right)
+{
+    Value result;
+    result.type = TYPE_VOID;
+    result.value.stringValue = NULL;
 
-                Value left = evaluateExpression(ast->children[i - 1], env);
-                Value right = evaluateExpression(ast->children[i + 1], env);
-                Value result;
+    if (op >= OP_EQ && op <= OP_DIV && isNumeric(left) && isNumeric(right) &&
+        (left.type == TYPE_LONG || left.type == TYPE_DOUBLE ||
+         right.type == TYPE_LONG || right.type == TYPE_DOUBLE))
+    {
+        return applyWideOperator(op, left, right);
+    }
 
-                if (strcmp(op, "||") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    result.value.boolValue = (left.value.boolValue || right.value.boolValue);
-                    return result;
-                }
-                else if (strcmp(op, "&&") == 0)
-                {
-                    result.type = TYPE_BOOL;
+    if (op == OP_OR)
+    {
+        result.type = TYPE_BOOL;
+        result.value.boolValue = (left.value.boolValue || right.value.boolValue);
+        return result;
+    }
+    else if (op == OP_AND)
+    {
+        result.type = TYPE_BOOL;
 
-                    // Verificar se ambos os operandos são booleanos, verificando os valores diretamente
-                    if (left.type != TYPE_BOOL || right.type != TYPE_BOOL)
-                    {
-                        printf("Erro: operador && requer operandos do tipo boolean (tipos: %s e %s)\n",
-                               getTypeString(left.type), getTypeString(right.type));
-                        // Debug para ajudar a identificar o problema
-                        exit(1);
-                    }
+        // Verificar se ambos os operandos são booleanos, verificando os valores diretamente
+        if (left.type != TYPE_BOOL || right.type != TYPE_BOOL)
+        {
+            fail("Erro: operador && requer operandos do tipo boolean (tipos: %s e %s)\n",
+                 getTypeString(left.type), getTypeString(right.type));
+        }
 
-                    // Executar a operação lógica AND
-                    result.value.boolValue = (left.value.boolValue && right.value.boolValue);
-                    return result;
-                }
-                else if (strcmp(op, "==") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.value.boolValue = (left.value.intValue == right.value.intValue);
-                    }
-                    else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
-                    {
-                        result.value.boolValue = (left.value.floatValue == right.value.floatValue);
-                    }
-                    else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
-                    {
-                        result.value.boolValue = (left.value.charValue == right.value.charValue);
-                    }
-                    else if (left.type == TYPE_BOOL && right.type == TYPE_BOOL)
-                    {
-                        result.value.boolValue = (left.value.boolValue == right.value.boolValue);
-                    }
-                    else if (left.type == TYPE_STRING && right.type == TYPE_STRING)
-                    {
-                        result.value.boolValue = (strcmp(left.value.stringValue, right.value.stringValue) == 0);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "!=") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.value.boolValue = (left.value.intValue != right.value.intValue);
-                    }
-                    else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
-                    {
-                        result.value.boolValue = (left.value.floatValue != right.value.floatValue);
-                    }
-                    else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
-                    {
-                        result.value.boolValue = (left.value.charValue != right.value.charValue);
-                    }
-                    else if (left.type == TYPE_BOOL && right.type == TYPE_BOOL)
-                    {
-                        result.value.boolValue = (left.value.boolValue != right.value.boolValue);
-                    }
-                    else if (left.type == TYPE_STRING && right.type == TYPE_STRING)
-                    {
-                        result.value.boolValue = (strcmp(left.value.stringValue, right.value.stringValue) != 0);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "<") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.value.boolValue = (left.value.intValue < right.value.intValue);
-                    }
-                    else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
-                    {
-                        result.value.boolValue = (left.value.floatValue < right.value.floatValue);
-                    }
-                    else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
-                    {
-                        result.value.boolValue = (left.value.charValue < right.value.charValue);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, ">") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.value.boolValue = (left.value.intValue > right.value.intValue);
-                    }
-                    else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
-                    {
-                        result.value.boolValue = (left.value.floatValue > right.value.floatValue);
-                    }
-                    else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
-                    {
-                        result.value.boolValue = (left.value.charValue > right.value.charValue);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "<=") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.value.boolValue = (left.value.intValue <= right.value.intValue);
-                    }
-                    else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
-                    {
-                        result.value.boolValue = (left.value.floatValue <= right.value.floatValue);
-                    }
-                    else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
-                    {
-                        result.value.boolValue = (left.value.charValue <= right.value.charValue);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, ">=") == 0)
-                {
-                    result.type = TYPE_BOOL;
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.value.boolValue = (left.value.intValue >= right.value.intValue);
-                    }
-                    else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
-                    {
-                        result.value.boolValue = (left.value.floatValue >= right.value.floatValue);
-                    }
-                    else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
-                    {
-                        result.value.boolValue = (left.value.charValue >= right.value.charValue);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "+") == 0)
-                {
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.type = TYPE_INT;
-                        result.value.intValue = left.value.intValue + right.value.intValue;
-                    }
-                    else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
-                             (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
-                             (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
-                    {
-                        result.type = TYPE_FLOAT;
-                        float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
-                        float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
-                        result.value.floatValue = leftVal + rightVal;
-                    }
-                    else if (left.type == TYPE_STRING || right.type == TYPE_STRING)
-                    {
-                        result.type = TYPE_STRING;
-                        char *leftStr = NULL;
-                        char *rightStr = NULL; // Cria cópias profundas das strings ou converte outros tipos para string
-                        if (left.type == TYPE_BOOL)
-                        {
-                            // Tratamento especial para booleanos para evitar problemas de concatenação
-                            leftStr = strdup(left.value.boolValue ? "true" : "false");
-                        }
-                        else if (left.type == TYPE_STRING)
-                        {
-                            leftStr = strdup(left.value.stringValue);
-                        }
-                        else
-                        {
-                            leftStr = valueToString(left);
-                        }
+        // Executar a operação lógica AND
+        result.value.boolValue = (left.value.boolValue && right.value.boolValue);
+        return result;
+    }
+    else if (op == OP_EQ)
+    {
+        result.type = TYPE_BOOL;
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.value.boolValue = (left.value.intValue == right.value.intValue);
+        }
+        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
+        {
+            result.value.boolValue = (left.value.floatValue == right.value.floatValue);
+        }
+        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
+        {
+            result.value.boolValue = (left.value.charValue == right.value.charValue);
+        }
+        else if (left.type == TYPE_BOOL && right.type == TYPE_BOOL)
+        {
+            result.value.boolValue = (left.value.boolValue == right.value.boolValue);
+        }
+        else if (left.type == TYPE_STRING && right.type == TYPE_STRING)
+        {
+            result.value.boolValue = (strcmp(left.value.stringValue, right.value.stringValue) == 0);
+        }
+        return result;
+    }
+    else if (op == OP_NE)
+    {
+        result.type = TYPE_BOOL;
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.value.boolValue = (left.value.intValue != right.value.intValue);
+        }
+        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
+        {
+            result.value.boolValue = (left.value.floatValue != right.value.floatValue);
+        }
+        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
+        {
+            result.value.boolValue = (left.value.charValue != right.value.charValue);
+        }
+        else if (left.type == TYPE_BOOL && right.type == TYPE_BOOL)
+        {
+            result.value.boolValue = (left.value.boolValue != right.value.boolValue);
+        }
+        else if (left.type == TYPE_STRING && right.type == TYPE_STRING)
+        {
+            result.value.boolValue = (strcmp(left.value.stringValue, right.value.stringValue) != 0);
+        }
+        return result;
+    }
+    else if (op == OP_LT)
+    {
+        result.type = TYPE_BOOL;
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.value.boolValue = (left.value.intValue < right.value.intValue);
+        }
+        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
+        {
+            result.value.boolValue = (left.value.floatValue < right.value.floatValue);
+        }
+        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
+        {
+            result.value.boolValue = (left.value.charValue < right.value.charValue);
+        }
+        return result;
+    }
+    else if (op == OP_GT)
+    {
+        result.type = TYPE_BOOL;
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.value.boolValue = (left.value.intValue > right.value.intValue);
+        }
+        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
+        {
+            result.value.boolValue = (left.value.floatValue > right.value.floatValue);
+        }
+        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
+        {
+            result.value.boolValue = (left.value.charValue > right.value.charValue);
+        }
+        return result;
+    }
+    else if (op == OP_LE)
+    {
+        result.type = TYPE_BOOL;
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.value.boolValue = (left.value.intValue <= right.value.intValue);
+        }
+        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
+        {
+            result.value.boolValue = (left.value.floatValue <= right.value.floatValue);
+        }
+        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
+        {
+            result.value.boolValue = (left.value.charValue <= right.value.charValue);
+        }
+        return result;
+    }
+    else if (op == OP_GE)
+    {
+        result.type = TYPE_BOOL;
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.value.boolValue = (left.value.intValue >= right.value.intValue);
+        }
+        else if (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT)
+        {
+            result.value.boolValue = (left.value.floatValue >= right.value.floatValue);
+        }
+        else if (left.type == TYPE_CHAR && right.type == TYPE_CHAR)
+        {
+            result.value.boolValue = (left.value.charValue >= right.value.charValue);
+        }
+        return result;
+    }
+    else if (op == OP_ADD)
+    {
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.type = TYPE_INT;
+            result.value.intValue = left.value.intValue + right.value.intValue;
+        }
+        else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
+                 (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
+                 (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
+        {
+            result.type = TYPE_FLOAT;
+            float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
+            float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
+            result.value.floatValue = leftVal + rightVal;
+        }
+        else if (left.type == TYPE_STRING || right.type == TYPE_STRING)
+        {
+            result = concatenateValues(left, right);
+        }
+        return result;
+    }
+    else if (op == OP_SUB)
+    {
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.type = TYPE_INT;
+            result.value.intValue = left.value.intValue - right.value.intValue;
+        }
+        else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
+                 (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
+                 (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
+        {
+            result.type = TYPE_FLOAT;
+            float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
+            float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
+            result.value.floatValue = leftVal - rightVal;
+        }
+        return result;
+    }
+    else if (op == OP_MUL)
+    {
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.type = TYPE_INT;
+            result.value.intValue = left.value.intValue * right.value.intValue;
+        }
+        else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
+                 (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
+                 (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
+        {
+            result.type = TYPE_FLOAT;
+            float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
+            float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
+            result.value.floatValue = leftVal * rightVal;
+        }
+        return result;
+    }
+    else if (op == OP_DIV)
+    {
+        if (right.type == TYPE_INT && right.value.intValue == 0)
+        {
+            fail("Erro: divisão por zero\n");
+        }
+        else if (right.type == TYPE_FLOAT && right.value.floatValue == 0.0)
+        {
+            fail("Erro: divisão por zero\n");
+        }
+
+        if (left.type == TYPE_INT && right.type == TYPE_INT)
+        {
+            result.type = TYPE_INT;
+            // Como no long: dividir por -1 é negar em complemento de dois, já
+            // que o menor int dividido por -1 não cabe no int e gera SIGFPE
+            if (right.value.intValue == -1)
+                result.value.intValue = (int)(0U - (unsigned)left.value.intValue);
+            else
+                result.value.intValue = left.value.intValue / right.value.intValue;
+        }
+        else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
+                 (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
+                 (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
+        {
+            result.type = TYPE_FLOAT;
+            float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
+            float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
+            result.value.floatValue = leftVal / rightVal;
+        }
+        return result;
+    }
 
-                        if (right.type == TYPE_BOOL)
-                        {
-                            // Tratamento especial para booleanos para evitar problemas de concatenação
-                            rightStr = strdup(right.value.boolValue ? "true" : "false");
-                        }
-                        else if (right.type == TYPE_STRING)
-                        {
-                            rightStr = strdup(right.value.stringValue);
-                        }
-                        else
-                        {
-                            rightStr = valueToString(right);
-                        }
+    return result;
+}
 
-                        // Aloca memória para a nova string concatenada
-                        size_t leftLen = strlen(leftStr);
-                        size_t rightLen = strlen(rightStr);
-                        result.value.stringValue = malloc(leftLen + rightLen + 1);
+// Aplica o operador unário - ou !
+Value applyUnaryOperator(Operator op, Value val)
+{
+    Value result;
+    result.type = TYPE_VOID;
+    result.value.stringValue = NULL;
 
-                        // Copia o conteúdo das strings usando strcpy/strcat para maior segurança
-                        strcpy(result.value.stringValue, leftStr);
-                        strcat(result.value.stringValue, rightStr);
+    if (op == OP_NEG)
+    {
+        if (val.type == TYPE_INT)
+        {
+            result.type = TYPE_INT;
+            result.value.intValue = -val.value.intValue;
+        }
+        else if (val.type == TYPE_FLOAT)
+        {
+            result.type = TYPE_FLOAT;
+            result.value.floatValue = -val.value.floatValue;
+        }
+        else if (val.type == TYPE_LONG)
+        {
+            result.type = TYPE_LONG;
+            result.value.longValue = (long long)(0ULL - (unsigned long long)val.value.longValue);
+        }
+        else if (val.type == TYPE_DOUBLE)
+        {
+            result.type = TYPE_DOUBLE;
+            result.value.doubleValue = -val.value.doubleValue;
+        }
+    }
+    else if (op == OP_NOT)
+    {
+        result.type = TYPE_BOOL;
+        result.value.boolValue = !val.value.boolValue;
+    }
 
-                        // Libera as strings temporárias
-                        free(leftStr);
-                        free(rightStr);
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "-") == 0)
-                {
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.type = TYPE_INT;
-                        result.value.intValue = left.value.intValue - right.value.intValue;
-                    }
-                    else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
-                             (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
-                             (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
-                    {
-                        result.type = TYPE_FLOAT;
-                        float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
-                        float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
-                        result.value.floatValue = leftVal - rightVal;
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "*") == 0)
-                {
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.type = TYPE_INT;
-                        result.value.intValue = left.value.intValue * right.value.intValue;
-                    }
-                    else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
-                             (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
-                             (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
-                    {
-                        result.type = TYPE_FLOAT;
-                        float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
-                        float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
-                        result.value.floatValue = leftVal * rightVal;
-                    }
-                    return result;
-                }
-                else if (strcmp(op, "/") == 0)
-                {
-                    if (right.type == TYPE_INT && right.value.intValue == 0)
-                    {
-                        printf("Erro: divisão por zero\n");
-                        exit(1);
-                    }
-                    else if (right.type == TYPE_FLOAT && right.value.floatValue == 0.0)
-                    {
-                        printf("Erro: divisão por zero\n");
-                        exit(1);
-                    }
+    return result;
+}
 
-                    if (left.type == TYPE_INT && right.type == TYPE_INT)
-                    {
-                        result.type = TYPE_INT;
-                        result.value.intValue = left.value.intValue / right.value.intValue;
-                    }
-                    else if ((left.type == TYPE_FLOAT && right.type == TYPE_INT) ||
-                             (left.type == TYPE_INT && right.type == TYPE_FLOAT) ||
-                             (left.type == TYPE_FLOAT && right.type == TYPE_FLOAT))
-                    {
-                        result.type = TYPE_FLOAT;
-                        float leftVal = (left.type == TYPE_INT) ? left.value.intValue : left.value.floatValue;
-                        float rightVal = (right.type == TYPE_INT) ? right.value.intValue : right.value.floatValue;
-                        result.value.floatValue = leftVal / rightVal;
-                    }
-                    return result;
-                }
+// Avalia uma expressão
+Value evaluateExpression(mpc_ast_t *ast, Environment *env)
+{
+    ExpressionKind kind = getExpressionKind(ast);
+    STATS_COUNT(expressions[kind]);
+
+    // Verifica se é uma chamada de função
+    if (kind == EXPR_CALL)
+    {
+        return evaluateCall(ast, env);
+    } // Verifica se é um identificador (variável)
+    if (kind == EXPR_IDENTIFIER)
+    {
+        Variable *var = findVariable(env, ast->contents);
+        if (!var)
+        {
+            fail("Erro: variável '%s' não encontrada\n", ast->contents);
+        }
+        // Garantindo que booleanos são retornados com tipo correto
+        return readVariable(var);
+    }
+
+    // Verificar se é um número
+    if (kind == EXPR_NUMBER)
+    {
+        return parseNumber(ast->contents);
+    }
+    // Verificar se é uma string
+    if (kind == EXPR_STRING)
+    {
+        Value val;
+        val.type = TYPE_STRING;
+
+        // Cria uma cópia do conteúdo para não modificar o original
+        char *content = ALLOC_STRDUP(ast->contents);
+
+        // Remove as aspas da cópia
+        char *str = content + 1;
+        str[strlen(str) - 1] = '\0';
+        // Garante que fazemos uma cópia profunda da string
+        val.value.stringValue = ALLOC_STRING(strlen(str) + 1);
+        strcpy(val.value.stringValue, str);
+
+        // Libera a cópia temporária
+        ALLOC_FREE(content);
+        return val;
+    }
+
+    // Verificar se é um caractere
+    if (kind == EXPR_CHAR)
+    {
+        Value val;
+        val.type = TYPE_CHAR;
+        val.value.charValue = ast->contents[1]; // Ignora a aspas inicial
+        return val;
+    } // Verificar se é um boolean (os literais true e false chegam com a tag string)
+    if (kind == EXPR_BOOLEAN)
+    {
+        Value val;
+        val.type = TYPE_BOOL;
+        val.value.boolValue = (strcmp(ast->contents, "true") == 0) ? 1 : 0;
+
+        return val;
+    }
+
+    // Expressão entre parênteses
+    if (kind == EXPR_PAREN)
+    {
+        for (int i = 0; i < ast->children_num; i++)
+        {
+            if (strstr(ast->children[i]->tag, "expression"))
+            {
+                return evaluateExpression(ast->children[i], env);
             }
         }
     }
 
+    // Operadores lógicos e aritméticos
+    if (kind == EXPR_BINARY)
+    {
+        int i = findOperatorIndex(ast);
+        Operator op = getOperator(ast->children[i]->contents);
+
+        Value left = evaluateExpression(ast->children[i - 1], env);
+        Value right = evaluateExpression(ast->children[i + 1], env);
+        return applyBinaryOperator(op, left, right);
+    }
+
     // Operador unário
-    if (ast->children_num >= 2)
+    if (kind == EXPR_UNARY)
+    {
+        Operator op = strcmp(ast->children[0]->contents, "-") == 0 ? OP_NEG : OP_NOT;
+        Value val = evaluateExpression(ast->children[1], env);
+        return applyUnaryOperator(op, val);
+    }
+
+    // Elemento de array
+    if (kind == EXPR_INDEX)
     {
-        char *op = ast->children[0]->contents;
+        char *varName;
+        mpc_ast_t *indexNode;
+        mpc_ast_t *exprNode;
+        getIndexParts(ast, &varName, &indexNode, &exprNode);
 
-        if (strcmp(op, "-") == 0 || strcmp(op, "!") == 0)
+        Variable *var = findVariable(env, varName);
+        if (!var)
         {
-            Value val = evaluateExpression(ast->children[1], env);
-            Value result;
+            fail("Erro: variável '%s' não encontrada\n", varName);
+        }
+        Value index = evaluateExpression(indexNode, env);
+        return indexGet(readVariable(var), index);
+    }
 
-            if (strcmp(op, "-") == 0)
-            {
-                if (val.type == TYPE_INT)
-                {
-                    result.type = TYPE_INT;
-                    result.value.intValue = -val.value.intValue;
-                }
-                else if (val.type == TYPE_FLOAT)
-                {
-                    result.type = TYPE_FLOAT;
-                    result.value.floatValue = -val.value.floatValue;
-                }
-            }
-            else if (strcmp(op, "!") == 0)
-            {
-                result.type = TYPE_BOOL;
-                result.value.boolValue = !val.value.boolValue;
-            }
+    // Tamanho de array ou string
+    if (kind == EXPR_LENGTH)
+    {
+        return valueLength(evaluateExpression(getCommandExpression(ast), env));
+    }
 
-            return result;
+    // Operação em bloco sobre arrays
+    if (kind == EXPR_ARRAY_OP)
+    {
+        Operator compare;
+        mpc_ast_t *leftNode;
+        mpc_ast_t *rightNode;
+        ArrayOp op = getArrayOpParts(ast, &compare, &leftNode, &rightNode);
+
+        Value left = evaluateExpression(leftNode, env);
+        Value right;
+        right.type = TYPE_VOID;
+        if (rightNode)
+        {
+            right = evaluateExpression(rightNode, env);
         }
+        return arrayOperation(op, compare, left, right);
+    }
+
+    // Teste de presença de uma chave no map
+    if (kind == EXPR_HAS)
+    {
+        mpc_ast_t *mapNode;
+        mpc_ast_t *keyNode;
+        getOperandParts(ast, &mapNode, &keyNode);
+        Value map = evaluateExpression(mapNode, env);
+        return mapHas(map, evaluateExpression(keyNode, env));
     }
 
-    printf("Erro: expressão %s %s não reconhecida\n", ast->tag);
+    // Chaves do map, na ordem de inserção
+    if (kind == EXPR_KEYS)
+    {
+        return mapKeys(evaluateExpression(getCommandExpression(ast), env));
+    }
 
-    exit(1);
+    fail("Erro: expressão %s não reconhecida\n", ast->tag);
 }
 
 // Avalia um comando de retorno
@@ -964,43 +1708,7 @@ Value evaluateReturn(mpc_ast_t *ast, Environment *env)
                 // Realiza a operação
                 if (leftVal.type == TYPE_STRING || rightVal.type == TYPE_STRING)
                 {
-                    char *leftStr = NULL;
-                    char *rightStr = NULL;
-
-                    // Cria cópias profundas das strings ou converte outros tipos para string
-                    if (leftVal.type == TYPE_STRING)
-                    {
-                        leftStr = strdup(leftVal.value.stringValue);
-                    }
-                    else
-                    {
-                        leftStr = valueToString(leftVal);
-                    }
-
-                    if (rightVal.type == TYPE_STRING)
-                    {
-                        rightStr = strdup(rightVal.value.stringValue);
-                    }
-                    else
-                    {
-                        rightStr = valueToString(rightVal);
-                    }
-
-                    // Aloca memória para a nova string concatenada
-                    returnValue.type = TYPE_STRING;
-                    size_t leftLen = strlen(leftStr);
-                    size_t rightLen = strlen(rightStr);
-                    returnValue.value.stringValue = malloc(leftLen + rightLen + 1);
-
-                    // Copia o conteúdo das strings usando memcpy que é mais eficiente
-                    memcpy(returnValue.value.stringValue, leftStr, leftLen);
-                    memcpy(returnValue.value.stringValue + leftLen, rightStr, rightLen);
-                    returnValue.value.stringValue[leftLen + rightLen] = '\0';
-                    // Libera as strings temporárias
-                    free(leftStr);
-                    free(rightStr);
-
-                    return returnValue;
+                    return concatenateValues(leftVal, rightVal);
                 }
             }
         }
@@ -1009,6 +1717,41 @@ Value evaluateReturn(mpc_ast_t *ast, Environment *env)
     return returnValue;
 }
 
+// Imprime um valor seguido de quebra de linha
+// Números são formatados direto no buffer de saída (ver output.h)
+void printValue(Value val)
+{
+    if (val.type == TYPE_STRING)
+    {
+        // Mesmo texto que o printf usava para strings nulas
+        const char *text = val.value.stringValue ? val.value.stringValue : "(null)";
+        outputLine(text, strlen(text));
+    }
+    else if (val.type == TYPE_CHAR)
+    {
+        outputLine(&val.value.charValue, 1);
+    }
+    else if (val.type == TYPE_VOID)
+    {
+        outputLine("void", 4);
+    }
+    else if (val.type == TYPE_ARRAY || val.type == TYPE_MAP)
+    {
+        size_t length = formatText(NULL, val);
+        char *text = ALLOC_MALLOC(length);
+        formatText(text, val);
+        outputLine(text, length);
+        ALLOC_FREE(text);
+    }
+    else
+    {
+        char *out = outputReserve(OUTPUT_FORMAT_MAX);
+        int length = formatScalar(out, val);
+        out[length] = '\n';
+        outputCommit(length + 1);
+    }
+}
+
 // Avalia uma lista de comandos
 void evaluateCommandList(mpc_ast_t *ast, Environment *env)
 {
@@ -1024,75 +1767,68 @@ void evaluateCommandList(mpc_ast_t *ast, Environment *env)
     }
 }
 
+static void executeCommand(mpc_ast_t *ast, Environment *env, CommandKind kind);
+
 void evaluateCommand(mpc_ast_t *ast, Environment *env)
 {
-    // Declaração de variável
-    if (strstr(ast->tag, "variable_declaration"))
+    CommandKind kind = getCommandKind(ast);
+    STATS_COUNT(commands[kind]);
+    if (!profileEnabled || kind == COMMAND_NONE)
     {
-        char *varType = NULL;
-        char *varName = NULL;
+        executeCommand(ast, env, kind);
+        return;
+    }
+    profileEnterCommand(ast);
+    executeCommand(ast, env, kind);
+    profileLeaveCommand();
+}
 
-        for (int j = 0; j < ast->children_num; j++)
-        {
-            if (strstr(ast->children[j]->tag, "type"))
-            {
-                varType = ast->children[j]->contents;
-            }
-            else if (strstr(ast->children[j]->tag, "identifier"))
-            {
-                varName = ast->children[j]->contents;
-            }
-        }
+static void executeCommand(mpc_ast_t *ast, Environment *env, CommandKind kind)
+{
+
+    // Declaração de variável
+    if (kind == COMMAND_VAR_DECL)
+    {
+        char *varType;
+        char *varName;
+        getDeclarationParts(ast, &varType, &varName);
 
         if (varType && varName)
         {
-            Value val;
-            val.type = getType(varType);
-
-            // Inicializa com valor padrão
-            switch (val.type)
-            {
-            case TYPE_INT:
-                val.value.intValue = 0;
-                break;
-            case TYPE_FLOAT:
-                val.value.floatValue = 0.0;
-                break;
-            case TYPE_CHAR:
-                val.value.charValue = '\0';
-                break;
-            case TYPE_BOOL:
-                val.value.boolValue = 0;
-                break;
-            case TYPE_STRING:
-                val.value.stringValue = strdup("");
-                break;
-            case TYPE_VOID:
-                // Nada a fazer para void
-                break;
-            }
-
+            // Inicializa com valor padrão (arrays começam vazios)
+            ValueType type = getType(varType);
+            Value val = type == TYPE_ARRAY ? newArray(getElementType(varType)) : defaultValue(type);
             setVariable(env, varName, val);
         }
     }
 
-    // Atribuição
-    else if (strstr(ast->tag, "assignment"))
+    // Atribuição de um elemento de array
+    else if (kind == COMMAND_INDEX_ASSIGN)
     {
-        char *varName = NULL;
-        mpc_ast_t *exprNode = NULL;
+        char *varName;
+        mpc_ast_t *indexNode;
+        mpc_ast_t *exprNode;
+        getIndexParts(ast, &varName, &indexNode, &exprNode);
 
-        for (int j = 0; j < ast->children_num; j++)
+        if (varName && indexNode && exprNode)
         {
-            if (strstr(ast->children[j]->tag, "identifier"))
-            {
-                varName = ast->children[j]->contents;
-            }
-            else if (strstr(ast->children[j]->tag, "expression"))
+            Variable *var = findVariable(env, varName);
+            if (!var)
             {
-                exprNode = ast->children[j];
+                fail("Erro: variável '%s' não encontrada\n", varName);
             }
+            Value index = evaluateExpression(indexNode, env);
+            Value val = evaluateExpression(exprNode, env);
+            indexSet(readVariable(var), index, val);
         }
+    }
+
+    // Atribuição
+    else if (kind == COMMAND_ASSIGN)
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getAssignmentParts(ast, &varName, &exprNode);
 
         if (varName && exprNode)
         {
@@ -1102,34 +1838,12 @@ void evaluateCommand(mpc_ast_t *ast, Environment *env)
     }
 
     // If-estrutura
-    else if (strstr(ast->tag, "if_structure"))
+    else if (kind == COMMAND_IF)
     {
-        mpc_ast_t *condNode = NULL;
-        mpc_ast_t *thenNode = NULL;
-        mpc_ast_t *elseNode = NULL;
-
-        for (int j = 0; j < ast->children_num; j++)
-        {
-            if (strstr(ast->children[j]->tag, "expression"))
-            {
-                condNode = ast->children[j];
-            }
-            else if (strstr(ast->children[j]->tag, "command_list") && !thenNode)
-            {
-                thenNode = ast->children[j];
-            }
-            else if (strstr(ast->children[j]->tag, "else"))
-            {
-                for (int k = 0; k < ast->children[j]->children_num; k++)
-                {
-                    if (strstr(ast->children[j]->children[k]->tag, "command_list"))
-                    {
-                        elseNode = ast->children[j]->children[k];
-                        break;
-                    }
-                }
-            }
-        }
+        mpc_ast_t *condNode;
+        mpc_ast_t *thenNode;
+        mpc_ast_t *elseNode;
+        getIfParts(ast, &condNode, &thenNode, &elseNode);
 
         if (condNode && thenNode)
         {
@@ -1137,8 +1851,7 @@ void evaluateCommand(mpc_ast_t *ast, Environment *env)
 
             if (condVal.type != TYPE_BOOL)
             {
-                printf("Erro: condição deve ser do tipo bool\n");
-                exit(1);
+                fail("Erro: condição deve ser do tipo bool\n");
             }
 
             if (condVal.value.boolValue)
@@ -1153,22 +1866,11 @@ void evaluateCommand(mpc_ast_t *ast, Environment *env)
     }
 
     // While-estrutura
-    else if (strstr(ast->tag, "while_structure"))
+    else if (kind == COMMAND_WHILE)
     {
-        mpc_ast_t *condNode = NULL;
-        mpc_ast_t *bodyNode = NULL;
-
-        for (int j = 0; j < ast->children_num; j++)
-        {
-            if (strstr(ast->children[j]->tag, "expression"))
-            {
-                condNode = ast->children[j];
-            }
-            else if (strstr(ast->children[j]->tag, "command_list"))
-            {
-                bodyNode = ast->children[j];
-            }
-        }
+        mpc_ast_t *condNode;
+        mpc_ast_t *bodyNode;
+        getWhileParts(ast, &condNode, &bodyNode);
 
         if (condNode && bodyNode)
         {
@@ -1178,8 +1880,7 @@ void evaluateCommand(mpc_ast_t *ast, Environment *env)
 
                 if (condVal.type != TYPE_BOOL)
                 {
-                    printf("Erro: condição deve ser do tipo bool\n");
-                    exit(1);
+                    fail("Erro: condição deve ser do tipo bool\n");
                 }
 
                 if (!condVal.value.boolValue)
@@ -1187,27 +1888,21 @@ void evaluateCommand(mpc_ast_t *ast, Environment *env)
                     break;
                 }
 
+                BUDGET_STEP();
                 evaluateCommandList(bodyNode, env);
             }
         }
     }
 
     // Chamada de função
-    else if (strstr(ast->tag, "function_call"))
+    else if (kind == COMMAND_CALL)
     {
         evaluateCall(ast, env);
     }
     // Return
-    else if (strstr(ast->tag, "return"))
+    else if (kind == COMMAND_RETURN)
     {
-        mpc_ast_t *exprNode = NULL;
-        for (int j = 0; j < ast->children_num; j++)
-        {
-            if (strstr(ast->children[j]->tag, "expression"))
-            {
-                exprNode = ast->children[j];
-            }
-        }
+        mpc_ast_t *exprNode = getCommandExpression(ast);
         if (exprNode)
         {
             Value val = evaluateExpression(exprNode, env);
@@ -1217,42 +1912,57 @@ void evaluateCommand(mpc_ast_t *ast, Environment *env)
     }
 
     // Print
-    else if (strstr(ast->tag, "print"))
+    else if (kind == COMMAND_PRINT)
     {
-        mpc_ast_t *exprNode = NULL;
-        for (int j = 0; j < ast->children_num; j++)
+        mpc_ast_t *exprNode = getCommandExpression(ast);
+
+        if (exprNode)
         {
-            if (strstr(ast->children[j]->tag, "expression"))
-            {
-                exprNode = ast->children[j];
-            }
+            Value val = evaluateExpression(exprNode, env);
+            printValue(val);
         }
+    }
 
-        if (exprNode)
+    // Flush
+    else if (kind == COMMAND_FLUSH)
+    {
+        outputFlush();
+    }
+
+    // Acrescenta um elemento ao fim de um array
+    else if (kind == COMMAND_PUSH)
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getPushParts(ast, &varName, &exprNode);
+
+        if (varName && exprNode)
         {
+            Variable *var = findVariable(env, varName);
+            if (!var)
+            {
+                fail("Erro: variável '%s' não encontrada\n", varName);
+            }
             Value val = evaluateExpression(exprNode, env);
+            arrayPush(readVariable(var), val);
+        }
+    }
+
+    // Remove uma chave de um map
+    else if (kind == COMMAND_DELETE)
+    {
+        char *varName;
+        mpc_ast_t *exprNode;
+        getPushParts(ast, &varName, &exprNode);
 
-            switch (val.type)
+        if (varName && exprNode)
+        {
+            Variable *var = findVariable(env, varName);
+            if (!var)
             {
-            case TYPE_INT:
-                printf("%d\n", val.value.intValue);
-                break;
-            case TYPE_FLOAT:
-                printf("%f\n", val.value.floatValue);
-                break;
-            case TYPE_CHAR:
-                printf("%c\n", val.value.charValue);
-                break;
-            case TYPE_BOOL:
-                printf("%s\n", val.value.boolValue ? "true" : "false");
-                break;
-            case TYPE_STRING:
-                printf("%s\n", val.value.stringValue);
-                break;
-            case TYPE_VOID:
-                printf("void\n");
-                break;
+                fail("Erro: variável '%s' não encontrada\n", varName);
             }
+            mapDelete(readVariable(var), evaluateExpression(exprNode, env));
         }
     }
 }
@@ -1275,7 +1985,7 @@ void loadFunction(mpc_ast_t *child, Environment *env)
             {
                 funcName = node->contents;
             }
-            else if (strstr(node->tag, "primitive_type") && !returnType)
+            else if ((strstr(node->tag, "primitive_type") || strstr(node->tag, "array_type")) && !returnType)
             {
                 returnType = node->contents;
             }
@@ -1292,11 +2002,14 @@ void loadFunction(mpc_ast_t *child, Environment *env)
         if (funcName && returnType && commandListNode)
         {
             Function func;
-            func.name = strdup(funcName);
+            func.name = ALLOC_STRDUP(funcName);
             func.returnType = getType(returnType);
             func.body = commandListNode;
             func.paramCount = 0;
             func.parameters = NULL;
+            func.callCount = 0;
+            func.jitCode = NULL;
+            func.profile = NULL;
 
             // Processa parâmetros, se houver
             if (paramListNode)
@@ -1312,7 +2025,7 @@ void loadFunction(mpc_ast_t *child, Environment *env)
 
                 if (func.paramCount > 0)
                 {
-                    func.parameters = malloc(sizeof(Parameter) * func.paramCount);
+                    func.parameters = ALLOC_MALLOC(sizeof(Parameter) * func.paramCount);
                     int paramIndex = 0;
 
                     for (int j = 0; j < paramListNode->children_num; j++)
@@ -1338,7 +2051,7 @@ void loadFunction(mpc_ast_t *child, Environment *env)
 
                             if (paramType && paramName)
                             {
-                                func.parameters[paramIndex].name = strdup(paramName);
+                                func.parameters[paramIndex].name = ALLOC_STRDUP(paramName);
                                 func.parameters[paramIndex].type = getType(paramType);
                                 paramIndex++;
                             }
@@ -1382,141 +2095,6 @@ void loadFunctions(mpc_ast_t *ast, Environment *env)
     }
 }
 
-int main(int argc, char **argv)
-{
-    // Definição dos parsers usando a gramática BNF
-    mpc_parser_t *Code = mpc_new("code");
-    mpc_parser_t *FunctionList = mpc_new("function_list");
-    mpc_parser_t *FunctionDecl = mpc_new("function_declaration");
-    mpc_parser_t *ParamList = mpc_new("parameter_list");
-    mpc_parser_t *Parameter = mpc_new("parameter");
-    mpc_parser_t *CmdList = mpc_new("command_list");
-    mpc_parser_t *Command = mpc_new("command");
-    mpc_parser_t *VarDecl = mpc_new("variable_declaration");
-    mpc_parser_t *Assignment = mpc_new("assignment");
-    mpc_parser_t *IfStruct = mpc_new("if_structure");
-    mpc_parser_t *ElseOpt = mpc_new("else_optional");
-    mpc_parser_t *WhileStruct = mpc_new("while_structure");
-    mpc_parser_t *FunctionCall = mpc_new("function_call");
-    mpc_parser_t *ArgsBlock = mpc_new("args_block");
-    mpc_parser_t *ArgList = mpc_new("arg_list");
-    mpc_parser_t *Arg = mpc_new("arg");
-    mpc_parser_t *Return = mpc_new("return");
-    mpc_parser_t *Print = mpc_new("print");
-    mpc_parser_t *Expression = mpc_new("expression");
-    mpc_parser_t *LogicalOr = mpc_new("logical_or");
-    mpc_parser_t *LogicalAnd = mpc_new("logical_and");
-    mpc_parser_t *Equality = mpc_new("equality");
-    mpc_parser_t *Relational = mpc_new("relational");
-    mpc_parser_t *Sum = mpc_new("sum");
-    mpc_parser_t *Product = mpc_new("product");
-    mpc_parser_t *Unary = mpc_new("unary");
-    mpc_parser_t *Primary = mpc_new("primary");
-    mpc_parser_t *Type = mpc_new("type");
-    mpc_parser_t *PrimitiveType = mpc_new("primitive_type");
-    mpc_parser_t *String = mpc_new("string");
-    mpc_parser_t *Identifier = mpc_new("identifier");
-    mpc_parser_t *Number = mpc_new("number");
-    mpc_parser_t *Character = mpc_new("character");
-    mpc_parser_t *Boolean = mpc_new("boolean");
-
-    // Gramática da linguagem
-    mpca_lang(MPCA_LANG_DEFAULT,
-              "code          : /^/ <function_list> /$/ ;\n"
-              "function_list : <function_declaration>+ ;\n"
-              "function_declaration : \"<function name='\" <identifier> \"' return='\" <type> \"'>\" <parameter_list>? <command_list>? \"</function>\" ;\n"
-              "parameter_list : \"<params>\" <parameter>+ \"</params>\" ;\n"
-              "parameter     : \"<param type='\" <type> \"'>\" <identifier> \"</param>\" ;\n"
-              "command_list  : <command>+ ;\n"
-              "command       : <return>\n"
-              "              | <print>\n"
-              "              | <variable_declaration>\n"
-              "              | <assignment>\n"
-              "              | <if_structure>\n"
-              "              | <while_structure>\n"
-              "              | <function_call> ;\n"
-              "variable_declaration : \"<var type='\" <type> \"'>\" <identifier> \"</var>\" ;\n"
-              "assignment    : \"<assign var='\" <identifier> \"'>\" <expression> \"</assign>\" ;\n"
-              "if_structure  : \"<if cond='\" <expression> \"'>\" <command_list>? \"</if>\" <else_optional>? ;\n"
-              "else_optional : \"<else>\" <command_list>? \"</else>\" ;\n"
-              "while_structure : \"<while cond='\" <expression> \"'>\" <command_list>? \"</while>\" ;\n"
-              "function_call : \"<call name='\" <identifier> \"'>\" <args_block>? \"</call>\" ;\n"
-              "args_block    : \"<args>\" <arg_list> \"</args>\" ;\n"
-              "arg_list      : <arg>+ ;\n"
-              "arg           : \"<arg>\" <expression> \"</arg>\" ;\n"
-              "return        : \"<return>\" <expression> \"</return>\" ;\n"
-              "print         : \"<print>\" <expression> \"</print>\" ;\n"
-              "expression    : <logical_or> ;\n"
-              "logical_or    : <logical_and> (\"||\" <logical_or>)* ;\n"
-              "logical_and   : <equality> (\"&&\" <logical_and>)* ;\n"
-              "equality      : <relational> ((\"==\" | \"!=\") <equality>)* ;\n"
-              "relational    : <sum> ((\"<=\" | \">=\" | \"<\" | \">\") <relational>)* ;\n"
-              "sum           : <product> ((\"+\" | \"-\") <sum>)* ;\n"
-              "product       : <unary> ((\"*\" | \"/\") <product>)* ;\n"
-              "unary         : (\"-\" | \"!\") <unary> | <primary> ;    \n"
-              "primary       : <number> | <character> | <boolean> | <string> | <identifier> | \"(\" <expression> \")\" | <function_call> ;\n"
-              "type          : <primitive_type> ;\n"
-              "primitive_type : \"int\" | \"float\" | \"char\" | \"bool\" | \"string\" | \"void\" ;\n"
-              "string        : /\"([^\"])*\"/ ;\n"
-              "identifier    : /[a-zA-Z][a-zA-Z0-9_]*/ ;\n"
-              "number        : /[0-9]+(\\.[0-9]+)?/ ;\n"
-              "character     : /\'[a-zA-Z]\'/ ;\n"
-              "boolean       : \"true\" | \"false\" ;\n",
-              Code, FunctionList, FunctionDecl, ParamList, Parameter,
-              CmdList, Command, Return, Print, VarDecl, Assignment, IfStruct,
-              ElseOpt, WhileStruct, FunctionCall, ArgsBlock, ArgList, Arg,
-              Expression, LogicalOr, LogicalAnd, Equality, Relational,
-              Sum, Product, Unary, Primary, Type, PrimitiveType,
-              String, Identifier, Number, Character, Boolean);
-
-    // Verifica se um arquivo foi fornecido como argumento
-    if (argc > 1)
-    {
-        mpc_result_t r;
-        if (mpc_parse_contents(argv[1], Code, &r))
-        {
-            mpc_ast_t *ast = (mpc_ast_t *)r.output;
-            // Inicializa o ambiente de execução
-            Environment *env = createEnvironment(NULL);
-
-            // Carrega as funções do arquivo
-            loadFunctions(ast, env);
-
-            // Encontra a função main e executa
-            Function *mainFunc = findFunction(env, "main");
-            if (mainFunc)
-            {
-                // Executa a função main
-                evaluateCommandList(mainFunc->body, env);
-            }
-            else
-            {
-                printf("Erro: função 'main' não encontrada\n");
-            }
-
-            mpc_ast_delete(ast);
-        }
-        else
-        {
-            mpc_err_print(r.error);
-            mpc_err_delete(r.error);
-        }
-    }
-    else
-    {
-        printf("Uso: %s <arquivo.phtml>\n", argv[0]);
-    }
-    // Limpa os parsers (33 parsers)
-    mpc_cleanup(34,
-                Code, FunctionList, FunctionDecl, ParamList, Parameter,
-                CmdList, Command, VarDecl, Assignment, IfStruct, ElseOpt, WhileStruct,
-                FunctionCall, ArgsBlock, ArgList, Arg, Return, Print, Expression, LogicalOr,
-                LogicalAnd, Equality, Relational, Sum, Product, Unary, Primary,
-                Type, PrimitiveType, String, Identifier, Number, Character, Boolean);
-
-    return 0;
-}
-
 // Função para corrigir o tipo de valor
 // Esta função é usada para garantir que valores booleanos sejam tratados corretamente
 Value fixValueType(Value value)
@@ -1528,13 +2106,13 @@ Value fixValueType(Value value)
         {
             if (strcmp(value.value.stringValue, "true") == 0)
             {
-                free(value.value.stringValue);
+                ALLOC_FREE(value.value.stringValue);
                 value.type = TYPE_BOOL;
                 value.value.boolValue = 1;
             }
             else if (strcmp(value.value.stringValue, "false") == 0)
             {
-                free(value.value.stringValue);
+                ALLOC_FREE(value.value.stringValue);
                 value.type = TYPE_BOOL;
                 value.value.boolValue = 0;
             }
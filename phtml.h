@@ -0,0 +1,231 @@
+#ifndef PHTML_H
+#define PHTML_H
+
+#include "mpc.h"
+
+// Definição das estruturas para os tipos da linguagem
+// Value ocupa 16 bytes (tipo + união de 8 bytes) e é passado e retornado em dois
+// registradores, então os tipos de 64 bits não aumentam o custo de copiar valores
+typedef enum
+{
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_CHAR,
+    TYPE_BOOL,
+    TYPE_STRING,
+    TYPE_VOID,
+    TYPE_LONG,   // inteiro de 64 bits
+    TYPE_DOUBLE, // ponto flutuante de 64 bits
+    TYPE_ARRAY,  // ver array.h
+    TYPE_MAP     // ver map.h
+} ValueType;
+
+typedef struct
+{
+    ValueType type;
+    union
+    {
+        int intValue;
+        float floatValue;
+        char charValue;
+        int boolValue;
+        char *stringValue;
+        long long longValue;
+        double doubleValue;
+        struct Array *arrayValue;
+        struct Map *mapValue;
+    } value;
+} Value;
+
+// Array com elementos de um único tipo, guardados em sequência no formato nativo
+// (int, float, double, char * ...); compartilhado por referência entre variáveis
+typedef struct Array
+{
+    ValueType elementType; // TYPE_VOID até o primeiro elemento quando o tipo não foi declarado
+    int length;
+    int capacity;
+    void *items;
+} Array;
+
+// Entrada de um map; as entradas ficam em sequência, na ordem de inserção
+typedef struct MapEntry
+{
+    unsigned hash;
+    Value key; // TYPE_VOID em uma entrada removida
+    Value value;
+} MapEntry;
+
+// Map de chaves int ou string (ver map.h); compartilhado por referência como os arrays
+typedef struct Map
+{
+    ValueType keyType; // TYPE_VOID até a primeira chave
+    int count;         // entradas presentes
+    int used;          // entradas ocupadas em 'entries', incluindo as removidas
+    int capacity;      // tamanho de 'entries'
+    int tableSize;     // potência de 2
+    int *table;        // posição da entrada em 'entries', ou MAP_EMPTY / MAP_REMOVED
+    MapEntry *entries;
+} Map;
+
+// Estrutura para parâmetros de função
+typedef struct
+{
+    char *name;
+    ValueType type;
+} Parameter;
+
+// Estrutura para armazenar funções
+typedef struct Function
+{
+    char *name;
+    ValueType returnType;
+    int paramCount;
+    Parameter *parameters;
+    mpc_ast_t *body;
+
+    // Estado do compilador JIT (ver jit.c)
+    int callCount;
+    struct JitCode *jitCode;
+
+    // Totais do perfil de execução (ver profile.c)
+    struct ProfileFunction *profile;
+} Function;
+
+// Estrutura para armazenar variáveis
+typedef struct Variable
+{
+    char *name;
+    Value value;
+    struct Variable *next;
+} Variable;
+
+// Ambiente de execução
+typedef struct Environment
+{
+    Variable *variables;
+    Function *functions;
+    int functionCount;
+    struct Environment *parent;
+
+    // Muda sempre que uma variável é criada neste ambiente (usado pelos caches de busca)
+    unsigned long version;
+} Environment;
+
+// Classificação dos nós da AST, na mesma ordem de testes usada pelo avaliador
+typedef enum
+{
+    COMMAND_NONE,
+    COMMAND_VAR_DECL,
+    COMMAND_INDEX_ASSIGN,
+    COMMAND_ASSIGN,
+    COMMAND_IF,
+    COMMAND_WHILE,
+    COMMAND_CALL,
+    COMMAND_RETURN,
+    COMMAND_PRINT,
+    COMMAND_FLUSH,
+    COMMAND_PUSH,
+    COMMAND_DELETE
+} CommandKind;
+
+typedef enum
+{
+    EXPR_CALL,
+    EXPR_INDEX,
+    EXPR_IDENTIFIER,
+    EXPR_NUMBER,
+    EXPR_STRING,
+    EXPR_CHAR,
+    EXPR_BOOLEAN,
+    EXPR_PAREN,
+    EXPR_BINARY,
+    EXPR_UNARY,
+    EXPR_LENGTH,
+    EXPR_ARRAY_OP,
+    EXPR_HAS,
+    EXPR_KEYS,
+    EXPR_INVALID
+} ExpressionKind;
+
+typedef enum
+{
+    OP_OR,
+    OP_AND,
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_GT,
+    OP_LE,
+    OP_GE,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_NEG,
+    OP_NOT,
+    OP_NONE
+} Operator;
+
+// Operações em bloco sobre arrays numéricos (ver array.h)
+typedef enum
+{
+    ARRAY_SUM,
+    ARRAY_MIN,
+    ARRAY_MAX,
+    ARRAY_DOT,
+    ARRAY_ADD,
+    ARRAY_MUL,
+    ARRAY_COUNT
+} ArrayOp;
+
+// Funções utilitárias
+ValueType getType(const char *typeStr);
+ValueType getElementType(const char *typeStr);
+char *getTypeString(ValueType type);
+Value fixValueType(Value value);
+Value defaultValue(ValueType type);
+Value parseNumber(const char *text);
+Value widenValue(ValueType target, Value value);
+Value copyValue(Value value);
+void printValue(Value val);
+
+// Ambiente e variáveis
+Environment *createEnvironment(Environment *parent);
+void freeEnvironment(Environment *env);
+Variable *findVariable(Environment *env, const char *name);
+void setVariable(Environment *env, const char *name, Value value);
+void assignVariable(Variable *var, Value value);
+Value readVariable(Variable *var);
+unsigned long getChainVersion(Environment *env);
+Function *findFunction(Environment *env, const char *name);
+void addFunction(Environment *env, Function func);
+
+// Classificação da AST
+CommandKind getCommandKind(mpc_ast_t *ast);
+ExpressionKind getExpressionKind(mpc_ast_t *ast);
+int findOperatorIndex(mpc_ast_t *ast);
+Operator getOperator(const char *op);
+void getDeclarationParts(mpc_ast_t *ast, char **varType, char **varName);
+void getAssignmentParts(mpc_ast_t *ast, char **varName, mpc_ast_t **exprNode);
+void getPushParts(mpc_ast_t *ast, char **varName, mpc_ast_t **exprNode);
+void getIndexParts(mpc_ast_t *ast, char **varName, mpc_ast_t **indexNode, mpc_ast_t **exprNode);
+ArrayOp getArrayOpParts(mpc_ast_t *ast, Operator *compare, mpc_ast_t **leftNode, mpc_ast_t **rightNode);
+void getOperandParts(mpc_ast_t *ast, mpc_ast_t **leftNode, mpc_ast_t **rightNode);
+void getIfParts(mpc_ast_t *ast, mpc_ast_t **condNode, mpc_ast_t **thenNode, mpc_ast_t **elseNode);
+void getWhileParts(mpc_ast_t *ast, mpc_ast_t **condNode, mpc_ast_t **bodyNode);
+mpc_ast_t *getCommandExpression(mpc_ast_t *ast);
+char *getCallName(mpc_ast_t *ast);
+int getCallArguments(mpc_ast_t *ast, mpc_ast_t ***argNodes);
+
+// Avaliação
+Value applyBinaryOperator(Operator op, Value left, Value right);
+Value applyUnaryOperator(Operator op, Value val);
+Value getReturnValue(ValueType returnType, Variable *returnVar);
+Value evaluateExpression(mpc_ast_t *ast, Environment *env);
+void evaluateCommandList(mpc_ast_t *ast, Environment *env);
+void evaluateCommand(mpc_ast_t *ast, Environment *env);
+
+// Carrega as <function> de um arquivo analisado no ambiente global
+void loadFunctions(mpc_ast_t *ast, Environment *env);
+
+#endif
@@ -0,0 +1,816 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "mpc.h"
+#include "alloc.h"
+#include "phtml.h"
+#include "profile.h"
+
+// Quantidade máxima de linhas no relatório
+#define PROFILE_REPORT_LINES 30
+
+// Tamanho máximo do trecho do código mostrado para cada linha
+#define PROFILE_SOURCE_WIDTH 60
+
+// Profundidade máxima da pilha guardada em uma amostra (as chamadas mais
+// internas que isso continuam contando, mas não aparecem na amostra)
+#define SAMPLE_STACK_MAX 1024
+
+// Tamanho do buffer circular de amostras, em palavras de 64 bits (potência de 2)
+#define SAMPLE_RING_WORDS (1 << 20)
+
+// Intervalo em que a thread de coleta esvazia o buffer
+#define SAMPLE_DRAIN_NS 20000000L
+
+// Tamanho inicial da tabela de pilhas distintas (potência de 2)
+#define SAMPLE_TABLE_INITIAL 256
+
+int profileEnabled = 0;
+
+// Diferente de zero no modo por amostragem (profileEnableSampling)
+static int sampling = 0;
+
+// Totais de uma função (ligados a Function.profile)
+typedef struct ProfileFunction
+{
+    Function *function;
+    long calls;
+    long long inclusive; // nanossegundos
+    long long exclusive;
+    long allocations;
+    size_t bytes;
+    int active; // chamadas em andamento; o tempo inclusivo só soma na mais externa
+    struct ProfileFunction *next;
+} ProfileFunction;
+
+// Totais de uma linha do arquivo
+typedef struct
+{
+    long count;
+    long long inclusive;
+    long long exclusive;
+    long allocations;
+    size_t bytes;
+    int active;
+} ProfileLine;
+
+// Nó da árvore de contextos de chamada, usada no arquivo de pilhas
+typedef struct ProfileNode
+{
+    ProfileFunction *function;
+    struct ProfileNode *parent;
+    struct ProfileNode *children;
+    struct ProfileNode *sibling;
+    long long exclusive;
+} ProfileNode;
+
+// Chamada ou comando em andamento
+typedef struct
+{
+    ProfileFunction *function; // chamadas
+    ProfileNode *node;         // chamadas
+    int row;                   // comandos (pelo índice: a tabela pode ser realocada)
+    long long start;
+    long long children;        // tempo das chamadas ou comandos internos
+} ProfileFrame;
+
+typedef struct
+{
+    ProfileFrame *frames;
+    int depth;
+    int capacity;
+} ProfileStack;
+
+static const char *sourceFile = NULL;
+static const char *foldedFile = NULL;
+
+static ProfileFunction *functions = NULL;
+static ProfileLine *lines = NULL;
+static int lineCount = 0;
+static ProfileNode root;
+
+static ProfileStack calls;
+static ProfileStack commands;
+
+static long long now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+static ProfileFrame *pushFrame(ProfileStack *stack)
+{
+    if (stack->depth == stack->capacity)
+    {
+        stack->capacity = stack->capacity ? stack->capacity * 2 : 64;
+        stack->frames = realloc(stack->frames, sizeof(ProfileFrame) * stack->capacity);
+    }
+    return &stack->frames[stack->depth++];
+}
+
+// Encerra o quadro do topo: retorna o tempo decorrido e o soma ao quadro de fora
+static long long popFrame(ProfileStack *stack, ProfileFrame **frame)
+{
+    *frame = &stack->frames[--stack->depth];
+    long long elapsed = now() - (*frame)->start;
+    if (stack->depth > 0)
+    {
+        stack->frames[stack->depth - 1].children += elapsed;
+    }
+    return elapsed;
+}
+
+static ProfileNode *childNode(ProfileNode *parent, ProfileFunction *function)
+{
+    for (ProfileNode *node = parent->children; node; node = node->sibling)
+    {
+        if (node->function == function)
+        {
+            return node;
+        }
+    }
+    ProfileNode *node = calloc(1, sizeof(ProfileNode));
+    node->function = function;
+    node->parent = parent;
+    node->sibling = parent->children;
+    parent->children = node;
+    return node;
+}
+
+static void sampleEnterCall(Function *function);
+static void sampleLeaveCall(void);
+static void sampleEnterCommand(int row);
+static void sampleLeaveCommand(void);
+
+void profileEnterCall(Function *function)
+{
+    if (sampling)
+    {
+        sampleEnterCall(function);
+        return;
+    }
+    ProfileFunction *entry = function->profile;
+    if (!entry)
+    {
+        entry = calloc(1, sizeof(ProfileFunction));
+        entry->function = function;
+        entry->next = functions;
+        functions = entry;
+        function->profile = entry;
+    }
+    entry->calls++;
+    entry->active++;
+
+    ProfileNode *parent = calls.depth > 0 ? calls.frames[calls.depth - 1].node : &root;
+    ProfileFrame *frame = pushFrame(&calls);
+    frame->function = entry;
+    frame->node = childNode(parent, entry);
+    frame->children = 0;
+    frame->start = now();
+}
+
+void profileLeaveCall(void)
+{
+    if (sampling)
+    {
+        sampleLeaveCall();
+        return;
+    }
+    ProfileFrame *frame;
+    long long elapsed = popFrame(&calls, &frame);
+    ProfileFunction *entry = frame->function;
+    long long exclusive = elapsed - frame->children;
+    entry->exclusive += exclusive;
+    frame->node->exclusive += exclusive;
+    if (--entry->active == 0)
+    {
+        entry->inclusive += elapsed;
+    }
+}
+
+void profileEnterCommand(mpc_ast_t *ast)
+{
+    int row = (int)ast->state.row;
+    if (sampling)
+    {
+        sampleEnterCommand(row);
+        return;
+    }
+    if (row >= lineCount)
+    {
+        int count = lineCount ? lineCount : 256;
+        while (count <= row)
+        {
+            count *= 2;
+        }
+        lines = realloc(lines, sizeof(ProfileLine) * count);
+        memset(lines + lineCount, 0, sizeof(ProfileLine) * (count - lineCount));
+        lineCount = count;
+    }
+    lines[row].count++;
+    lines[row].active++;
+
+    ProfileFrame *frame = pushFrame(&commands);
+    frame->row = row;
+    frame->children = 0;
+    frame->start = now();
+}
+
+void profileLeaveCommand(void)
+{
+    if (sampling)
+    {
+        sampleLeaveCommand();
+        return;
+    }
+    ProfileFrame *frame;
+    long long elapsed = popFrame(&commands, &frame);
+    ProfileLine *line = &lines[frame->row];
+    line->exclusive += elapsed - frame->children;
+    if (--line->active == 0)
+    {
+        line->inclusive += elapsed;
+    }
+}
+
+void profileAllocation(size_t bytes)
+{
+    if (sampling)
+    {
+        return;
+    }
+    if (calls.depth > 0)
+    {
+        ProfileFunction *entry = calls.frames[calls.depth - 1].function;
+        entry->allocations++;
+        entry->bytes += bytes;
+    }
+    if (commands.depth > 0)
+    {
+        ProfileLine *line = &lines[commands.frames[commands.depth - 1].row];
+        line->allocations++;
+        line->bytes += bytes;
+    }
+}
+
+static int compareFunctions(const void *a, const void *b)
+{
+    long long left = (*(ProfileFunction *const *)a)->exclusive;
+    long long right = (*(ProfileFunction *const *)b)->exclusive;
+    return (left < right) - (left > right);
+}
+
+static const ProfileLine *sortedLines = NULL;
+
+static int compareRows(const void *a, const void *b)
+{
+    long long left = sortedLines[*(const int *)a].exclusive;
+    long long right = sortedLines[*(const int *)b].exclusive;
+    if (left != right)
+    {
+        return (left < right) - (left > right);
+    }
+    return *(const int *)a - *(const int *)b;
+}
+
+static double milliseconds(long long nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+static double percent(long long part, long long total)
+{
+    return total > 0 ? 100.0 * part / total : 0;
+}
+
+// Lê o arquivo e separa as linhas (as quebras viram '\0'); retorna a quantidade
+static int readSource(char **text, char ***starts)
+{
+    *text = NULL;
+    *starts = NULL;
+    FILE *file = sourceFile ? fopen(sourceFile, "rb") : NULL;
+    if (!file)
+    {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    *text = malloc(size + 1);
+    size = (long)fread(*text, 1, size, file);
+    (*text)[size] = '\0';
+    fclose(file);
+
+    int count = 1;
+    for (long i = 0; i < size; i++)
+    {
+        count += (*text)[i] == '\n';
+    }
+    *starts = malloc(sizeof(char *) * count);
+    int row = 0;
+    (*starts)[row++] = *text;
+    for (long i = 0; i < size; i++)
+    {
+        if ((*text)[i] == '\n')
+        {
+            (*text)[i] = '\0';
+            (*starts)[row++] = *text + i + 1;
+        }
+    }
+    return count;
+}
+
+// Escreve uma linha por contexto de chamada: main;f;g <tempo exclusivo em ns>
+static void writeFolded(FILE *file, ProfileNode *node)
+{
+    for (; node; node = node->sibling)
+    {
+        if (node->exclusive > 0)
+        {
+            int depth = 0;
+            for (ProfileNode *up = node; up != &root; up = up->parent)
+            {
+                depth++;
+            }
+            ProfileNode **path = malloc(sizeof(ProfileNode *) * depth);
+            int index = depth;
+            for (ProfileNode *up = node; up != &root; up = up->parent)
+            {
+                path[--index] = up;
+            }
+            for (int i = 0; i < depth; i++)
+            {
+                fprintf(file, "%s%s", i > 0 ? ";" : "", path[i]->function->function->name);
+            }
+            fprintf(file, " %lld\n", node->exclusive);
+            free(path);
+        }
+        writeFolded(file, node->children);
+    }
+}
+
+static void profileReport(void)
+{
+    // Um erro em tempo de execução encerra o programa no meio de chamadas e
+    // comandos; eles são fechados aqui para que o tempo gasto até o erro conte
+    while (commands.depth > 0)
+    {
+        profileLeaveCommand();
+    }
+    while (calls.depth > 0)
+    {
+        profileLeaveCall();
+    }
+
+    int functionCount = 0;
+    long long total = 0;
+    for (ProfileFunction *entry = functions; entry; entry = entry->next)
+    {
+        functionCount++;
+        total += entry->exclusive;
+    }
+    ProfileFunction **sorted = malloc(sizeof(ProfileFunction *) * (functionCount ? functionCount : 1));
+    int index = 0;
+    for (ProfileFunction *entry = functions; entry; entry = entry->next)
+    {
+        sorted[index++] = entry;
+    }
+    qsort(sorted, functionCount, sizeof(ProfileFunction *), compareFunctions);
+
+    fprintf(stderr, "\nPerfil: %.3f ms em %d funções\n\n", milliseconds(total), functionCount);
+    // A largura do printf é em bytes: cada letra acentuada dos cabeçalhos ocupa dois,
+    // então as colunas com acento levam um a mais por letra para ficarem alinhadas.
+    // Os outros relatórios (--alloc-report e as ferramentas de bench/) seguem a mesma regra
+    fprintf(stderr, "%-25s %10s %12s %12s %7s %12s %12s\n",
+            "função", "chamadas", "inclusivo", "exclusivo", "%", "alocações", "bytes");
+    for (int i = 0; i < functionCount; i++)
+    {
+        ProfileFunction *entry = sorted[i];
+        fprintf(stderr, "%-24s %10ld %12.3f %12.3f %6.1f%% %10ld %12zu\n",
+                entry->function->name, entry->calls, milliseconds(entry->inclusive),
+                milliseconds(entry->exclusive), percent(entry->exclusive, total),
+                entry->allocations, entry->bytes);
+    }
+    free(sorted);
+
+    // Linhas executadas, da que tem mais tempo exclusivo para a que tem menos
+    int *rows = malloc(sizeof(int) * (lineCount ? lineCount : 1));
+    int rowCount = 0;
+    for (int row = 0; row < lineCount; row++)
+    {
+        if (lines[row].count > 0)
+        {
+            rows[rowCount++] = row;
+        }
+    }
+    sortedLines = lines;
+    qsort(rows, rowCount, sizeof(int), compareRows);
+
+    char *text;
+    char **source;
+    int sourceLines = readSource(&text, &source);
+
+    fprintf(stderr, "\n%6s %12s %12s %12s %7s %12s %12s  %s\n",
+            "linha", "execuções", "inclusivo", "exclusivo", "%", "alocações", "bytes", "código");
+    int shown = rowCount < PROFILE_REPORT_LINES ? rowCount : PROFILE_REPORT_LINES;
+    for (int i = 0; i < shown; i++)
+    {
+        int row = rows[i];
+        ProfileLine *line = &lines[row];
+        const char *code = row < sourceLines ? source[row] : "";
+        while (*code == ' ' || *code == '\t')
+        {
+            code++;
+        }
+        fprintf(stderr, "%6d %10ld %12.3f %12.3f %6.1f%% %10ld %12zu  %.*s\n",
+                row + 1, line->count, milliseconds(line->inclusive), milliseconds(line->exclusive),
+                percent(line->exclusive, total), line->allocations, line->bytes,
+                PROFILE_SOURCE_WIDTH, code);
+    }
+    if (rowCount > shown)
+    {
+        fprintf(stderr, "... mais %d linhas\n", rowCount - shown);
+    }
+    fprintf(stderr, "(tempos em ms)\n");
+    free(rows);
+    free(source);
+    free(text);
+
+    if (foldedFile)
+    {
+        FILE *file = fopen(foldedFile, "w");
+        if (!file)
+        {
+            fprintf(stderr, "Erro: não foi possível criar '%s'\n", foldedFile);
+            return;
+        }
+        writeFolded(file, root.children);
+        fclose(file);
+    }
+}
+
+void profileEnable(const char *sourcePath, const char *foldedPath)
+{
+    if (profileEnabled)
+    {
+        return;
+    }
+    sourceFile = sourcePath;
+    foldedFile = foldedPath;
+    profileEnabled = 1;
+    allocProfiling = 1;
+    atexit(profileReport);
+}
+
+// Perfil por amostragem
+//
+// A execução mantém uma pilha paralela com a função e a linha atual de cada
+// chamada (só escritas simples, sem medir tempo). O SIGPROF do setitimer copia
+// essa pilha para um buffer circular, sem travas: o tratador do sinal é o único
+// que escreve e a thread de coleta a única que lê, cada um avançando seu índice.
+// A thread de coleta agrupa as pilhas iguais e, no fim, elas são gravadas como
+// main:3;desenha:12;linha:20 <amostras>.
+
+typedef struct
+{
+    Function *function;
+    int row; // linha do comando em execução na chamada (-1 antes do primeiro)
+} SampleFrame;
+
+// Pilha paralela; alterada só pela thread do programa e lida pelo tratador do
+// sinal, que a interrompe (as barreiras de sinal mantêm a ordem das escritas)
+static SampleFrame sampleStack[SAMPLE_STACK_MAX];
+static int sampleDepth = 0;
+
+// Linhas anteriores dos comandos em andamento, restauradas no fim de cada um
+static int *sampleRows = NULL;
+static int sampleRowDepth = 0;
+static int sampleRowCapacity = 0;
+
+// Buffer circular: cada amostra é a profundidade seguida de função e linha por quadro
+static uint64_t *ring = NULL;
+static uint64_t ringHead = 0; // escrito pelo tratador do sinal
+static uint64_t ringTail = 0; // escrito pela thread de coleta
+static unsigned long samplesDropped = 0;
+
+// Pilhas distintas e suas contagens (só a thread de coleta acessa)
+typedef struct SampleStack
+{
+    uint64_t hash;
+    int depth;
+    SampleFrame *frames;
+    unsigned long count;
+    struct SampleStack *next;
+} SampleStack;
+
+static SampleStack **stackTable = NULL;
+static int stackTableSize = 0;
+static int stackCount = 0;
+static unsigned long samplesTaken = 0;
+
+static int sampleRate = 0;
+static int stopCollector = 0;
+static pthread_t collector;
+static long long samplingStart = 0;
+
+static void sampleEnterCall(Function *function)
+{
+    int depth = sampleDepth;
+    if (depth < SAMPLE_STACK_MAX)
+    {
+        sampleStack[depth].function = function;
+        sampleStack[depth].row = -1;
+    }
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    sampleDepth = depth + 1;
+}
+
+static void sampleLeaveCall(void)
+{
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    sampleDepth--;
+}
+
+static void sampleEnterCommand(int row)
+{
+    int depth = sampleDepth;
+    if (depth == 0 || depth > SAMPLE_STACK_MAX)
+    {
+        return;
+    }
+    if (sampleRowDepth == sampleRowCapacity)
+    {
+        sampleRowCapacity = sampleRowCapacity ? sampleRowCapacity * 2 : 256;
+        sampleRows = realloc(sampleRows, sizeof(int) * sampleRowCapacity);
+    }
+    sampleRows[sampleRowDepth++] = sampleStack[depth - 1].row;
+    sampleStack[depth - 1].row = row;
+}
+
+static void sampleLeaveCommand(void)
+{
+    int depth = sampleDepth;
+    if (depth == 0 || depth > SAMPLE_STACK_MAX)
+    {
+        return;
+    }
+    sampleStack[depth - 1].row = sampleRows[--sampleRowDepth];
+}
+
+// Tratador do SIGPROF: copia a pilha atual para o buffer, ou descarta a amostra
+// se a thread de coleta ainda não abriu espaço
+static void takeSample(int signal)
+{
+    (void)signal;
+    int depth = sampleDepth;
+    if (depth == 0)
+    {
+        return;
+    }
+    if (depth > SAMPLE_STACK_MAX)
+    {
+        depth = SAMPLE_STACK_MAX;
+    }
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+    uint64_t head = ringHead;
+    uint64_t tail = __atomic_load_n(&ringTail, __ATOMIC_ACQUIRE);
+    uint64_t needed = 1 + 2 * (uint64_t)depth;
+    if (SAMPLE_RING_WORDS - (head - tail) < needed)
+    {
+        samplesDropped++;
+        return;
+    }
+    uint64_t mask = SAMPLE_RING_WORDS - 1;
+    ring[head++ & mask] = (uint64_t)depth;
+    for (int i = 0; i < depth; i++)
+    {
+        ring[head++ & mask] = (uint64_t)(uintptr_t)sampleStack[i].function;
+        ring[head++ & mask] = (uint64_t)(int64_t)sampleStack[i].row;
+    }
+    __atomic_store_n(&ringHead, head, __ATOMIC_RELEASE);
+}
+
+static uint64_t hashFrames(const SampleFrame *frames, int depth)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < depth; i++)
+    {
+        hash = (hash ^ (uint64_t)(uintptr_t)frames[i].function) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)(uint32_t)frames[i].row) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void growStackTable(void)
+{
+    int size = stackTableSize ? stackTableSize * 2 : SAMPLE_TABLE_INITIAL;
+    SampleStack **table = calloc(size, sizeof(SampleStack *));
+    for (int i = 0; i < stackTableSize; i++)
+    {
+        SampleStack *entry = stackTable[i];
+        while (entry)
+        {
+            SampleStack *next = entry->next;
+            entry->next = table[entry->hash & (size - 1)];
+            table[entry->hash & (size - 1)] = entry;
+            entry = next;
+        }
+    }
+    free(stackTable);
+    stackTable = table;
+    stackTableSize = size;
+}
+
+static void countStack(const SampleFrame *frames, int depth)
+{
+    uint64_t hash = hashFrames(frames, depth);
+    for (SampleStack *entry = stackTable[hash & (stackTableSize - 1)]; entry; entry = entry->next)
+    {
+        if (entry->hash == hash && entry->depth == depth &&
+            memcmp(entry->frames, frames, sizeof(SampleFrame) * depth) == 0)
+        {
+            entry->count++;
+            return;
+        }
+    }
+    if (stackCount >= stackTableSize)
+    {
+        growStackTable();
+    }
+    SampleStack *entry = malloc(sizeof(SampleStack));
+    entry->hash = hash;
+    entry->depth = depth;
+    entry->frames = malloc(sizeof(SampleFrame) * depth);
+    memcpy(entry->frames, frames, sizeof(SampleFrame) * depth);
+    entry->count = 1;
+    entry->next = stackTable[hash & (stackTableSize - 1)];
+    stackTable[hash & (stackTableSize - 1)] = entry;
+    stackCount++;
+}
+
+// Agrupa as amostras que estão no buffer
+static void drainSamples(void)
+{
+    static SampleFrame frames[SAMPLE_STACK_MAX];
+    uint64_t head = __atomic_load_n(&ringHead, __ATOMIC_ACQUIRE);
+    uint64_t tail = ringTail;
+    uint64_t mask = SAMPLE_RING_WORDS - 1;
+    while (tail != head)
+    {
+        int depth = (int)ring[tail++ & mask];
+        for (int i = 0; i < depth; i++)
+        {
+            // Os quadros ficam zerados antes da comparação (o preenchimento conta no memcmp)
+            memset(&frames[i], 0, sizeof(SampleFrame));
+            frames[i].function = (Function *)(uintptr_t)ring[tail++ & mask];
+            frames[i].row = (int)(int64_t)ring[tail++ & mask];
+        }
+        countStack(frames, depth);
+        samplesTaken++;
+    }
+    __atomic_store_n(&ringTail, tail, __ATOMIC_RELEASE);
+}
+
+static void *collectSamples(void *argument)
+{
+    (void)argument;
+    struct timespec interval = {0, SAMPLE_DRAIN_NS};
+    while (!__atomic_load_n(&stopCollector, __ATOMIC_ACQUIRE))
+    {
+        nanosleep(&interval, NULL);
+        drainSamples();
+    }
+    return NULL;
+}
+
+static int compareStacks(const void *a, const void *b)
+{
+    unsigned long left = (*(SampleStack *const *)a)->count;
+    unsigned long right = (*(SampleStack *const *)b)->count;
+    return (left < right) - (left > right);
+}
+
+static void writeFrame(FILE *file, const SampleFrame *frame)
+{
+    if (frame->row >= 0)
+    {
+        fprintf(file, "%s:%d", frame->function->name, frame->row + 1);
+    }
+    else
+    {
+        fprintf(file, "%s", frame->function->name);
+    }
+}
+
+static void sampleReport(void)
+{
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_PROF, &off, NULL);
+    signal(SIGPROF, SIG_IGN);
+
+    __atomic_store_n(&stopCollector, 1, __ATOMIC_RELEASE);
+    pthread_join(collector, NULL);
+    drainSamples();
+    double seconds = (now() - samplingStart) / 1e9;
+
+    SampleStack **sorted = malloc(sizeof(SampleStack *) * (stackCount ? stackCount : 1));
+    int index = 0;
+    for (int i = 0; i < stackTableSize; i++)
+    {
+        for (SampleStack *entry = stackTable[i]; entry; entry = entry->next)
+        {
+            sorted[index++] = entry;
+        }
+    }
+    qsort(sorted, stackCount, sizeof(SampleStack *), compareStacks);
+
+    fprintf(stderr, "\nAmostras: %lu em %.3f s a %d Hz (%lu descartadas), %d pilhas distintas\n",
+            samplesTaken, seconds, sampleRate, samplesDropped, stackCount);
+
+    FILE *file = fopen(foldedFile, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Erro: não foi possível criar '%s'\n", foldedFile);
+    }
+    else
+    {
+        for (int i = 0; i < stackCount; i++)
+        {
+            for (int j = 0; j < sorted[i]->depth; j++)
+            {
+                if (j > 0)
+                {
+                    fputc(';', file);
+                }
+                writeFrame(file, &sorted[i]->frames[j]);
+            }
+            fprintf(file, " %lu\n", sorted[i]->count);
+        }
+        fclose(file);
+        fprintf(stderr, "Pilhas gravadas em '%s'\n", foldedFile);
+    }
+
+    // As pilhas mais frequentes, pela função e linha do topo
+    int shown = stackCount < 10 ? stackCount : 10;
+    for (int i = 0; i < shown; i++)
+    {
+        SampleStack *entry = sorted[i];
+        fprintf(stderr, "%8lu %5.1f%%  ", entry->count, 100.0 * entry->count / samplesTaken);
+        writeFrame(stderr, &entry->frames[entry->depth - 1]);
+        fprintf(stderr, " (profundidade %d)\n", entry->depth);
+    }
+    free(sorted);
+}
+
+void profileEnableSampling(int hz, const char *foldedPath)
+{
+    if (profileEnabled || hz <= 0)
+    {
+        return;
+    }
+    foldedFile = foldedPath;
+    sampleRate = hz;
+    ring = malloc(sizeof(uint64_t) * SAMPLE_RING_WORDS);
+    growStackTable();
+
+    // A thread de coleta nasce com o SIGPROF bloqueado, para que só a thread do
+    // programa seja interrompida
+    sigset_t signals;
+    sigset_t previous;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPROF);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+    pthread_create(&collector, NULL, collectSamples, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = takeSample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    sampling = 1;
+    profileEnabled = 1;
+    atexit(sampleReport);
+
+    struct itimerval timer;
+    long interval = 1000000L / hz;
+    if (interval < 1)
+    {
+        interval = 1;
+    }
+    timer.it_interval.tv_sec = interval / 1000000L;
+    timer.it_interval.tv_usec = interval % 1000000L;
+    timer.it_value = timer.it_interval;
+    samplingStart = now();
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
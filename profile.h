@@ -0,0 +1,56 @@
+#ifndef PHTML_PROFILE_H
+#define PHTML_PROFILE_H
+
+#include <stddef.h>
+#include "mpc.h"
+#include "phtml.h"
+
+// Perfil de execução (phtml --profile arquivo.phtml)
+//
+// Para cada função do programa e cada linha do arquivo são contadas as
+// execuções, o tempo inclusivo (com tudo que foi chamado a partir dela), o tempo
+// exclusivo (só o trecho da própria função ou linha) e as alocações feitas pelo
+// interpretador enquanto ela estava ativa. O relatório sai na saída de erro no
+// fim do programa, ordenado pelo tempo exclusivo.
+//
+// Com --profile-folded=arquivo, o tempo exclusivo de cada pilha de chamadas
+// (main;desenha;linha 1234567, em nanossegundos) é gravado no formato usado por
+// flamegraph.pl e speedscope.
+//
+// Com --sample-profile=HZ, em vez de medir cada chamada, a pilha de funções e
+// linhas é copiada HZ vezes por segundo de tempo de CPU (SIGPROF) e, no fim, as
+// pilhas e a quantidade de amostras de cada uma são gravadas no mesmo formato
+// (main:3;desenha:12 57). Só há escritas simples por chamada e por comando, então
+// funções curtas não ficam mais lentas que o resto, como na medição completa.
+//
+// O perfil mede o interpretador de árvore: funções executadas pelo JIT contam
+// como chamadas, mas sem as linhas do corpo. Como o JIT, guarda estado nas
+// funções e é só da linha de comando.
+
+// Arquivo de pilhas do modo por amostragem quando --profile-folded não é usado
+#define PROFILE_SAMPLE_OUTPUT "phtml.folded"
+
+// Diferente de zero depois de profileEnable; os ganchos só são chamados com ele
+extern int profileEnabled;
+
+// Ativa o perfil; o relatório é emitido na saída do processo (atexit)
+// 'sourcePath' é usado para mostrar o texto das linhas; 'foldedPath' pode ser NULL
+void profileEnable(const char *sourcePath, const char *foldedPath);
+
+// Ativa o modo por amostragem, com 'hz' amostras por segundo; o resumo sai na
+// saída de erro e as pilhas em 'foldedPath'
+void profileEnableSampling(int hz, const char *foldedPath);
+
+// Início e fim da execução do corpo de uma função
+void profileEnterCall(Function *function);
+void profileLeaveCall(void);
+
+// Início e fim de um comando (a linha é a do nó na AST)
+void profileEnterCommand(mpc_ast_t *ast);
+void profileLeaveCommand(void);
+
+// Alocação feita pelo interpretador, contada na função e na linha ativas
+// Chamada pelas macros de alloc.h enquanto o perfil está ativo
+void profileAllocation(size_t bytes);
+
+#endif
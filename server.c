@@ -0,0 +1,755 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "libphtml.h"
+#include "batch.h"
+#include "server.h"
+
+#define SERVER_EVENTS 64
+#define SERVER_READ_CHUNK 4096
+#define SERVER_CACHE_INITIAL 64
+
+// Programa em cache; continua vivo enquanto algum pedido o usa, mesmo depois de
+// ser substituído por uma versão mais nova do arquivo
+typedef struct
+{
+    PhtmlProgram *program;
+    int refs;
+} CachedProgram;
+
+typedef struct CacheEntry
+{
+    char *path;
+    unsigned hash;
+    struct timespec mtime;
+    off_t size;
+    CachedProgram *cached;
+    struct CacheEntry *next;
+} CacheEntry;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    CacheEntry **buckets;
+    int bucketCount; // potência de 2
+    int count;
+} ProgramCache;
+
+typedef struct Connection
+{
+    int fd;
+    char *input;
+    size_t inputLength;
+    size_t inputCapacity;
+    char *output;
+    size_t outputLength;
+    size_t outputSent;
+    int busy;     // há um pedido em execução ou uma resposta sendo enviada
+    int inWorker; // o pedido está com uma das threads de execução
+    int eof;      // o cliente não vai enviar mais nada
+    int closed;   // fd fechado; a memória é liberada no fim da rodada do epoll
+    unsigned events; // eventos registrados no epoll
+    struct Connection *next; // lista de conexões fechadas
+} Connection;
+
+typedef struct Request
+{
+    Connection *connection;
+    char *line;
+    char *response;
+    size_t responseLength;
+    struct Request *next;
+} Request;
+
+typedef struct
+{
+    Request *head;
+    Request *tail;
+} RequestList;
+
+typedef struct
+{
+    PhtmlRuntime *runtime;
+    ProgramCache cache;
+    int epollFd;
+    int listenFd;
+    int wakeFd;   // eventfd: as threads avisam que há respostas prontas
+    int signalFd; // SIGINT e SIGTERM
+
+    // Conexões fechadas nesta rodada: ainda podem aparecer nos eventos já recebidos
+    Connection *closedConnections;
+
+    // Pedidos esperando uma thread
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    RequestList pending;
+    int stopping;
+
+    // Respostas esperando a thread do epoll
+    pthread_mutex_t doneLock;
+    RequestList done;
+} Server;
+
+static void appendRequest(RequestList *list, Request *request)
+{
+    request->next = NULL;
+    if (list->tail)
+        list->tail->next = request;
+    else
+        list->head = request;
+    list->tail = request;
+}
+
+// Cache de programas
+
+static unsigned hashPath(const char *path)
+{
+    // FNV-1a
+    unsigned hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)path; *c; c++)
+    {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+static CacheEntry *findEntry(ProgramCache *cache, const char *path, unsigned hash)
+{
+    for (CacheEntry *entry = cache->buckets[hash & (cache->bucketCount - 1)]; entry; entry = entry->next)
+    {
+        if (entry->hash == hash && strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static CacheEntry *insertEntry(ProgramCache *cache, const char *path, unsigned hash)
+{
+    if (cache->count >= cache->bucketCount)
+    {
+        int bucketCount = cache->bucketCount * 2;
+        CacheEntry **buckets = calloc(bucketCount, sizeof(CacheEntry *));
+        for (int i = 0; i < cache->bucketCount; i++)
+        {
+            CacheEntry *entry = cache->buckets[i];
+            while (entry)
+            {
+                CacheEntry *next = entry->next;
+                entry->next = buckets[entry->hash & (bucketCount - 1)];
+                buckets[entry->hash & (bucketCount - 1)] = entry;
+                entry = next;
+            }
+        }
+        free(cache->buckets);
+        cache->buckets = buckets;
+        cache->bucketCount = bucketCount;
+    }
+
+    CacheEntry *entry = calloc(1, sizeof(CacheEntry));
+    entry->path = strdup(path);
+    entry->hash = hash;
+    entry->next = cache->buckets[hash & (cache->bucketCount - 1)];
+    cache->buckets[hash & (cache->bucketCount - 1)] = entry;
+    cache->count++;
+    return entry;
+}
+
+// Deve ser chamada com a trava do cache
+static void releaseLocked(CachedProgram *cached)
+{
+    if (--cached->refs == 0)
+    {
+        phtmlDestroyProgram(cached->program);
+        free(cached);
+    }
+}
+
+static void releaseProgram(ProgramCache *cache, CachedProgram *cached)
+{
+    pthread_mutex_lock(&cache->lock);
+    releaseLocked(cached);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Programa do arquivo, analisado de novo se ele mudou desde a última vez
+static CachedProgram *acquireProgram(Server *server, const char *path, PhtmlStatus *status,
+                                     char *error, size_t errorSize)
+{
+    struct stat info;
+    if (stat(path, &info) != 0)
+    {
+        *status = PHTML_ERROR_IO;
+        snprintf(error, errorSize, "Erro: não foi possível abrir '%s'", path);
+        return NULL;
+    }
+
+    ProgramCache *cache = &server->cache;
+    unsigned hash = hashPath(path);
+    pthread_mutex_lock(&cache->lock);
+    CacheEntry *entry = findEntry(cache, path, hash);
+    if (entry && entry->size == info.st_size && entry->mtime.tv_sec == info.st_mtim.tv_sec &&
+        entry->mtime.tv_nsec == info.st_mtim.tv_nsec)
+    {
+        CachedProgram *cached = entry->cached;
+        cached->refs++;
+        pthread_mutex_unlock(&cache->lock);
+        return cached;
+    }
+    // A versão anterior só tem as funções que mudaram analisadas de novo
+    CachedProgram *previous = entry ? entry->cached : NULL;
+    if (previous)
+    {
+        previous->refs++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    // A análise é feita fora da trava, sem bloquear os pedidos de outros arquivos
+    PhtmlProgram *program;
+    *status = phtmlRecompileFile(server->runtime, previous ? previous->program : NULL, path, &program);
+    if (previous)
+    {
+        releaseProgram(cache, previous);
+    }
+    if (*status != PHTML_OK)
+    {
+        snprintf(error, errorSize, "%s", phtmlError(server->runtime));
+        return NULL;
+    }
+
+    CachedProgram *cached = malloc(sizeof(CachedProgram));
+    cached->program = program;
+    cached->refs = 2; // o cache e o pedido
+
+    // A data é a lida antes da análise: se o arquivo mudar durante ela, o próximo
+    // pedido analisa de novo
+    pthread_mutex_lock(&cache->lock);
+    entry = findEntry(cache, path, hash);
+    if (entry)
+    {
+        releaseLocked(entry->cached);
+    }
+    else
+    {
+        entry = insertEntry(cache, path, hash);
+    }
+    entry->mtime = info.st_mtim;
+    entry->size = info.st_size;
+    entry->cached = cached;
+    pthread_mutex_unlock(&cache->lock);
+    return cached;
+}
+
+static void destroyCache(ProgramCache *cache)
+{
+    for (int i = 0; i < cache->bucketCount; i++)
+    {
+        CacheEntry *entry = cache->buckets[i];
+        while (entry)
+        {
+            CacheEntry *next = entry->next;
+            releaseLocked(entry->cached);
+            free(entry->path);
+            free(entry);
+            entry = next;
+        }
+    }
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+}
+
+// Threads de execução
+
+// Resposta: "status tamanho\n" seguido da saída e, em um erro, da mensagem
+static void buildResponse(Request *request, PhtmlStatus status, const char *output, size_t length,
+                          const char *error)
+{
+    size_t errorLength = status != PHTML_OK ? strlen(error) + 1 : 0;
+    char header[48];
+    int headerLength = snprintf(header, sizeof(header), "%d %zu\n", (int)status, length + errorLength);
+
+    request->responseLength = headerLength + length + errorLength;
+    request->response = malloc(request->responseLength);
+    char *out = request->response;
+    memcpy(out, header, headerLength);
+    memcpy(out + headerLength, output, length);
+    if (errorLength)
+    {
+        memcpy(out + headerLength + length, error, errorLength - 1);
+        out[request->responseLength - 1] = '\n';
+    }
+}
+
+static void handleRequest(Server *server, Request *request, char **buffer, size_t *capacity)
+{
+    const char *path;
+    PhtmlValue *args;
+    int argCount;
+    char error[512];
+
+    if (!batchSplitLine(request->line, &path, &args, &argCount) || !path)
+    {
+        snprintf(error, sizeof(error), "Erro: pedido inválido");
+        buildResponse(request, PHTML_ERROR_ARGUMENTS, "", 0, error);
+        free(args);
+        return;
+    }
+
+    PhtmlStatus status;
+    CachedProgram *cached = acquireProgram(server, path, &status, error, sizeof(error));
+    if (!cached)
+    {
+        buildResponse(request, status, "", 0, error);
+        free(args);
+        return;
+    }
+
+    size_t length;
+    status = phtmlRunBuffered(cached->program, "main", args, argCount, buffer, capacity, &length, NULL);
+    releaseProgram(&server->cache, cached);
+    buildResponse(request, status, *buffer, length, phtmlError(server->runtime));
+    free(args);
+}
+
+static void *runWorker(void *argument)
+{
+    Server *server = argument;
+    char *buffer = NULL;
+    size_t capacity = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&server->lock);
+        while (!server->pending.head && !server->stopping)
+        {
+            pthread_cond_wait(&server->ready, &server->lock);
+        }
+        Request *request = server->pending.head;
+        if (!request)
+        {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        server->pending.head = request->next;
+        if (!server->pending.head)
+        {
+            server->pending.tail = NULL;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        handleRequest(server, request, &buffer, &capacity);
+
+        pthread_mutex_lock(&server->doneLock);
+        appendRequest(&server->done, request);
+        pthread_mutex_unlock(&server->doneLock);
+        uint64_t one = 1;
+        if (write(server->wakeFd, &one, sizeof(one)) < 0)
+        {
+            perror("phtml: eventfd");
+        }
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+// Conexões (só a thread do epoll mexe nelas)
+
+// Com um pedido em andamento a conexão não é lida: o que o cliente enviar fica
+// no socket até a resposta sair, então a entrada guardada não passa de um pedido
+static void updateEvents(Server *server, Connection *connection)
+{
+    unsigned events = (connection->busy ? 0 : EPOLLIN) |
+                      (connection->outputSent < connection->outputLength ? EPOLLOUT : 0);
+    if (connection->events == events)
+    {
+        return;
+    }
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+    epoll_ctl(server->epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->events = events;
+}
+
+static void discardConnection(Server *server, Connection *connection)
+{
+    connection->next = server->closedConnections;
+    server->closedConnections = connection;
+}
+
+// Se um pedido ainda estiver com uma thread, a conexão só é descartada quando ele voltar
+static void closeConnection(Server *server, Connection *connection)
+{
+    if (connection->closed)
+    {
+        return;
+    }
+    epoll_ctl(server->epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->closed = 1;
+    free(connection->output);
+    connection->output = NULL;
+    if (!connection->inWorker)
+    {
+        discardConnection(server, connection);
+    }
+}
+
+static void freeClosedConnections(Server *server)
+{
+    while (server->closedConnections)
+    {
+        Connection *connection = server->closedConnections;
+        server->closedConnections = connection->next;
+        free(connection->input);
+        free(connection);
+    }
+}
+
+// Entrega a próxima linha completa às threads; uma conexão tem um pedido por vez
+static void processInput(Server *server, Connection *connection)
+{
+    if (connection->busy || connection->closed)
+    {
+        return;
+    }
+
+    char *end = memchr(connection->input, '\n', connection->inputLength);
+    if (!end)
+    {
+        if (connection->inputLength > SERVER_REQUEST_MAX || connection->eof)
+        {
+            closeConnection(server, connection);
+        }
+        return;
+    }
+
+    size_t lineLength = end - connection->input;
+    Request *request = malloc(sizeof(Request));
+    request->connection = connection;
+    request->line = malloc(lineLength + 1);
+    memcpy(request->line, connection->input, lineLength);
+    request->line[lineLength] = '\0';
+    if (lineLength > 0 && request->line[lineLength - 1] == '\r')
+    {
+        request->line[lineLength - 1] = '\0';
+    }
+    connection->inputLength -= lineLength + 1;
+    memmove(connection->input, end + 1, connection->inputLength);
+    connection->busy = 1;
+    connection->inWorker = 1;
+    updateEvents(server, connection);
+
+    pthread_mutex_lock(&server->lock);
+    appendRequest(&server->pending, request);
+    pthread_cond_signal(&server->ready);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void flushOutput(Server *server, Connection *connection)
+{
+    while (connection->outputSent < connection->outputLength)
+    {
+        ssize_t sent = send(connection->fd, connection->output + connection->outputSent,
+                            connection->outputLength - connection->outputSent, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                updateEvents(server, connection);
+                return;
+            }
+            closeConnection(server, connection);
+            return;
+        }
+        connection->outputSent += sent;
+    }
+
+    free(connection->output);
+    connection->output = NULL;
+    connection->busy = 0;
+    updateEvents(server, connection);
+    processInput(server, connection);
+}
+
+// Lê até ter uma linha completa; o resto fica no socket até o próximo pedido
+static void readInput(Server *server, Connection *connection)
+{
+    if (connection->busy)
+    {
+        // Só EPOLLHUP ou EPOLLERR chegam aqui sem EPOLLIN: o cliente se foi e
+        // não há para quem responder
+        closeConnection(server, connection);
+        return;
+    }
+    for (;;)
+    {
+        if (connection->inputCapacity - connection->inputLength < SERVER_READ_CHUNK)
+        {
+            connection->inputCapacity = connection->inputCapacity * 2 + SERVER_READ_CHUNK;
+            connection->input = realloc(connection->input, connection->inputCapacity);
+        }
+        ssize_t received = recv(connection->fd, connection->input + connection->inputLength,
+                                connection->inputCapacity - connection->inputLength, 0);
+        if (received > 0)
+        {
+            char *start = connection->input + connection->inputLength;
+            connection->inputLength += received;
+            if (memchr(start, '\n', received) || connection->inputLength > SERVER_REQUEST_MAX)
+            {
+                break;
+            }
+            continue;
+        }
+        if (received == 0)
+        {
+            connection->eof = 1;
+            break;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            closeConnection(server, connection);
+            return;
+        }
+        break;
+    }
+
+    processInput(server, connection);
+    if (!connection->closed && connection->eof && !connection->busy)
+    {
+        closeConnection(server, connection);
+    }
+}
+
+static void acceptConnections(Server *server)
+{
+    for (;;)
+    {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                perror("phtml: accept");
+            }
+            return;
+        }
+
+        Connection *connection = calloc(1, sizeof(Connection));
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+// Envia as respostas prontas
+static void deliverResponses(Server *server)
+{
+    uint64_t count;
+    if (read(server->wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        perror("phtml: eventfd");
+    }
+
+    pthread_mutex_lock(&server->doneLock);
+    Request *request = server->done.head;
+    server->done.head = server->done.tail = NULL;
+    pthread_mutex_unlock(&server->doneLock);
+
+    while (request)
+    {
+        Request *next = request->next;
+        Connection *connection = request->connection;
+        connection->inWorker = 0;
+        if (connection->closed)
+        {
+            discardConnection(server, connection);
+            free(request->response);
+        }
+        else
+        {
+            connection->output = request->response;
+            connection->outputLength = request->responseLength;
+            connection->outputSent = 0;
+            flushOutput(server, connection);
+            if (!connection->closed && connection->eof && !connection->busy)
+            {
+                closeConnection(server, connection);
+            }
+        }
+        free(request->line);
+        free(request);
+        request = next;
+    }
+}
+
+static int openSocket(const char *socketPath)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Erro: caminho do socket muito longo: %s\n", socketPath);
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // Um socket esquecido por uma execução anterior é substituído; outros arquivos não
+    struct stat info;
+    if (lstat(socketPath, &info) == 0 && S_ISSOCK(info.st_mode))
+    {
+        unlink(socketPath);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        fprintf(stderr, "Erro: não foi possível abrir o socket '%s': %s\n", socketPath, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+int serverRun(const char *socketPath, int workers, const PhtmlLimits *limits)
+{
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.listenFd = openSocket(socketPath);
+    if (server.listenFd < 0)
+    {
+        return 1;
+    }
+
+    // Os sinais chegam pelo signalfd; as threads herdam a máscara
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    server.signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    server.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+    // Os descritores do próprio servidor são identificados pelo endereço do campo
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &server.listenFd;
+    epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &event);
+    event.data.ptr = &server.wakeFd;
+    epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.wakeFd, &event);
+    event.data.ptr = &server.signalFd;
+    epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.signalFd, &event);
+
+    server.runtime = phtmlCreateRuntime();
+    phtmlSetLimits(server.runtime, limits);
+    pthread_mutex_init(&server.cache.lock, NULL);
+    server.cache.bucketCount = SERVER_CACHE_INITIAL;
+    server.cache.buckets = calloc(SERVER_CACHE_INITIAL, sizeof(CacheEntry *));
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.ready, NULL);
+    pthread_mutex_init(&server.doneLock, NULL);
+
+    int workerCount = workers > 0 ? workers : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_t *threads = malloc(sizeof(pthread_t) * workerCount);
+    for (int i = 0; i < workerCount; i++)
+    {
+        pthread_create(&threads[i], NULL, runWorker, &server);
+    }
+    fprintf(stderr, "phtml: atendendo em %s com %d threads\n", socketPath, workerCount);
+
+    int running = 1;
+    struct epoll_event events[SERVER_EVENTS];
+    while (running)
+    {
+        int count = epoll_wait(server.epollFd, events, SERVER_EVENTS, -1);
+        if (count < 0 && errno != EINTR)
+        {
+            perror("phtml: epoll_wait");
+            break;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            void *source = events[i].data.ptr;
+            if (source == &server.listenFd)
+            {
+                acceptConnections(&server);
+            }
+            else if (source == &server.wakeFd)
+            {
+                deliverResponses(&server);
+            }
+            else if (source == &server.signalFd)
+            {
+                running = 0;
+            }
+            else
+            {
+                Connection *connection = source;
+                if (connection->closed)
+                {
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT)
+                {
+                    flushOutput(&server, connection);
+                }
+                if (!connection->closed && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                {
+                    readInput(&server, connection);
+                }
+            }
+        }
+        freeClosedConnections(&server);
+    }
+
+    // Encerramento: as threads terminam os pedidos já recebidos e saem
+    fprintf(stderr, "phtml: encerrando\n");
+    close(server.listenFd);
+    unlink(socketPath);
+    pthread_mutex_lock(&server.lock);
+    server.stopping = 1;
+    pthread_cond_broadcast(&server.ready);
+    pthread_mutex_unlock(&server.lock);
+    for (int i = 0; i < workerCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    destroyCache(&server.cache);
+    phtmlDestroyRuntime(server.runtime);
+    close(server.epollFd);
+    close(server.wakeFd);
+    close(server.signalFd);
+    return 0;
+}
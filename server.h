@@ -0,0 +1,35 @@
+#ifndef PHTML_SERVER_H
+#define PHTML_SERVER_H
+
+#include "libphtml.h"
+
+// Servidor local (phtml --serve /caminho/do.sock)
+//
+// Mantém os programas analisados em memória e os executa a pedido de outros
+// processos, por um socket Unix. Cada pedido é uma linha no formato da lista do
+// --batch (ver batch.h): o arquivo .phtml seguido dos argumentos da função main.
+//
+//     paginas/produto.phtml 42 "Cadeira azul"\n
+//
+// A resposta é uma linha com o status (PhtmlStatus, 0 = ok) e o tamanho da saída,
+// seguida da saída; em um erro, a mensagem aparece no fim, como na linha de
+// comando. Uma conexão pode enviar vários pedidos, respondidos em ordem.
+//
+//     0 27\n
+//     Cadeira azul #42 199.900000\n
+//
+// Uma thread atende as conexões com epoll e entrega os pedidos completos a um
+// conjunto fixo de threads, que executam pela biblioteca (libphtml.h). Os
+// programas ficam em cache pelo caminho; se a data de modificação ou o tamanho
+// do arquivo mudar, ele é compilado de novo no próximo pedido por
+// phtmlRecompile, que só analisa as funções editadas. SIGINT e SIGTERM encerram o
+// servidor e removem o socket.
+
+// Tamanho máximo de uma linha de pedido
+#define SERVER_REQUEST_MAX (64 * 1024)
+
+// 'workers' igual a 0 usa uma thread por processador; 'limits' vale para cada
+// pedido (um pedido que passa de um limite recebe o status PHTML_ERROR_LIMIT)
+int serverRun(const char *socketPath, int workers, const PhtmlLimits *limits);
+
+#endif
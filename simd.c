@@ -0,0 +1,753 @@
+#include "simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+
+// Elementos processados por bloco, em todas as versões
+#define LANES 8
+
+#define PICK_MIN(x, m) ((x) < (m) ? (x) : (m))
+#define PICK_MAX(x, m) ((x) > (m) ? (x) : (m))
+
+#define COMPARE(x, op, t)             \
+    ((op) == OP_EQ   ? (x) == (t)     \
+     : (op) == OP_NE ? (x) != (t)     \
+     : (op) == OP_LT ? (x) < (t)      \
+     : (op) == OP_GT ? (x) > (t)      \
+     : (op) == OP_LE ? (x) <= (t)     \
+                     : (x) >= (t))
+
+// Junção das faixas: a mesma árvore de somas em todas as versões
+static unsigned joinUInt(const unsigned *lanes)
+{
+    unsigned total = 0;
+    for (int j = 0; j < LANES; j++)
+    {
+        total += lanes[j];
+    }
+    return total;
+}
+
+static unsigned long long joinULong(const unsigned long long *lanes)
+{
+    unsigned long long total = 0;
+    for (int j = 0; j < LANES; j++)
+    {
+        total += lanes[j];
+    }
+    return total;
+}
+
+static float joinFloat(const float *l)
+{
+    return ((l[0] + l[1]) + (l[2] + l[3])) + ((l[4] + l[5]) + (l[6] + l[7]));
+}
+
+static double joinDouble(const double *l)
+{
+    return ((l[0] + l[1]) + (l[2] + l[3])) + ((l[4] + l[5]) + (l[6] + l[7]));
+}
+
+static int minLanesInt(const int *lanes)
+{
+    int result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MIN(lanes[j], result);
+    }
+    return result;
+}
+
+static long long minLanesLong(const long long *lanes)
+{
+    long long result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MIN(lanes[j], result);
+    }
+    return result;
+}
+
+static float minLanesFloat(const float *lanes)
+{
+    float result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MIN(lanes[j], result);
+    }
+    return result;
+}
+
+static double minLanesDouble(const double *lanes)
+{
+    double result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MIN(lanes[j], result);
+    }
+    return result;
+}
+
+static int maxLanesInt(const int *lanes)
+{
+    int result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MAX(lanes[j], result);
+    }
+    return result;
+}
+
+static long long maxLanesLong(const long long *lanes)
+{
+    long long result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MAX(lanes[j], result);
+    }
+    return result;
+}
+
+static float maxLanesFloat(const float *lanes)
+{
+    float result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MAX(lanes[j], result);
+    }
+    return result;
+}
+
+static double maxLanesDouble(const double *lanes)
+{
+    double result = lanes[0];
+    for (int j = 1; j < LANES; j++)
+    {
+        result = PICK_MAX(lanes[j], result);
+    }
+    return result;
+}
+
+// Elementos a partir de 'start'; inteiros dão a volta no estouro
+static void mapTailInt(int *out, const int *v, int start, int n, Operator op, int k)
+{
+    for (int i = start; i < n; i++)
+    {
+        out[i] = (int)(op == OP_ADD ? (unsigned)v[i] + (unsigned)k : (unsigned)v[i] * (unsigned)k);
+    }
+}
+
+static void mapTailLong(long long *out, const long long *v, int start, int n, Operator op, long long k)
+{
+    for (int i = start; i < n; i++)
+    {
+        unsigned long long x = (unsigned long long)v[i];
+        out[i] = (long long)(op == OP_ADD ? x + (unsigned long long)k : x * (unsigned long long)k);
+    }
+}
+
+static void mapTailFloat(float *out, const float *v, int start, int n, Operator op, float k)
+{
+    for (int i = start; i < n; i++)
+    {
+        out[i] = op == OP_ADD ? v[i] + k : v[i] * k;
+    }
+}
+
+static void mapTailDouble(double *out, const double *v, int start, int n, Operator op, double k)
+{
+    for (int i = start; i < n; i++)
+    {
+        out[i] = op == OP_ADD ? v[i] + k : v[i] * k;
+    }
+}
+
+// Versão escalar: as mesmas 8 faixas, uma de cada vez
+
+static int scalarSumInt(const int *v, int n)
+{
+    unsigned acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            acc[j] += (unsigned)v[i + j];
+        }
+    }
+    unsigned total = joinUInt(acc);
+    for (; i < n; i++)
+    {
+        total += (unsigned)v[i];
+    }
+    return (int)total;
+}
+
+static long long scalarSumLong(const long long *v, int n)
+{
+    unsigned long long acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            acc[j] += (unsigned long long)v[i + j];
+        }
+    }
+    unsigned long long total = joinULong(acc);
+    for (; i < n; i++)
+    {
+        total += (unsigned long long)v[i];
+    }
+    return (long long)total;
+}
+
+static float scalarSumFloat(const float *v, int n)
+{
+    float acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            acc[j] += v[i + j];
+        }
+    }
+    float total = joinFloat(acc);
+    for (; i < n; i++)
+    {
+        total += v[i];
+    }
+    return total;
+}
+
+static double scalarSumDouble(const double *v, int n)
+{
+    double acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            acc[j] += v[i + j];
+        }
+    }
+    double total = joinDouble(acc);
+    for (; i < n; i++)
+    {
+        total += v[i];
+    }
+    return total;
+}
+
+static int scalarMinInt(const int *v, int n)
+{
+    int result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        int m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MIN(v[i + j], m[j]);
+            }
+        }
+        result = minLanesInt(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static long long scalarMinLong(const long long *v, int n)
+{
+    long long result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        long long m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MIN(v[i + j], m[j]);
+            }
+        }
+        result = minLanesLong(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static float scalarMinFloat(const float *v, int n)
+{
+    float result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        float m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MIN(v[i + j], m[j]);
+            }
+        }
+        result = minLanesFloat(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static double scalarMinDouble(const double *v, int n)
+{
+    double result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        double m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MIN(v[i + j], m[j]);
+            }
+        }
+        result = minLanesDouble(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static int scalarMaxInt(const int *v, int n)
+{
+    int result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        int m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MAX(v[i + j], m[j]);
+            }
+        }
+        result = maxLanesInt(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static long long scalarMaxLong(const long long *v, int n)
+{
+    long long result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        long long m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MAX(v[i + j], m[j]);
+            }
+        }
+        result = maxLanesLong(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static float scalarMaxFloat(const float *v, int n)
+{
+    float result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        float m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MAX(v[i + j], m[j]);
+            }
+        }
+        result = maxLanesFloat(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static double scalarMaxDouble(const double *v, int n)
+{
+    double result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        double m[LANES];
+        memcpy(m, v, sizeof(m));
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            for (int j = 0; j < LANES; j++)
+            {
+                m[j] = PICK_MAX(v[i + j], m[j]);
+            }
+        }
+        result = maxLanesDouble(m);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static int scalarDotInt(const int *a, const int *b, int n)
+{
+    unsigned acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            acc[j] += (unsigned)a[i + j] * (unsigned)b[i + j];
+        }
+    }
+    unsigned total = joinUInt(acc);
+    for (; i < n; i++)
+    {
+        total += (unsigned)a[i] * (unsigned)b[i];
+    }
+    return (int)total;
+}
+
+static long long scalarDotLong(const long long *a, const long long *b, int n)
+{
+    unsigned long long acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            acc[j] += (unsigned long long)a[i + j] * (unsigned long long)b[i + j];
+        }
+    }
+    unsigned long long total = joinULong(acc);
+    for (; i < n; i++)
+    {
+        total += (unsigned long long)a[i] * (unsigned long long)b[i];
+    }
+    return (long long)total;
+}
+
+static float scalarDotFloat(const float *a, const float *b, int n)
+{
+    float acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            float product = a[i + j] * b[i + j];
+            acc[j] += product;
+        }
+    }
+    float total = joinFloat(acc);
+    for (; i < n; i++)
+    {
+        float product = a[i] * b[i];
+        total += product;
+    }
+    return total;
+}
+
+static double scalarDotDouble(const double *a, const double *b, int n)
+{
+    double acc[LANES] = {0};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (int j = 0; j < LANES; j++)
+        {
+            double product = a[i + j] * b[i + j];
+            acc[j] += product;
+        }
+    }
+    double total = joinDouble(acc);
+    for (; i < n; i++)
+    {
+        double product = a[i] * b[i];
+        total += product;
+    }
+    return total;
+}
+
+static void scalarMapInt(int *out, const int *v, int n, Operator op, int k)
+{
+    mapTailInt(out, v, 0, n, op, k);
+}
+
+static void scalarMapLong(long long *out, const long long *v, int n, Operator op, long long k)
+{
+    mapTailLong(out, v, 0, n, op, k);
+}
+
+static void scalarMapFloat(float *out, const float *v, int n, Operator op, float k)
+{
+    mapTailFloat(out, v, 0, n, op, k);
+}
+
+static void scalarMapDouble(double *out, const double *v, int n, Operator op, double k)
+{
+    mapTailDouble(out, v, 0, n, op, k);
+}
+
+static int scalarCountInt(const int *v, int n, Operator op, int t)
+{
+    int total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static int scalarCountLong(const long long *v, int n, Operator op, long long t)
+{
+    int total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static int scalarCountFloat(const float *v, int n, Operator op, float t)
+{
+    int total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static int scalarCountDouble(const double *v, int n, Operator op, double t)
+{
+    int total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static const SimdKernels scalarKernels = {
+    SIMD_SCALAR,
+    scalarSumInt, scalarSumLong, scalarSumFloat, scalarSumDouble,
+    scalarMinInt, scalarMinLong, scalarMinFloat, scalarMinDouble,
+    scalarMaxInt, scalarMaxLong, scalarMaxFloat, scalarMaxDouble,
+    scalarDotInt, scalarDotLong, scalarDotFloat, scalarDotDouble,
+    scalarMapInt, scalarMapLong, scalarMapFloat, scalarMapDouble,
+    scalarCountInt, scalarCountLong, scalarCountFloat, scalarCountDouble,
+};
+
+#if SIMD_X86
+
+// Vetores do tamanho dos registradores SSE2 (16 bytes) e AVX2 (32 bytes), com as
+// versões sem exigência de alinhamento usadas nas leituras e escritas
+#define VECTOR_TYPES(prefix, size)                                                        \
+    typedef int prefix##Int __attribute__((vector_size(size)));                          \
+    typedef unsigned prefix##UInt __attribute__((vector_size(size)));                    \
+    typedef long long prefix##Long __attribute__((vector_size(size)));                   \
+    typedef unsigned long long prefix##ULong __attribute__((vector_size(size)));         \
+    typedef float prefix##Float __attribute__((vector_size(size)));                      \
+    typedef double prefix##Double __attribute__((vector_size(size)));                    \
+    typedef int prefix##IntU __attribute__((vector_size(size), aligned(4)));             \
+    typedef long long prefix##LongU __attribute__((vector_size(size), aligned(8)));      \
+    typedef float prefix##FloatU __attribute__((vector_size(size), aligned(4)));         \
+    typedef double prefix##DoubleU __attribute__((vector_size(size), aligned(8)));
+
+VECTOR_TYPES(Vec16, 16)
+VECTOR_TYPES(Vec32, 32)
+
+#define VecInt VEC(Int)
+#define VecUInt VEC(UInt)
+#define VecLong VEC(Long)
+#define VecULong VEC(ULong)
+#define VecFloat VEC(Float)
+#define VecDouble VEC(Double)
+#define VecIntU VEC(IntU)
+#define VecLongU VEC(LongU)
+#define VecFloatU VEC(FloatU)
+#define VecDoubleU VEC(DoubleU)
+#define LOAD(type, p) (*(const type##U *)(p))
+#define STORE(type, p, x) (*(type##U *)(p) = (x))
+
+// Comparação de cada faixa com o limite; o resultado é -1 (verdadeiro) ou 0
+#define COMPARE_LANES(hit, type, x, op, t)  \
+    switch (op)                             \
+    {                                       \
+    case OP_EQ:                             \
+        hit = (type)((x) == (t));           \
+        break;                              \
+    case OP_NE:                             \
+        hit = (type)((x) != (t));           \
+        break;                              \
+    case OP_LT:                             \
+        hit = (type)((x) < (t));            \
+        break;                              \
+    case OP_GT:                             \
+        hit = (type)((x) > (t));            \
+        break;                              \
+    case OP_LE:                             \
+        hit = (type)((x) <= (t));           \
+        break;                              \
+    default:                                \
+        hit = (type)((x) >= (t));           \
+        break;                              \
+    }
+
+// SSE2 faz parte de todo processador x86-64: é o alvo padrão do compilador
+#define KERNEL(name) sse2_##name
+#define KERNEL_LEVEL SIMD_SSE2
+#define VEC(name) Vec16##name
+#include "simd_kernels.h"
+#undef KERNEL
+#undef KERNEL_LEVEL
+#undef VEC
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define KERNEL(name) avx2_##name
+#define KERNEL_LEVEL SIMD_AVX2
+#define VEC(name) Vec32##name
+#include "simd_kernels.h"
+#undef KERNEL
+#undef KERNEL_LEVEL
+#undef VEC
+#pragma GCC pop_options
+
+// AVX2 exige o bit no CPUID e que o sistema salve os registradores de 256 bits
+static int hasAvx2(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return 0;
+    }
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+    {
+        return 0;
+    }
+
+    unsigned xcrLow, xcrHigh;
+    __asm__("xgetbv" : "=a"(xcrLow), "=d"(xcrHigh) : "c"(0));
+    if ((xcrLow & 6) != 6)
+    {
+        return 0;
+    }
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return 0;
+    }
+    return (ebx & bit_AVX2) != 0;
+}
+
+#endif
+
+static SimdLevel detectLevel(void)
+{
+#if SIMD_X86
+    return hasAvx2() ? SIMD_AVX2 : SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+static const SimdKernels *kernelsFor(SimdLevel level)
+{
+#if SIMD_X86
+    if (level == SIMD_AVX2)
+        return &avx2_kernels;
+    if (level == SIMD_SSE2)
+        return &sse2_kernels;
+#endif
+    (void)level;
+    return &scalarKernels;
+}
+
+const SimdKernels *simdKernels(void)
+{
+    // Várias threads podem fazer a detecção ao mesmo tempo; todas chegam ao mesmo resultado
+    static const SimdKernels *active = NULL;
+    const SimdKernels *kernels = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+    if (!kernels)
+    {
+        SimdLevel level = detectLevel();
+
+        // PHTML_SIMD só pode baixar o nível, nunca usar instruções ausentes
+        const char *forced = getenv("PHTML_SIMD");
+        if (forced)
+        {
+            if (strcmp(forced, "scalar") == 0)
+                level = SIMD_SCALAR;
+            else if (strcmp(forced, "sse2") == 0 && level > SIMD_SSE2)
+                level = SIMD_SSE2;
+        }
+        kernels = kernelsFor(level);
+        __atomic_store_n(&active, kernels, __ATOMIC_RELEASE);
+    }
+    return kernels;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_AVX2:
+        return "avx2";
+    case SIMD_SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef PHTML_SIMD_H
+#define PHTML_SIMD_H
+
+#include "phtml.h"
+
+// Operações em bloco sobre arrays numéricos (<sum>, <min>, <max>, <dot>, <add>,
+// <mul> e <count>; ver array.c)
+//
+// Cada operação tem uma versão AVX2, uma SSE2 e uma escalar. A versão é escolhida
+// pelo CPUID na primeira chamada de simdKernels (PHTML_SIMD=scalar|sse2|avx2 força
+// uma versão menor que a disponível). Todas percorrem os elementos em 8 faixas
+// e juntam as faixas na mesma ordem, então a soma e o produto escalar de float e
+// double dão o mesmo resultado em qualquer máquina. Inteiros dão a volta no
+// estouro, como nas operações do interpretador.
+
+typedef enum
+{
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+} SimdLevel;
+
+// Os ponteiros de entrada não precisam de alinhamento; <min> e <max> exigem n > 0
+typedef struct
+{
+    SimdLevel level;
+
+    int (*sumInt)(const int *v, int n);
+    long long (*sumLong)(const long long *v, int n);
+    float (*sumFloat)(const float *v, int n);
+    double (*sumDouble)(const double *v, int n);
+
+    int (*minInt)(const int *v, int n);
+    long long (*minLong)(const long long *v, int n);
+    float (*minFloat)(const float *v, int n);
+    double (*minDouble)(const double *v, int n);
+
+    int (*maxInt)(const int *v, int n);
+    long long (*maxLong)(const long long *v, int n);
+    float (*maxFloat)(const float *v, int n);
+    double (*maxDouble)(const double *v, int n);
+
+    int (*dotInt)(const int *a, const int *b, int n);
+    long long (*dotLong)(const long long *a, const long long *b, int n);
+    float (*dotFloat)(const float *a, const float *b, int n);
+    double (*dotDouble)(const double *a, const double *b, int n);
+
+    // out[i] = v[i] op k, com op OP_ADD ou OP_MUL (out pode ser o próprio v)
+    void (*mapInt)(int *out, const int *v, int n, Operator op, int k);
+    void (*mapLong)(long long *out, const long long *v, int n, Operator op, long long k);
+    void (*mapFloat)(float *out, const float *v, int n, Operator op, float k);
+    void (*mapDouble)(double *out, const double *v, int n, Operator op, double k);
+
+    // Quantidade de elementos com v[i] op t, com op de OP_EQ a OP_GE
+    int (*countInt)(const int *v, int n, Operator op, int t);
+    int (*countLong)(const long long *v, int n, Operator op, long long t);
+    int (*countFloat)(const float *v, int n, Operator op, float t);
+    int (*countDouble)(const double *v, int n, Operator op, double t);
+} SimdKernels;
+
+const SimdKernels *simdKernels(void);
+
+const char *simdLevelName(SimdLevel level);
+
+#endif
@@ -0,0 +1,653 @@
+// Corpo das operações vetoriais de simd.c
+//
+// Este arquivo é incluído uma vez para cada conjunto de instruções: KERNEL(nome)
+// dá o nome da versão, KERNEL_LEVEL o SimdLevel, #pragma GCC target as
+// instruções e Vec* os vetores do tamanho dos registradores (16 bytes no SSE2,
+// 32 no AVX2). Cada bloco de 8 elementos ocupa PARTS32 vetores de int ou float
+// e PARTS64 de long ou double, então as 8 faixas são as mesmas em todas as
+// versões. A junção das faixas e o fim do array que não completa um bloco ficam
+// com as funções comuns de simd.c, as mesmas da versão escalar.
+
+#define WIDTH32 ((int)(sizeof(VecInt) / sizeof(int)))
+#define WIDTH64 ((int)(sizeof(VecLong) / sizeof(long long)))
+#define PARTS32 (LANES / WIDTH32)
+#define PARTS64 (LANES / WIDTH64)
+
+// Os vetores de um bloco ficam em registradores só se o laço das partes for desenrolado
+#define PARTS_UNROLL _Pragma("GCC unroll 4")
+
+static int KERNEL(sumInt)(const int *v, int n)
+{
+    VecUInt acc[PARTS32] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            acc[p] += (VecUInt)LOAD(VecInt, v + i + p * WIDTH32);
+        }
+    }
+    unsigned lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    unsigned total = joinUInt(lanes);
+    for (; i < n; i++)
+    {
+        total += (unsigned)v[i];
+    }
+    return (int)total;
+}
+
+static long long KERNEL(sumLong)(const long long *v, int n)
+{
+    VecULong acc[PARTS64] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            acc[p] += (VecULong)LOAD(VecLong, v + i + p * WIDTH64);
+        }
+    }
+    unsigned long long lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    unsigned long long total = joinULong(lanes);
+    for (; i < n; i++)
+    {
+        total += (unsigned long long)v[i];
+    }
+    return (long long)total;
+}
+
+static float KERNEL(sumFloat)(const float *v, int n)
+{
+    VecFloat acc[PARTS32] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            acc[p] += LOAD(VecFloat, v + i + p * WIDTH32);
+        }
+    }
+    float lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    float total = joinFloat(lanes);
+    for (; i < n; i++)
+    {
+        total += v[i];
+    }
+    return total;
+}
+
+static double KERNEL(sumDouble)(const double *v, int n)
+{
+    VecDouble acc[PARTS64] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            acc[p] += LOAD(VecDouble, v + i + p * WIDTH64);
+        }
+    }
+    double lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    double total = joinDouble(lanes);
+    for (; i < n; i++)
+    {
+        total += v[i];
+    }
+    return total;
+}
+
+// Mínimo e máximo: cada faixa guarda o menor (maior) valor visto, escolhido por
+// máscara como em 'x < m ? x : m'
+static int KERNEL(minInt)(const int *v, int n)
+{
+    int result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecInt m[PARTS32];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            m[p] = LOAD(VecInt, v + p * WIDTH32);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS32; p++)
+            {
+                VecInt x = LOAD(VecInt, v + i + p * WIDTH32);
+                VecInt pick = (VecInt)(x < m[p]);
+                m[p] = (x & pick) | (m[p] & ~pick);
+            }
+        }
+        int lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = minLanesInt(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static long long KERNEL(minLong)(const long long *v, int n)
+{
+    long long result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecLong m[PARTS64];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            m[p] = LOAD(VecLong, v + p * WIDTH64);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS64; p++)
+            {
+                VecLong x = LOAD(VecLong, v + i + p * WIDTH64);
+                VecLong pick = (VecLong)(x < m[p]);
+                m[p] = (x & pick) | (m[p] & ~pick);
+            }
+        }
+        long long lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = minLanesLong(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static float KERNEL(minFloat)(const float *v, int n)
+{
+    float result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecFloat m[PARTS32];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            m[p] = LOAD(VecFloat, v + p * WIDTH32);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS32; p++)
+            {
+                VecFloat x = LOAD(VecFloat, v + i + p * WIDTH32);
+                VecInt pick = (VecInt)(x < m[p]);
+                m[p] = (VecFloat)(((VecInt)x & pick) | ((VecInt)m[p] & ~pick));
+            }
+        }
+        float lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = minLanesFloat(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static double KERNEL(minDouble)(const double *v, int n)
+{
+    double result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecDouble m[PARTS64];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            m[p] = LOAD(VecDouble, v + p * WIDTH64);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS64; p++)
+            {
+                VecDouble x = LOAD(VecDouble, v + i + p * WIDTH64);
+                VecLong pick = (VecLong)(x < m[p]);
+                m[p] = (VecDouble)(((VecLong)x & pick) | ((VecLong)m[p] & ~pick));
+            }
+        }
+        double lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = minLanesDouble(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MIN(v[i], result);
+    }
+    return result;
+}
+
+static int KERNEL(maxInt)(const int *v, int n)
+{
+    int result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecInt m[PARTS32];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            m[p] = LOAD(VecInt, v + p * WIDTH32);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS32; p++)
+            {
+                VecInt x = LOAD(VecInt, v + i + p * WIDTH32);
+                VecInt pick = (VecInt)(x > m[p]);
+                m[p] = (x & pick) | (m[p] & ~pick);
+            }
+        }
+        int lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = maxLanesInt(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static long long KERNEL(maxLong)(const long long *v, int n)
+{
+    long long result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecLong m[PARTS64];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            m[p] = LOAD(VecLong, v + p * WIDTH64);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS64; p++)
+            {
+                VecLong x = LOAD(VecLong, v + i + p * WIDTH64);
+                VecLong pick = (VecLong)(x > m[p]);
+                m[p] = (x & pick) | (m[p] & ~pick);
+            }
+        }
+        long long lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = maxLanesLong(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static float KERNEL(maxFloat)(const float *v, int n)
+{
+    float result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecFloat m[PARTS32];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            m[p] = LOAD(VecFloat, v + p * WIDTH32);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS32; p++)
+            {
+                VecFloat x = LOAD(VecFloat, v + i + p * WIDTH32);
+                VecInt pick = (VecInt)(x > m[p]);
+                m[p] = (VecFloat)(((VecInt)x & pick) | ((VecInt)m[p] & ~pick));
+            }
+        }
+        float lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = maxLanesFloat(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static double KERNEL(maxDouble)(const double *v, int n)
+{
+    double result = v[0];
+    int i = 0;
+    if (n >= LANES)
+    {
+        VecDouble m[PARTS64];
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            m[p] = LOAD(VecDouble, v + p * WIDTH64);
+        }
+        for (i = LANES; i + LANES <= n; i += LANES)
+        {
+            PARTS_UNROLL
+            for (int p = 0; p < PARTS64; p++)
+            {
+                VecDouble x = LOAD(VecDouble, v + i + p * WIDTH64);
+                VecLong pick = (VecLong)(x > m[p]);
+                m[p] = (VecDouble)(((VecLong)x & pick) | ((VecLong)m[p] & ~pick));
+            }
+        }
+        double lanes[LANES];
+        memcpy(lanes, m, sizeof(lanes));
+        result = maxLanesDouble(lanes);
+    }
+    for (; i < n; i++)
+    {
+        result = PICK_MAX(v[i], result);
+    }
+    return result;
+}
+
+static int KERNEL(dotInt)(const int *a, const int *b, int n)
+{
+    VecUInt acc[PARTS32] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            acc[p] += (VecUInt)LOAD(VecInt, a + i + p * WIDTH32) * (VecUInt)LOAD(VecInt, b + i + p * WIDTH32);
+        }
+    }
+    unsigned lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    unsigned total = joinUInt(lanes);
+    for (; i < n; i++)
+    {
+        total += (unsigned)a[i] * (unsigned)b[i];
+    }
+    return (int)total;
+}
+
+static long long KERNEL(dotLong)(const long long *a, const long long *b, int n)
+{
+    VecULong acc[PARTS64] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            acc[p] += (VecULong)LOAD(VecLong, a + i + p * WIDTH64) * (VecULong)LOAD(VecLong, b + i + p * WIDTH64);
+        }
+    }
+    unsigned long long lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    unsigned long long total = joinULong(lanes);
+    for (; i < n; i++)
+    {
+        total += (unsigned long long)a[i] * (unsigned long long)b[i];
+    }
+    return (long long)total;
+}
+
+static float KERNEL(dotFloat)(const float *a, const float *b, int n)
+{
+    VecFloat acc[PARTS32] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS32; p++)
+        {
+            VecFloat product = LOAD(VecFloat, a + i + p * WIDTH32) * LOAD(VecFloat, b + i + p * WIDTH32);
+            acc[p] += product;
+        }
+    }
+    float lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    float total = joinFloat(lanes);
+    for (; i < n; i++)
+    {
+        float product = a[i] * b[i];
+        total += product;
+    }
+    return total;
+}
+
+static double KERNEL(dotDouble)(const double *a, const double *b, int n)
+{
+    VecDouble acc[PARTS64] = {{0}};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        PARTS_UNROLL
+        for (int p = 0; p < PARTS64; p++)
+        {
+            VecDouble product = LOAD(VecDouble, a + i + p * WIDTH64) * LOAD(VecDouble, b + i + p * WIDTH64);
+            acc[p] += product;
+        }
+    }
+    double lanes[LANES];
+    memcpy(lanes, acc, sizeof(lanes));
+    double total = joinDouble(lanes);
+    for (; i < n; i++)
+    {
+        double product = a[i] * b[i];
+        total += product;
+    }
+    return total;
+}
+
+// Operação com um escalar: cada vetor é independente, sem faixas a juntar
+static void KERNEL(mapInt)(int *out, const int *v, int n, Operator op, int k)
+{
+    int i = 0;
+    if (op == OP_ADD)
+    {
+        for (; i + WIDTH32 <= n; i += WIDTH32)
+        {
+            STORE(VecInt, out + i, (VecInt)((VecUInt)LOAD(VecInt, v + i) + (unsigned)k));
+        }
+    }
+    else
+    {
+        for (; i + WIDTH32 <= n; i += WIDTH32)
+        {
+            STORE(VecInt, out + i, (VecInt)((VecUInt)LOAD(VecInt, v + i) * (unsigned)k));
+        }
+    }
+    mapTailInt(out, v, i, n, op, k);
+}
+
+static void KERNEL(mapLong)(long long *out, const long long *v, int n, Operator op, long long k)
+{
+    int i = 0;
+    if (op == OP_ADD)
+    {
+        for (; i + WIDTH64 <= n; i += WIDTH64)
+        {
+            STORE(VecLong, out + i, (VecLong)((VecULong)LOAD(VecLong, v + i) + (unsigned long long)k));
+        }
+    }
+    else
+    {
+        for (; i + WIDTH64 <= n; i += WIDTH64)
+        {
+            STORE(VecLong, out + i, (VecLong)((VecULong)LOAD(VecLong, v + i) * (unsigned long long)k));
+        }
+    }
+    mapTailLong(out, v, i, n, op, k);
+}
+
+static void KERNEL(mapFloat)(float *out, const float *v, int n, Operator op, float k)
+{
+    int i = 0;
+    if (op == OP_ADD)
+    {
+        for (; i + WIDTH32 <= n; i += WIDTH32)
+        {
+            STORE(VecFloat, out + i, LOAD(VecFloat, v + i) + k);
+        }
+    }
+    else
+    {
+        for (; i + WIDTH32 <= n; i += WIDTH32)
+        {
+            STORE(VecFloat, out + i, LOAD(VecFloat, v + i) * k);
+        }
+    }
+    mapTailFloat(out, v, i, n, op, k);
+}
+
+static void KERNEL(mapDouble)(double *out, const double *v, int n, Operator op, double k)
+{
+    int i = 0;
+    if (op == OP_ADD)
+    {
+        for (; i + WIDTH64 <= n; i += WIDTH64)
+        {
+            STORE(VecDouble, out + i, LOAD(VecDouble, v + i) + k);
+        }
+    }
+    else
+    {
+        for (; i + WIDTH64 <= n; i += WIDTH64)
+        {
+            STORE(VecDouble, out + i, LOAD(VecDouble, v + i) * k);
+        }
+    }
+    mapTailDouble(out, v, i, n, op, k);
+}
+
+// Contagem: a comparação dá -1 nas faixas verdadeiras, que é subtraído do contador
+static int KERNEL(countInt)(const int *v, int n, Operator op, int t)
+{
+    VecInt count = {0};
+    int i = 0;
+    for (; i + WIDTH32 <= n; i += WIDTH32)
+    {
+        VecInt x = LOAD(VecInt, v + i);
+        VecInt hit;
+        COMPARE_LANES(hit, VecInt, x, op, t);
+        count -= hit;
+    }
+    int total = 0;
+    for (int j = 0; j < WIDTH32; j++)
+    {
+        total += count[j];
+    }
+    for (; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static int KERNEL(countLong)(const long long *v, int n, Operator op, long long t)
+{
+    VecLong count = {0};
+    int i = 0;
+    for (; i + WIDTH64 <= n; i += WIDTH64)
+    {
+        VecLong x = LOAD(VecLong, v + i);
+        VecLong hit;
+        COMPARE_LANES(hit, VecLong, x, op, t);
+        count -= hit;
+    }
+    int total = 0;
+    for (int j = 0; j < WIDTH64; j++)
+    {
+        total += (int)count[j];
+    }
+    for (; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static int KERNEL(countFloat)(const float *v, int n, Operator op, float t)
+{
+    VecInt count = {0};
+    int i = 0;
+    for (; i + WIDTH32 <= n; i += WIDTH32)
+    {
+        VecFloat x = LOAD(VecFloat, v + i);
+        VecInt hit;
+        COMPARE_LANES(hit, VecInt, x, op, t);
+        count -= hit;
+    }
+    int total = 0;
+    for (int j = 0; j < WIDTH32; j++)
+    {
+        total += count[j];
+    }
+    for (; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static int KERNEL(countDouble)(const double *v, int n, Operator op, double t)
+{
+    VecLong count = {0};
+    int i = 0;
+    for (; i + WIDTH64 <= n; i += WIDTH64)
+    {
+        VecDouble x = LOAD(VecDouble, v + i);
+        VecLong hit;
+        COMPARE_LANES(hit, VecLong, x, op, t);
+        count -= hit;
+    }
+    int total = 0;
+    for (int j = 0; j < WIDTH64; j++)
+    {
+        total += (int)count[j];
+    }
+    for (; i < n; i++)
+    {
+        total += COMPARE(v[i], op, t);
+    }
+    return total;
+}
+
+static const SimdKernels KERNEL(kernels) = {
+    KERNEL_LEVEL,
+    KERNEL(sumInt), KERNEL(sumLong), KERNEL(sumFloat), KERNEL(sumDouble),
+    KERNEL(minInt), KERNEL(minLong), KERNEL(minFloat), KERNEL(minDouble),
+    KERNEL(maxInt), KERNEL(maxLong), KERNEL(maxFloat), KERNEL(maxDouble),
+    KERNEL(dotInt), KERNEL(dotLong), KERNEL(dotFloat), KERNEL(dotDouble),
+    KERNEL(mapInt), KERNEL(mapLong), KERNEL(mapFloat), KERNEL(mapDouble),
+    KERNEL(countInt), KERNEL(countLong), KERNEL(countFloat), KERNEL(countDouble),
+};
+
+#undef WIDTH32
+#undef WIDTH64
+#undef PARTS32
+#undef PARTS64
+#undef PARTS_UNROLL
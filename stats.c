@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "phtml.h"
+#include "stats.h"
+
+#ifdef PHTML_STATS
+__thread Stats stats;
+#endif
+
+static double phaseTimes[STATS_PHASES];
+static double phaseStarts[STATS_PHASES]; // 0 quando a fase não está em andamento
+
+static const char *phaseNames[STATS_PHASES] = {"gramática", "análise", "carga", "execução"};
+
+#ifdef PHTML_STATS
+static const char *commandNames[STATS_COMMAND_KINDS] = {
+    "sem comando", "var", "atribuição indexada", "assign", "if", "while",
+    "call", "return", "print", "flush", "push", "delete"};
+
+static const char *expressionNames[STATS_EXPRESSION_KINDS] = {
+    "chamada", "índice", "identificador", "número", "string", "char", "booleano",
+    "parênteses", "binária", "unária", "length", "operação em bloco", "has", "keys",
+    "inválida"};
+
+// Lista "nome quantidade" dos itens diferentes de zero, do mais frequente ao menos
+static void printKinds(const char *title, const char **names, const unsigned long *counts, int count)
+{
+    int printed[STATS_EXPRESSION_KINDS] = {0};
+    unsigned long total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        total += counts[i];
+    }
+    fprintf(stderr, "  %s: %lu\n", title, total);
+    for (;;)
+    {
+        int best = -1;
+        for (int i = 0; i < count; i++)
+        {
+            if (!printed[i] && counts[i] > 0 && (best < 0 || counts[i] > counts[best]))
+            {
+                best = i;
+            }
+        }
+        if (best < 0)
+        {
+            break;
+        }
+        printed[best] = 1;
+        fprintf(stderr, "    %-20s %12lu\n", names[best], counts[best]);
+    }
+}
+#endif
+
+static double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+void statsStart(StatsPhase phase)
+{
+    phaseStarts[phase] = now();
+}
+
+void statsStop(StatsPhase phase)
+{
+    if (phaseStarts[phase] > 0)
+    {
+        phaseTimes[phase] += now() - phaseStarts[phase];
+        phaseStarts[phase] = 0;
+    }
+}
+
+static void statsReport(void)
+{
+    for (int i = 0; i < STATS_PHASES; i++)
+    {
+        statsStop(i);
+    }
+
+    fprintf(stderr, "\nEstatísticas\n  tempo (ms):");
+    for (int i = 0; i < STATS_PHASES; i++)
+    {
+        fprintf(stderr, "%s %s %.3f", i > 0 ? "," : "", phaseNames[i], phaseTimes[i] * 1e3);
+    }
+    fprintf(stderr, "\n");
+
+    // ru_maxrss é o pico do processo inteiro, em KB no Linux
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "  pico de memória (RSS): %ld KB\n", usage.ru_maxrss);
+
+#ifdef PHTML_STATS
+    fprintf(stderr, "  saída: %zu bytes em %lu envios\n", stats.outputBytes, stats.outputWrites);
+    fprintf(stderr, "  chamadas: %lu (nativas: %lu), ambientes criados: %lu, variáveis criadas: %lu\n",
+            stats.calls, stats.builtinCalls, stats.environments, stats.variables);
+    double lookups = stats.lookups ? (double)stats.lookups : 1;
+    fprintf(stderr, "  buscas de variáveis: %lu (média de %.2f ambientes e %.2f comparações por busca)\n",
+            stats.lookups, stats.lookupScopes / lookups, stats.lookupCompares / lookups);
+    fprintf(stderr, "  strings alocadas: %lu (%zu bytes)\n", stats.strings, stats.stringBytes);
+    printKinds("comandos", commandNames, stats.commands, STATS_COMMAND_KINDS);
+    printKinds("expressões", expressionNames, stats.expressions, STATS_EXPRESSION_KINDS);
+#else
+    fprintf(stderr, "  contadores desativados (compile com -DPHTML_STATS)\n");
+#endif
+}
+
+void statsEnable(void)
+{
+    atexit(statsReport);
+}
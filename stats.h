@@ -0,0 +1,66 @@
+#ifndef PHTML_STATS_H
+#define PHTML_STATS_H
+
+#include <stddef.h>
+#include "phtml.h"
+
+// Estatísticas de execução (phtml --stats)
+//
+// Os contadores são campos de uma estrutura de cada thread, incrementados pelas
+// macros STATS_COUNT e STATS_ADD nos pontos do interpretador. Eles só existem
+// quando o interpretador é compilado com -DPHTML_STATS; sem isso as macros não
+// geram código e --stats mostra apenas os tempos das fases, a saída e o pico de
+// memória do processo.
+
+#define STATS_COMMAND_KINDS (COMMAND_DELETE + 1)
+#define STATS_EXPRESSION_KINDS (EXPR_INVALID + 1)
+
+typedef struct
+{
+    unsigned long commands[STATS_COMMAND_KINDS];       // por CommandKind
+    unsigned long expressions[STATS_EXPRESSION_KINDS]; // por ExpressionKind
+
+    unsigned long lookups;        // findVariable
+    unsigned long lookupScopes;   // ambientes percorridos nas buscas
+    unsigned long lookupCompares; // variáveis comparadas nas buscas
+
+    unsigned long calls;        // funções do programa
+    unsigned long builtinCalls; // funções nativas
+    unsigned long environments;
+    unsigned long variables; // variáveis criadas
+
+    unsigned long strings; // strings alocadas pelo interpretador
+    size_t stringBytes;
+
+    unsigned long outputWrites; // envios do buffer de saída
+    size_t outputBytes;
+} Stats;
+
+#ifdef PHTML_STATS
+extern __thread Stats stats;
+#define STATS_COUNT(field) ((void)(stats.field++))
+#define STATS_ADD(field, amount) ((void)(stats.field += (amount)))
+#else
+#define STATS_COUNT(field) ((void)0)
+#define STATS_ADD(field, amount) ((void)0)
+#endif
+
+// Fases medidas pela linha de comando
+typedef enum
+{
+    STATS_GRAMMAR, // construção dos parsers
+    STATS_PARSE,   // mpc_parse_contents
+    STATS_LOAD,    // loadFunctions
+    STATS_EXECUTE,
+    STATS_PHASES
+} StatsPhase;
+
+// Ativa o relatório, escrito na saída de erro no fim do processo (atexit)
+void statsEnable(void);
+
+// Início e fim de uma fase; se o programa terminar com erro no meio de uma
+// fase, ela é encerrada no relatório
+void statsStart(StatsPhase phase);
+void statsStop(StatsPhase phase);
+
+#endif
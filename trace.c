@@ -0,0 +1,259 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "phtml.h"
+#include "trace.h"
+
+// Eventos que as chamadas de função não podem usar, para que as fases e os
+// envios da saída ainda sejam registrados depois de muitas chamadas
+#define TRACE_EVENT_RESERVE 1024
+
+// Tamanho máximo de uma string nos argumentos de uma chamada
+#define TRACE_STRING_MAX 24
+
+int traceEnabled = 0;
+
+// Um intervalo ("ph": "X"); a posição é reservada no início e a duração
+// preenchida no fim, então intervalos internos ficam antes dos externos só
+// quando terminam antes
+typedef struct
+{
+    const char *name;
+    const char *category;
+    long long start; // nanossegundos desde traceEnable
+    long long duration;
+    char args[TRACE_ARGS_MAX];
+} TraceEvent;
+
+static const char *tracePath = NULL;
+static TraceEvent *events = NULL;
+static int eventCount = 0;
+static unsigned long dropped = 0;
+static long long origin = 0;
+
+// Intervalos abertos: índice do evento, ou -1 quando ele foi descartado
+static int *openEvents = NULL;
+static int openDepth = 0;
+static int openCapacity = 0;
+
+static long long now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+// Reserva um evento e o empilha como aberto; retorna NULL se já há 'limit' eventos
+static TraceEvent *beginEvent(const char *name, const char *category, int limit)
+{
+    if (openDepth == openCapacity)
+    {
+        openCapacity = openCapacity ? openCapacity * 2 : 256;
+        openEvents = realloc(openEvents, sizeof(int) * openCapacity);
+    }
+    if (eventCount >= limit)
+    {
+        dropped++;
+        openEvents[openDepth++] = -1;
+        return NULL;
+    }
+    TraceEvent *event = &events[eventCount];
+    openEvents[openDepth++] = eventCount++;
+    event->name = name;
+    event->category = category;
+    event->args[0] = '\0';
+    return event;
+}
+
+void traceBegin(const char *name, const char *category, const char *args)
+{
+    TraceEvent *event = beginEvent(name, category, TRACE_EVENT_MAX);
+    if (event)
+    {
+        if (args)
+        {
+            snprintf(event->args, sizeof(event->args), "%s", args);
+        }
+        event->start = now() - origin;
+    }
+}
+
+// Escreve 'text' como string JSON, cortada em 'limit' caracteres (com "...")
+static size_t appendString(char *out, size_t room, const char *text, size_t limit)
+{
+    // Cada caractere ocupa até 2 bytes; sobra espaço para "...", aspas e '\0'
+    if (room < 7)
+    {
+        return 0;
+    }
+    size_t used = 0;
+    size_t i = 0;
+    out[used++] = '"';
+    for (; text[i] && i < limit && used + 6 < room; i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\')
+        {
+            out[used++] = '\\';
+        }
+        out[used++] = c < 0x20 ? ' ' : (char)c;
+    }
+    if (text[i])
+    {
+        memcpy(out + used, "...", 3);
+        used += 3;
+    }
+    out[used++] = '"';
+    out[used] = '\0';
+    return used;
+}
+
+// Resumo de um argumento: números e booleanos como estão, strings cortadas,
+// arrays e maps pelo tamanho
+// JSON não tem NaN nem infinito: esses valores vão como string, como no JavaScript
+static size_t appendNumber(char *out, size_t room, double number)
+{
+    if (isnan(number))
+    {
+        return appendString(out, room, "NaN", 3);
+    }
+    if (isinf(number))
+    {
+        return appendString(out, room, number > 0 ? "Infinity" : "-Infinity", 9);
+    }
+    return snprintf(out, room, "%g", number);
+}
+
+static size_t appendValue(char *out, size_t room, Value value)
+{
+    char text[64];
+    switch (value.type)
+    {
+    case TYPE_INT:
+        return snprintf(out, room, "%d", value.value.intValue);
+    case TYPE_LONG:
+        return snprintf(out, room, "%lld", value.value.longValue);
+    case TYPE_FLOAT:
+        return appendNumber(out, room, value.value.floatValue);
+    case TYPE_DOUBLE:
+        return appendNumber(out, room, value.value.doubleValue);
+    case TYPE_BOOL:
+        return snprintf(out, room, "%s", value.value.boolValue ? "true" : "false");
+    case TYPE_CHAR:
+        text[0] = value.value.charValue;
+        text[1] = '\0';
+        return appendString(out, room, text, 1);
+    case TYPE_STRING:
+        return appendString(out, room, value.value.stringValue ? value.value.stringValue : "(null)",
+                            TRACE_STRING_MAX);
+    case TYPE_ARRAY:
+        snprintf(text, sizeof(text), "array[%d]", value.value.arrayValue->length);
+        return appendString(out, room, text, sizeof(text));
+    case TYPE_MAP:
+        snprintf(text, sizeof(text), "map[%d]", value.value.mapValue->count);
+        return appendString(out, room, text, sizeof(text));
+    default:
+        return appendString(out, room, "void", 4);
+    }
+}
+
+void traceBeginCall(Function *function, const Value *args, int argCount)
+{
+    TraceEvent *event = beginEvent(function->name, "call", TRACE_EVENT_MAX - TRACE_EVENT_RESERVE);
+    if (!event)
+    {
+        return;
+    }
+
+    // "nome": valor de cada parâmetro, enquanto couber
+    size_t used = 0;
+    size_t room = sizeof(event->args);
+    for (int i = 0; i < argCount && i < function->paramCount; i++)
+    {
+        char member[TRACE_ARGS_MAX];
+        size_t length = snprintf(member, sizeof(member), "%s", i > 0 ? ", " : "");
+        length += appendString(member + length, sizeof(member) - length,
+                               function->parameters[i].name, TRACE_STRING_MAX);
+        length += snprintf(member + length, sizeof(member) - length, ": ");
+        length += appendValue(member + length, sizeof(member) - length, args[i]);
+        if (length >= sizeof(member) - 1 || used + length >= room)
+        {
+            break;
+        }
+        memcpy(event->args + used, member, length + 1);
+        used += length;
+    }
+    event->start = now() - origin;
+}
+
+void traceEnd(void)
+{
+    if (openDepth == 0)
+    {
+        return;
+    }
+    int index = openEvents[--openDepth];
+    if (index >= 0)
+    {
+        events[index].duration = now() - origin - events[index].start;
+    }
+}
+
+static void writeEvent(FILE *file, const TraceEvent *event)
+{
+    char name[TRACE_ARGS_MAX];
+    appendString(name, sizeof(name), event->name, sizeof(name) - 8);
+    fprintf(file, ",\n{\"name\": %s, \"cat\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": 1, "
+                  "\"ts\": %.3f, \"dur\": %.3f, \"args\": {%s}}",
+            name, event->category, (int)getpid(),
+            event->start / 1e3, event->duration / 1e3, event->args);
+}
+
+static void traceWrite(void)
+{
+    // Um erro em tempo de execução encerra o programa com intervalos abertos
+    while (openDepth > 0)
+    {
+        traceEnd();
+    }
+
+    FILE *file = fopen(tracePath, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Erro: não foi possível criar '%s'\n", tracePath);
+        return;
+    }
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped\": %lu}, \"traceEvents\": [", dropped);
+    fprintf(file, "\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 1, "
+                  "\"args\": {\"name\": \"phtml\"}}",
+            (int)getpid());
+    for (int i = 0; i < eventCount; i++)
+    {
+        writeEvent(file, &events[i]);
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    if (dropped > 0)
+    {
+        fprintf(stderr, "Aviso: %lu eventos do rastro descartados (limite de %d)\n", dropped, TRACE_EVENT_MAX);
+    }
+}
+
+void traceEnable(const char *path)
+{
+    if (traceEnabled)
+    {
+        return;
+    }
+    tracePath = path;
+    // O buffer é tocado agora para que as faltas de página não caiam na execução
+    events = malloc(sizeof(TraceEvent) * TRACE_EVENT_MAX);
+    memset(events, 0, sizeof(TraceEvent) * TRACE_EVENT_MAX);
+    origin = now();
+    traceEnabled = 1;
+    atexit(traceWrite);
+}
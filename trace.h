@@ -0,0 +1,40 @@
+#ifndef PHTML_TRACE_H
+#define PHTML_TRACE_H
+
+#include "phtml.h"
+
+// Rastro de execução no formato Trace Event do Chrome (phtml --trace=saida.json)
+//
+// Registra intervalos para a construção da gramática, a análise do arquivo
+// (mpc_parse_contents), a carga das funções, cada chamada de função do programa
+// (com os argumentos resumidos) e cada envio da saída. O arquivo pode ser aberto
+// em chrome://tracing, no Perfetto ou no speedscope.
+//
+// Os eventos vão para um buffer alocado (e já tocado) ao ativar o rastro e o
+// arquivo só é escrito no fim do processo, para não alterar o tempo da saída do
+// programa. Eventos além da capacidade são descartados e contados. Como o
+// perfil, é só da linha de comando.
+
+// Quantidade de eventos guardados
+#define TRACE_EVENT_MAX (128 * 1024)
+
+// Espaço para os argumentos de um evento (membros de um objeto JSON)
+#define TRACE_ARGS_MAX 120
+
+// Diferente de zero depois de traceEnable; os ganchos só são chamados com ele
+extern int traceEnabled;
+
+// Ativa o rastro; o arquivo é escrito na saída do processo (atexit)
+void traceEnable(const char *path);
+
+// Início de um intervalo; 'args' são membros JSON já formatados ("bytes": 10) ou NULL
+// 'name' e 'category' precisam continuar válidos até o fim do processo
+void traceBegin(const char *name, const char *category, const char *args);
+
+// Início da chamada de uma função, com os argumentos já avaliados
+void traceBeginCall(Function *function, const Value *args, int argCount);
+
+// Fim do intervalo aberto mais recente
+void traceEnd(void);
+
+#endif